@@ -93,6 +93,8 @@
 #include "AudioProcessingSettings.h"
 
 #include "PicClipsDialog.h"
+#include "BatchCompile.h"
+#include "format.h"
 
 // REVIEW temp
 #define _CRTDBG_MAP_ALLOC
@@ -118,6 +120,7 @@ public:
     CSCICommandLineInfo()
     {
         m_bLogFlag = FALSE;
+        m_bCompileFlag = FALSE;
     }
     void ParseParam(const TCHAR *pszParam, BOOL bFlag, BOOL bLast)
     {
@@ -125,14 +128,21 @@ public:
         {
             m_strLogFile = pszParam;
         }
+        if (m_bCompileFlag && !bFlag)
+        {
+            m_strCompileFolder = pszParam;
+        }
         m_bLogFlag = (0 == lstrcmpi(pszParam, TEXT("log")));
+        m_bCompileFlag = (0 == lstrcmpi(pszParam, TEXT("compile")));
         __super::ParseParam(pszParam, bFlag, bLast);
     }
 
     CString m_strLogFile;
+    CString m_strCompileFolder;     // /compile <gamefolder> compiles all the game's scripts and exits
 
 private:
     BOOL m_bLogFlag;
+    BOOL m_bCompileFlag;
 };
 
 // SCICompanionApp
@@ -166,7 +176,7 @@ END_MESSAGE_MAP()
 
 // SCICompanionApp construction
 
-SCICompanionApp::SCICompanionApp()
+SCICompanionApp::SCICompanionApp() : _commandLineExitCode(-1), _batchCompileLog(nullptr)
 {
     m_eHelpType = afxHTMLHelp;
 }
@@ -436,6 +446,13 @@ BOOL SCICompanionApp::InitInstance()
         appState->_logFile.Open(cmdLine.m_strLogFile, CFile::modeWrite | CFile::modeCreate | CFile::shareExclusive);
     }
 
+    if (!cmdLine.m_strCompileFolder.IsEmpty())
+    {
+        // Compile without ever showing the main window, then exit.
+        _commandLineExitCode = _BatchCompile((PCSTR)cmdLine.m_strCompileFolder);
+        return FALSE;
+    }
+
     if (!_RegisterWindowClasses())
     {
         appState->LogInfo(TEXT("Couldn't register window classes."));
@@ -510,9 +527,120 @@ int SCICompanionApp::ExitInstance()
     appState->ExitInstance();
     int iRet = __super::ExitInstance();
     delete appState;
+    if (_commandLineExitCode != -1)
+    {
+        iRet = _commandLineExitCode;
+    }
     return iRet;
 }
 
+int SCICompanionApp::DoMessageBox(LPCTSTR lpszPrompt, UINT nType, UINT nIDPrompt)
+{
+    if (_batchCompileLog)
+    {
+        UINT icon = nType & MB_ICONMASK;
+        _batchCompileLog->ReportResult(CompileResult(lpszPrompt,
+            (icon == MB_ICONERROR) ? CompileResult::CRT_Error : ((icon == MB_ICONWARNING) ? CompileResult::CRT_Warning : CompileResult::CRT_Message)));
+        // Decline anything we're asked, so nothing is done on our behalf.
+        switch (nType & MB_TYPEMASK)
+        {
+            case MB_YESNO:
+                return IDNO;
+            case MB_OKCANCEL:
+            case MB_YESNOCANCEL:
+            case MB_RETRYCANCEL:
+                return IDCANCEL;
+            case MB_ABORTRETRYIGNORE:
+                return IDABORT;
+            default:
+                return IDOK;
+        }
+    }
+    return __super::DoMessageBox(lpszPrompt, nType, nIDPrompt);
+}
+
+//
+// Compiles all the scripts in gameFolder, writing the results to the console we were launched
+// from (if any) and the log file (if any). Returns the process exit code.
+//
+int SCICompanionApp::_BatchCompile(const std::string &gameFolder)
+{
+    FILE *console = nullptr;
+    if (AttachConsole(ATTACH_PARENT_PROCESS))
+    {
+        freopen_s(&console, "CONOUT$", "w", stdout);
+    }
+
+    int exitCode = 0;
+    CompileLog log;
+    // Nobody is around to dismiss message boxes, so they go to the log (see DoMessageBox). Rule out
+    // the obvious problems with the game folder first anyway, for clearer errors.
+    _batchCompileLog = &log;
+    TCHAR szMap[MAX_PATH];
+    if (!PathIsDirectory(gameFolder.c_str()))
+    {
+        log.ReportResult(CompileResult(fmt::format("{0} is not a folder.", gameFolder), CompileResult::CRT_Error));
+        exitCode = 2;
+    }
+    else if (!PathCombine(szMap, gameFolder.c_str(), TEXT("resource.map")) || !PathFileExists(szMap))
+    {
+        log.ReportResult(CompileResult(fmt::format("No resource.map in {0}.", gameFolder), CompileResult::CRT_Error));
+        exitCode = 2;
+    }
+    else
+    {
+        try
+        {
+            appState->GetResourceMap().SetGameFolder(gameFolder);
+            BatchCompileReport report;
+            if (!BatchCompileScripts(appState->GetResourceMap(), std::vector<ScriptId>(), log, report))
+            {
+                exitCode = 1;
+            }
+        }
+        catch (std::exception &e)
+        {
+            log.ReportResult(CompileResult(e.what(), CompileResult::CRT_Error));
+            exitCode = 2;
+        }
+        catch (CException *e)
+        {
+            // Whatever threw this has already said why, in the log.
+            e->Delete();
+            log.ReportResult(CompileResult(fmt::format("Unable to open {0}.", gameFolder), CompileResult::CRT_Error));
+            exitCode = 2;
+        }
+    }
+
+    _batchCompileLog = nullptr;
+
+    for (const CompileResult &result : log.Results())
+    {
+        std::string line;
+        if (result.CanGotoScript())
+        {
+            line = fmt::format("{0}({1}): {2}{3}", result.GetScript().GetFullPath(), result.GetLineNumber(),
+                result.IsError() ? "error: " : (result.IsWarning() ? "warning: " : ""), result.GetMessage());
+        }
+        else
+        {
+            line = result.GetMessage();
+        }
+        if (console)
+        {
+            printf("%s\n", line.c_str());
+        }
+        appState->LogInfo(TEXT("%s"), line.c_str());
+    }
+
+    if (console)
+    {
+        fclose(console);
+        FreeConsole();
+    }
+    return exitCode;
+}
+
 
 void SCICompanionApp::_LoadSettings(BOOL fReset)
 {
@@ -49,10 +49,12 @@ public:
 public:
     virtual BOOL InitInstance();
     virtual int ExitInstance();
+    virtual int DoMessageBox(LPCTSTR lpszPrompt, UINT nType, UINT nIDPrompt) override;
 
     BOOL _RegisterWindowClasses();
     void _LoadSettings(BOOL fReset = FALSE);
     void _SaveSettings();
+    int _BatchCompile(const std::string &gameFolder);
 
     virtual void AddToRecentFileList(PCTSTR lpszPathName) override;
     virtual CDocument* OpenDocumentFile(PCTSTR lpszFileName) override;
@@ -78,7 +80,10 @@ public:
     DECLARE_MESSAGE_MAP()
 
 private:
-
+    // When run as a command line batch compiler, this is the process exit code.
+    int _commandLineExitCode;
+    // While batch compiling, message boxes go here instead.
+    CompileLog *_batchCompileLog;
 };
 
 
@@ -0,0 +1,81 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "BatchCompile.h"
+#include "ResourceMap.h"
+#include "BuildGraph.h"
+#include "format.h"
+
+namespace
+{
+    std::string _FormatPhase(const char *name, double seconds, double totalSeconds)
+    {
+        double percent = (totalSeconds > 0) ? (seconds * 100.0 / totalSeconds) : 0.0;
+        return fmt::format("  {0:<10}{1:8.3f}s ({2:.0f}%)", name, seconds, percent);
+    }
+}
+
+bool BatchCompileScripts(CResourceMap &resourceMap, std::vector<ScriptId> scripts, CompileLog &log, BatchCompileReport &report)
+{
+    report = BatchCompileReport();
+    if (scripts.empty())
+    {
+        resourceMap.GetAllScripts(scripts);
+    }
+
+    CPrecisionTimer timer;
+    timer.Start();
+    {
+        DeferResourceAppend defer(resourceMap);
+
+        CompileTables tables;
+        tables.Load(resourceMap.GetSCIVersion());
+        PrecompiledHeaders headers(resourceMap);
+        for (ScriptId &scriptId : scripts)
+        {
+            // Each script gets its own log, so we know which ones failed.
+            CompileLog scriptLog;
+            CompileResults results(scriptLog);
+            if (!NewCompileScript(results, scriptLog, tables, headers, scriptId) || scriptLog.HasErrors())
+            {
+                report.FailedCount++;
+            }
+            report.ScriptCount++;
+            report.Timings += results.Timings;
+            for (const CompileResult &result : scriptLog.Results())
+            {
+                log.ReportResult(result);
+            }
+        }
+        tables.Save();
+        resourceMap.GetBuildGraph().Save();
+
+        // Committing the deferred resources is part of writing the output.
+        CPrecisionTimer commitTimer;
+        commitTimer.Start();
+        defer.Commit();
+        report.Timings.Write += commitTimer.Stop();
+    }
+    report.TotalSeconds = timer.Stop();
+
+    log.ReportResult(CompileResult("--------------------------------"));
+    log.ReportResult(CompileResult(fmt::format("{0} scripts compiled, {1} failed, in {2:.2f} seconds ({3:.1f} scripts/sec).",
+        report.ScriptCount, report.FailedCount, report.TotalSeconds, report.ScriptsPerSecond())));
+    log.ReportResult(CompileResult(_FormatPhase("Parse", report.Timings.Parse, report.TotalSeconds)));
+    log.ReportResult(CompileResult(_FormatPhase("Prescan", report.Timings.Prescan, report.TotalSeconds)));
+    log.ReportResult(CompileResult(_FormatPhase("CodeGen", report.Timings.CodeGen, report.TotalSeconds)));
+    log.ReportResult(CompileResult(_FormatPhase("Write", report.Timings.Write, report.TotalSeconds)));
+    log.CalculateErrors();
+    return report.FailedCount == 0;
+}
@@ -0,0 +1,39 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+#include "CompileContext.h"
+
+class CResourceMap;
+
+struct BatchCompileReport
+{
+    BatchCompileReport() : ScriptCount(0), FailedCount(0), TotalSeconds(0) {}
+
+    double ScriptsPerSecond() const { return (TotalSeconds > 0) ? (ScriptCount / TotalSeconds) : 0.0; }
+
+    int ScriptCount;
+    int FailedCount;
+    double TotalSeconds;
+    CompileTimings Timings;
+};
+
+//
+// Compiles scripts in the game currently loaded in resourceMap, without any UI. This is what
+// Compile All does, minus the progress dialog, so it can be driven from the command line or tests.
+// If scripts is empty, all the game's scripts are compiled.
+// Each script's results are added to log, followed by a summary of the time spent in each phase.
+// Returns true if there were no errors.
+//
+bool BatchCompileScripts(CResourceMap &resourceMap, std::vector<ScriptId> scripts, CompileLog &log, BatchCompileReport &report);
@@ -0,0 +1,255 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "BatchDecompile.h"
+#include "CompiledScript.h"
+#include "DecompileCache.h"
+#include "DecompileScript.h"
+#include "DecompilerResults.h"
+#include "DisassembleHelper.h"
+#include "GameFolderHelper.h"
+#include "ScriptOM.h"
+#include "SCO.h"
+#include "format.h"
+#include <future>
+#include <atomic>
+
+using namespace std;
+
+namespace
+{
+    struct DecompileJob
+    {
+        DecompileJob() : Succeeded(false), Cacheable(false) {}
+
+        uint16_t ScriptNumber;
+        bool Succeeded;
+        bool Cacheable;     // Decompiled (not from the cache) and not aborted partway.
+        DecompileOutputs Outputs;
+        DecompileCache::Result CacheResult;
+    };
+
+    // Passes everything on to the real results, noting what's needed to replay them for a cached result.
+    class CapturingDecompilerResults : public IDecompilerResults
+    {
+    public:
+        CapturingDecompilerResults(IDecompilerResults &inner, DecompileCache::Result &result) : _inner(inner), _result(result) {}
+
+        void AddResult(DecompilerResultType type, const std::string &message) override
+        {
+            if (type != DecompilerResultType::Update)
+            {
+                _result.Messages.emplace_back(type, message);
+            }
+            _inner.AddResult(type, message);
+        }
+        bool IsAborted() override { return _inner.IsAborted(); }
+        void InformStats(bool functionSuccessful, int byteCount) override
+        {
+            _result.FunctionStats.emplace_back(functionSuccessful, byteCount);
+            _inner.InformStats(functionSuccessful, byteCount);
+        }
+        void SetGlobalVarsUpdated(const std::vector<std::pair<std::string, std::string>> &mainDirtyRenames) override { _inner.SetGlobalVarsUpdated(mainDirtyRenames); }
+        void InformDominators(const NodeSet &nodes, ControlFlowNode *entry, const std::function<NodeSet(ControlFlowNode*)> &edgesIn, const DominatorMap &dominators) override
+        {
+            _inner.InformDominators(nodes, entry, edgesIn, dominators);
+        }
+
+    private:
+        IDecompilerResults &_inner;
+        DecompileCache::Result &_result;
+    };
+
+    bool _UseCachedResult(const GameFolderHelper &helper, const SelectorTable &selectors, IDecompilerResults &results, const DecompileCache &cache, DecompileJob &job)
+    {
+        DecompileCache::Result &cached = job.CacheResult;
+        if (!cache.Lookup(helper, job.ScriptNumber, cached) || cached.SCO.empty())
+        {
+            return false;
+        }
+        unique_ptr<CSCOFile> sco = make_unique<CSCOFile>();
+        sci::istream scoStream(&cached.SCO[0], (uint32_t)cached.SCO.size());
+        if (!sco->Load(scoStream, selectors))
+        {
+            return false;
+        }
+
+        for (const auto &message : cached.Messages)
+        {
+            results.AddResult(message.first, message.second);
+        }
+        for (const auto &stat : cached.FunctionStats)
+        {
+            results.InformStats(stat.first, stat.second);
+        }
+        string sourceFilename = helper.GetScriptFileName(job.ScriptNumber);
+        MakeTextFile(cached.Source.c_str(), sourceFilename);
+        results.AddResult(DecompilerResultType::Important, fmt::format("Generated {0} (unchanged)", sourceFilename));
+        job.Outputs.SCO = move(sco);
+        job.Outputs.MainRenames = cached.MainRenames;
+        job.Succeeded = true;
+        return true;
+    }
+
+    void _DecompileOne(const GameFolderHelper &helper, const SelectorTable &selectors, IDecompilerResults &results, DecompileScriptFunc &decompile, const DecompileCache *cache, DecompileJob &job)
+    {
+        try
+        {
+            results.AddResult(DecompilerResultType::Important, fmt::format("Decompiling script {0}", job.ScriptNumber));
+            if (cache && _UseCachedResult(helper, selectors, results, *cache, job))
+            {
+                return;
+            }
+            job.CacheResult = DecompileCache::Result();
+            CompiledScript compiledScript(0, CompiledScriptFlags::RemoveBadExports);
+            if (compiledScript.Load(helper, helper.Version, job.ScriptNumber))
+            {
+                CapturingDecompilerResults capturingResults(results, job.CacheResult);
+                unique_ptr<sci::Script> pScript = decompile(job.ScriptNumber, compiledScript, capturingResults, job.Outputs);
+                if (pScript)
+                {
+                    job.Cacheable = !results.IsAborted();
+                    // Dump it to the .sc file
+                    // TODO: If it already exists, we might want to ask for confirmation.
+                    std::stringstream ss;
+                    sci::SourceCodeWriter out(ss, helper.GetDefaultGameLanguage(), pScript.get());
+                    pScript->OutputSourceCode(out);
+                    string sourceFilename = helper.GetScriptFileName(job.ScriptNumber);
+                    job.CacheResult.Source = ss.str();
+                    MakeTextFile(job.CacheResult.Source.c_str(), sourceFilename);
+                    results.AddResult(DecompilerResultType::Important, fmt::format("Generated {0}", sourceFilename));
+                    job.Succeeded = true;
+                }
+            }
+        }
+        catch (std::exception &e)
+        {
+            results.AddResult(DecompilerResultType::Error, fmt::format("Script {0}: {1}", job.ScriptNumber, e.what()));
+        }
+    }
+
+    // Applies the renames main's .sco doesn't have yet, returning those that were applied.
+    vector<pair<string, string>> _MergeMainRenames(CSCOFile &mainSCO, const vector<pair<string, string>> &renames)
+    {
+        vector<pair<string, string>> applied;
+        vector<CSCOLocalVariable> &globals = mainSCO.GetVariables();
+        for (const auto &rename : renames)
+        {
+            size_t index = (size_t)stoi(rename.first.substr(strlen("global")));
+            if ((index < globals.size()) && (globals[index].GetName() == _GetGlobalVariableName((int)index)))
+            {
+                bool nameInUse = any_of(globals.begin(), globals.end(), [&rename](CSCOLocalVariable &global) { return global.GetName() == rename.second; });
+                if (!nameInUse)
+                {
+                    globals[index].SetName(rename.second);
+                    applied.push_back(rename);
+                }
+            }
+        }
+        return applied;
+    }
+}
+
+void DecompileScripts(const GameFolderHelper &helper, const SelectorTable &selectors, const std::set<uint16_t> &scriptNumbers, IDecompilerResults &results, DecompileScriptFunc decompile, unsigned int threadCount, DecompileCache *cache)
+{
+    // Remember what was decompiled, while the .sco files it read are still there to be hashed.
+    auto recordInCache = [&](DecompileJob &job)
+    {
+        if (cache && job.Succeeded && job.Cacheable)
+        {
+            cache->Record(helper, job.ScriptNumber, move(job.CacheResult), job.Outputs);
+        }
+    };
+
+    // std::set keeps these in script number order, which is the order we save things in.
+    vector<DecompileJob> jobs(scriptNumbers.size());
+    size_t i = 0;
+    for (uint16_t scriptNumber : scriptNumbers)
+    {
+        jobs[i++].ScriptNumber = scriptNumber;
+    }
+
+    size_t firstParallelJob = 0;
+    if (!jobs.empty() && (jobs[0].ScriptNumber == 0) && !results.IsAborted())
+    {
+        _DecompileOne(helper, selectors, results, decompile, cache, jobs[0]);
+        recordInCache(jobs[0]);
+        if (jobs[0].Succeeded && jobs[0].Outputs.SCO)
+        {
+            SaveSCOFile(helper, *jobs[0].Outputs.SCO);
+        }
+        firstParallelJob = 1;
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = max(1u, thread::hardware_concurrency());
+    }
+    threadCount = min(threadCount, (unsigned int)(jobs.size() - firstParallelJob));
+
+    atomic<size_t> nextJob(firstParallelJob);
+    auto worker = [&]()
+    {
+        size_t jobIndex;
+        while (!results.IsAborted() && ((jobIndex = nextJob++) < jobs.size()))
+        {
+            _DecompileOne(helper, selectors, results, decompile, cache, jobs[jobIndex]);
+        }
+    };
+    vector<future<void>> workers;
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        workers.push_back(async(launch::async, worker));
+    }
+    for (auto &workerFuture : workers)
+    {
+        workerFuture.wait();
+    }
+
+    for (size_t j = firstParallelJob; j < jobs.size(); j++)
+    {
+        recordInCache(jobs[j]);
+    }
+    if (cache)
+    {
+        cache->EndBatch();
+    }
+
+    // Now that nothing is reading them, save the new .sco files, and gather up the global variable names.
+    vector<pair<string, string>> mainRenames;
+    for (size_t j = firstParallelJob; j < jobs.size(); j++)
+    {
+        DecompileJob &job = jobs[j];
+        if (job.Succeeded && job.Outputs.SCO)
+        {
+            SaveSCOFile(helper, *job.Outputs.SCO);
+            mainRenames.insert(mainRenames.end(), job.Outputs.MainRenames.begin(), job.Outputs.MainRenames.end());
+        }
+    }
+
+    if (!mainRenames.empty())
+    {
+        unique_ptr<CSCOFile> mainSCO = GetExistingSCOFromScriptNumber(helper, 0, selectors);
+        if (mainSCO)
+        {
+            vector<pair<string, string>> applied = _MergeMainRenames(*mainSCO, mainRenames);
+            if (!applied.empty())
+            {
+                results.AddResult(DecompilerResultType::Important, "Updating global variables in script 0");
+                results.SetGlobalVarsUpdated(applied);
+                SaveSCOFile(helper, *mainSCO);
+            }
+        }
+    }
+}
@@ -0,0 +1,51 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+#include <functional>
+
+namespace sci
+{
+    class Script;
+}
+class CompiledScript;
+class GameFolderHelper;
+class IDecompilerResults;
+class SelectorTable;
+struct DecompileOutputs;
+class DecompileCache;
+
+// Decompiles a single script, returning its outputs rather than saving them (see DecompileOutputs).
+// It should report to results, rather than to whatever results were passed to DecompileScripts.
+typedef std::function<std::unique_ptr<sci::Script>(uint16_t scriptNumber, CompiledScript &compiledScript, IDecompilerResults &results, DecompileOutputs &outputs)> DecompileScriptFunc;
+
+//
+// Decompiles a set of scripts on worker threads, and writes out their source and .sco files.
+//
+// Decompiling a script reads the .sco files of the scripts it uses, and main's .sco for global variable names.
+// So that the results don't depend on thread timing, each script sees the .sco files as they were before
+// we started: the new ones are only written once all the scripts are done. The exception is main, which is
+// decompiled first on its own, since every other script reads it.
+// Names for global variables suggested by the other scripts are then merged into main's .sco in script
+// number order. If two scripts name the same global, the lower-numbered one wins.
+//
+// decompile is called concurrently, so anything it shares between scripts (lookups, config) must already be
+// loaded and must only be read from. If threadCount is 0, one thread per core is used.
+//
+// If a cache is given (already prepared with the same lookups and config), scripts whose inputs haven't
+// changed since they were last decompiled aren't decompiled again: their previous output is written out
+// instead. Newly decompiled scripts are added to the cache, but it isn't saved. The batch is ended once
+// they've been recorded, so the cache needs to be prepared again before the next call.
+//
+void DecompileScripts(const GameFolderHelper &helper, const SelectorTable &selectors, const std::set<uint16_t> &scriptNumbers, IDecompilerResults &results, DecompileScriptFunc decompile, unsigned int threadCount = 0, DecompileCache *cache = nullptr);
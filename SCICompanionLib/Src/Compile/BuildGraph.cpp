@@ -0,0 +1,344 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "BuildGraph.h"
+#include "ResourceMap.h"
+#include "ResourceBlob.h"
+#include "Vocab99x.h"
+#include "crc.h"
+
+using namespace std;
+
+const uint32_t BuildGraphSignature = (('S' << 24) + ('C' << 16) + ('B' << 8) + 'G');
+const uint16_t BuildGraphVersion = 2;
+
+namespace
+{
+    template<typename _TKey, typename _TValue>
+    void _WriteMap(sci::ostream &out, const std::map<_TKey, _TValue> &map)
+    {
+        out << (uint32_t)map.size();
+        for (const auto &pair : map)
+        {
+            out << pair.first;
+            out << pair.second;
+        }
+    }
+
+    template<typename _TKey, typename _TValue>
+    void _ReadMap(sci::istream &reader, std::map<_TKey, _TValue> &map)
+    {
+        uint32_t count;
+        reader >> count;
+        for (uint32_t i = 0; reader.good() && (i < count); i++)
+        {
+            _TKey key;
+            _TValue value;
+            reader >> key;
+            reader >> value;
+            map[key] = value;
+        }
+    }
+}
+
+BuildGraph::BuildGraph() : _dirty(false) {}
+
+void BuildGraph::SetFilename(const std::string &filename)
+{
+    if (_filename != filename)
+    {
+        _filename = filename;
+        _records.clear();
+        _dirty = false;
+        if (!_filename.empty())
+        {
+            _Load(_filename);
+        }
+    }
+}
+
+void BuildGraph::_Load(const std::string &filename)
+{
+    if (!PathFileExists(filename.c_str()))
+    {
+        return;
+    }
+    try
+    {
+        ScopedFile scoped(filename, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING);
+        sci::streamOwner owner(scoped.hFile);
+        sci::istream reader = owner.getReader();
+
+        uint32_t signature, count;
+        uint16_t version;
+        reader >> signature;
+        reader >> version;
+        reader >> count;
+        if (reader.good() && (signature == BuildGraphSignature) && (version == BuildGraphVersion))
+        {
+            for (uint32_t i = 0; reader.good() && (i < count); i++)
+            {
+                string title;
+                Record record;
+                uint8_t usesVocab;
+                reader >> title;
+                reader >> record.ScriptNumber;
+                reader >> record.EnvironmentHash;
+                reader >> record.SourceHash;
+                reader >> record.VocabHash;
+                reader >> usesVocab;
+                record.Inputs.UsesVocab = (usesVocab != 0);
+                _ReadMap(reader, record.Includes);
+                _ReadMap(reader, record.Inputs.SCOs);
+                _ReadMap(reader, record.Inputs.Selectors);
+                _ReadMap(reader, record.Inputs.SelectorNames);
+                _ReadMap(reader, record.Inputs.DefaultSelectors);
+                _ReadMap(reader, record.Inputs.Kernels);
+                _ReadMap(reader, record.Inputs.Species);
+                if (reader.good())
+                {
+                    _records[title] = move(record);
+                }
+            }
+        }
+    }
+    catch (std::exception)
+    {
+        // Then everything will just be considered out of date.
+        _records.clear();
+    }
+}
+
+void BuildGraph::Save()
+{
+    if (!_dirty || _filename.empty())
+    {
+        return;
+    }
+
+    sci::ostream out;
+    out << BuildGraphSignature;
+    out << BuildGraphVersion;
+    out << (uint32_t)_records.size();
+    for (const auto &pair : _records)
+    {
+        const Record &record = pair.second;
+        out << pair.first;
+        out << record.ScriptNumber;
+        out << record.EnvironmentHash;
+        out << record.SourceHash;
+        out << record.VocabHash;
+        out << (uint8_t)(record.Inputs.UsesVocab ? 1 : 0);
+        _WriteMap(out, record.Includes);
+        _WriteMap(out, record.Inputs.SCOs);
+        _WriteMap(out, record.Inputs.Selectors);
+        _WriteMap(out, record.Inputs.SelectorNames);
+        _WriteMap(out, record.Inputs.DefaultSelectors);
+        _WriteMap(out, record.Inputs.Kernels);
+        _WriteMap(out, record.Inputs.Species);
+    }
+
+    try
+    {
+        string folder = _filename.substr(0, _filename.find_last_of('\\'));
+        if (EnsureFolderExists(folder, false))
+        {
+            ScopedFile scoped(_filename, GENERIC_WRITE, 0, CREATE_ALWAYS);
+            scoped.Write(out.GetInternalPointer(), out.GetDataSize());
+            _dirty = false;
+        }
+    }
+    catch (std::exception)
+    {
+        // The graph is just an optimization. If we can't write it, things will be recompiled next time.
+    }
+}
+
+uint32_t BuildGraph::_HashFile(const std::string &fullPath, hash_map &fileHashes)
+{
+    string key = fullPath;
+    transform(key.begin(), key.end(), key.begin(), ::tolower);
+    auto it = fileHashes.find(key);
+    if (it != fileHashes.end())
+    {
+        return it->second;
+    }
+
+    // 0 means the file is missing or empty.
+    uint32_t hash = 0;
+    std::ifstream file(fullPath, std::ios::binary);
+    if (file.is_open())
+    {
+        std::vector<uint8_t> contents;
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        hash = contents.empty() ? 0 : (uint32_t)crcFast(&contents[0], (int)contents.size());
+    }
+    fileHashes[key] = hash;
+    return hash;
+}
+
+// The parts of the game's configuration that affect the generated code.
+uint32_t BuildGraph::_HashEnvironment(CResourceMap &resourceMap)
+{
+    const SCIVersion &version = resourceMap.GetSCIVersion();
+    uint8_t settings[] =
+    {
+        (uint8_t)version.MapFormat,
+        (uint8_t)version.lofsaOpcodeIsAbsolute,
+        (uint8_t)version.SeparateHeapResources,
+        (uint8_t)version.HasOldSCI0ScriptHeader,
+        (uint8_t)version.Kernels,
+        (uint8_t)version.IsExportWide,
+        (uint8_t)version.IsZeroExportValid,
+        (uint8_t)(version.MainVocabResource & 0xff),
+        (uint8_t)(version.MainVocabResource >> 8),
+        (uint8_t)resourceMap.Helper().GetGenerateDebugInfo(),
+    };
+    return (uint32_t)crcFast(settings, ARRAYSIZE(settings));
+}
+
+uint32_t BuildGraph::_HashVocab(CResourceMap &resourceMap)
+{
+    std::unique_ptr<ResourceBlob> blob = resourceMap.MostRecentResource(ResourceType::Vocab, resourceMap.GetSCIVersion().MainVocabResource, false);
+    return (blob && blob->GetLength()) ? (uint32_t)crcFast(blob->GetData(), (int)blob->GetLength()) : 0;
+}
+
+void BuildGraph::RecordCompile(CResourceMap &resourceMap, const ScriptId &scriptId, uint16_t scriptNumber, const std::set<std::string> &includes, const CompileInputs &inputs)
+{
+    hash_map fileHashes;
+    Record record;
+    record.ScriptNumber = scriptNumber;
+    record.EnvironmentHash = _HashEnvironment(resourceMap);
+    record.SourceHash = _HashFile(scriptId.GetFullPath(), fileHashes);
+    record.VocabHash = inputs.UsesVocab ? _HashVocab(resourceMap) : 0;
+    for (const string &include : includes)
+    {
+        record.Includes[include] = _HashFile(resourceMap.GetIncludePath(include), fileHashes);
+    }
+    record.Inputs = inputs;
+    _records[scriptId.GetTitleLower()] = move(record);
+    _dirty = true;
+}
+
+void BuildGraph::Forget(const ScriptId &scriptId)
+{
+    if (_records.erase(scriptId.GetTitleLower()))
+    {
+        _dirty = true;
+    }
+}
+
+bool BuildGraph::_IsUpToDate(CResourceMap &resourceMap, CompileTables &tables, const ScriptId &scriptId, const Record &record, hash_map &fileHashes)
+{
+    if ((record.EnvironmentHash != _HashEnvironment(resourceMap)) ||
+        !resourceMap.DoesResourceExist(ResourceType::Script, record.ScriptNumber) ||
+        (record.SourceHash != _HashFile(scriptId.GetFullPath(), fileHashes)))
+    {
+        return false;
+    }
+    for (const auto &include : record.Includes)
+    {
+        if (include.second != _HashFile(resourceMap.GetIncludePath(include.first), fileHashes))
+        {
+            return false;
+        }
+    }
+    const GameFolderHelper &helper = resourceMap.Helper();
+    for (const auto &sco : record.Inputs.SCOs)
+    {
+        if (sco.second != _HashFile(helper.GetScriptObjectFileName(sco.first), fileHashes))
+        {
+            return false;
+        }
+    }
+    for (const auto &selector : record.Inputs.Selectors)
+    {
+        uint16_t value;
+        if (!tables.Selectors().ReverseLookup(selector.first, value))
+        {
+            value = CompileInputs::NotFound;
+        }
+        if (value != selector.second)
+        {
+            return false;
+        }
+    }
+    for (const auto &selectorName : record.Inputs.SelectorNames)
+    {
+        if (tables.Selectors().Lookup(selectorName.first) != selectorName.second)
+        {
+            return false;
+        }
+    }
+    for (const auto &defaultSelector : record.Inputs.DefaultSelectors)
+    {
+        if ((tables.Selectors().IsDefaultSelector(defaultSelector.first) ? 1 : 0) != defaultSelector.second)
+        {
+            return false;
+        }
+    }
+    for (const auto &kernel : record.Inputs.Kernels)
+    {
+        uint16_t value;
+        if (!tables.Kernels().ReverseLookup(kernel.first, value))
+        {
+            value = CompileInputs::NotFound;
+        }
+        if (value != kernel.second)
+        {
+            return false;
+        }
+    }
+    for (const auto &species : record.Inputs.Species)
+    {
+        uint16_t script, index;
+        if (!tables.Species().GetSpeciesLocation(species.first, script, index) ||
+            ((((uint32_t)script << 16) | index) != species.second))
+        {
+            return false;
+        }
+    }
+    if (record.Inputs.UsesVocab)
+    {
+        auto it = fileHashes.find("<vocab>");
+        if (it == fileHashes.end())
+        {
+            it = fileHashes.emplace("<vocab>", _HashVocab(resourceMap)).first;
+        }
+        if (it->second != record.VocabHash)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BuildGraph::GetOutOfDateScripts(CResourceMap &resourceMap, CompileTables &tables, const std::vector<ScriptId> &scripts, std::unordered_set<std::string> &outOfDate, std::unordered_set<std::string> &unknown)
+{
+    // Many scripts include the same headers and use the same .sco files, so only hash each once.
+    hash_map fileHashes;
+    for (const ScriptId &scriptId : scripts)
+    {
+        string title = scriptId.GetTitleLower();
+        auto it = _records.find(title);
+        if (it == _records.end())
+        {
+            unknown.insert(title);
+        }
+        else if (!_IsUpToDate(resourceMap, tables, scriptId, it->second, fileHashes))
+        {
+            outOfDate.insert(title);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+#include "CompileContext.h"
+
+class CResourceMap;
+
+//
+// Remembers, for each script that compiled successfully, what went into it: the hash of its source,
+// the hashes of the headers it included, and the selectors, kernels, species and .sco files it looked up.
+// A script whose inputs all match what's in the game now would compile to the same thing, so it doesn't
+// need to be recompiled. In particular, if a script is recompiled and its .sco comes out byte-identical,
+// the scripts that use it stay up to date.
+// The graph is saved in the game folder.
+//
+class BuildGraph
+{
+public:
+    BuildGraph();
+
+    // Where the graph is persisted (empty means nowhere). Loads whatever is there.
+    void SetFilename(const std::string &filename);
+
+    // Call after a script compiles successfully. includes are the names of all the headers it used.
+    void RecordCompile(CResourceMap &resourceMap, const ScriptId &scriptId, uint16_t scriptNumber, const std::set<std::string> &includes, const CompileInputs &inputs);
+
+    // Call when a script fails to compile.
+    void Forget(const ScriptId &scriptId);
+
+    // Adds the lower-case titles of scripts whose inputs have changed to outOfDate, and those we have no
+    // record of to unknown.
+    void GetOutOfDateScripts(CResourceMap &resourceMap, CompileTables &tables, const std::vector<ScriptId> &scripts, std::unordered_set<std::string> &outOfDate, std::unordered_set<std::string> &unknown);
+
+    // Writes the graph to disk, if anything changed.
+    void Save();
+
+private:
+    struct Record
+    {
+        uint16_t ScriptNumber;
+        uint32_t EnvironmentHash;
+        uint32_t SourceHash;
+        uint32_t VocabHash;                         // Only if Inputs.UsesVocab
+        std::map<std::string, uint32_t> Includes;   // Header name to the crc of its contents
+        CompileInputs Inputs;
+    };
+
+    typedef std::unordered_map<std::string, uint32_t> hash_map;
+
+    void _Load(const std::string &filename);
+    bool _IsUpToDate(CResourceMap &resourceMap, CompileTables &tables, const ScriptId &scriptId, const Record &record, hash_map &fileHashes);
+    static uint32_t _HashFile(const std::string &fullPath, hash_map &fileHashes);
+    static uint32_t _HashEnvironment(CResourceMap &resourceMap);
+    static uint32_t _HashVocab(CResourceMap &resourceMap);
+
+    std::string _filename;
+    std::unordered_map<std::string, Record> _records;   // Keyed by lower-case script title
+    bool _dirty;
+};
@@ -26,8 +26,8 @@
 #include <unordered_map>
 #include "Text.h"
 #include "ResourceEntity.h"
-#include "CCrystalTextBuffer.h"
-#include "CrystalScriptStream.h"
+#include "HeaderCache.h"
+#include "crc.h"
 #include "PMachine.h"
 #include "StringUtil.h"
 
@@ -104,6 +104,8 @@ TextComponent &CompileResults::GetTextComponent()
 void CompileContext::_LoadSCO(const std::string &name, bool fErrorIfNotFound)
 {
     assert(!name.empty());
+    string key = name;
+    transform(key.begin(), key.end(), key.begin(), ::tolower);
     string scoFileName = appState->GetResourceMap().Helper().GetScriptObjectFileName(name);
     HANDLE hFile = CreateFile(scoFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
     if (hFile == INVALID_HANDLE_VALUE)
@@ -114,8 +116,11 @@ void CompileContext::_LoadSCO(const std::string &name, bool fErrorIfNotFound)
     if (hFile != INVALID_HANDLE_VALUE)
     {
         sci::streamOwner streamOwner(hFile);
+        sci::istream reader = streamOwner.getReader();
+        uint32_t hash = (reader.GetDataSize() > 0) ? (uint32_t)crcFast(reader.GetInternalPointer(), (int)reader.GetDataSize()) : 0;
+        _inputs.SCOs[key] = hash;
         CSCOFile scoFile;
-        if (scoFile.Load(streamOwner.getReader(), _tables.Selectors()))
+        if (scoFile.Load(reader, _tables.Selectors()))
         {
             _scos[scoFile.GetScriptNumber()] = scoFile;
         }
@@ -131,6 +136,10 @@ void CompileContext::_LoadSCO(const std::string &name, bool fErrorIfNotFound)
         FormatMessage(FORMAT_MESSAGE_FROM_SYSTEM, 0, GetLastError(), 0, szError, ARRAYSIZE(szError), nullptr);
         ReportError(_pErrorScript, "Unable to open '%s': %s", scoFileName.c_str(), szError);
     }
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        _inputs.SCOs[key] = 0;
+    }
 }
 
 // Loads an SCOFile if we don't already have one for this script.
@@ -227,15 +236,28 @@ WORD CompileContext::LookupSelectorAndAdd(const string &str)
         // We can just keep on adding to the selectors list (lots of room)
         w = _tables.Selectors().Add(str);
     }
+    _inputs.Selectors[str] = w;
     return w;
 }
 bool CompileContext::LookupSelector(const string &str, WORD &wIndex)
 {
-    return _tables.Selectors().ReverseLookup(str, wIndex);
+    bool found = _tables.Selectors().ReverseLookup(str, wIndex);
+    _inputs.Selectors[str] = found ? wIndex : CompileInputs::NotFound;
+    return found;
 }
 void CompileContext::DefineNewSelector(const std::string &str, WORD &wIndex)
 {
     wIndex = _tables.Selectors().Add(str);
+    _inputs.Selectors[str] = wIndex;
+}
+bool CompileContext::_GetSpeciesLocation(SpeciesIndex wSpeciesIndex, WORD &wScript, WORD &wClassIndexInScript)
+{
+    bool found = _tables.Species().GetSpeciesLocation(wSpeciesIndex, wScript, wClassIndexInScript);
+    if (found)
+    {
+        _inputs.Species[wSpeciesIndex] = ((uint32_t)wScript << 16) | wClassIndexInScript;
+    }
+    return found;
 }
 bool CompileContext::LookupDefine(const std::string &str, WORD &wValue)
 {
@@ -430,7 +452,9 @@ bool CompileContext::LookupSpeciesIndex(const string &str, SpeciesIndex &wSpecie
 }
 bool CompileContext::IsDefaultSelector(uint16_t value)
 {
-    return _tables.Selectors().IsDefaultSelector(value);
+    bool isDefault = _tables.Selectors().IsDefaultSelector(value);
+    _inputs.DefaultSelectors[value] = isDefault ? 1 : 0;
+    return isDefault;
 }
 bool CompileContext::LookupTypeSpeciesIndex(const string &str, SpeciesIndex &wSpeciesIndex)
 {
@@ -462,7 +486,7 @@ std::string CompileContext::SpeciesIndexToDataTypeString(SpeciesIndex wSpeciesIn
     {
         // Nope, not one of the built-in types.
         WORD wScript, wClassIndexInScript;
-        if (_tables.Species().GetSpeciesLocation(wSpeciesIndex, wScript, wClassIndexInScript))
+        if (_GetSpeciesLocation(wSpeciesIndex, wScript, wClassIndexInScript))
         {
             _LoadSCOIfNone(wScript);
             CSCOFile &scoFile = _scos[wScript];
@@ -543,7 +567,7 @@ vector<species_property> CompileContext::GetSpeciesProperties(const string &spec
         for (int i = 0; i < commonPropsCount; i++)
         {
             WORD wSelector = 0;
-            _tables.Selectors().ReverseLookup(commonProps[i], wSelector);
+            LookupSelector(commonProps[i], wSelector);
             species_property commonProp = { wSelector, 0, commonPropsTypes[i], false };
             propertiesRet.push_back(commonProp);
         }
@@ -588,7 +612,9 @@ ProcedureType CompileContext::LookupProc(const string &str, WORD &wScript, WORD
 {
     ProcedureType type = ProcedureUnknown;
     // First try kernel.
-    if (_tables.Kernels().ReverseLookup(str, wIndex))
+    bool isKernel = _tables.Kernels().ReverseLookup(str, wIndex);
+    _inputs.Kernels[str] = isKernel ? wIndex : CompileInputs::NotFound;
+    if (isKernel)
     {
         type = ProcedureKernel;
     }
@@ -668,7 +694,7 @@ bool CompileContext::_GetSCOObject(SpeciesIndex wSpecies, CSCOObjectClass &scoOb
     if (!IsPODType(wSpecies))
     {
         WORD wScript, wClassIndexInScript;
-        if (_tables.Species().GetSpeciesLocation(wSpecies, wScript, wClassIndexInScript))
+        if (_GetSpeciesLocation(wSpecies, wScript, wClassIndexInScript))
         {
             _LoadSCOIfNone(wScript);
             CSCOFile &scoFile = _scos[wScript];
@@ -742,12 +768,14 @@ bool CompileContext::SupportTypeChecking()
 bool CompileContext::LookupWord(const string &word, WORD &wWordGroup)
 {
     Vocab000::WordGroup group;
+    _inputs.UsesVocab = true;
     bool fRet = _tables.Vocab()->LookupWord(word, group);
     wWordGroup = (WORD)group;
     return fRet;
 }
 bool CompileContext::LookupWordGroupClass(uint16_t group, WordClass *wordClass)
 {
+    _inputs.UsesVocab = true;
     return _tables.Vocab()->GetGroupClass(group, wordClass);
 }
 sci::Script *CompileContext::SetErrorContext(sci::Script *pScript)
@@ -1054,7 +1082,9 @@ WORD CompileContext::EnsureSpeciesTableEntry(WORD wIndexInScript)
 {
     // This won't work unless we have a valid script number
     assert(_wScriptNumber != InvalidResourceNumber);
-    return _tables.Species().MaybeAddSpeciesIndex(_wScriptNumber, wIndexInScript);
+    WORD wSpecies = _tables.Species().MaybeAddSpeciesIndex(_wScriptNumber, wIndexInScript);
+    _inputs.Species[wSpecies] = ((uint32_t)_wScriptNumber << 16) | wIndexInScript;
+    return wSpecies;
 }
 void CompileContext::LoadIncludes()
 {
@@ -1100,9 +1130,11 @@ CSCOFile &CompileContext::GetScriptSCO()
     assert(_wScriptNumber != InvalidResourceNumber);
     return _scos[_wScriptNumber];
 }
-std::string CompileContext::LookupSelectorName(WORD wIndex) const
+std::string CompileContext::LookupSelectorName(WORD wIndex)
 {
-    return _tables.Selectors().Lookup(wIndex);
+    std::string name = _tables.Selectors().Lookup(wIndex);
+    _inputs.SelectorNames[wIndex] = name;
+    return name;
 }
 vector<uint16_t> CompileContext::GetRelocations()
 {
@@ -1133,7 +1165,10 @@ std::vector<std::string> &GetDefaultHeaders(Script &script)
     return g_defaultSCIStudioHeaders; // empty
 }
 
-PrecompiledHeaders::~PrecompiledHeaders() {}
+PrecompiledHeaders::~PrecompiledHeaders()
+{
+    _resourceMap.GetHeaderCache().Save();
+}
 
 void PrecompiledHeaders::Update(CompileContext &context, Script &script)
 {
@@ -1164,15 +1199,12 @@ void PrecompiledHeaders::Update(CompileContext &context, Script &script)
                 auto encounteredIt = nonHeadersEncountered.find(*curHeaderIt);
                 if (encounteredIt == nonHeadersEncountered.end())
                 {
-                    // It's a header we have not yet encountered. Parse it.
+                    // It's a header we have not yet encountered. Parse it (or get it from the cache).
                     ScriptId scriptId(_resourceMap.GetIncludePath(*curHeaderIt));
-                    CCrystalTextBuffer buffer;
-                    if (buffer.LoadFromFile(scriptId.GetFullPath().c_str()))
+                    unique_ptr<Script> pNewHeader;
+                    if (_resourceMap.GetHeaderCache().Load(scriptId.GetFullPath(), context.GetVersion(), &context, pNewHeader))
                     {
-                        CScriptStreamLimiter limiter(&buffer);
-                        CCrystalScriptStream stream(&limiter);
-                        unique_ptr<Script> pNewHeader = std::make_unique<Script>(scriptId);
-                        if (SyntaxParser_Parse(*pNewHeader, stream, PreProcessorDefinesFromSCIVersion(context.GetVersion()), &context))
+                        if (pNewHeader)
                         {
                             if (pNewHeader->IsHeader())
                             {
@@ -1194,7 +1226,6 @@ void PrecompiledHeaders::Update(CompileContext &context, Script &script)
                             ss << "Parsing errors while loading " << scriptId.GetFullPath() << ".";
                             context.ReportResult(CompileResult(ss.str(), CompileResult::CRT_Error));
                         }
-                        buffer.FreeAll();
                     }
                     else
                     {
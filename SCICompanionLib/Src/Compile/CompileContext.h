@@ -92,6 +92,9 @@ public:
     void Update(CompileContext &context, sci::Script &script);
 
     bool LookupDefine(const std::string &str, WORD &wValue);
+
+    // The names of all the headers the last script included (directly or not).
+    const std::set<std::string> &GetCurrentHeaders() const { return _curHeaderList; }
 private:
     typedef std::unordered_map<std::string, sci::Define*> defines_map;
     typedef std::unordered_map<std::string, std::unique_ptr<sci::Script>> header_map;
@@ -130,6 +133,43 @@ struct CompileStats
     int Saids;
 };
 
+// Time spent (in seconds) in each phase of compiling a script.
+struct CompileTimings
+{
+    CompileTimings() : Parse(0), Prescan(0), CodeGen(0), Write(0) {}
+
+    CompileTimings &operator+=(const CompileTimings &other)
+    {
+        Parse += other.Parse;
+        Prescan += other.Prescan;
+        CodeGen += other.CodeGen;
+        Write += other.Write;
+        return *this;
+    }
+
+    double Parse;       // Loading and parsing the source
+    double Prescan;     // Includes, defines and prescan
+    double CodeGen;     // Everything else in GenerateScriptResource
+    double Write;       // Saving the .scr/.hep resources and the .sco/.scd files
+};
+
+// What a script's compile looked up besides its own source and headers. The build graph uses
+// this to tell whether the script needs to be recompiled.
+struct CompileInputs
+{
+    CompileInputs() : UsesVocab(false) {}
+
+    static const uint16_t NotFound = 0xffff;
+
+    std::map<std::string, uint32_t> SCOs;       // Script title (lower case) to the crc of its .sco file (0 if missing)
+    std::map<std::string, uint16_t> Selectors;  // Name to selector number, or NotFound
+    std::map<uint16_t, std::string> SelectorNames;  // Selector number to its name
+    std::map<uint16_t, uint8_t> DefaultSelectors;   // Selector number to whether it's one of the default selectors
+    std::map<std::string, uint16_t> Kernels;    // Name to kernel number, or NotFound
+    std::map<uint16_t, uint32_t> Species;       // Species to its location: (script << 16) | index in script
+    bool UsesVocab;                             // For said strings and word group classes
+};
+
 class CompileContext : public ICompileLog, public ILookupDefine, public ITrackCodeSink, public ILookupSaids
 {
 public:
@@ -201,6 +241,7 @@ private:
     typedef std::unordered_map<WORD, CSCOFile> WordSCOMap;
     WordSCOMap _scos;
     std::unordered_map<WORD, std::string> _numberToNameMap;
+    CompileInputs _inputs;
     std::vector<CSCOObjectClass> _instances;
     WORD _wScriptNumber;
     ICompileLog &_results;
@@ -264,6 +305,7 @@ public:
     ProcedureType LookupProc(const std::string &str, WORD &wScript, WORD &wIndex, std::string &classOwner);
     ProcedureType LookupProc(const std::string &str);
     bool _GetSCOObject(SpeciesIndex wSpecies, CSCOObjectClass &scoObject);
+    bool _GetSpeciesLocation(SpeciesIndex wSpeciesIndex, WORD &wScript, WORD &wClassIndexInScript);
     bool LookupSpeciesMethodOrProperty(SpeciesIndex wCallee, WORD wSelector, SpeciesIndex &propertyType, bool &fMethod);
     void PushOutputContext(OutputContext outputContext);
     void PopOutputContext();
@@ -337,7 +379,8 @@ public:
     void AddSCOPublics(CSCOPublicExport scoPublic);
     std::vector<CSCOObjectClass> &GetInstanceSCOs();
     CSCOFile &GetScriptSCO();
-    std::string LookupSelectorName(WORD wIndex) const;
+    const CompileInputs &GetInputs() const { return _inputs; }
+    std::string LookupSelectorName(WORD wIndex);
     std::vector<WORD> GetRelocations();
 
 private:
@@ -517,6 +560,8 @@ public:
     TextComponent &GetTextComponent();
     void SetAutoTextNumber(uint16_t autoTextNumber);
     CompileStats Stats;
+    CompileTimings Timings;
+    CompileInputs Inputs;
 
 private:
     std::vector<uint8_t> _outputScr;
@@ -557,6 +602,8 @@ private:
 bool GenerateScriptResource(SCIVersion version, sci::Script &script, PrecompiledHeaders &headers, CompileTables &tables, CompileResults &results, bool generateDebugInfo);
 void ErrorHelper(CompileContext &context, const ISourceCodePosition *pPos, const std::string &text, const std::string &identifier, bool checkUse = true);
 bool NewCompileScript(CompileResults &results, CompileLog &log, CompileTables &tables, PrecompiledHeaders &headers, ScriptId &script);
+std::unique_ptr<sci::Script> ParseScriptForCompile(CompileLog &log, ScriptId &script);
+bool GenerateParsedScript(CompileResults &results, CompileLog &log, CompileTables &tables, PrecompiledHeaders &headers, ScriptId &script, sci::Script &parsedScript);
 std::unique_ptr<sci::Script> SimpleCompile(CompileLog &log, ScriptId &scriptId, bool addCommentsToOM = false);
 void MergeScripts(sci::Script &mainScript, sci::Script &scriptToBeMerged);
 void ParseSaidString(CompileContext *contextOpt, ILookupSaids &context, const std::string &stringCode, std::vector<uint8_t> *output, const ISourceCodePosition *pos, std::vector<std::string> *wordsOptional = nullptr);
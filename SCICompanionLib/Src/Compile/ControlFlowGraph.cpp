@@ -395,7 +395,32 @@ bool IsNotAllowedAsPredecessor(code_pos pos)
     return pos->get_opcode() == Opcode::JMP || pos->get_opcode() == Opcode::RET;
 }
 
-int debugIndex = 1;
+const size_t NodeArenaBlockSize = 16 * 1024;
+
+ControlFlowNodeArena::~ControlFlowNodeArena()
+{
+    for (auto it = _nodes.rbegin(); it != _nodes.rend(); ++it)
+    {
+        (*it)->~ControlFlowNode();
+    }
+}
+
+void *ControlFlowNodeArena::_Allocate(size_t size, size_t alignment)
+{
+    size_t padding = (alignment - (reinterpret_cast<uintptr_t>(_current) % alignment)) % alignment;
+    if (!_current || ((padding + size) > _remaining))
+    {
+        assert(size <= NodeArenaBlockSize);
+        _blocks.push_back(std::make_unique<uint8_t[]>(NodeArenaBlockSize));
+        _current = _blocks.back().get();
+        _remaining = NodeArenaBlockSize;
+        padding = (alignment - (reinterpret_cast<uintptr_t>(_current) % alignment)) % alignment;
+    }
+    void *memory = _current + padding;
+    _current += padding + size;
+    _remaining -= padding + size;
+    return memory;
+}
 
 ControlFlowNode *_GetFirstPredecessorOrNull(ControlFlowNode *node)
 {
@@ -440,7 +465,7 @@ void ControlFlowGraph::_IdentifySwitchCases(ControlFlowNode *switchNodeIn)
     // Now we need to find the case tails and collect the nodes between head/tail. Then create the case nodes
     // We can look at the toss predecessors and see which ones are dominated by which cases.
     // Nope, that is actually not sufficient. The first case node dominate ALL toss preds.
-    DominatorMap dominators = GenerateDominators(switchNodeIn, switchHead);
+    DominatorMap dominators = _GenerateDominators(switchNodeIn, switchHead);
     NodeSet caseNodes;
     for (ControlFlowNode *caseHead : caseHeads)
     {
@@ -605,8 +630,7 @@ void CollectMoreChildren(ControlFlowNode *structure, const DominatorMap &dominat
         ControlFlowNode *node = pop_ptr(toProcess);
         for (ControlFlowNode *pred : node->Predecessors())
         {
-            const NodeSet &predDoms = dominators.at(pred);
-            if ((pred != head) && (predDoms.contains(head)))
+            if ((pred != head) && dominators.IsADominatedByB(pred, head))
             {
                 // It's a predecessor that's dominated by the structure header. It's definitely
                 // one of its children. Avoid needless processing by only adding it if it's not already
@@ -635,7 +659,7 @@ ControlFlowNode *ControlFlowGraph::_ProcessNaturalLoop(ControlFlowGraph &loopDet
     // Now let's collect more children. Any predecessors of the child who are dominated by our header node should be included.
     // This will collect things like breaks, etc... that were not collected when we went from the latch node to the header to
     // collect children.
-    DominatorMap dominators = GenerateDominators(parent, (*parent)[SemId::Head]);
+    DominatorMap dominators = loopDetection._GenerateDominators(parent, (*parent)[SemId::Head]);
     CollectMoreChildren(loopNode, dominators);
 
     loopDetection._ReplaceNodeInWorkingSet(parent, loopNode);
@@ -682,11 +706,10 @@ vector<NodeBlock> ControlFlowGraph::_FindSwitchBlocks(DominatorMap &dominators,
         // In SCI, switches finish with a TOSS instruction, so let's specifically look for that.
         if (maybeToss->startsWith(Opcode::TOSS))
         {
-            auto &tossDominators = dominators.at(maybeToss);
             ControlFlowNode *pred = _GetFirstPredecessorOrNull(maybeToss);
             while (pred)
             {
-                if (tossDominators.contains(pred))
+                if (dominators.IsADominatedByB(maybeToss, pred))
                 {
                     // We found it. This pred node dominates the toss. Assert that there's DUP instruction in here.
                     // If we find that in some cases there isn't, we'll need to adjust our algorithm.
@@ -1227,9 +1250,8 @@ vector<NodeBlock> _FindBackEdges(DominatorMap &dominators, DominatorMap &postDom
     {
         for (ControlFlowNode *pred : node->Predecessors())
         {
-            auto &predsDoms = dominators.at(pred);
             // Does node dominate its predecessor? If so, pred -> node is a back edge
-            if (predsDoms.contains(node))
+            if (dominators.IsADominatedByB(pred, node))
             {
                 backEdges.emplace_back(node, pred, true, structure);
             }
@@ -1354,8 +1376,7 @@ ControlFlowNode *_FindMaxNodeDominatedByMWithTwoOrMoreInEdges(DominatorMap &domi
         ControlFlowNode *possibleFollow = *it;
         if (possibleFollow->Predecessors().size() >= 2)
         {
-            NodeSet &dominatorsForNode = dominators.at(possibleFollow);
-            if (dominatorsForNode.contains(m))
+            if (dominators.IsADominatedByB(possibleFollow, m))
             {
                 if (immediateDominators.at(possibleFollow) == m)
                 {
@@ -1378,7 +1399,7 @@ void ControlFlowGraph::_FindAllIfStatements()
     // We discover structures from the most inner to the most outer (in this particular call of the function)
     for (ControlFlowNode *structure : controlStructuresCopy)
     {
-        DominatorMap dominators = GenerateDominators(structure, (*structure)[SemId::Head]);
+        DominatorMap dominators = _GenerateDominators(structure, (*structure)[SemId::Head]);
         _FindIfStatements(dominators, structure);
         if (_decompilerResults.IsAborted())
         {
@@ -1831,6 +1852,29 @@ bool _DoNothing(ControlFlowGraph &cfg, ControlFlowNode &parent, vector<NodeBlock
     return true;
 }
 
+// These let the results know whenever the dominators for a structure are actually recalculated.
+DominatorMap ControlFlowGraph::_GenerateDominators(ControlFlowNode *parent, ControlFlowNode *n0)
+{
+    bool recalculate = parent->dirty;
+    DominatorMap dominators = GenerateDominators(parent, n0);
+    if (recalculate)
+    {
+        _decompilerResults.InformDominators(parent->Children(), n0, NoJmpPreds, dominators);
+    }
+    return dominators;
+}
+
+DominatorMap ControlFlowGraph::_GeneratePostDominators(ControlFlowNode *parent, ControlFlowNode *n0)
+{
+    bool recalculate = parent->postDirty;
+    DominatorMap postDominators = GeneratePostDominators(parent, n0);
+    if (recalculate)
+    {
+        _decompilerResults.InformDominators(parent->Children(), n0, [](ControlFlowNode *node) { return node->Successors(); }, postDominators);
+    }
+    return postDominators;
+}
+
 bool ControlFlowGraph::Generate(code_pos start, code_pos end)
 {
     try
@@ -1847,7 +1891,7 @@ bool ControlFlowGraph::Generate(code_pos start, code_pos end)
         // so maybe it causes no problems). The nodes being pruned really have no chance of affecting code.
         _PruneDegenerateNodes(main);
 
-        DominatorMap dominators = GenerateDominators(main, (*main)[SemId::Head]);
+        DominatorMap dominators = _GenerateDominators(main, (*main)[SemId::Head]);
 
         if (showFile)
         {
@@ -26,6 +26,35 @@ struct NodeBlock
     NodeSet body;
 };
 
+// Owns the nodes of a single ControlFlowGraph. They're carved out of large blocks instead of being allocated
+// one by one, and are all destroyed together with the graph.
+class ControlFlowNodeArena
+{
+public:
+    ControlFlowNodeArena() : _current(nullptr), _remaining(0) {}
+    ControlFlowNodeArena(const ControlFlowNodeArena &src) = delete;
+    ControlFlowNodeArena& operator=(const ControlFlowNodeArena &src) = delete;
+    ~ControlFlowNodeArena();
+
+    template<typename _TNode, typename... Args>
+    _TNode *Create(Args... args)
+    {
+        _TNode *node = new (_Allocate(sizeof(_TNode), alignof(_TNode))) _TNode(args...);
+        _nodes.push_back(node);
+        return node;
+    }
+
+    size_t GetNodeCount() const { return _nodes.size(); }
+
+private:
+    void *_Allocate(size_t size, size_t alignment);
+
+    std::vector<std::unique_ptr<uint8_t[]>> _blocks;
+    std::vector<ControlFlowNode*> _nodes;
+    uint8_t *_current;
+    size_t _remaining;
+};
+
 class ControlFlowGraph
 {
 public:
@@ -41,10 +70,7 @@ public:
     template<typename _TNode, typename... Args>
     _TNode *MakeStructuredNode(Args... args)
     {
-        unique_ptr<_TNode> newNode = std::make_unique<_TNode>(args...);
-        _TNode *ret = newNode.get();
-        nodesOwner.push_back(move(newNode));
-        ret->ArbitraryDebugIndex = debugIndex++;
+        _TNode *ret = MakeNode<_TNode>(args...);
         discoveredControlStructures.insert(ret);
         return ret;
     }
@@ -52,16 +78,16 @@ public:
     template<typename _TNode, typename... Args>
     _TNode *MakeNode(Args... args)
     {
-        unique_ptr<_TNode> newNode = std::make_unique<_TNode>(args...);
-        _TNode *ret = newNode.get();
-        nodesOwner.push_back(move(newNode));
-        ret->ArbitraryDebugIndex = debugIndex++;
+        _TNode *ret = nodesOwner.Create<_TNode>(args...);
+        ret->ArbitraryDebugIndex = (int)nodesOwner.GetNodeCount();
         return ret;
     }
 
 
 private:
     void _ThrowIfAborted();
+    DominatorMap _GenerateDominators(ControlFlowNode *parent, ControlFlowNode *n0);
+    DominatorMap _GeneratePostDominators(ControlFlowNode *parent, ControlFlowNode *n0);
     ControlFlowNode *_EnsureExitNode(NodeSet &existingExitNodes, ControlFlowNode *exitNodePredecessor, ControlFlowNode *exitNodeSuccessor);
     ControlFlowNode *_ReplaceIfStatementInWorkingSet(ControlFlowNode *structure, ControlFlowNode *ifHeader, ControlFlowNode *ifFollowNode);
     void _ReplaceNodeInFollowNodes(ControlFlowNode *newNode);
@@ -99,9 +125,9 @@ private:
             do
             {
                 // 1) calculate dominators
-                DominatorMap dominators = GenerateDominators(structure, (*structure)[SemId::Head]);
+                DominatorMap dominators = _GenerateDominators(structure, (*structure)[SemId::Head]);
                 assert(structure->MaybeGet(SemId::Tail));
-                DominatorMap postDominators = GeneratePostDominators(structure, (*structure)[SemId::Tail]);
+                DominatorMap postDominators = _GeneratePostDominators(structure, (*structure)[SemId::Tail]);
 
                 // 2) Find the head/tail of the constructs we're looking for (e.g. for switch: toss nodes, and follow them back to a dominator, bounding the switch statement).
                 blocks = findBlocks(dominators, postDominators, structure);
@@ -149,7 +175,7 @@ private:
     }
 
 
-    std::vector<std::unique_ptr<ControlFlowNode>> nodesOwner;
+    ControlFlowNodeArena nodesOwner;
 
     NodeSet discoveredControlStructures;
     ControlFlowNode *mainStructure;
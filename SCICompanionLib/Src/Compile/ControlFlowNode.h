@@ -92,10 +92,11 @@ namespace std
 // Using a sorted vector (instead of a set) provides about a 10x speed up in our scenario.
 // It comes with a few disadvantages, like iterators are invalidated when items are added/removed
 // (which may be a good thing). It's possible we still have bugs regarding this.
+// Most sets (predecessors and successors in particular) only have a few nodes, so those are stored inline.
 #define USE_VECTOR_NODESET 1
 
 #ifdef USE_VECTOR_NODESET
-struct NodeSet : public sorted_vector<ControlFlowNode*>
+struct NodeSet : public sorted_vector<ControlFlowNode*, std::less<ControlFlowNode*>, small_vector<ControlFlowNode*, 4>>
 {
     bool contains(ControlFlowNode* node) const
     {
@@ -394,13 +395,36 @@ bool MaybeGetThenAndElseBranches(ControlFlowNode *node, ControlFlowNode **thenNo
 ControlFlowNode *GetOtherBranch(ControlFlowNode *branchNode, ControlFlowNode *branch1);
 bool IsThenBranch(ControlFlowNode *branchNode, ControlFlowNode *target);
 
-class DominatorMap : public std::map < ControlFlowNode*, NodeSet >
+//
+// The dominators (or post-dominators) of a set of nodes, stored as a tree of immediate dominators over
+// a dense numbering of the nodes. Dominance queries are constant time, using the tree's pre and post order.
+// Nodes other than the entry that have no incoming edges (or have incoming edges from outside the set) are
+// treated as additional entries, so they're dominated only by themselves.
+//
+class DominatorMap
 {
 public:
-    bool IsADominatedByB(ControlFlowNode *a, ControlFlowNode *b) const
-    {
-        return at(a).contains(b);
-    }
+    // edgesIn returns the predecessors of a node (or the successors, for post-dominators).
+    DominatorMap(const NodeSet &nodes, ControlFlowNode *entry, const std::function<NodeSet(ControlFlowNode*)> &edgesIn);
+
+    // Whether b dominates a. Every node dominates itself. Throws std::out_of_range if a is unknown.
+    bool IsADominatedByB(ControlFlowNode *a, ControlFlowNode *b) const;
+
+    // False if anything besides the entry node has no immediate dominator.
+    bool HasSingleEntry() const;
+    ControlFlowNode *GetEntry() const { return _nodes[0]; }
+    std::map<ControlFlowNode*, ControlFlowNode*> GetImmediateDominators() const;
+
+private:
+    int _GetIndex(ControlFlowNode *node) const;
+
+    std::unordered_map<ControlFlowNode*, int> _indices;
+    std::vector<ControlFlowNode*> _nodes;   // The entry first, then the other nodes, then outside predecessors
+    size_t _nodeCount;                      // Not including outside predecessors
+    std::vector<int> _idom;                 // -1 for entries, and for nodes that can't be reached from any entry
+    std::vector<int> _preOrder;             // Position in the dominator tree, or -1 if not in it
+    std::vector<int> _postOrder;
+    bool _singleEntry;
 };
 
 ControlFlowNode *GetFirstSuccessorOrNull(ControlFlowNode *node);
\ No newline at end of file
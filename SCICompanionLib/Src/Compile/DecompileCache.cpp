@@ -0,0 +1,351 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "DecompileCache.h"
+#include "DecompileScript.h"
+#include "DecompilerConfig.h"
+#include "CompiledScript.h"
+#include "GameFolderHelper.h"
+#include "ResourceBlob.h"
+#include "SCO.h"
+#include "Vocab99x.h"
+#include "crc.h"
+
+using namespace std;
+
+const uint32_t DecompileCacheSignature = (('S' << 24) + ('C' << 16) + ('D' << 8) + 'C');
+// Bump this when a change to the decompiler changes what it generates.
+const uint16_t DecompileCacheVersion = 1;
+
+namespace
+{
+    template<typename _TKey, typename _TValue>
+    void _WriteMap(sci::ostream &out, const std::map<_TKey, _TValue> &map)
+    {
+        out << (uint32_t)map.size();
+        for (const auto &pair : map)
+        {
+            out << pair.first;
+            out << pair.second;
+        }
+    }
+
+    template<typename _TKey, typename _TValue>
+    void _ReadMap(sci::istream &reader, std::map<_TKey, _TValue> &map)
+    {
+        uint32_t count;
+        reader >> count;
+        for (uint32_t i = 0; reader.good() && (i < count); i++)
+        {
+            _TKey key;
+            _TValue value;
+            reader >> key;
+            reader >> value;
+            map[key] = value;
+        }
+    }
+
+    uint32_t _HashBlob(const ResourceBlob *blob)
+    {
+        // 0 means the resource is missing or empty.
+        return (blob && blob->GetLength()) ? (uint32_t)crcFast(blob->GetData(), (int)blob->GetLength()) : 0;
+    }
+
+    uint32_t _HashFile(const std::string &fullPath)
+    {
+        uint32_t hash = 0;
+        std::ifstream file(fullPath, std::ios::binary);
+        if (file.is_open())
+        {
+            std::vector<uint8_t> contents;
+            contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            hash = contents.empty() ? 0 : (uint32_t)crcFast(&contents[0], (int)contents.size());
+        }
+        return hash;
+    }
+}
+
+DecompileCache::DecompileCache() : _config(nullptr), _environmentHash(0), _dirty(false) {}
+
+void DecompileCache::SetFilename(const std::string &filename)
+{
+    if (_filename != filename)
+    {
+        _filename = filename;
+        _entries.clear();
+        _dirty = false;
+        if (!_filename.empty())
+        {
+            _Load(_filename);
+        }
+    }
+}
+
+void DecompileCache::_Load(const std::string &filename)
+{
+    if (!PathFileExists(filename.c_str()))
+    {
+        return;
+    }
+    try
+    {
+        ScopedFile scoped(filename, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING);
+        sci::streamOwner owner(scoped.hFile);
+        sci::istream reader = owner.getReader();
+
+        uint32_t signature, count;
+        uint16_t version;
+        reader >> signature;
+        reader >> version;
+        reader >> count;
+        if (reader.good() && (signature == DecompileCacheSignature) && (version == DecompileCacheVersion))
+        {
+            for (uint32_t i = 0; reader.good() && (i < count); i++)
+            {
+                uint16_t scriptNumber;
+                Entry entry;
+                reader >> scriptNumber;
+                reader >> entry.EnvironmentHash;
+                reader >> entry.ResourceHash;
+                _ReadMap(reader, entry.SCOs);
+                _ReadMap(reader, entry.ConfigEntries);
+
+                uint32_t size;
+                reader >> entry.Output.Source;
+                reader >> size;
+                entry.Output.SCO.resize(min(size, reader.GetDataSize() - reader.tellg()));
+                if (!entry.Output.SCO.empty())
+                {
+                    reader.read_data(&entry.Output.SCO[0], (uint32_t)entry.Output.SCO.size());
+                }
+                reader >> size;
+                for (uint32_t j = 0; reader.good() && (j < size); j++)
+                {
+                    pair<string, string> rename;
+                    reader >> rename.first;
+                    reader >> rename.second;
+                    entry.Output.MainRenames.push_back(rename);
+                }
+                reader >> size;
+                for (uint32_t j = 0; reader.good() && (j < size); j++)
+                {
+                    uint8_t type;
+                    string message;
+                    reader >> type;
+                    reader >> message;
+                    entry.Output.Messages.emplace_back((DecompilerResultType)type, message);
+                }
+                reader >> size;
+                for (uint32_t j = 0; reader.good() && (j < size); j++)
+                {
+                    uint8_t successful;
+                    uint32_t byteCount;
+                    reader >> successful;
+                    reader >> byteCount;
+                    entry.Output.FunctionStats.emplace_back(successful != 0, (int)byteCount);
+                }
+
+                if (reader.good())
+                {
+                    _entries[scriptNumber] = move(entry);
+                }
+            }
+        }
+    }
+    catch (std::exception)
+    {
+        // Then everything will just be decompiled again.
+        _entries.clear();
+    }
+}
+
+void DecompileCache::Save()
+{
+    if (!_dirty || _filename.empty())
+    {
+        return;
+    }
+
+    sci::ostream out;
+    out << DecompileCacheSignature;
+    out << DecompileCacheVersion;
+    out << (uint32_t)_entries.size();
+    for (const auto &pair : _entries)
+    {
+        const Entry &entry = pair.second;
+        out << pair.first;
+        out << entry.EnvironmentHash;
+        out << entry.ResourceHash;
+        _WriteMap(out, entry.SCOs);
+        _WriteMap(out, entry.ConfigEntries);
+
+        out << entry.Output.Source;
+        out << (uint32_t)entry.Output.SCO.size();
+        if (!entry.Output.SCO.empty())
+        {
+            out.WriteBytes(&entry.Output.SCO[0], (int)entry.Output.SCO.size());
+        }
+        out << (uint32_t)entry.Output.MainRenames.size();
+        for (const auto &rename : entry.Output.MainRenames)
+        {
+            out << rename.first;
+            out << rename.second;
+        }
+        out << (uint32_t)entry.Output.Messages.size();
+        for (const auto &message : entry.Output.Messages)
+        {
+            out << (uint8_t)message.first;
+            out << message.second;
+        }
+        out << (uint32_t)entry.Output.FunctionStats.size();
+        for (const auto &stat : entry.Output.FunctionStats)
+        {
+            out << (uint8_t)(stat.first ? 1 : 0);
+            out << (uint32_t)stat.second;
+        }
+    }
+
+    try
+    {
+        string folder = _filename.substr(0, _filename.find_last_of('\\'));
+        if (EnsureFolderExists(folder, false))
+        {
+            ScopedFile scoped(_filename, GENERIC_WRITE, 0, CREATE_ALWAYS);
+            scoped.Write(out.GetInternalPointer(), out.GetDataSize());
+            _dirty = false;
+        }
+    }
+    catch (std::exception)
+    {
+        // The cache is just an optimization. If we can't write it, things will be decompiled again next time.
+    }
+}
+
+// The things every script's decompile depends on.
+uint32_t DecompileCache::_HashEnvironment(const GameFolderHelper &helper, GlobalCompiledScriptLookups &lookups, bool decompileAsm, bool substituteTextTuples)
+{
+    const SCIVersion &version = helper.Version;
+    sci::ostream out;
+    out << DecompileCacheVersion;
+    out << (uint8_t)version.MapFormat;
+    out << (uint8_t)version.PackageFormat;
+    out << (uint8_t)version.lofsaOpcodeIsAbsolute;
+    out << (uint8_t)version.SeparateHeapResources;
+    out << (uint8_t)version.HasOldSCI0ScriptHeader;
+    out << (uint8_t)version.HasSaidVocab;
+    out << (uint8_t)version.Kernels;
+    out << (uint8_t)version.IsExportWide;
+    out << (uint8_t)version.IsZeroExportValid;
+    out << version.MainVocabResource;
+    out << (uint8_t)helper.GetDefaultGameLanguage();
+    out << (uint8_t)decompileAsm;
+    out << (uint8_t)substituteTextTuples;
+
+    // Said strings come from the main vocab, and script names (and so .sco filenames) from game.ini.
+    out << _HashBlob(helper.MostRecentResource(ResourceType::Vocab, version.MainVocabResource, ResourceEnumFlags::None).get());
+    out << _HashBlob(helper.MostRecentResource(ResourceType::Vocab, VocabKernelNames, ResourceEnumFlags::None).get());
+    out << _HashFile(helper.GetGameIniFileName());
+    for (const string &name : lookups.GetSelectorTable().GetNames())
+    {
+        out << name;
+    }
+    // Any script's objects might be the superclass of something, so the class table is made from all of them.
+    for (CompiledScript *script : lookups.GetGlobalClassTable().GetAllScripts())
+    {
+        out << script->GetScriptNumber();
+        out << _HashScriptResources(helper, script->GetScriptNumber());
+    }
+    return (uint32_t)crcFast(out.GetInternalPointer(), (int)out.GetDataSize());
+}
+
+uint32_t DecompileCache::_HashScriptResources(const GameFolderHelper &helper, uint16_t scriptNumber)
+{
+    uint32_t hashes[] =
+    {
+        _HashBlob(helper.MostRecentResource(ResourceType::Script, scriptNumber, ResourceEnumFlags::None).get()),
+        _HashBlob(helper.MostRecentResource(ResourceType::Heap, scriptNumber, ResourceEnumFlags::None).get()),
+        _HashBlob(helper.MostRecentResource(ResourceType::Text, scriptNumber, ResourceEnumFlags::None).get()),
+    };
+    return (uint32_t)crcFast(reinterpret_cast<const uint8_t*>(hashes), (int)sizeof(hashes));
+}
+
+uint32_t DecompileCache::_HashSCO(const GameFolderHelper &helper, uint16_t scriptNumber)
+{
+    string filename = helper.GetScriptObjectFileName(scriptNumber);
+    return filename.empty() ? 0 : _HashFile(filename);
+}
+
+void DecompileCache::Prepare(const GameFolderHelper &helper, GlobalCompiledScriptLookups &lookups, const IDecompilerConfig &config, bool decompileAsm, bool substituteTextTuples)
+{
+    _config = &config;
+    _environmentHash = _HashEnvironment(helper, lookups, decompileAsm, substituteTextTuples);
+}
+
+void DecompileCache::EndBatch()
+{
+    // The config belongs to whoever prepared us, and may not be around for the next batch.
+    _config = nullptr;
+}
+
+bool DecompileCache::Lookup(const GameFolderHelper &helper, uint16_t scriptNumber, Result &result) const
+{
+    auto it = _entries.find(scriptNumber);
+    if (!_config || (it == _entries.end()))
+    {
+        return false;
+    }
+    const Entry &entry = it->second;
+    if ((entry.EnvironmentHash != _environmentHash) || (entry.ResourceHash != _HashScriptResources(helper, scriptNumber)))
+    {
+        return false;
+    }
+    for (const auto &sco : entry.SCOs)
+    {
+        if (sco.second != _HashSCO(helper, sco.first))
+        {
+            return false;
+        }
+    }
+    for (const auto &configEntry : entry.ConfigEntries)
+    {
+        if (configEntry.second != _config->HashEntry(configEntry.first))
+        {
+            return false;
+        }
+    }
+    result = entry.Output;
+    return true;
+}
+
+void DecompileCache::Record(const GameFolderHelper &helper, uint16_t scriptNumber, Result result, const DecompileOutputs &outputs)
+{
+    if (!_config || !outputs.SCO)
+    {
+        return;
+    }
+    Entry entry;
+    entry.EnvironmentHash = _environmentHash;
+    entry.ResourceHash = _HashScriptResources(helper, scriptNumber);
+    for (uint16_t scoScript : outputs.SCOsRead)
+    {
+        entry.SCOs[scoScript] = _HashSCO(helper, scoScript);
+    }
+    entry.ConfigEntries = outputs.ConfigEntriesUsed;
+    entry.Output = move(result);
+    entry.Output.SCO.clear();
+    outputs.SCO->Save(entry.Output.SCO);
+    entry.Output.MainRenames = outputs.MainRenames;
+    _entries[scriptNumber] = move(entry);
+    _dirty = true;
+}
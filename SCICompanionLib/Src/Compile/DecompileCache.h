@@ -0,0 +1,87 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+#include "DecompilerResults.h"
+
+class GameFolderHelper;
+class GlobalCompiledScriptLookups;
+class IDecompilerConfig;
+struct DecompileOutputs;
+
+//
+// Remembers, for each script that decompiled successfully, what came out and what went into it: the hash
+// of its script, heap and text resources, the hashes of the .sco files it read, and the Decompiler.ini
+// entries it consulted. Everything else that every script depends on (version, selectors, class table,
+// vocab, game.ini and the decompile options) is folded into one environment hash.
+// A script whose inputs all match would decompile to the same thing again, so the remembered source and
+// .sco can be used instead.
+// The cache is saved in the game folder.
+//
+class DecompileCache
+{
+public:
+    struct Result
+    {
+        std::string Source;
+        std::vector<uint8_t> SCO;
+        std::vector<std::pair<std::string, std::string>> MainRenames;
+        std::vector<std::pair<DecompilerResultType, std::string>> Messages;  // What the decompile reported, other than updates
+        std::vector<std::pair<bool, int>> FunctionStats;                      // See IDecompilerResults::InformStats
+    };
+
+    DecompileCache();
+
+    // Where the cache is persisted (empty means nowhere). Loads whatever is there.
+    void SetFilename(const std::string &filename);
+
+    // Call before decompiling a set of scripts, with what they'll be decompiled with. config must outlive
+    // any calls to Lookup or Record, up until EndBatch.
+    void Prepare(const GameFolderHelper &helper, GlobalCompiledScriptLookups &lookups, const IDecompilerConfig &config, bool decompileAsm, bool substituteTextTuples);
+
+    // Call once the set of scripts is done. Lookup and Record do nothing until the cache is prepared again.
+    void EndBatch();
+
+    // Returns true, and the result, if the script's inputs are the same as when it was recorded. This may be
+    // called from several threads at once, but not at the same time as Prepare or Record.
+    bool Lookup(const GameFolderHelper &helper, uint16_t scriptNumber, Result &result) const;
+
+    // Call after a script decompiles successfully, before any new .sco files are saved (so we remember the
+    // ones the decompile actually read). The .sco and main renames are taken from outputs.
+    void Record(const GameFolderHelper &helper, uint16_t scriptNumber, Result result, const DecompileOutputs &outputs);
+
+    // Writes the cache to disk, if anything changed.
+    void Save();
+
+private:
+    struct Entry
+    {
+        uint32_t EnvironmentHash;
+        uint32_t ResourceHash;
+        std::map<uint16_t, uint32_t> SCOs;              // Script number to the crc of its .sco
+        std::map<std::string, uint32_t> ConfigEntries;  // See IDecompilerConfig::HashEntry
+        Result Output;
+    };
+
+    void _Load(const std::string &filename);
+    static uint32_t _HashEnvironment(const GameFolderHelper &helper, GlobalCompiledScriptLookups &lookups, bool decompileAsm, bool substituteTextTuples);
+    static uint32_t _HashScriptResources(const GameFolderHelper &helper, uint16_t scriptNumber);
+    static uint32_t _HashSCO(const GameFolderHelper &helper, uint16_t scriptNumber);
+
+    std::string _filename;
+    std::unordered_map<uint16_t, Entry> _entries;
+    const IDecompilerConfig *_config;
+    uint32_t _environmentHash;
+    bool _dirty;
+};
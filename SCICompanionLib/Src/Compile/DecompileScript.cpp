@@ -30,6 +30,15 @@ using namespace std;
 
 const char InvalidLookupError[] = "LOOKUP_ERROR";
 
+DecompileOutputs::DecompileOutputs() {}
+DecompileOutputs::~DecompileOutputs() {}
+
+unique_ptr<CSCOFile> _GetExistingSCO(DecompileLookups &lookups, const GameFolderHelper &helper, uint16_t scriptNumber)
+{
+    lookups.TrackSCORead(scriptNumber);
+    return GetExistingSCOFromScriptNumber(helper, scriptNumber, lookups.GetSelectorTable());
+}
+
 void DecompileObject(const CompiledObject &object,
     sci::Script &script,
     DecompileLookups &lookups,
@@ -305,7 +314,7 @@ private:
     {
         if (_scoMap.find(script) == _scoMap.end())
         {
-            _scoMap[script] = move(GetExistingSCOFromScriptNumber(_helper, script, _lookups.GetSelectorTable()));
+            _scoMap[script] = move(_GetExistingSCO(_lookups, _helper, script));
         }
         return _scoMap.at(script).get();
     }
@@ -320,7 +329,7 @@ private:
 void ResolvePublicProcedureCalls(DecompileLookups &lookups, const GameFolderHelper &helper, Script &script, const CompiledScript &compiledScript)
 {
     unordered_map<int, unique_ptr<CSCOFile>> scoMap;
-    scoMap[script.GetScriptNumber()] = move(GetExistingSCOFromScriptNumber(helper, script.GetScriptNumber(), lookups.GetSelectorTable()));
+    scoMap[script.GetScriptNumber()] = move(_GetExistingSCO(lookups, helper, script.GetScriptNumber()));
 
     // First let's resolve the exports
     CSCOFile *thisSCO = scoMap.at(script.GetScriptNumber()).get();
@@ -373,7 +382,7 @@ private:
     const IDecompilerConfig &_config;
 };
 
-Script *Decompile(const GameFolderHelper &helper, const CompiledScript &compiledScript, DecompileLookups &lookups, const Vocab000 *pWords)
+Script *Decompile(const GameFolderHelper &helper, const CompiledScript &compiledScript, DecompileLookups &lookups, const Vocab000 *pWords, DecompileOutputs *outputs)
 {
     unique_ptr<Script> pScript = std::make_unique<Script>();
     pScript->SyntaxVersion = 2;
@@ -506,9 +515,9 @@ Script *Decompile(const GameFolderHelper &helper, const CompiledScript &compiled
         unique_ptr<CSCOFile> mainSCO;
         if (compiledScript.GetScriptNumber() != 0)
         {
-            mainSCO = GetExistingSCOFromScriptNumber(helper, 0, lookups.GetSelectorTable());
+            mainSCO = _GetExistingSCO(lookups, helper, 0);
         }
-        unique_ptr<CSCOFile> oldScriptSCO = GetExistingSCOFromScriptNumber(helper, compiledScript.GetScriptNumber(), lookups.GetSelectorTable());
+        unique_ptr<CSCOFile> oldScriptSCO = _GetExistingSCO(lookups, helper, compiledScript.GetScriptNumber());
 
         vector<pair<string, string>> mainDirtyRenames;
         AutoDetectVariableNames(*pScript, lookups.GetDecompilerConfig(), mainSCO.get(), oldScriptSCO.get(), mainDirtyRenames);
@@ -536,10 +545,20 @@ Script *Decompile(const GameFolderHelper &helper, const CompiledScript &compiled
         // Decompiling always generates an SCO. Any pertinent info from the old SCO should be transfered
         // to the new one based extracting info from the script.
         std::unique_ptr<CSCOFile> scoFile = SCOFromScriptAndCompiledScript(*pScript, compiledScript);
-        SaveSCOFile(helper, *scoFile);
+        if (outputs)
+        {
+            // The caller will save these.
+            outputs->SCO = move(scoFile);
+            outputs->MainRenames = mainDirtyRenames;
+            outputs->SCOsRead = lookups.GetSCOsRead();
+        }
+        else
+        {
+            SaveSCOFile(helper, *scoFile);
+        }
 
         // We may have added some global info to main's SCO. Save that now.
-        if (!mainDirtyRenames.empty())
+        if (!outputs && !mainDirtyRenames.empty())
         {
             lookups.DecompileResults().AddResult(DecompilerResultType::Important, "Updating global variables in script 0");
             lookups.DecompileResults().SetGlobalVarsUpdated(mainDirtyRenames);
@@ -21,5 +21,24 @@ class CompiledScript;
 class DecompileLookups;
 class ILookupNames;
 class GameFolderHelper;
+class CSCOFile;
 struct Vocab000;
-sci::Script *Decompile(const GameFolderHelper &helper, const CompiledScript &compiledScript, DecompileLookups &lookups, const Vocab000 *pWords);
\ No newline at end of file
+
+// Besides the source, decompiling a script produces a new .sco file for it, and possibly names for
+// global variables that should be saved to main's .sco. If these are requested from Decompile, they're
+// returned here rather than saved, so that a caller decompiling several scripts at once can decide when
+// (and in what order) to write them.
+struct DecompileOutputs
+{
+    DecompileOutputs();
+    ~DecompileOutputs();
+
+    std::unique_ptr<CSCOFile> SCO;
+    std::vector<std::pair<std::string, std::string>> MainRenames;     // e.g. global5 -> gEgo
+
+    // What the result depends on besides the script itself (see DecompileCache).
+    std::set<uint16_t> SCOsRead;
+    std::map<std::string, uint32_t> ConfigEntriesUsed;                // e.g. valueType:gEgo -> hash
+};
+
+sci::Script *Decompile(const GameFolderHelper &helper, const CompiledScript &compiledScript, DecompileLookups &lookups, const Vocab000 *pWords, DecompileOutputs *outputs = nullptr);
\ No newline at end of file
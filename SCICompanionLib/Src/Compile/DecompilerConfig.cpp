@@ -21,6 +21,7 @@
 #include "CrystalScriptStream.h"
 #include "SyntaxParser.h"
 #include "CompileInterfaces.h"
+#include "crc.h"
 #include <regex>
 #include <format.h>
 
@@ -53,8 +54,18 @@ unique_ptr<Script> GetDefinesScript(const GameFolderHelper &helper, const std::s
     return script;
 }
 
+// The kinds of entries that RecordingDecompilerConfig notes, and HashEntry understands.
+const char ParameterNamesEntry[] = "parameterNames";
+const char MethodParameterTypesEntry[] = "methodParameterTypes";
+const char KernelParameterTypesEntry[] = "kernelParameterTypes";
+const char ValueTypeEntry[] = "valueType";
+const char BitfieldPropertyEntry[] = "bitfieldProperty";
+const char TextResourceTupleEntry[] = "textResourceTuple";
+
 class DecompilerConfig : public IDecompilerConfig
 {
+    friend class RecordingDecompilerConfig;
+
 public:
     DecompilerConfig(const GameFolderHelper &helper, const SelectorTable &selectorTable) : _selectorTable(selectorTable)
     {
@@ -161,34 +172,113 @@ public:
         _ResolveValuesHelper(binaryOp.GetStatement2(), { binaryOp.GetStatement1() });
     }
 
-private:
+    uint32_t HashEntry(const std::string &entry) const
+    {
+        size_t colon = entry.find(':');
+        string kind = entry.substr(0, colon);
+        string key = (colon == string::npos) ? "" : entry.substr(colon + 1);
 
-    void _ResolveValuesHelper(SyntaxNode *source, const vector<SyntaxNode*> &destinations) const
+        stringstream description;
+        if (kind == ParameterNamesEntry)
+        {
+            for (const string &name : GetParameterNamesFor(nullptr, key))
+            {
+                description << name << ",";
+            }
+        }
+        else if (kind == MethodParameterTypesEntry)
+        {
+            _DescribeParamTypes(description, _methodCallParamTypes, key);
+        }
+        else if (kind == KernelParameterTypesEntry)
+        {
+            _DescribeParamTypes(description, _kernelCallParamTypes, key);
+        }
+        else if (kind == ValueTypeEntry)
+        {
+            auto it = _switchValueTypes.find(key);
+            if (it != _switchValueTypes.end())
+            {
+                _DescribeEnum(description, it->second);
+            }
+        }
+        else if (kind == BitfieldPropertyEntry)
+        {
+            description << IsBitfieldProperty(key);
+        }
+        else if (kind == TextResourceTupleEntry)
+        {
+            description << IsTextResourceTupleProcedure(key);
+        }
+
+        string text = description.str();
+        return text.empty() ? 0 : (uint32_t)crcFast(reinterpret_cast<const uint8_t*>(text.c_str()), (int)text.length());
+    }
+
+private:
+    // The key under which the type of a value is found in commonSwitchValueTypes.
+    bool _GetValueTypeKey(SyntaxNode *source, string &key) const
     {
-        if (source)
+        bool found = false;
+        PropertyValue *pv = SafeSyntaxNode<PropertyValue>(source);
+        if ((pv != nullptr) && (pv->GetType() == ValueType::Token))
         {
-            auto itType = _switchValueTypes.end();
-            PropertyValue *pv = SafeSyntaxNode<PropertyValue>(source);
-            if ((pv != nullptr) && (pv->GetType() == ValueType::Token))
+            key = pv->GetStringValue();
+            found = true;
+        }
+        LValue *lValue = SafeSyntaxNode<LValue>(source);
+        if (lValue)
+        {
+            key = lValue->GetName();
+            found = true;
+        }
+        SendCall *sendCall = SafeSyntaxNode<SendCall>(source);
+        if (sendCall && (sendCall->GetParams().size() == 1) && !sendCall->GetObjectA().empty())
+        {
+            auto &sendParam = sendCall->GetParams()[0];
+            if (sendParam->GetSelectorParams().size() == 0) // It may be a property access
             {
-                itType = _switchValueTypes.find(pv->GetStringValue());
+                key = fmt::format("{0}.{1}", sendCall->GetObjectA(), sendParam->GetSelectorName());
+                found = true;
             }
-            LValue *lValue = SafeSyntaxNode<LValue>(source);
-            if (lValue)
+        }
+        return found;
+    }
+
+    void _DescribeEnum(ostream &description, const string &enumName) const
+    {
+        description << enumName << ":";
+        auto itEnum = _enumLists.find(enumName);
+        if (itEnum != _enumLists.end())
+        {
+            // Sort it, so the description doesn't depend on hash order.
+            map<uint16_t, string> sorted(itEnum->second.begin(), itEnum->second.end());
+            for (const auto &value : sorted)
             {
-                itType = _switchValueTypes.find(lValue->GetName());
+                description << value.first << "=" << value.second << ",";
             }
-            SendCall *sendCall = SafeSyntaxNode<SendCall>(source);
-            if (sendCall && (sendCall->GetParams().size() == 1) && !sendCall->GetObjectA().empty())
+        }
+        description << ";";
+    }
+
+    void _DescribeParamTypes(ostream &description, const std::unordered_map<string, vector<string>> &storage, const string &key) const
+    {
+        auto it = storage.find(key);
+        if (it != storage.end())
+        {
+            for (const string &type : it->second)
             {
-                auto &sendParam = sendCall->GetParams()[0];
-                if (sendParam->GetSelectorParams().size() == 0) // It may be a property access
-                {
-                    string lookupValue = fmt::format("{0}.{1}", sendCall->GetObjectA(), sendParam->GetSelectorName());
-                    itType = _switchValueTypes.find(lookupValue);
-                }
+                _DescribeEnum(description, type);
             }
+        }
+    }
 
+    void _ResolveValuesHelper(SyntaxNode *source, const vector<SyntaxNode*> &destinations) const
+    {
+        string key;
+        if (source && _GetValueTypeKey(source, key))
+        {
+            auto itType = _switchValueTypes.find(key);
             if (itType != _switchValueTypes.end())
             {
                 const enumList_t &enumList = _enumLists.at(itType->second); // Guaranteed to exist.
@@ -380,7 +470,95 @@ private:
     const SelectorTable &_selectorTable;
 };
 
+class RecordingDecompilerConfig : public IDecompilerConfig
+{
+public:
+    RecordingDecompilerConfig(const DecompilerConfig &config, std::map<std::string, uint32_t> &entriesUsed) : _config(config), _entriesUsed(entriesUsed)
+    {
+        error = config.error;
+    }
+
+    std::vector<std::string> GetParameterNamesFor(sci::ClassDefinition *classDef, const std::string &methodName) const
+    {
+        _Note(ParameterNamesEntry, methodName);
+        return _config.GetParameterNamesFor(classDef, methodName);
+    }
+
+    void ResolveMethodCallParameterTypes(sci::SendParam &sendParam) const
+    {
+        _Note(MethodParameterTypesEntry, sendParam.GetName());
+        _config.ResolveMethodCallParameterTypes(sendParam);
+    }
+
+    void ResolveProcedureCallParameterTypes(sci::ProcedureCall &procCall) const
+    {
+        _Note(KernelParameterTypesEntry, procCall.GetName());
+        _config.ResolveProcedureCallParameterTypes(procCall);
+    }
+
+    void ResolveSwitchStatementValues(sci::SwitchStatement &switchStatement) const
+    {
+        _NoteValueType(switchStatement.GetStatement1());
+        _config.ResolveSwitchStatementValues(switchStatement);
+    }
+
+    void ResolveBinaryOpValues(sci::BinaryOp &binaryOp) const
+    {
+        _NoteValueType(binaryOp.GetStatement1());
+        _NoteValueType(binaryOp.GetStatement2());
+        _config.ResolveBinaryOpValues(binaryOp);
+    }
+
+    bool IsBitfieldProperty(const std::string &propertyName) const
+    {
+        _Note(BitfieldPropertyEntry, propertyName);
+        return _config.IsBitfieldProperty(propertyName);
+    }
+
+    bool IsTextResourceTupleProcedure(const std::string &procName) const
+    {
+        _Note(TextResourceTupleEntry, procName);
+        return _config.IsTextResourceTupleProcedure(procName);
+    }
+
+    const SelectorTable &GetSelectorTable() const { return _config.GetSelectorTable(); }
+
+    uint32_t HashEntry(const std::string &entry) const { return _config.HashEntry(entry); }
+
+private:
+    void _Note(const char *kind, const std::string &key) const
+    {
+        string entry = fmt::format("{0}:{1}", kind, key);
+        if (_entriesUsed.find(entry) == _entriesUsed.end())
+        {
+            _entriesUsed[entry] = _config.HashEntry(entry);
+        }
+    }
+
+    void _NoteValueType(SyntaxNode *source) const
+    {
+        string key;
+        if (source && _config._GetValueTypeKey(source, key))
+        {
+            _Note(ValueTypeEntry, key);
+        }
+    }
+
+    const DecompilerConfig &_config;
+    std::map<std::string, uint32_t> &_entriesUsed;
+};
+
 std::unique_ptr<IDecompilerConfig> CreateDecompilerConfig(const GameFolderHelper &helper, const SelectorTable &selectorTable)
 {
     return make_unique<DecompilerConfig>(helper, selectorTable);
 }
+
+std::unique_ptr<IDecompilerConfig> CreateRecordingDecompilerConfig(const IDecompilerConfig &config, std::map<std::string, uint32_t> &entriesUsed)
+{
+    const DecompilerConfig *decompilerConfig = dynamic_cast<const DecompilerConfig*>(&config);
+    if (!decompilerConfig)
+    {
+        throw std::exception("Only configs from CreateDecompilerConfig can be recorded");
+    }
+    return make_unique<RecordingDecompilerConfig>(*decompilerConfig, entriesUsed);
+}
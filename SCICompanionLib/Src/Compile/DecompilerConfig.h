@@ -38,9 +38,18 @@ public:
     virtual bool IsBitfieldProperty(const std::string &propertyName) const = 0;
     virtual bool IsTextResourceTupleProcedure(const std::string &procName) const = 0;
     virtual const SelectorTable &GetSelectorTable() const = 0;
+
+    // Returns a hash of what the config says about one thing (an entry noted by a recording config, below),
+    // or 0 if it says nothing. Cached decompile results use this to tell whether a change affects them.
+    virtual uint32_t HashEntry(const std::string &entry) const = 0;
+
     virtual ~IDecompilerConfig() {}
 
     std::string error;
 };
 
 std::unique_ptr<IDecompilerConfig> CreateDecompilerConfig(const GameFolderHelper &helper, const SelectorTable &selectorTable);
+
+// Wraps a config from CreateDecompilerConfig, adding each entry that's consulted (and its hash) to entriesUsed.
+// Throws for any other kind of config.
+std::unique_ptr<IDecompilerConfig> CreateRecordingDecompilerConfig(const IDecompilerConfig &config, std::map<std::string, uint32_t> &entriesUsed);
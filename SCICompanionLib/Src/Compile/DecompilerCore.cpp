@@ -1341,6 +1341,7 @@ std::string DecompileLookups::ReverseLookupGlobalVariableName(WORD wIndex)
     };
 
 
+    TrackSCORead(0);
     std::string result = _pOFLookups->ReverseLookupGlobalVariableName(wIndex);
     if (result.empty())
     {
@@ -1356,6 +1357,7 @@ std::string DecompileLookups::ReverseLookupGlobalVariableName(WORD wIndex)
 }
 std::string DecompileLookups::ReverseLookupPublicExportName(WORD wScript, WORD wIndex)
 {
+    TrackSCORead(wScript);
     std::string ret = _pOFLookups->ReverseLookupPublicExportName(wScript, wIndex);
     if (ret.empty())
     {
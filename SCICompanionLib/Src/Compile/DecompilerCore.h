@@ -149,6 +149,10 @@ public:
     void TrackUsingScript(uint16_t scriptNumber) { if (_wScript != scriptNumber) _usings.insert(scriptNumber); }
     std::set<uint16_t> GetValidUsings();
 
+    // Track which .sco files were consulted, since the decompiled script depends on them.
+    void TrackSCORead(uint16_t scriptNumber) { _scosRead.insert(scriptNumber); }
+    const std::set<uint16_t> &GetSCOsRead() const { return _scosRead; }
+
     FunctionDecompileHints FunctionDecompileHints;
 
     const sci::ClassDefinition *DecompileLookups::GetClassContext() const;
@@ -210,6 +214,7 @@ private:
     std::unordered_set<uint16_t> _propertySelectors;
 
     std::set<uint16_t> _usings;
+    std::set<uint16_t> _scosRead;
 };
 
 void DecompileRaw(sci::FunctionBase &func, DecompileLookups &lookups, const BYTE *pBegin, const BYTE *pEnd, const BYTE *pScriptResourceEnd, uint16_t wBaseOffset);
@@ -258,4 +263,5 @@ bool _IsVOStoreOperation(Opcode bOpcode);
 class IDecompilerResults;
 class GameFolderHelper;
 class GlobalCompiledScriptLookups;
-std::unique_ptr<sci::Script> DecompileScript(const IDecompilerConfig *config, GlobalCompiledScriptLookups &scriptLookups, const GameFolderHelper &helper, uint16_t wScript, CompiledScript &compiledScript, IDecompilerResults &results, bool debugControlFlow = false, bool debugInstConsumption = false, PCSTR pszDebugFilter = nullptr, bool decompileAsm = false, bool substituteTextTuples = false);
+struct DecompileOutputs;
+std::unique_ptr<sci::Script> DecompileScript(const IDecompilerConfig *config, GlobalCompiledScriptLookups &scriptLookups, const GameFolderHelper &helper, uint16_t wScript, CompiledScript &compiledScript, IDecompilerResults &results, bool debugControlFlow = false, bool debugInstConsumption = false, PCSTR pszDebugFilter = nullptr, bool decompileAsm = false, bool substituteTextTuples = false, DecompileOutputs *outputs = nullptr);
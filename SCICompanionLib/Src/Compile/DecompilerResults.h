@@ -13,6 +13,10 @@
 ***************************************************************************/
 #pragma once
 
+struct ControlFlowNode;
+struct NodeSet;
+class DominatorMap;
+
 enum class DecompilerResultType
 {
     Update, // A minor update
@@ -28,4 +32,6 @@ public:
     virtual bool IsAborted() = 0;
     virtual void InformStats(bool functionSuccessful, int byteCount) = 0;
     virtual void SetGlobalVarsUpdated(const std::vector<std::pair<std::string, std::string>> &mainDirtyRenames) = 0;
+    // Called whenever control flow analysis calculates (post-)dominators for a set of nodes, so they can be checked.
+    virtual void InformDominators(const NodeSet &nodes, ControlFlowNode *entry, const std::function<NodeSet(ControlFlowNode*)> &edgesIn, const DominatorMap &dominators) {}
 };
\ No newline at end of file
@@ -1231,7 +1231,10 @@ bool GenerateScriptResource_SCI0(Script &script, PrecompiledHeaders &headers, Co
 
     _Section3_Synonyms(script, context, output, results);
 
+    CPrecisionTimer timer;
+    timer.Start();
     CommonScriptPrep(script, context, results);
+    results.Timings.Prescan += timer.Stop();
 
     // To figure out how many exports we have, let's look at the public procedures and public instances
     size_t offsetOfExports = 0;
@@ -1297,6 +1300,7 @@ bool GenerateScriptResource_SCI0(Script &script, PrecompiledHeaders &headers, Co
 
     context.FixupSinksAndSources(output, output);
 
+    results.Inputs = context.GetInputs();
     return !context.HasErrors();
 }
 
@@ -1411,7 +1415,10 @@ bool GenerateScriptResource_SCI11(Script &script, PrecompiledHeaders &headers, C
     // Create our "CompileContext", which holds state during the compilation.
     CompileContext context(appState->GetVersion(), script, headers, tables, results.GetLog(), generateDebugInfo);
 
+    CPrecisionTimer timer;
+    timer.Start();
     CommonScriptPrep(script, context, results);
+    results.Timings.Prescan += timer.Stop();
     // Errors above could mean crashes below. Bail out now.
     if (!context.HasErrors())
     {
@@ -1547,17 +1554,25 @@ bool GenerateScriptResource_SCI11(Script &script, PrecompiledHeaders &headers, C
         }
     }
 
+    results.Inputs = context.GetInputs();
     return !context.HasErrors();
 }
 
 bool GenerateScriptResource(SCIVersion version, sci::Script &script, PrecompiledHeaders &headers, CompileTables &tables, CompileResults &results, bool generateDebugInfo)
 {
+    CPrecisionTimer timer;
+    timer.Start();
+    double prescanBefore = results.Timings.Prescan;
+    bool result;
     if (version.SeparateHeapResources)
     {
-        return GenerateScriptResource_SCI11(script, headers, tables, results, generateDebugInfo);
+        result = GenerateScriptResource_SCI11(script, headers, tables, results, generateDebugInfo);
     }
     else
     {
-        return GenerateScriptResource_SCI0(script, headers, tables, results, generateDebugInfo);
+        result = GenerateScriptResource_SCI0(script, headers, tables, results, generateDebugInfo);
     }
+    // Prescan time was already recorded, so count the rest as code generation.
+    results.Timings.CodeGen += timer.Stop() - (results.Timings.Prescan - prescanBefore);
+    return result;
 }
\ No newline at end of file
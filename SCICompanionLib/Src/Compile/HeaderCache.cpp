@@ -0,0 +1,346 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "HeaderCache.h"
+#include "ScriptOM.h"
+#include "SyntaxParser.h"
+#include "CrystalScriptStream.h"
+#include "crc.h"
+
+using namespace sci;
+using namespace std;
+
+const uint32_t HeaderCacheSignature = (('S' << 24) + ('C' << 16) + ('H' << 8) + 'C');
+const uint16_t HeaderCacheVersion = 1;
+
+namespace
+{
+    // Counts what the parser reports, so we know whether a header parsed cleanly.
+    class CountingLog : public ICompileLog
+    {
+    public:
+        CountingLog(ICompileLog *log) : Count(0), _log(log) {}
+        void ReportResult(const CompileResult &result) override
+        {
+            Count++;
+            if (_log)
+            {
+                _log->ReportResult(result);
+            }
+        }
+
+        int Count;
+
+    private:
+        ICompileLog *_log;
+    };
+
+    uint32_t _HashPreprocessorDefines(SCIVersion version)
+    {
+        unordered_set<string> defines = PreProcessorDefinesFromSCIVersion(version);
+        set<string> sorted(defines.begin(), defines.end());
+        string all;
+        for (const string &define : sorted)
+        {
+            all += define;
+            all += ';';
+        }
+        return all.empty() ? 0 : (uint32_t)crcFast(reinterpret_cast<const uint8_t*>(all.c_str()), (int)all.length());
+    }
+
+    uint32_t _PackLineCol(LineCol pos)
+    {
+        return ((uint32_t)pos.Line() << 16) | (uint32_t)pos.Column();
+    }
+
+    LineCol _UnpackLineCol(uint32_t packed)
+    {
+        return LineCol((int)(packed >> 16), (int)(packed & 0xffff));
+    }
+}
+
+HeaderCache::HeaderCache() : _dirty(false) {}
+
+void HeaderCache::SetFilename(const std::string &filename)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_filename != filename)
+    {
+        _filename = filename;
+        _entries.clear();
+        _dirty = false;
+        if (!_filename.empty())
+        {
+            _Load(_filename);
+        }
+    }
+}
+
+void HeaderCache::_Load(const std::string &filename)
+{
+    if (!PathFileExists(filename.c_str()))
+    {
+        return;
+    }
+    try
+    {
+        ScopedFile scoped(filename, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING);
+        sci::streamOwner owner(scoped.hFile);
+        sci::istream reader = owner.getReader();
+
+        uint32_t signature, count;
+        uint16_t version;
+        reader >> signature;
+        reader >> version;
+        reader >> count;
+        if (reader.good() && (signature == HeaderCacheSignature) && (version == HeaderCacheVersion))
+        {
+            for (uint32_t i = 0; reader.good() && (i < count); i++)
+            {
+                string path;
+                Entry entry;
+                uint16_t includeCount, defineCount;
+                reader >> path;
+                reader >> entry.WriteTime;
+                reader >> entry.Size;
+                reader >> entry.ContentHash;
+                reader >> entry.DefinesHash;
+                reader >> includeCount;
+                for (uint16_t j = 0; reader.good() && (j < includeCount); j++)
+                {
+                    string include;
+                    reader >> include;
+                    entry.Includes.push_back(include);
+                }
+                reader >> defineCount;
+                for (uint16_t j = 0; reader.good() && (j < defineCount); j++)
+                {
+                    CachedDefine define;
+                    uint16_t flags;
+                    uint32_t start, end;
+                    reader >> define.Label;
+                    reader >> define.Value;
+                    reader >> flags;
+                    reader >> start;
+                    reader >> end;
+                    define.Flags = (IntegerFlags)flags;
+                    define.Start = _UnpackLineCol(start);
+                    define.End = _UnpackLineCol(end);
+                    entry.Defines.push_back(define);
+                }
+                if (reader.good())
+                {
+                    _entries[path] = move(entry);
+                }
+            }
+        }
+    }
+    catch (std::exception)
+    {
+        // Then we'll just parse the headers again.
+        _entries.clear();
+    }
+}
+
+void HeaderCache::Save()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_dirty || _filename.empty())
+    {
+        return;
+    }
+
+    sci::ostream out;
+    out << HeaderCacheSignature;
+    out << HeaderCacheVersion;
+    out << (uint32_t)_entries.size();
+    for (const auto &pair : _entries)
+    {
+        const Entry &entry = pair.second;
+        out << pair.first;
+        out << entry.WriteTime;
+        out << entry.Size;
+        out << entry.ContentHash;
+        out << entry.DefinesHash;
+        out << (uint16_t)entry.Includes.size();
+        for (const string &include : entry.Includes)
+        {
+            out << include;
+        }
+        out << (uint16_t)entry.Defines.size();
+        for (const CachedDefine &define : entry.Defines)
+        {
+            out << define.Label;
+            out << define.Value;
+            out << (uint16_t)define.Flags;
+            out << _PackLineCol(define.Start);
+            out << _PackLineCol(define.End);
+        }
+    }
+
+    try
+    {
+        string folder = _filename.substr(0, _filename.find_last_of('\\'));
+        if (EnsureFolderExists(folder, false))
+        {
+            ScopedFile scoped(_filename, GENERIC_WRITE, 0, CREATE_ALWAYS);
+            scoped.Write(out.GetInternalPointer(), out.GetDataSize());
+            _dirty = false;
+        }
+    }
+    catch (std::exception)
+    {
+        // The cache is just an optimization. Another instance may have it open.
+    }
+}
+
+std::unique_ptr<Script> HeaderCache::_CreateScript(const ScriptId &scriptId, const Entry &entry)
+{
+    unique_ptr<Script> script = make_unique<Script>(scriptId);
+    for (const string &include : entry.Includes)
+    {
+        script->AddInclude(include);
+    }
+    for (const CachedDefine &cached : entry.Defines)
+    {
+        unique_ptr<Define> define = make_unique<Define>();
+        define->SetLabel(cached.Label);
+        define->SetValue(cached.Value, cached.Flags);
+        define->SetScript(script.get());
+        define->SetPosition(cached.Start);
+        define->SetEndPosition(cached.End);
+        script->AddDefine(move(define));
+    }
+    return script;
+}
+
+bool HeaderCache::_IsSameEntry(const Entry &one, const Entry &two)
+{
+    if ((one.WriteTime != two.WriteTime) || (one.Size != two.Size) || (one.ContentHash != two.ContentHash) ||
+        (one.DefinesHash != two.DefinesHash) || (one.Includes != two.Includes) || (one.Defines.size() != two.Defines.size()))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < one.Defines.size(); i++)
+    {
+        const CachedDefine &defineOne = one.Defines[i];
+        const CachedDefine &defineTwo = two.Defines[i];
+        if ((defineOne.Label != defineTwo.Label) || (defineOne.Value != defineTwo.Value) || (defineOne.Flags != defineTwo.Flags) ||
+            (_PackLineCol(defineOne.Start) != _PackLineCol(defineTwo.Start)) || (_PackLineCol(defineOne.End) != _PackLineCol(defineTwo.End)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void HeaderCache::_FillEntry(const Script &script, Entry &entry)
+{
+    entry.Includes = script.GetIncludes();
+    entry.Defines.clear();
+    for (const auto &define : script.GetDefines())
+    {
+        CachedDefine cached = { define->GetLabel(), define->GetValue(), define->GetFlags(), define->GetPosition(), define->GetEndPosition() };
+        entry.Defines.push_back(cached);
+    }
+}
+
+bool HeaderCache::Load(const std::string &fullPath, SCIVersion version, ICompileLog *log, std::unique_ptr<sci::Script> &script)
+{
+    script.reset();
+
+    ScriptId scriptId(fullPath);
+    bool isHeader = scriptId.IsHeader();
+    string key = fullPath;
+    transform(key.begin(), key.end(), key.begin(), ::tolower);
+    uint32_t definesHash = _HashPreprocessorDefines(version);
+
+    uint64_t writeTime = 0;
+    uint32_t size = 0;
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (isHeader && GetFileAttributesEx(fullPath.c_str(), GetFileExInfoStandard, &attributes))
+    {
+        writeTime = ((uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+        size = attributes.nFileSizeLow;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _entries.find(key);
+        if ((it != _entries.end()) && (it->second.DefinesHash == definesHash) && (it->second.WriteTime == writeTime) && (it->second.Size == size))
+        {
+            script = _CreateScript(scriptId, it->second);
+            return true;
+        }
+    }
+
+    CCrystalTextBuffer buffer;
+    if (!buffer.LoadFromFile(fullPath.c_str()))
+    {
+        return false;
+    }
+
+    uint32_t contentHash = 0;
+    if (isHeader)
+    {
+        // The timestamp changed, but the contents may not have (e.g. the file was just re-saved or copied).
+        std::vector<uint8_t> contents;
+        std::ifstream file(fullPath, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        contentHash = contents.empty() ? 0 : (uint32_t)crcFast(&contents[0], (int)contents.size());
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _entries.find(key);
+        if ((it != _entries.end()) && (it->second.DefinesHash == definesHash) && (it->second.ContentHash == contentHash))
+        {
+            if ((it->second.WriteTime != writeTime) || (it->second.Size != size))
+            {
+                it->second.WriteTime = writeTime;
+                it->second.Size = size;
+                _dirty = true;
+            }
+            script = _CreateScript(scriptId, it->second);
+            buffer.FreeAll();
+            return true;
+        }
+    }
+
+    CScriptStreamLimiter limiter(&buffer);
+    CCrystalScriptStream stream(&limiter);
+    unique_ptr<Script> parsed = make_unique<Script>(scriptId);
+    CountingLog countingLog(log);
+    if (SyntaxParser_Parse(*parsed, stream, PreProcessorDefinesFromSCIVersion(version), &countingLog))
+    {
+        // Only cache headers that parsed without any errors or warnings, since we wouldn't report them again.
+        if (isHeader && (countingLog.Count == 0))
+        {
+            Entry entry;
+            entry.WriteTime = writeTime;
+            entry.Size = size;
+            entry.ContentHash = contentHash;
+            entry.DefinesHash = definesHash;
+            _FillEntry(*parsed, entry);
+
+            // Only an entry that's new or different needs to be written out.
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _entries.find(key);
+            if ((it == _entries.end()) || !_IsSameEntry(it->second, entry))
+            {
+                _entries[key] = move(entry);
+                _dirty = true;
+            }
+        }
+        script = move(parsed);
+    }
+    buffer.FreeAll();
+    return true;
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+#include "CompileInterfaces.h"
+
+namespace sci
+{
+    class Script;
+}
+
+//
+// Caches what the compiler and class browser need from header files (their includes and defines),
+// so that unchanged headers aren't re-parsed each time a game is opened or a compile is started.
+// Entries are keyed by full path, and are valid as long as the file's modification time and size
+// (or failing that, a crc of its contents) and the preprocessor defines are unchanged.
+// The cache is saved in the game folder. It's used from both the UI thread and the class browser's
+// background thread.
+//
+class HeaderCache
+{
+public:
+    HeaderCache();
+
+    // Where the cache is persisted (empty means nowhere). Loads whatever is there.
+    void SetFilename(const std::string &filename);
+
+    // Returns false if the file couldn't be loaded. Otherwise script is set to the parsed file, or nullptr
+    // if there were parse errors (which are reported to log).
+    // For headers, the script only contains includes and defines. Other files aren't cached, and are returned
+    // in full.
+    bool Load(const std::string &fullPath, SCIVersion version, ICompileLog *log, std::unique_ptr<sci::Script> &script);
+
+    // Writes the cache to disk, but only if an entry was added or invalidated since it was loaded or last saved.
+    void Save();
+
+private:
+    struct CachedDefine
+    {
+        std::string Label;
+        uint16_t Value;
+        IntegerFlags Flags;
+        LineCol Start;
+        LineCol End;
+    };
+
+    struct Entry
+    {
+        uint64_t WriteTime;
+        uint32_t Size;
+        uint32_t ContentHash;
+        uint32_t DefinesHash;   // Of the preprocessor defines the header was parsed with
+        std::vector<std::string> Includes;
+        std::vector<CachedDefine> Defines;
+    };
+
+    void _Load(const std::string &filename);
+    static std::unique_ptr<sci::Script> _CreateScript(const ScriptId &scriptId, const Entry &entry);
+    static void _FillEntry(const sci::Script &script, Entry &entry);
+    static bool _IsSameEntry(const Entry &one, const Entry &two);
+
+    std::mutex _mutex;
+    std::string _filename;
+    std::unordered_map<std::string, Entry> _entries;    // Keyed by lower-case full path
+    bool _dirty;
+};
@@ -0,0 +1,139 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "IncrementalParse.h"
+#include "CrystalScriptStream.h"
+
+using namespace sci;
+using namespace std;
+
+void _ReadLines(CScriptStreamLimiter &limiter, vector<string> &lines)
+{
+    int lineCount = limiter.GetLineCount();
+    lines.reserve(lineCount);
+    for (int i = 0; i < lineCount; i++)
+    {
+        PCSTR chars = limiter.GetLineChars(i);
+        lines.emplace_back(chars ? chars : "", chars ? limiter.GetLineLength(i) : 0);
+    }
+}
+
+void IncrementalParseState::Reset(CScriptStreamLimiter &limiter, const unordered_set<string> &preProcessorDefines, bool addCommentsToOM, bool collectComments)
+{
+    _valid = false;
+    _lines.clear();
+    _ReadLines(limiter, _lines);
+    _constructs.clear();
+    _preProcessorDefines = preProcessorDefines;
+    _addCommentsToOM = addCommentsToOM;
+    _collectComments = collectComments;
+}
+
+void IncrementalParseState::SetConstructs(vector<TopLevelConstruct> constructs)
+{
+    _constructs = move(constructs);
+    _valid = true;
+}
+
+bool IncrementalParseState::Plan(CScriptStreamLimiter &limiter, const unordered_set<string> &preProcessorDefines, vector<string> &lines, IncrementalParsePlan &plan) const
+{
+    if (!_valid || (preProcessorDefines != _preProcessorDefines))
+    {
+        return false;
+    }
+
+    _ReadLines(limiter, lines);
+
+    // The first 'prefix' lines and the last 'suffix' lines are unchanged.
+    size_t common = min(lines.size(), _lines.size());
+    size_t prefix = 0;
+    while ((prefix < common) && (lines[prefix] == _lines[prefix]))
+    {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while ((suffix < (common - prefix)) && (lines[lines.size() - 1 - suffix] == _lines[_lines.size() - 1 - suffix]))
+    {
+        suffix++;
+    }
+
+    // Keep the constructs that end before the edit, and re-parse from there.
+    plan.FirstConstruct = 0;
+    while ((plan.FirstConstruct < _constructs.size()) && ((size_t)_constructs[plan.FirstConstruct].End.Line() < prefix))
+    {
+        plan.FirstConstruct++;
+    }
+    if (plan.FirstConstruct > 0)
+    {
+        plan.Restart = _constructs[plan.FirstConstruct - 1].End;
+        plan.RestartCounts = _constructs[plan.FirstConstruct - 1].CountsAtEnd;
+    }
+    else
+    {
+        plan.Restart = LineCol();
+        plan.RestartCounts = ScriptElementCounts();
+    }
+
+    // One construct overrides another's script number (and such), so we can't tell what the result of removing one would be.
+    for (size_t i = plan.FirstConstruct; i < _constructs.size(); i++)
+    {
+        if (_constructs[i].SetsHeader)
+        {
+            return false;
+        }
+    }
+
+    // The constructs after the edit can be kept if they haven't moved.
+    plan.HasTail = false;
+    plan.TailConstruct = _constructs.size();
+    if (lines.size() == _lines.size())
+    {
+        size_t firstUnchangedLine = _lines.size() - suffix;
+        for (size_t i = plan.FirstConstruct; i < _constructs.size(); i++)
+        {
+            if ((size_t)_constructs[i].Start.Line() >= firstUnchangedLine)
+            {
+                plan.HasTail = true;
+                plan.TailConstruct = i;
+                plan.Stop = _constructs[i].Start;
+                plan.StopCounts = _constructs[i].CountsAtStart;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void IncrementalParseState::Update(vector<string> lines, const IncrementalParsePlan &plan, vector<TopLevelConstruct> newConstructs, const ScriptElementCounts &stopCounts, bool valid)
+{
+    vector<TopLevelConstruct> constructs(_constructs.begin(), _constructs.begin() + plan.FirstConstruct);
+    move(newConstructs.begin(), newConstructs.end(), back_inserter(constructs));
+    if (plan.HasTail)
+    {
+        // These stay where they were, but there may be a different number of elements before them now.
+        for (size_t i = plan.TailConstruct; i < _constructs.size(); i++)
+        {
+            TopLevelConstruct construct = _constructs[i];
+            for (size_t j = 0; j < ARRAYSIZE(stopCounts.Counts); j++)
+            {
+                construct.CountsAtStart.Counts[j] = construct.CountsAtStart.Counts[j] - plan.StopCounts.Counts[j] + stopCounts.Counts[j];
+                construct.CountsAtEnd.Counts[j] = construct.CountsAtEnd.Counts[j] - plan.StopCounts.Counts[j] + stopCounts.Counts[j];
+            }
+            constructs.push_back(construct);
+        }
+    }
+    _constructs = move(constructs);
+    _lines = move(lines);
+    _valid = valid;
+}
@@ -0,0 +1,182 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+#include "ScriptOM.h"
+#include "SyntaxContext.h"
+
+class CScriptStreamLimiter;
+
+// A top-level construct (class, procedure, define, etc...) encountered while parsing a script.
+struct TopLevelConstruct
+{
+    LineCol Start;                              // The opening parenthesis
+    LineCol End;                                // Just past the closing parenthesis
+    sci::ScriptElementCounts CountsAtStart;     // This includes any comments that precede the construct
+    sci::ScriptElementCounts CountsAtEnd;
+    bool SetsHeader;                            // It changes the script number, text# or version
+};
+
+// What needs to be re-parsed after an edit.
+struct IncrementalParsePlan
+{
+    // Everything up to here (the end of the last construct before the edit) is kept.
+    LineCol Restart;
+    sci::ScriptElementCounts RestartCounts;
+    size_t FirstConstruct;
+
+    // If there is a tail, everything from here on (the first construct after the edit) is kept too.
+    bool HasTail;
+    LineCol Stop;
+    sci::ScriptElementCounts StopCounts;
+    size_t TailConstruct;
+};
+
+//
+// Remembers the text a script was parsed from, and where its top-level constructs were, so that an edited
+// version of the script can be parsed by only re-parsing the constructs that the edit touched.
+// The parts of the syntax tree that precede the edit are always kept. Those that follow it are kept only
+// if the edit didn't add or remove lines, since otherwise the position of every node in them would change.
+//
+class IncrementalParseState
+{
+public:
+    IncrementalParseState() : _valid(false), _addCommentsToOM(false), _collectComments(false) {}
+
+    // Called before a full parse of the text in limiter. The state is only valid once the constructs are set.
+    void Reset(CScriptStreamLimiter &limiter, const std::unordered_set<std::string> &preProcessorDefines, bool addCommentsToOM, bool collectComments);
+    void SetConstructs(std::vector<TopLevelConstruct> constructs);
+    void Invalidate() { _valid = false; }
+
+    bool AddCommentsToOM() const { return _addCommentsToOM; }
+    bool CollectComments() const { return _collectComments; }
+
+    // Figures out what needs to be re-parsed for the new text in limiter. Returns false if this isn't something
+    // that can be done incrementally.
+    bool Plan(CScriptStreamLimiter &limiter, const std::unordered_set<std::string> &preProcessorDefines, std::vector<std::string> &lines, IncrementalParsePlan &plan) const;
+    // Called once the plan has been carried out. stopCounts are the script's element counts at plan.Stop.
+    void Update(std::vector<std::string> lines, const IncrementalParsePlan &plan, std::vector<TopLevelConstruct> newConstructs, const sci::ScriptElementCounts &stopCounts, bool valid);
+
+private:
+    bool _valid;
+    std::vector<std::string> _lines;
+    std::vector<TopLevelConstruct> _constructs;
+    std::unordered_set<std::string> _preProcessorDefines;
+    bool _addCommentsToOM;
+    bool _collectComments;
+};
+
+// The things top-level constructs set, rather than add to.
+struct ScriptHeaderState
+{
+    ScriptHeaderState(const sci::Script &script) : Number(script.GetScriptNumber()), Define(script.GetScriptNumberDefine()), GenText(script.GetGenText()), SyntaxVersion(script.SyntaxVersion) {}
+
+    bool operator==(const ScriptHeaderState &other) const
+    {
+        return (Number == other.Number) && (Define == other.Define) && (GenText == other.GenText) && (SyntaxVersion == other.SyntaxVersion);
+    }
+
+    WORD Number;
+    std::string Define;
+    const sci::PropertyValue *GenText;
+    int SyntaxVersion;
+};
+
+//
+// Matches top-level constructs one by one until the end of the stream. This is equivalent to matching
+// *topLevelConstruct followed by the end of the stream, but notes where each construct lies.
+// If stopAt is supplied, matching ends there instead (and fails if a construct doesn't start exactly there).
+//
+template<typename _CommentPolicy, typename _TParser>
+bool MatchTopLevelConstructs(const _TParser &topLevelConstruct, SyntaxContext &context, streamIt &stream, std::vector<TopLevelConstruct> &constructs, const LineCol *stopAt = nullptr)
+{
+    sci::Script &script = context.Script();
+    while (true)
+    {
+        _CommentPolicy::EatWhitespaceAndComments(&context, stream);
+        LineCol start = stream.GetPosition();
+        if (stopAt && !(start < *stopAt))
+        {
+            return (start == *stopAt);
+        }
+        if (*stream == 0)
+        {
+            return (stopAt == nullptr);
+        }
+
+        TopLevelConstruct construct;
+        construct.Start = start;
+        construct.CountsAtStart = script.GetElementCounts();
+        ScriptHeaderState headerBefore(script);
+        if (!topLevelConstruct.Match(&context, stream).Result())
+        {
+            return false;
+        }
+        construct.End = stream.GetPosition();
+        construct.CountsAtEnd = script.GetElementCounts();
+        construct.SetsHeader = !(ScriptHeaderState(script) == headerBefore);
+        constructs.push_back(construct);
+    }
+}
+
+//
+// Re-parses an edited script in place, according to state. postProcess is given the newly parsed top-level
+// elements, and returns false if it reported any problems with them.
+// Returns false, leaving the script as it was, if the edit can't be handled incrementally.
+//
+template<typename _CommentPolicy, typename _TParser, typename _TPostProcess>
+bool ParseTopLevelIncremental(const _TParser &topLevelConstruct, sci::Script &script, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, IncrementalParseState &state, _TPostProcess postProcess)
+{
+    std::vector<std::string> lines;
+    IncrementalParsePlan plan;
+    if (!state.Plan(*stream.GetLimiter(), preProcessorDefines, lines, plan))
+    {
+        return false;
+    }
+
+    // Set aside what follows the edit, and what it replaces.
+    sci::Script header, replaced, tail;
+    script.CopyHeaderTo(header);
+    if (plan.HasTail)
+    {
+        script.MoveElementsTo(plan.StopCounts, tail);
+    }
+    script.MoveElementsTo(plan.RestartCounts, replaced);
+
+    std::vector<TopLevelConstruct> newConstructs;
+    bool success;
+    {
+        streamIt it = stream.get_at(plan.Restart);
+        SyntaxContext context(it, script, preProcessorDefines, state.AddCommentsToOM(), state.CollectComments());
+        success = MatchTopLevelConstructs<_CommentPolicy>(topLevelConstruct, context, it, newConstructs, plan.HasTail ? &plan.Stop : nullptr);
+    }
+
+    sci::Script newElements;
+    script.MoveElementsTo(plan.RestartCounts, newElements);
+    if (!success)
+    {
+        // Put things back the way they were. A full parse will report the error.
+        replaced.MoveElementsTo(sci::ScriptElementCounts(), script);
+        tail.MoveElementsTo(sci::ScriptElementCounts(), script);
+        header.CopyHeaderTo(script);
+        return false;
+    }
+
+    bool valid = postProcess(newElements);
+    newElements.MoveElementsTo(sci::ScriptElementCounts(), script);
+    sci::ScriptElementCounts stopCounts = script.GetElementCounts();
+    tail.MoveElementsTo(sci::ScriptElementCounts(), script);
+    state.Update(std::move(lines), plan, std::move(newConstructs), stopCounts, valid);
+    return true;
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "ParallelScriptParser.h"
+#include "format.h"
+
+using namespace std;
+
+ParallelScriptParser::ParallelScriptParser(const std::vector<ScriptId> &scripts, size_t parseAhead) :
+    _scripts(scripts),
+    _results(scripts.size()),
+    _parseAhead(max((size_t)1, parseAhead)),
+    _nextToParse(0),
+    _nextToTake(0),
+    _abort(false)
+{
+    // Leave one core for the code generation on the calling thread.
+    unsigned int cores = thread::hardware_concurrency();
+    unsigned int workerCount = (cores > 1) ? (cores - 1) : 1;
+    workerCount = min(workerCount, (unsigned int)max((size_t)1, scripts.size()));
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        _workers.push_back(async(launch::async, &ParallelScriptParser::_Worker, this));
+    }
+}
+
+ParallelScriptParser::~ParallelScriptParser()
+{
+    Abort();
+    for (auto &worker : _workers)
+    {
+        worker.wait();
+    }
+}
+
+void ParallelScriptParser::Abort()
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+        _abort = true;
+    }
+    _canContinue.notify_all();
+}
+
+void ParallelScriptParser::_Worker()
+{
+    while (true)
+    {
+        size_t index;
+        {
+            unique_lock<mutex> lock(_mutex);
+            _canContinue.wait(lock, [this]() { return _abort || (_nextToParse >= _scripts.size()) || (_nextToParse < (_nextToTake + _parseAhead)); });
+            if (_abort || (_nextToParse >= _scripts.size()))
+            {
+                return;
+            }
+            index = _nextToParse++;
+        }
+
+        CompileLog log;
+        std::unique_ptr<sci::Script> script;
+        try
+        {
+            script = ParseScriptForCompile(log, _scripts[index]);
+        }
+        catch (std::exception &e)
+        {
+            log.ReportResult(CompileResult(fmt::format("Error parsing {0}: {1}", _scripts[index].GetTitle(), e.what()), CompileResult::CompileResultType::CRT_Error));
+        }
+
+        {
+            lock_guard<mutex> lock(_mutex);
+            ParseResult &result = _results[index];
+            result.Log = move(log);
+            result.Script = move(script);
+            result.Done = true;
+        }
+        _parsed.notify_all();
+    }
+}
+
+bool ParallelScriptParser::TryTake(size_t index, std::chrono::milliseconds timeout, CompileLog &log, std::unique_ptr<sci::Script> &script)
+{
+    assert(index == _nextToTake);
+    unique_lock<mutex> lock(_mutex);
+    if (!_parsed.wait_for(lock, timeout, [this, index]() { return _results[index].Done; }))
+    {
+        return false;
+    }
+
+    ParseResult &result = _results[index];
+    for (const CompileResult &compileResult : result.Log.Results())
+    {
+        log.ReportResult(compileResult);
+    }
+    script = move(result.Script);
+    result.Log.Clear();
+    _nextToTake = index + 1;
+    lock.unlock();
+    _canContinue.notify_all();
+    return true;
+}
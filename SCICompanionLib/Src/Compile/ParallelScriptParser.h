@@ -0,0 +1,64 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+#include "CompileContext.h"
+#include <future>
+
+//
+// Parses a list of scripts on worker threads, ahead of code generation.
+// Code generation updates the species and selector tables and reads the .sco files of scripts compiled
+// before it, so it has to happen one script at a time, in order, to produce the same output as a serial
+// compile. Parsing has no such dependencies, and is where most of the time goes, so we do it in parallel.
+//
+class ParallelScriptParser
+{
+public:
+    // Workers stay at most parseAhead scripts ahead of the last one taken.
+    ParallelScriptParser(const std::vector<ScriptId> &scripts, size_t parseAhead = 32);
+    ~ParallelScriptParser();
+
+    // Waits up to timeout for script index to be parsed. If it was, appends its parse results to log and
+    // returns true. script is set to the parsed script, or nullptr if it failed to load or parse.
+    // Scripts must be taken in order.
+    bool TryTake(size_t index, std::chrono::milliseconds timeout, CompileLog &log, std::unique_ptr<sci::Script> &script);
+
+    // Stops the workers from starting any new scripts.
+    void Abort();
+
+private:
+    void _Worker();
+
+    struct ParseResult
+    {
+        ParseResult() : Done(false) {}
+
+        bool Done;
+        CompileLog Log;
+        std::unique_ptr<sci::Script> Script;
+    };
+
+    std::vector<ScriptId> _scripts;
+    std::vector<ParseResult> _results;
+    size_t _parseAhead;
+
+    std::mutex _mutex;
+    std::condition_variable _parsed;        // Signalled when a script is parsed
+    std::condition_variable _canContinue;   // Signalled when a script is taken, or on abort
+    size_t _nextToParse;
+    size_t _nextToTake;
+    bool _abort;
+
+    std::vector<std::future<void>> _workers;
+};
@@ -5,6 +5,7 @@
 #include "ParserActions.h"
 #include "Operators.h"
 #include "OperatorTables.h"
+#include "IncrementalParse.h"
 #include "format.h"
 
 using namespace sci;
@@ -1140,7 +1141,7 @@ void SCISyntaxParser::Load()
     procedures_fwd =
         keyword_p("procedure") >> *alphanumNK_p[AddProcedureFwdA];
 
-    entire_script = *(oppar[GeneralE]
+    top_level_construct = oppar[GeneralE]
         >> (include
         | use
         | define[FinishDefineA]
@@ -1162,7 +1163,9 @@ void SCISyntaxParser::Load()
         | procedures_fwd
 
         | script_var)[{IdentifierE, ParseAutoCompleteContext::TopLevelKeyword}]
-        >> clpar[GeneralE]);
+        >> clpar[GeneralE];
+
+    entire_script = *top_level_construct;
 
     // And for headers, only defines, includes are allowed. And also #ifdef!
     // REVIEW: This is kind of a hack.
@@ -1198,7 +1201,7 @@ void SCISyntaxParser::Load()
 // - Identify switchtos and auto-number their cases
 // - Transform cond into if-elseif-else
 //
-void PostProcessScript(ICompileLog *pLog, Script &script)
+void _PropagatePublic(Script &script)
 {
     // Push public down to instances and procedures
     EnumScriptElements<ProcedureDefinition>(script,
@@ -1215,10 +1218,16 @@ void PostProcessScript(ICompileLog *pLog, Script &script)
         instance.SetPublic(script.IsExport(instance.GetName()));
     }
         );
+}
+
+// Returns false if any problems were reported.
+bool _TransformStatements(ICompileLog *pLog, Script &script, const ScriptId &scriptId)
+{
+    bool success = true;
 
     // Re-work conds into if-elses.
     EnumScriptElements<CondStatement>(script,
-        [pLog, &script](CondStatement &cond)
+        [pLog, &scriptId, &success](CondStatement &cond)
     {
         // TODO: Enforce that else needs to be last.
         // TODO: What if only one else?
@@ -1240,8 +1249,9 @@ void PostProcessScript(ICompileLog *pLog, Script &script)
                 {
                     if (pLog)
                     {
-                        pLog->ReportResult(CompileResult("The else clause must be the last clause in a cond.", script.GetScriptId(), clause->GetPosition().Line()));
+                        pLog->ReportResult(CompileResult("The else clause must be the last clause in a cond.", scriptId, clause->GetPosition().Line()));
                     }
+                    success = false;
                     break;
                 }
                 std::unique_ptr<IfStatement> newIf = make_unique<IfStatement>();
@@ -1298,6 +1308,11 @@ void PostProcessScript(ICompileLog *pLog, Script &script)
     }
         );
 
+    return success;
+}
+
+void _ReportUnimplemented(ICompileLog *pLog, Script &script)
+{
     // Report warnings if any un-implemented constructs are used.
     std::vector<std::string> unimplementedWarnings;
     if (!script.Externs.empty())
@@ -1339,6 +1354,15 @@ void PostProcessScript(ICompileLog *pLog, Script &script)
     }
 }
 
+// Returns false if any problems were reported.
+bool PostProcessScript(ICompileLog *pLog, Script &script)
+{
+    _PropagatePublic(script);
+    bool success = _TransformStatements(pLog, script, script.GetScriptId());
+    _ReportUnimplemented(pLog, script);
+    return success;
+}
+
 // For error reporting:
 template<typename _It>
 void ExtractSomeToken(std::string &str, _It &stream)
@@ -1355,7 +1379,7 @@ void ExtractSomeToken(std::string &str, _It &stream)
 //
 // This does the parsing.
 //
-bool SCISyntaxParser::Parse(Script &script, streamIt &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool addCommentsToOM, bool collectComments)
+bool SCISyntaxParser::Parse(Script &script, streamIt &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool addCommentsToOM, bool collectComments, IncrementalParseState *incrementalState)
 {
     SyntaxContext context(stream, script, preProcessorDefines, addCommentsToOM, collectComments);
     bool fRet = false;
@@ -1364,9 +1388,16 @@ bool SCISyntaxParser::Parse(Script &script, streamIt &stream, std::unordered_set
     context.ParseDebug = true;
 #endif
 
-    if (entire_script.Match(&context, stream).Result() && (*stream == 0)) // Needs a full match
+    std::vector<TopLevelConstruct> constructs;
+    bool matched = incrementalState ?
+        MatchTopLevelConstructs<EatCommentSemi>(top_level_construct, context, stream, constructs) :
+        (entire_script.Match(&context, stream).Result() && (*stream == 0)); // Needs a full match
+    if (matched)
     {
-        PostProcessScript(pError, script);
+        if (PostProcessScript(pError, script) && incrementalState)
+        {
+            incrementalState->SetConstructs(move(constructs));
+        }
         fRet = true;
     }
     else
@@ -1425,6 +1456,21 @@ bool SCISyntaxParser::Parse(Script &script, streamIt &stream, std::unordered_set
     return fRet;
 }
 
+bool SCISyntaxParser::ParseIncremental(Script &script, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, IncrementalParseState &state, ICompileLog *pError)
+{
+    // Only the new parts of the script need their statements transformed, but public-ness depends on the exports.
+    ScriptId scriptId = script.GetScriptId();
+    bool fRet = ParseTopLevelIncremental<EatCommentSemi>(top_level_construct, script, stream, preProcessorDefines, state,
+        [pError, &scriptId](Script &newElements) { return _TransformStatements(pError, newElements, scriptId); }
+        );
+    if (fRet)
+    {
+        _PropagatePublic(script);
+        _ReportUnimplemented(pError, script);
+    }
+    return fRet;
+}
+
 bool SCISyntaxParser::ParseHeader(Script &script, streamIt &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool collectComments)
 {
     SyntaxContext context(stream, script, preProcessorDefines, false, collectComments);
@@ -11,13 +11,16 @@
 // Our parser...
 typedef ParserBase<SyntaxContext, streamIt, EatCommentSemi> ParserSCI;
 
+class IncrementalParseState;
+
 class SCISyntaxParser
 {
 public:
     SCISyntaxParser();
 
-    bool Parse(sci::Script &script, CCrystalScriptStream::const_iterator &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool addCommentsToOM, bool collectComments);
+    bool Parse(sci::Script &script, CCrystalScriptStream::const_iterator &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool addCommentsToOM, bool collectComments, IncrementalParseState *incrementalState = nullptr);
     bool Parse(sci::Script &script, CCrystalScriptStream::const_iterator &stream, std::unordered_set<std::string> preProcessorDefines, SyntaxContext &context);
+    bool ParseIncremental(sci::Script &script, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, IncrementalParseState &state, ICompileLog *pError);
     bool ParseHeader(sci::Script &script, CCrystalScriptStream::const_iterator &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool collectComments);
     void Load();
 
@@ -26,6 +29,7 @@ private:
 
 
     ParserSCI entire_script;
+    ParserSCI top_level_construct;
 
     // Basics
     ParserSCI immediateValue;
@@ -280,6 +280,67 @@ void Script::SetGenText(const sci::PropertyValue &propValue)
 }
 const PropertyValue *Script::GetGenText() const { return _genTextValue.get(); }
 
+template<typename _T>
+void _MoveElements(std::vector<_T> &source, size_t begin, std::vector<_T> &dest)
+{
+    assert(begin <= source.size());
+    std::move(source.begin() + begin, source.end(), std::back_inserter(dest));
+    source.erase(source.begin() + begin, source.end());
+}
+
+// These need to list the elements in the same order.
+ScriptElementCounts Script::GetElementCounts() const
+{
+    ScriptElementCounts counts;
+    size_t i = 0;
+    counts.Counts[i++] = _uses.size();
+    counts.Counts[i++] = _includes.size();
+    counts.Counts[i++] = _scriptVariables.size();
+    counts.Counts[i++] = _scriptStringDeclarations.size();
+    counts.Counts[i++] = _classes.size();
+    counts.Counts[i++] = _procedures.size();
+    counts.Counts[i++] = _synonyms.size();
+    counts.Counts[i++] = _defines.size();
+    counts.Counts[i++] = _exports.size();
+    counts.Counts[i++] = _comments.size();
+    counts.Counts[i++] = Globals.size();
+    counts.Counts[i++] = Externs.size();
+    counts.Counts[i++] = Selectors.size();
+    counts.Counts[i++] = ClassDefs.size();
+    counts.Counts[i++] = ProcedureForwards.size();
+    assert(i == ARRAYSIZE(counts.Counts));
+    return counts;
+}
+
+void Script::MoveElementsTo(const ScriptElementCounts &begin, Script &other)
+{
+    size_t i = 0;
+    _MoveElements(_uses, begin.Counts[i++], other._uses);
+    _MoveElements(_includes, begin.Counts[i++], other._includes);
+    _MoveElements(_scriptVariables, begin.Counts[i++], other._scriptVariables);
+    _MoveElements(_scriptStringDeclarations, begin.Counts[i++], other._scriptStringDeclarations);
+    _MoveElements(_classes, begin.Counts[i++], other._classes);
+    _MoveElements(_procedures, begin.Counts[i++], other._procedures);
+    _MoveElements(_synonyms, begin.Counts[i++], other._synonyms);
+    _MoveElements(_defines, begin.Counts[i++], other._defines);
+    _MoveElements(_exports, begin.Counts[i++], other._exports);
+    _MoveElements(_comments, begin.Counts[i++], other._comments);
+    _MoveElements(Globals, begin.Counts[i++], other.Globals);
+    _MoveElements(Externs, begin.Counts[i++], other.Externs);
+    _MoveElements(Selectors, begin.Counts[i++], other.Selectors);
+    _MoveElements(ClassDefs, begin.Counts[i++], other.ClassDefs);
+    _MoveElements(ProcedureForwards, begin.Counts[i++], other.ProcedureForwards);
+    assert(i == ARRAYSIZE(begin.Counts));
+}
+
+void Script::CopyHeaderTo(Script &other) const
+{
+    other._scriptId.SetResourceNumber(_scriptId.GetResourceNumber());
+    other._scriptDefine = _scriptDefine;
+    other._genTextValue.reset(_genTextValue ? new PropertyValue(*_genTextValue) : nullptr);
+    other.SyntaxVersion = SyntaxVersion;
+}
+
 ConditionalExpression::ConditionalExpression(std::unique_ptr<SyntaxNode> statement)
 {
     AddStatement(std::move(statement));
@@ -1127,6 +1127,16 @@ namespace sci
     };
 
     typedef std::vector<std::unique_ptr<ExportEntry>> ExportEntryVector;
+
+    //
+    // The number of each kind of top-level element in a script. Since each kind is stored in
+    // source order, this identifies a point in the script (used for incremental parsing).
+    //
+    struct ScriptElementCounts
+    {
+        ScriptElementCounts() : Counts() {}
+        size_t Counts[15];
+    };
     
     //
     // This represents an entire script
@@ -1197,6 +1207,13 @@ namespace sci
 
         ScriptId GetScriptId() const { return _scriptId; }
 
+        // For incremental parsing: moves the top-level elements (and comments) from the given point onwards
+        // to the end of another script. Their owner script is left as is.
+        ScriptElementCounts GetElementCounts() const;
+        void MoveElementsTo(const ScriptElementCounts &begin, Script &other);
+        // The things that top-level constructs set, rather than add to: script number, text# and version.
+        void CopyHeaderTo(Script &other) const;
+
         //
         std::vector<std::unique_ptr<GlobalDeclaration>> Globals;
         std::vector<std::unique_ptr<ExternDeclaration>> Externs;
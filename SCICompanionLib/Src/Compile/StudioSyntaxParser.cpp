@@ -23,6 +23,7 @@
 #include "Operators.h"
 #include "OperatorTables.h"
 #include "ParserActions.h"
+#include "IncrementalParse.h"
 
 using namespace sci;
 using namespace std;
@@ -842,7 +843,7 @@ void StudioSyntaxParser::Load()
   
     // The actual script grammer - rules that contain multiple entities (e.g. local, synonyms),
     // have their finishing actions defined on those entities themselves, rather than here.
-    entire_script = *(oppar[GeneralE]
+    top_level_construct = oppar[GeneralE]
         >> (version
             | include
             | use
@@ -855,7 +856,9 @@ void StudioSyntaxParser::Load()
             | synonyms
             | script_var
             | script_string)[{IdentifierE, ParseAutoCompleteContext::TopLevelKeyword}]
-        >> clpar[GeneralE]);
+        >> clpar[GeneralE];
+
+    entire_script = *top_level_construct;
 
     // And for headers, only defines and includes are allowed. And also #ifdef!
     entire_header = *
@@ -888,12 +891,20 @@ void SyntaxContext::ReportError(const std::string &error, streamIt pos)
 //
 // This does the parsing.
 //
-bool StudioSyntaxParser::Parse(Script &script, streamIt &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool addCommentsToOM, bool collectComments)
+bool StudioSyntaxParser::Parse(Script &script, streamIt &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool addCommentsToOM, bool collectComments, IncrementalParseState *incrementalState)
 {
     SyntaxContext context(stream, script, preProcessorDefines, addCommentsToOM, collectComments);
     bool fRet = false;
-    if (entire_script.Match(&context, stream).Result() && (*stream == 0)) // Needs a full match
+    std::vector<TopLevelConstruct> constructs;
+    bool matched = incrementalState ?
+        MatchTopLevelConstructs<EatCommentCpp>(top_level_construct, context, stream, constructs) :
+        (entire_script.Match(&context, stream).Result() && (*stream == 0)); // Needs a full match
+    if (matched)
     {
+        if (incrementalState)
+        {
+            incrementalState->SetConstructs(move(constructs));
+        }
         fRet = true;
     }
     else
@@ -923,6 +934,13 @@ bool StudioSyntaxParser::Parse(Script &script, streamIt &stream, std::unordered_
     return fRet;
 }
 
+bool StudioSyntaxParser::ParseIncremental(Script &script, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, IncrementalParseState &state)
+{
+    return ParseTopLevelIncremental<EatCommentCpp>(top_level_construct, script, stream, preProcessorDefines, state,
+        [](Script &newElements) { return true; }
+        );
+}
+
 bool StudioSyntaxParser::ParseHeader(Script &script, streamIt &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool collectComments)
 {
     SyntaxContext context(stream, script, preProcessorDefines, false, collectComments);
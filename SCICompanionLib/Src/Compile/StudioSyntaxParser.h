@@ -565,6 +565,7 @@ void GeneralE(MatchResult &match, const ParserBase<_TContext, _It, _CommentPolic
 typedef ParserBase<SyntaxContext, streamIt, EatCommentCpp> Parser;
 
 class ICompileLog; // fwd decl
+class IncrementalParseState;
 
 class IReportError
 {
@@ -575,8 +576,9 @@ public:
 class StudioSyntaxParser
 {
 public:
-    bool Parse(sci::Script &script, CCrystalScriptStream::const_iterator &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool addCommentsToOM, bool collectComments);
+    bool Parse(sci::Script &script, CCrystalScriptStream::const_iterator &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool addCommentsToOM, bool collectComments, IncrementalParseState *incrementalState = nullptr);
     bool Parse(sci::Script &script, CCrystalScriptStream::const_iterator &stream, std::unordered_set<std::string> preProcessorDefines, SyntaxContext &context);
+    bool ParseIncremental(sci::Script &script, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, IncrementalParseState &state);
     bool ParseHeader(sci::Script &script, CCrystalScriptStream::const_iterator &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pError, bool collectComments);
     void Load();
 
@@ -669,6 +671,7 @@ private:
     Parser script_string;
   
     Parser entire_script;
+    Parser top_level_construct;
     Parser entire_header;
 
 
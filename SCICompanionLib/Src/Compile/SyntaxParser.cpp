@@ -15,6 +15,7 @@
 #include "SyntaxParser.h"
 #include "StudioSyntaxParser.h"
 #include "SCISyntaxParser.h"
+#include "IncrementalParse.h"
 
 // Our parser global variables
 StudioSyntaxParser g_studio;
@@ -53,8 +54,18 @@ bool SyntaxParser_ParseAC(sci::Script &script, CCrystalScriptStream::const_itera
     return fRet;
 }
 
-bool SyntaxParser_Parse(sci::Script &script, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pLog, bool fParseComments, SyntaxContext *pContext, bool addCommentsToOM)
+bool SyntaxParser_Parse(sci::Script &script, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pLog, bool fParseComments, SyntaxContext *pContext, bool addCommentsToOM, IncrementalParseState *incrementalState)
 {
+    if (incrementalState)
+    {
+        // Only ordinary full parses record what's needed for incremental parsing.
+        incrementalState->Reset(*stream.GetLimiter(), preProcessorDefines, addCommentsToOM, fParseComments);
+        if (script.IsHeader() || pContext)
+        {
+            incrementalState = nullptr;
+        }
+    }
+
     bool fRet = false;
     if (script.Language() == LangSyntaxStudio)
     {
@@ -72,7 +83,7 @@ bool SyntaxParser_Parse(sci::Script &script, CCrystalScriptStream &stream, std::
             else
             {
                 // Or maybe someone either wants error logs:
-                fRet = g_studio.Parse(script, stream.begin(), preProcessorDefines, pLog, addCommentsToOM, fParseComments);
+                fRet = g_studio.Parse(script, stream.begin(), preProcessorDefines, pLog, addCommentsToOM, fParseComments, incrementalState);
             }
         }
     }
@@ -92,7 +103,7 @@ bool SyntaxParser_Parse(sci::Script &script, CCrystalScriptStream &stream, std::
             else
             {
                 // Or maybe someone either wants error logs:
-                fRet = g_sci.Parse(script, stream.begin(), preProcessorDefines, pLog, addCommentsToOM, fParseComments);
+                fRet = g_sci.Parse(script, stream.begin(), preProcessorDefines, pLog, addCommentsToOM, fParseComments, incrementalState);
             }
         }
 
@@ -103,3 +114,20 @@ bool SyntaxParser_Parse(sci::Script &script, CCrystalScriptStream &stream, std::
     }
     return fRet;
 }
+
+bool SyntaxParser_ParseIncremental(sci::Script &script, IncrementalParseState &state, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pLog)
+{
+    bool fRet = false;
+    if (!script.IsHeader())
+    {
+        if (script.Language() == LangSyntaxStudio)
+        {
+            fRet = g_studio.ParseIncremental(script, stream, preProcessorDefines, state);
+        }
+        else if (script.Language() == LangSyntaxSCI)
+        {
+            fRet = g_sci.ParseIncremental(script, stream, preProcessorDefines, state, pLog);
+        }
+    }
+    return fRet;
+}
@@ -20,8 +20,14 @@ namespace sci
 class CCrystalScriptStream;
 class ICompileLog;
 class SyntaxContext;
+class IncrementalParseState;
 
-bool SyntaxParser_Parse(sci::Script &script, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pLog = nullptr, bool fParseComments = false, SyntaxContext *pContext = nullptr, bool addCommentsToOM = false);
+// If incrementalState is supplied, it remembers what's needed to later re-parse an edited version of the script with SyntaxParser_ParseIncremental.
+bool SyntaxParser_Parse(sci::Script &script, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pLog = nullptr, bool fParseComments = false, SyntaxContext *pContext = nullptr, bool addCommentsToOM = false, IncrementalParseState *incrementalState = nullptr);
+
+// Parses an edited version of a script in place, re-using the parts of its syntax tree that the edit didn't touch. The result is the same as a full parse.
+// Returns false, leaving the script unchanged, if that isn't possible (including when there is a syntax error). A full parse should be done instead.
+bool SyntaxParser_ParseIncremental(sci::Script &script, IncrementalParseState &state, CCrystalScriptStream &stream, std::unordered_set<std::string> preProcessorDefines, ICompileLog *pLog = nullptr);
 
 std::unordered_set<std::string> PreProcessorDefinesFromSCIVersion(SCIVersion version);
 
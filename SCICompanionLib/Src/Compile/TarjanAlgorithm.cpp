@@ -18,80 +18,272 @@
 
 using namespace std;
 
-template<typename _Func>
-void SomeFunction(DominatorMap &dominators, NodeSet &newDominators, ControlFlowNode *n, _Func func)
+// Computes immediate dominators with the iterative algorithm from Cooper, Harvey and Kennedy's
+// "A Simple, Fast Dominance Algorithm", over nodes numbered densely in reverse post order.
+// A virtual root (numbered after all the real nodes) sits above the entry and any other nodes that
+// have to be treated as entries, so that they all end up in one tree.
+DominatorMap::DominatorMap(const NodeSet &nodes, ControlFlowNode *entry, const std::function<NodeSet(ControlFlowNode*)> &edgesIn) : _singleEntry(true)
 {
-    newDominators.insert(n);
+    _nodes.reserve(nodes.size() + 1);
+    _nodes.push_back(entry);
+    _indices[entry] = 0;
+    for (ControlFlowNode *node : nodes)
+    {
+        if (_indices.emplace(node, (int)_nodes.size()).second)
+        {
+            _nodes.push_back(node);
+        }
+    }
+    _nodeCount = _nodes.size();
 
-    if (!func(n).empty())
+    // Incoming edges by index. Entries just have the virtual root.
+    int root = (int)_nodeCount;
+    vector<vector<int>> preds(_nodeCount + 1);
+    vector<vector<int>> succs(_nodeCount + 1);
+    for (size_t i = 0; i < _nodeCount; i++)
     {
-        NodeSet result;
-        bool first = true;
-        for (ControlFlowNode *pred : func(n))
+        bool isEntry = (i == 0);
+        if (!isEntry)
         {
-            if (first)
+            NodeSet nodePreds = edgesIn(_nodes[i]);
+            isEntry = nodePreds.empty();
+            for (ControlFlowNode *pred : nodePreds)
             {
-                result = dominators[pred];
-                first = false;
+                auto it = _indices.find(pred);
+                if (it == _indices.end())
+                {
+                    // An edge from outside the set. Remember the node so we can answer queries about it.
+                    it = _indices.emplace(pred, (int)_nodes.size()).first;
+                    _nodes.push_back(pred);
+                }
+                if (it->second >= (int)_nodeCount)
+                {
+                    isEntry = true;
+                }
+                else
+                {
+                    preds[i].push_back(it->second);
+                }
             }
-            else
-            {
-                NodeSet resultTemp;
-                NodeSet &temp = dominators[pred];
-                set_intersection(result.begin(), result.end(),
-                    temp.begin(), temp.end(),
-                    inserter(resultTemp, resultTemp.begin()),
-                    std::less<ControlFlowNode*>()
-                    );
+            _singleEntry = _singleEntry && !isEntry;
+        }
+        if (isEntry)
+        {
+            preds[i].assign(1, root);
+        }
+        for (int pred : preds[i])
+        {
+            succs[pred].push_back((int)i);
+        }
+    }
+    _singleEntry = _singleEntry && (_nodes.size() == _nodeCount);
 
-                swap(resultTemp, result);
+    // Reverse post order from the virtual root
+    vector<int> postOrder;
+    postOrder.reserve(_nodeCount + 1);
+    vector<bool> visited(_nodeCount + 1, false);
+    stack<pair<int, size_t>> toVisit;
+    toVisit.emplace(root, 0);
+    visited[root] = true;
+    while (!toVisit.empty())
+    {
+        int node = toVisit.top().first;
+        size_t &nextSucc = toVisit.top().second;
+        if (nextSucc < succs[node].size())
+        {
+            int succ = succs[node][nextSucc++];
+            if (!visited[succ])
+            {
+                visited[succ] = true;
+                toVisit.emplace(succ, 0);
             }
         }
-
-        for (ControlFlowNode *node : result)
+        else
         {
-            newDominators.insert(node);
+            postOrder.push_back(node);
+            toVisit.pop();
         }
     }
-    // Now look at all the predecessors p of n. 
-    // Add in the intersection of all those dominators for them.
-}
-
-template<typename _Func>
-DominatorMap GenerateDominators(NodeSet N, ControlFlowNode *n0, _Func func)
-{
-    NodeSet N_minus_n0 = N;
-    N_minus_n0.erase(n0);
+    vector<int> rpoNumber(_nodeCount + 1, -1);
+    for (size_t i = 0; i < postOrder.size(); i++)
+    {
+        rpoNumber[postOrder[i]] = (int)(postOrder.size() - 1 - i);
+    }
 
-    DominatorMap dominators;
+    const int Undefined = -1;
+    vector<int> idom(_nodeCount + 1, Undefined);
+    idom[root] = root;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto it = postOrder.rbegin(); it != postOrder.rend(); ++it)
+        {
+            int node = *it;
+            if (node == root)
+            {
+                continue;
+            }
+            int newIdom = Undefined;
+            for (int pred : preds[node])
+            {
+                if (idom[pred] == Undefined)
+                {
+                    continue;
+                }
+                if (newIdom == Undefined)
+                {
+                    newIdom = pred;
+                }
+                else
+                {
+                    // Walk up the tree from both until we meet.
+                    int finger1 = pred;
+                    int finger2 = newIdom;
+                    while (finger1 != finger2)
+                    {
+                        while (rpoNumber[finger1] > rpoNumber[finger2])
+                        {
+                            finger1 = idom[finger1];
+                        }
+                        while (rpoNumber[finger2] > rpoNumber[finger1])
+                        {
+                            finger2 = idom[finger2];
+                        }
+                    }
+                    newIdom = finger1;
+                }
+            }
+            if (idom[node] != newIdom)
+            {
+                idom[node] = newIdom;
+                changed = true;
+            }
+        }
+    }
 
-    // dominator of the start node is the start itself
-    dominators[n0].insert(n0);
+    // Number the dominator tree, so that b dominates a iff a's range is inside b's.
+    vector<vector<int>> treeChildren(_nodeCount + 1);
+    for (size_t i = 0; i < _nodeCount; i++)
+    {
+        if (idom[i] != Undefined)
+        {
+            treeChildren[idom[i]].push_back((int)i);
+        }
+    }
+    _preOrder.assign(_nodeCount + 1, -1);
+    _postOrder.assign(_nodeCount + 1, -1);
+    int preCounter = 0;
+    int postCounter = 0;
+    toVisit.emplace(root, 0);
+    _preOrder[root] = preCounter++;
+    while (!toVisit.empty())
+    {
+        int node = toVisit.top().first;
+        size_t &nextChild = toVisit.top().second;
+        if (nextChild < treeChildren[node].size())
+        {
+            int child = treeChildren[node][nextChild++];
+            _preOrder[child] = preCounter++;
+            toVisit.emplace(child, 0);
+        }
+        else
+        {
+            _postOrder[node] = postCounter++;
+            toVisit.pop();
+        }
+    }
 
-    // for all other nodes, set all nodes as the dominators
-    for (ControlFlowNode *n : N_minus_n0)
+    _idom.resize(_nodeCount);
+    vector<int> unreached;
+    for (size_t i = 0; i < _nodeCount; i++)
     {
-        dominators[n] = N;
+        _idom[i] = ((idom[i] == Undefined) || (idom[i] == root)) ? -1 : idom[i];
+        if (_preOrder[i] == -1)
+        {
+            unreached.push_back((int)i);
+        }
     }
 
-    // Iteratively eliminate nodes that are not dominators
-    bool changes = true;
-    while (changes)
+    // Nodes that can't be reached from any entry (e.g. a loop in dead code) are dominated by every node.
+    // Give them the same immediate dominator the iterative set-based calculation did: the one other
+    // node that dominates nothing else.
+    if (unreached.size() == 2)
     {
-        changes = false;
-        for (ControlFlowNode *n : N_minus_n0)
+        _idom[unreached[0]] = unreached[1];
+        _idom[unreached[1]] = unreached[0];
+    }
+    else if (unreached.size() == 1)
+    {
+        for (ControlFlowNode *node : nodes)
         {
-            NodeSet newDominatorsFor_n;
-            SomeFunction(dominators, newDominatorsFor_n, n, func);
-            if (newDominatorsFor_n != dominators[n])
+            int index = _indices.at(node);
+            if ((index != unreached[0]) && treeChildren[index].empty())
             {
-                dominators[n] = newDominatorsFor_n;
-                changes = true;
+                _idom[unreached[0]] = index;
+                break;
             }
         }
     }
 
-    return dominators;
+    for (size_t i = 1; i < _nodeCount; i++)
+    {
+        _singleEntry = _singleEntry && (_idom[i] != -1);
+    }
+}
+
+int DominatorMap::_GetIndex(ControlFlowNode *node) const
+{
+    auto it = _indices.find(node);
+    if (it == _indices.end())
+    {
+        throw std::out_of_range("Node has no dominator information");
+    }
+    return it->second;
+}
+
+bool DominatorMap::IsADominatedByB(ControlFlowNode *a, ControlFlowNode *b) const
+{
+    int indexA = _GetIndex(a);
+    if (indexA >= (int)_nodeCount)
+    {
+        // Nodes outside the set aren't dominated by anything.
+        return false;
+    }
+    auto itB = _indices.find(b);
+    if ((itB == _indices.end()) || (itB->second >= (int)_nodeCount))
+    {
+        return false;
+    }
+    int indexB = itB->second;
+    if (_preOrder[indexA] == -1)
+    {
+        // A can't be reached from any entry (e.g. an unreachable loop), so everything dominates it.
+        return true;
+    }
+    if (_preOrder[indexB] == -1)
+    {
+        return false;
+    }
+    return (_preOrder[indexB] <= _preOrder[indexA]) && (_postOrder[indexA] <= _postOrder[indexB]);
+}
+
+bool DominatorMap::HasSingleEntry() const
+{
+    return _singleEntry;
+}
+
+std::map<ControlFlowNode*, ControlFlowNode*> DominatorMap::GetImmediateDominators() const
+{
+    map<ControlFlowNode*, ControlFlowNode*> immediateDominators;
+    for (size_t i = 0; i < _nodeCount; i++)
+    {
+        if (_idom[i] != -1)
+        {
+            immediateDominators[_nodes[i]] = _nodes[_idom[i]];
+        }
+    }
+    return immediateDominators;
 }
 
 // Filter out predecessors that are a single jump with no predecessors
@@ -122,7 +314,7 @@ DominatorMap GenerateDominators(ControlFlowNode *parent, ControlFlowNode *n0)
 {
     if (parent->dirty)
     {
-        parent->dominators = make_unique<DominatorMap>(GenerateDominators(parent->Children(), n0, [](ControlFlowNode *node) { return NoJmpPreds(node); }));
+        parent->dominators = make_unique<DominatorMap>(parent->Children(), n0, [](ControlFlowNode *node) { return NoJmpPreds(node); });
         parent->dirty = false;
     }
     return *parent->dominators;
@@ -133,7 +325,7 @@ DominatorMap GeneratePostDominators(ControlFlowNode *parent, ControlFlowNode *n0
 {
     if (parent->postDirty)
     {
-        parent->postDominators = make_unique<DominatorMap>(GenerateDominators(parent->Children(), n0, [](ControlFlowNode *node) { return node->Successors(); }));
+        parent->postDominators = make_unique<DominatorMap>(parent->Children(), n0, [](ControlFlowNode *node) { return node->Successors(); });
         parent->postDirty = false;
     }
     return *parent->postDominators;
@@ -204,50 +396,12 @@ NodeSet CollectNodesBetween(ControlFlowNode *head, ControlFlowNode *tail, NodeSe
 
 map<ControlFlowNode*, ControlFlowNode*> CalculateImmediateDominators(const DominatorMap &dominatorMap)
 {
-    map<ControlFlowNode*, ControlFlowNode*> immediateDominators;
-    for (const auto &pair : dominatorMap)
-    {
-        ControlFlowNode *dominatee = pair.first;
-        // One of its dominators is its immediate dominator
-        // Its immediate dominator is the dominator that dominates it, but does not dominate any other
-        // node that dominates the dominatee.
-        // So this algorithm, I guess, is n^2 in complexity with the number of dominators for a node.
-        // (If we care about perf, we could find the guy with the highest address and it would likely be the imm dom)
-        const NodeSet &dominators = pair.second;
-
-        for (ControlFlowNode *potentialImmDom : dominators)
-        {
-            if (potentialImmDom != dominatee)   // I forget if dominator map for the dominatee includes the dominatee
-            {
-                bool found = true;
-                for (ControlFlowNode *test : dominators)
-                {
-                    if ((test != potentialImmDom) && (test != dominatee))
-                    {
-                        if (dominatorMap.at(test).contains(potentialImmDom))
-                        {
-                            // Our potential immediate dominator dominates other nodes of the dominatees dominators.
-                            // So it can't be the immediate dominator
-                            found = false;
-                            break;
-                        }
-                    }
-                }
-                if (found)
-                {
-                    immediateDominators[dominatee] = potentialImmDom;
-                    break;
-                }
-            }
-        }
-    }
-
-    if (immediateDominators.size() != (dominatorMap.size() - 1))
+    if (!dominatorMap.HasSingleEntry())
     {
         // Every node must have an immediate dominator except the header
-        throw ControlFlowException(dominatorMap.begin()->first,  "Problem with calculating dominators");
+        throw ControlFlowException(dominatorMap.GetEntry(), "Problem with calculating dominators");
     }
-    return immediateDominators;
+    return dominatorMap.GetImmediateDominators();
 }
 
 map<ControlFlowNode*, ControlFlowNode*> CalculateImmediatePostDominators(const DominatorMap &postDominators)
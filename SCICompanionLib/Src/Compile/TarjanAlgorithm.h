@@ -17,6 +17,7 @@ struct ControlFlowNode;
 
 DominatorMap GenerateDominators(ControlFlowNode *parent, ControlFlowNode *n0);
 DominatorMap GeneratePostDominators(ControlFlowNode *parent, ControlFlowNode *n0);
+NodeSet NoJmpPreds(ControlFlowNode *node);
 
 bool IsReachable(ControlFlowNode *head, ControlFlowNode *tail);
 NodeSet CollectNodesBetween(ControlFlowNode *head, ControlFlowNode *tail, NodeSet possible);
@@ -22,6 +22,9 @@
 #include "DecompilerConfig.h"
 #include "format.h"
 #include "ResourceContainer.h"
+#include "BatchDecompile.h"
+#include "DecompileScript.h"
+#include "DecompileCache.h"
 
 using namespace std;
 
@@ -794,25 +797,29 @@ void DecompileDialog::s_DecompileThreadWorker(DecompileDialog *pThis)
 
         if (pThis->_lookups)
         {
-            for (uint16_t scriptNum : scriptNumbers)
+            // Scripts are decompiled on several threads, which only read from the lookups, config and vocab.
+            // Make sure the vocab is loaded before they start.
+            appState->GetResourceMap().GetVocab000();
+            std::string debugFunctionMatch = (PCSTR)pThis->_debugFunctionMatch;
+
+            // Scripts that haven't changed since they were last decompiled come from the cache, unless we're
+            // debugging the decompiler (in which case we want it to actually run).
+            DecompileCache *cache = nullptr;
+            if (!pThis->_debugControlFlow && !pThis->_debugInstConsumption)
             {
-                if (!pThis->_decompileResults->IsAborted())
+                cache = &appState->GetResourceMap().GetDecompileCache();
+                cache->Prepare(helper, *pThis->_lookups, *pThis->_decompilerConfig, pThis->_debugAsm, pThis->_substituteTextTuples);
+            }
+
+            DecompileScripts(helper, pThis->_lookups->GetSelectorTable(), scriptNumbers, *pThis->_decompileResults,
+                [pThis, &helper, &debugFunctionMatch](uint16_t scriptNum, CompiledScript &compiledScript, IDecompilerResults &results, DecompileOutputs &outputs)
                 {
-                    pThis->_decompileResults->AddResult(DecompilerResultType::Important, fmt::format("Decompiling script {0}", scriptNum));
-                    CompiledScript compiledScript(0, CompiledScriptFlags::RemoveBadExports);
-                    if (compiledScript.Load(helper, helper.Version, scriptNum))
-                    {
-                        unique_ptr<sci::Script> pScript = DecompileScript(pThis->_decompilerConfig.get(), *pThis->_lookups, helper, scriptNum, compiledScript, *pThis->_decompileResults, pThis->_debugControlFlow, pThis->_debugInstConsumption, (PCSTR)pThis->_debugFunctionMatch, pThis->_debugAsm, pThis->_substituteTextTuples);
-                        // Dump it to the .sc file
-                        // TODO: If it already exists, we might want to ask for confirmation.
-                        std::stringstream ss;
-                        sci::SourceCodeWriter out(ss, helper.GetDefaultGameLanguage(), pScript.get());
-                        pScript->OutputSourceCode(out);
-                        string sourceFilename = helper.GetScriptFileName(scriptNum);
-                        MakeTextFile(ss.str().c_str(), sourceFilename);
-                        pThis->_decompileResults->AddResult(DecompilerResultType::Important, fmt::format("Generated {0}", sourceFilename));
-                    }
-                }
+                    return DecompileScript(pThis->_decompilerConfig.get(), *pThis->_lookups, helper, scriptNum, compiledScript, results, pThis->_debugControlFlow, pThis->_debugInstConsumption, debugFunctionMatch.c_str(), pThis->_debugAsm, pThis->_substituteTextTuples, &outputs);
+                },
+                0, cache);
+            if (cache)
+            {
+                cache->Save();
             }
             if (pThis->_decompileResults->IsAborted())
             {
@@ -851,6 +858,7 @@ void DecompilerDialogResults::AddResult(DecompilerResultType type, const std::st
 
 void DecompilerDialogResults::InformStats(bool functionSuccessful, int byteCount)
 {
+    std::lock_guard<std::mutex> lock(_statsMutex);
     if (functionSuccessful)
     {
         _successCount++;
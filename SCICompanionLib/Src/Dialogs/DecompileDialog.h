@@ -16,6 +16,7 @@
 #include "GameFolderHelper.h"
 #include "DecompilerResults.h"
 #include <future>
+#include <atomic>
 
 class CSCOFile;
 class IDecompilerConfig;
@@ -40,7 +41,8 @@ public:
     int _fallbackBytes;
 
 private:
-    bool _aborted;
+    std::mutex _statsMutex;     // InformStats is called from multiple threads
+    std::atomic<bool> _aborted;
     HWND _hwnd;
     std::vector<std::pair<std::string, std::string>> _globalsUpdated;
 };
@@ -19,6 +19,8 @@
 #include "ScriptOM.h"
 #include "NewCompileDialog.h"
 #include "ScriptDocument.h"
+#include "ParallelScriptParser.h"
+#include "BuildGraph.h"
 #include <filesystem>
 #include <regex>
 
@@ -89,9 +91,21 @@ LRESULT CNewCompileDialog::CompileAll(WPARAM wParam, LPARAM lParam)
     }
     else
     {
+        std::unique_ptr<sci::Script> script;
+        if (!_parser->TryTake(_nScript, std::chrono::milliseconds(50), _log, script))
+        {
+            // Still being parsed. Check again in a bit, so we keep pumping messages in the meantime.
+            PostMessage(UWM_STARTCOMPILE, 0, 0);
+            return 0;
+        }
+
         // Do a compile
         CompileResults results(_log);
-        NewCompileScript(results, _log, _tables, _headers, scriptId);
+        if (script)
+        {
+            GenerateParsedScript(results, _log, _tables, _headers, scriptId, *script);
+        }
+        _log.CalculateErrors();
 
         // The compile is done.  Post the results.
         appState->OutputAddBatch(OutputPaneType::Compile, _log.Results());
@@ -182,6 +196,7 @@ BOOL CNewCompileDialog::OnInitDialog()
         {
             // Set the range of the progress control.
             m_wndProgress.SetRange32(0, (int)_scripts.size());
+            _parser = std::make_unique<ParallelScriptParser>(_scripts);
             PostMessage(UWM_STARTCOMPILE, 0, 0);
         }
         else
@@ -202,6 +217,9 @@ BOOL CNewCompileDialog::OnInitDialog()
 
 void CNewCompileDialog::OnDestroy()
 {
+    // Stop any parsing still going on.
+    _parser.reset();
+
     // Do some reporting.
     std::stringstream str;
     str << _nScript << " scripts compiled.";
@@ -212,6 +230,7 @@ void CNewCompileDialog::OnDestroy()
 
     // Save any tables...
     _tables.Save();
+    appState->GetResourceMap().GetBuildGraph().Save();
 
     __super::OnDestroy();
 }
@@ -15,6 +15,8 @@
 
 #include "CompileContext.h"
 
+class ParallelScriptParser;
+
 // CCompileDialog dialog
 
 class CNewCompileDialog : public CExtResizableDialog
@@ -46,6 +48,8 @@ protected:
     CompileTables _tables;
     PrecompiledHeaders _headers;
     CompileLog _log;
+    // Parses scripts ahead of us on worker threads. Code generation happens here, in order.
+    std::unique_ptr<ParallelScriptParser> _parser;
 
     std::unordered_set<std::string> _scriptsToRecompile;
 
@@ -1077,6 +1077,21 @@ ResourceBlob *CResourceListCtrl::_GetResourceForItemRealized(int nItem)
     return blob;
 }
 
+// The lParams of the items that are currently scrolled into view.
+std::unordered_set<LPARAM> CResourceListCtrl::_GetVisibleItemParams()
+{
+    std::unordered_set<LPARAM> visible;
+    int count = GetItemCount();
+    for (int i = 0; i < count; i++)
+    {
+        if (IsItemVisible(i))
+        {
+            visible.insert((LPARAM)GetItemData(i));
+        }
+    }
+    return visible;
+}
+
 HRESULT CResourceListCtrl::_UpdateEntries()
 {
     HRESULT hr = E_FAIL;
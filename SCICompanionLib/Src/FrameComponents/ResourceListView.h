@@ -100,6 +100,7 @@ protected:
     ResourceBlob *_GetResourceForItemMetadataOnly(LPARAM lParam);
     ResourceBlob *_GetResourceForItemRealized(LPARAM lParam);
     int _GetItemForResource(const ResourceBlob *pData);
+    std::unordered_set<LPARAM> _GetVisibleItemParams();
     void _DeleteMatchingItems(int resourceNumber, int packageNumber, ResourceSourceFlags sourceFlags);
 
     int _iView;
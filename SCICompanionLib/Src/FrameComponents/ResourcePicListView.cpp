@@ -23,7 +23,6 @@
 #include "ResourceListDoc.h"
 #include "ResourceListView.h"
 #include "ResourcePicListView.h"
-#include "QueueItems.h"
 #include "PaletteOperations.h"
 #include "ResourceBlob.h"
 
@@ -42,6 +41,7 @@ IMPLEMENT_DYNCREATE(CResourcePicListCtrl, CResourceListCtrl)
 
 BEGIN_MESSAGE_MAP(CResourcePicListCtrl, CResourceListCtrl)
     ON_NOTIFY_REFLECT(LVN_GETDISPINFO, OnGetDispInfo)
+    ON_NOTIFY_REFLECT(LVN_ENDSCROLL, OnEndScroll)
     ON_NOTIFY_REFLECT(NM_DBLCLK, OnItemDoubleClick)
     ON_MESSAGE(UWM_PICREADY, OnPicReady)
 END_MESSAGE_MAP()
@@ -60,23 +60,29 @@ CResourcePicListCtrl::CResourcePicListCtrl()
 {
     _iTokenImageIndex = 0;
     _himlPics = nullptr;
-    _pQueue = nullptr;
 }
 
 CResourcePicListCtrl::~CResourcePicListCtrl()
 {
-    if (_pQueue)
-    {
-        _pQueue->Abort();
-    }
+}
+
+HBITMAP _CreatePicThumbnail(const ResourceBlob &blob, int cx, int cy)
+{
+    std::unique_ptr<ResourceEntity> picResource = CreateResourceFromResourceData(blob);
+    // Draw this pic!
+    return GetPicBitmap(PicScreen::Visual, picResource->GetComponent<PicComponent>(), picResource->TryGetComponent<PaletteComponent>(), cx, cy);
 }
 
 PICWORKRESULT *PICWORKRESULT::CreateFromWorkItem(PICWORKITEM *pWorkItem)
 {
     HBITMAP hbm = NULL;
-    std::unique_ptr<ResourceEntity> picResource = CreateResourceFromResourceData(pWorkItem->blob);
-    // Draw this pic!
-    hbm = GetPicBitmap(PicScreen::Visual, picResource->GetComponent<PicComponent>(), picResource->TryGetComponent<PaletteComponent>(), DefaultPicWidth, _GetPicBitmapHeight());
+    const ResourceBlob &blob = pWorkItem->blob;
+    const ThumbnailKey &key = pWorkItem->key;
+    std::shared_ptr<const Thumbnail> thumbnail = appState->GetThumbnailCache().GetOrCreate(key, [&blob, &key]() { return _CreatePicThumbnail(blob, key.Width, key.Height); });
+    if (thumbnail)
+    {
+        hbm = thumbnail->CreateBitmap();
+    }
 
     PICWORKRESULT *pResult = new PICWORKRESULT;
     if (pResult)
@@ -98,11 +104,25 @@ BOOL CResourcePicListCtrl::SetItemImage(int nItem , int nImageIndex)
     return SetItem(&item);
 }
 
+ThumbnailKey CResourcePicListCtrl::_GetThumbnailKey(const ResourceBlob &blob)
+{
+    ThumbnailKey key;
+    key.Type = blob.GetType();
+    key.Number = blob.GetNumber();
+    key.Base36Number = blob.GetBase36();
+    key.ContentHash = ThumbnailCache::HashResource(blob);
+    key.Context = 0;
+    key.Width = (uint16_t)DefaultPicWidth;
+    key.Height = (uint16_t)_GetPicBitmapHeight();
+    return key;
+}
+
 LRESULT CResourcePicListCtrl::OnPicReady(WPARAM wParam, LPARAM lParam)
 {
-    PICWORKRESULT *pWorkResult;
-    while (_pQueue->TakeWorkResult(&pWorkResult))
+    std::unique_ptr<PICWORKRESULT> workResult;
+    while (_scheduler && (workResult = _scheduler->RetrieveNextResponse()))
     {
+        PICWORKRESULT *pWorkResult = workResult.get();
         int cItems = GetItemCount();
         for (int i = 0; i < cItems; i++)
         {
@@ -121,7 +141,6 @@ LRESULT CResourcePicListCtrl::OnPicReady(WPARAM wParam, LPARAM lParam)
                 break;
             }
         }
-        delete pWorkResult;
     }
     return 0;
 }
@@ -134,13 +153,31 @@ void CResourcePicListCtrl::OnGetDispInfo(NMHDR* pNMHDR, LRESULT* pResult)
     { 
         if (_iView == LVS_ICON)
         {
-            if (_pQueue)
+            if (_scheduler)
             {
                 ResourceBlob *pData = _GetResourceForItemRealized(pItem->lParam);
-                unique_ptr<PICWORKITEM> pWorkItem = make_unique<PICWORKITEM>();
-                pWorkItem->blob = *pData;
-                _pQueue->GiveWorkItem(move(pWorkItem));
-                pItem->iImage = _iTokenImageIndex; // Done!
+                ThumbnailKey key = _GetThumbnailKey(*pData);
+                std::shared_ptr<const Thumbnail> thumbnail = appState->GetThumbnailCache().LookupInMemory(key);
+                int iImage = -1;
+                if (thumbnail)
+                {
+                    // We've drawn this before, no need to go to the background thread.
+                    HBITMAP hbm = thumbnail->CreateBitmap();
+                    iImage = ImageList_Add(_himlPics, hbm, NULL);
+                    DeleteObject(hbm);
+                }
+                if (iImage == -1)
+                {
+                    unique_ptr<PICWORKITEM> pWorkItem = make_unique<PICWORKITEM>();
+                    pWorkItem->blob = *pData;
+                    pWorkItem->lParam = pItem->lParam;
+                    pWorkItem->key = key;
+                    _scheduler->SubmitTask(move(pWorkItem),
+                        [](ITaskStatus &status, PICWORKITEM &workItem) { return unique_ptr<PICWORKRESULT>(PICWORKRESULT::CreateFromWorkItem(&workItem)); },
+                        ThumbnailPriorityVisible);
+                    iImage = _iTokenImageIndex;
+                }
+                pItem->iImage = iImage; // Done!
                 pItem->mask |= LVIF_DI_SETITEM; // So we don't ask for it again.
             }
         }
@@ -149,6 +186,20 @@ void CResourcePicListCtrl::OnGetDispInfo(NMHDR* pNMHDR, LRESULT* pResult)
     *pResult = 0; 
 }
 
+void CResourcePicListCtrl::OnEndScroll(NMHDR* pNMHDR, LRESULT* pResult)
+{
+    // Generate thumbnails for what the user is looking at now, before the ones that were scrolled past.
+    if (_scheduler)
+    {
+        std::unordered_set<LPARAM> visible = _GetVisibleItemParams();
+        _scheduler->Reprioritize([&visible](const PICWORKITEM &workItem)
+        {
+            return (visible.find(workItem.lParam) != visible.end()) ? ThumbnailPriorityVisible : ThumbnailPriorityOffscreen;
+        });
+    }
+    *pResult = 0;
+}
+
 void CResourcePicListCtrl::_RegenerateImages()
 {
     int count = this->GetItemCount();
@@ -203,18 +254,8 @@ void CResourcePicListCtrl::_OnInitListView(int cItems)
     }
 
     // Prepare our worker thread.
-    if (_pQueue)
-    {
-        _pQueue->Abort();
-    }
-    _pQueue = std::make_shared<QueueItems<PICWORKITEM, PICWORKRESULT>>(GetSafeHwnd(), UWM_PICREADY);
-    if (_pQueue)
-    {
-        if (!_pQueue->Init())
-        {
-            _pQueue = nullptr;
-        }
-    }
+    _scheduler.reset();
+    _scheduler = std::make_unique<BackgroundScheduler<PICWORKITEM, PICWORKRESULT>>(GetSafeHwnd(), UWM_PICREADY);
 
     // LVS_EX_BORDERSELECT, supported on IE 4.0 or later. -> Removed, as it causes problems in details view
     // LVS_EX_DOUBLEBUFFER, supported on XP or later.
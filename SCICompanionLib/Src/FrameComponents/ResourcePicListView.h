@@ -18,14 +18,17 @@
 #pragma once
 
 #include "ResourceListView.h"
-#include "QueueItems.h"
+#include "Task.h"
 #include "ResourceBlob.h"
+#include "ThumbnailCache.h"
 
 // This is created by the UI thread, and deleted by the worker thread.
 class PICWORKITEM
 {
 public:
     ResourceBlob blob;
+    LPARAM lParam;
+    ThumbnailKey key;
 };
 
 
@@ -68,11 +71,13 @@ public:
 #endif
     void OnGetDispInfo(NMHDR* pNMHDR, LRESULT* pResult);
     void OnItemChanged(NMHDR* pNMHDR, LRESULT* pResult);
+    void OnEndScroll(NMHDR* pNMHDR, LRESULT* pResult);
 
 protected:
     virtual void _PrepareLVITEM(LVITEM *pItem);
     virtual void _OnInitListView(int cItems);
     void _RegenerateImages() override;
+    ThumbnailKey _GetThumbnailKey(const ResourceBlob &blob);
 
 // Generated message map functions
 protected:
@@ -85,6 +90,6 @@ private:
     HIMAGELIST _himlPics;
 
     int _iTokenImageIndex;
-    std::shared_ptr<QueueItems<PICWORKITEM, PICWORKRESULT>> _pQueue;
+    std::unique_ptr<BackgroundScheduler<PICWORKITEM, PICWORKRESULT>> _scheduler;
 };
 
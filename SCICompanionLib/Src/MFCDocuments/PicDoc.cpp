@@ -50,7 +50,7 @@ END_MESSAGE_MAP()
 
 // CPicDoc construction/destruction
 
-CPicDoc::CPicDoc() : _previewPalette(nullptr), _showPolygons(false), _currentPolyIndex(-1), _fakeEgoResourceNumber(-1), _dependencyTracker(nullptr), _isUndithered(false)
+CPicDoc::CPicDoc() : _pdm(nullptr, nullptr, false, true), _previewPalette(nullptr), _showPolygons(false), _currentPolyIndex(-1), _fakeEgoResourceNumber(-1), _dependencyTracker(nullptr), _isUndithered(false), _firstChangedCommand(0)
 {
     // Add ourselves as a sync
     CResourceMap &map = appState->GetResourceMap();
@@ -345,8 +345,10 @@ void CPicDoc::InsertCommand(PicCommand *pCommand)
     ptrdiff_t delta = 0;
     ptrdiff_t pos = _pdm.GetPos();
     ApplyChangesWithPost<PicComponent>(
-        [pCommand, &delta, pos](PicComponent &pic)
+        [this, pCommand, &delta, pos](PicComponent &pic)
     {
+        // (InsertCommands may replace the command before pos)
+        _firstChangedCommand = max((ptrdiff_t)0, ((pos == -1) ? (ptrdiff_t)pic.commands.size() : pos) - 1);
         delta = ::InsertCommands(pic, pos, 1, pCommand);
         return WrapHint(PicChangeHint::EditPicInvalid | PicChangeHint::EditPicPos);
     },
@@ -362,8 +364,9 @@ void CPicDoc::InsertCommands(INT_PTR iStart, INT_PTR cCount, PicCommand *pComman
     INT_PTR iPos = _pdm.GetPos();
 
     ApplyChangesWithPost<PicComponent>(
-        [iStart, cCount, pCommands](PicComponent &pic)
+        [this, iStart, cCount, pCommands](PicComponent &pic)
     {
+        _firstChangedCommand = max((ptrdiff_t)0, ((iStart == -1) ? (ptrdiff_t)pic.commands.size() : iStart) - 1);
         ::InsertCommands(pic, iStart, cCount, pCommands);
         return WrapHint(PicChangeHint::EditPicInvalid | PicChangeHint::EditPicPos);
     },
@@ -386,8 +389,9 @@ void CPicDoc::RemoveCommand(INT_PTR iCommandIndex)
 {
     INT_PTR iPos = _pdm.GetPos();
     ApplyChangesWithPost<PicComponent>(
-        [iCommandIndex](PicComponent &pic)
+        [this, iCommandIndex](PicComponent &pic)
     {
+        _firstChangedCommand = max((ptrdiff_t)0, iCommandIndex);
         ::RemoveCommand(pic, iCommandIndex);
         return WrapHint(PicChangeHint::EditPicInvalid | PicChangeHint::EditPicPos);
     },
@@ -411,8 +415,9 @@ void CPicDoc::RemoveCommandRange(INT_PTR iStart, INT_PTR iEnd)
     INT_PTR iPos = _pdm.GetPos();
 
     ApplyChangesWithPost<PicComponent>(
-        [iStart, iEnd](PicComponent &pic)
+        [this, iStart, iEnd](PicComponent &pic)
     {
+        _firstChangedCommand = max((ptrdiff_t)0, iStart);
         ::RemoveCommandRange(pic, iStart, iEnd);
         return WrapHint(PicChangeHint::EditPicInvalid | PicChangeHint::EditPicPos);
     },
@@ -484,7 +489,8 @@ void CPicDoc::PostApplyChanges(CObject *pObj)
     }
 
     // Invalidate our pic before we update views..
-    _pdm.Invalidate();
+    _pdm.Invalidate(_firstChangedCommand);
+    _firstChangedCommand = 0;
 }
 
 bool CPicDoc::v_IsVGA()
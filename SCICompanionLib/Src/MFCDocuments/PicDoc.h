@@ -174,6 +174,9 @@ private:
 
     void PostApplyChanges(CObject *pObj) override;
 
+    // The first command affected by the change being applied. The draw manager can keep what it drew before that.
+    ptrdiff_t _firstChangedCommand;
+
     // Pattern state.  We do not use the pattern state
     // from the current position in the pic.  Instead, we store our
     // own pattern state in the document.
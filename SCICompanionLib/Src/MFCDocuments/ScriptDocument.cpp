@@ -41,6 +41,7 @@
 #include "format.h"
 #include "ResourceBlob.h"
 #include "DependencyTracker.h"
+#include "BuildGraph.h"
 #include "OutputCodeHelper.h"
 #include "ScriptConvert.h"
 #include <filesystem>
@@ -149,6 +150,7 @@ void CScriptDocument::OnCompile()
         {
             tables.Save();
         }
+        appState->GetResourceMap().GetBuildGraph().Save();
 
         // put a timestamp in.
         char sz[100];
@@ -215,11 +217,13 @@ std::unique_ptr<sci::Script> SimpleCompile(CompileLog &log, ScriptId &scriptId,
     return script;
 }
 
-bool NewCompileScript(CompileResults &results, CompileLog &log, CompileTables &tables, PrecompiledHeaders &headers, ScriptId &script)
+//
+// Loads and parses a script in preparation for compiling it. This doesn't touch any shared compile state,
+// so it can be done on any thread. Returns nullptr if the script couldn't be loaded or parsed.
+//
+std::unique_ptr<sci::Script> ParseScriptForCompile(CompileLog &log, ScriptId &script)
 {
-    bool fRet = false;
-	ClassBrowserLock lock(appState->GetClassBrowser());
-    lock.Lock();
+    std::unique_ptr<sci::Script> pScriptRet;
 
     // Make a new buffer.
     CCrystalTextBuffer buffer;
@@ -238,72 +242,114 @@ bool NewCompileScript(CompileResults &results, CompileLog &log, CompileTables &t
                     CompileResult(fmt::format("Script {0} ({1}) declared itself as resource {2}", script.GetResourceNumber(), script.GetTitle(), pScript->GetScriptNumber()),
                     CompileResult::CompileResultType::CRT_Warning));
             }
+            pScriptRet = std::move(pScript);
+        }
+        buffer.FreeAll();
+    }
+    return pScriptRet;
+}
 
-            // Compile and save script resource.
-            // Compile our own script!
-            if (GenerateScriptResource(appState->GetVersion(), *pScript, headers, tables, results, appState->GetResourceMap().Helper().GetGenerateDebugInfo()))
+//
+// Generates code for a script returned by ParseScriptForCompile, and saves the resulting resources.
+// This updates the compile tables and reads other scripts' .sco files, so scripts need to go through
+// here one at a time, in a consistent order. The caller is responsible for calling log.CalculateErrors().
+//
+bool GenerateParsedScript(CompileResults &results, CompileLog &log, CompileTables &tables, PrecompiledHeaders &headers, ScriptId &script, sci::Script &parsedScript)
+{
+    bool fRet = false;
+	ClassBrowserLock lock(appState->GetClassBrowser());
+    lock.Lock();
+
+    // Compile and save script resource.
+    // Compile our own script!
+    if (GenerateScriptResource(appState->GetVersion(), parsedScript, headers, tables, results, appState->GetResourceMap().Helper().GetGenerateDebugInfo()))
+    {
+        WORD wNum = results.GetScriptNumber();
+
+        // Save the text resource - but only if it's different than what's there (otherwise needless text resource turds pile up)
+        if (!results.GetTextComponent().Texts.empty())
+        {
+            assert(script.Language() != LangSyntaxStudio);
+
+            ResourceEntity &textResource = results.GetTextResource();
+            // Mark it as being auto-generated by a script compile:
+            textResource.GetComponent<TextComponent>().AddString(AutoGenTextSentinel);
+
+            auto existingTextResource = appState->GetResourceMap().CreateResourceFromNumber(ResourceType::Text, textResource.ResourceNumber);
+            if (!existingTextResource || !existingTextResource->GetComponent<TextComponent>().AreTextsEqual(textResource.GetComponent<TextComponent>()))
             {
-                WORD wNum = results.GetScriptNumber();
+                appState->GetResourceMap().AppendResource(textResource, appState->GetVersion().DefaultVolumeFile, textResource.ResourceNumber, "");
+                log.ReportResult(
+                    CompileResult(fmt::format("Text resource {1} changed. Added {0} entries.", results.GetTextComponent().Texts.size(), textResource.ResourceNumber),
+                    CompileResult::CompileResultType::CRT_Message)
+                    );
+            } // Else don't save.
+        }
 
-                // Save the text resource - but only if it's different than what's there (otherwise needless text resource turds pile up)
-                if (!results.GetTextComponent().Texts.empty())
-                {
-                    assert(script.Language() != LangSyntaxStudio);
-
-                    ResourceEntity &textResource = results.GetTextResource();
-                    // Mark it as being auto-generated by a script compile:
-                    textResource.GetComponent<TextComponent>().AddString(AutoGenTextSentinel);
-
-                    auto existingTextResource = appState->GetResourceMap().CreateResourceFromNumber(ResourceType::Text, textResource.ResourceNumber);
-                    if (!existingTextResource || !existingTextResource->GetComponent<TextComponent>().AreTextsEqual(textResource.GetComponent<TextComponent>()))
-                    {
-                        appState->GetResourceMap().AppendResource(textResource, appState->GetVersion().DefaultVolumeFile, textResource.ResourceNumber, "");
-                        log.ReportResult(
-                            CompileResult(fmt::format("Text resource {1} changed. Added {0} entries.", results.GetTextComponent().Texts.size(), textResource.ResourceNumber),
-                            CompileResult::CompileResultType::CRT_Message)
-                            );
-                    } // Else don't save.
-                }
+        // Update any tables that need to be modified (global class table, selector table)
 
-                // Update any tables that need to be modified (global class table, selector table)
+        CPrecisionTimer timer;
+        timer.Start();
 
-                // Save the script resource
-                std::vector<BYTE> &output = results.GetScriptResource();
-                const GameFolderHelper &helper = appState->GetResourceMap().Helper();
-                appState->GetResourceMap().AppendResource(ResourceBlob(helper, nullptr, ResourceType::Script, output, helper.Version.DefaultVolumeFile, wNum, NoBase36, helper.Version, helper.GetDefaultSaveSourceFlags()));
+        // Save the script resource
+        std::vector<BYTE> &output = results.GetScriptResource();
+        const GameFolderHelper &helper = appState->GetResourceMap().Helper();
+        appState->GetResourceMap().AppendResource(ResourceBlob(helper, nullptr, ResourceType::Script, output, helper.Version.DefaultVolumeFile, wNum, NoBase36, helper.Version, helper.GetDefaultSaveSourceFlags()));
 
-                std::vector<BYTE> &outputHep = results.GetHeapResource();
-                if (!outputHep.empty())
-                {
-                    appState->GetResourceMap().AppendResource(ResourceBlob(helper, nullptr, ResourceType::Heap, outputHep, helper.Version.DefaultVolumeFile, wNum, NoBase36, helper.Version, helper.GetDefaultSaveSourceFlags()));
-                }
+        std::vector<BYTE> &outputHep = results.GetHeapResource();
+        if (!outputHep.empty())
+        {
+            appState->GetResourceMap().AppendResource(ResourceBlob(helper, nullptr, ResourceType::Heap, outputHep, helper.Version.DefaultVolumeFile, wNum, NoBase36, helper.Version, helper.GetDefaultSaveSourceFlags()));
+        }
 
-                appState->GetDependencyTracker().ClearScript(pScript->GetScriptId());
+        appState->GetDependencyTracker().ClearScript(parsedScript.GetScriptId());
 
-                // Save the corresponding sco file.
-                CSCOFile &sco = results.GetSCO();
-                {
-                    SaveSCOFile(helper, sco, script);
-                }
+        // Save the corresponding sco file.
+        CSCOFile &sco = results.GetSCO();
+        {
+            SaveSCOFile(helper, sco, script);
+        }
 
-                if (!results.GetDebugInfo().empty())
-                {
-                    // Save debug information.
-                    std::string scdFileName = helper.GetScriptDebugFileName(script.GetResourceNumber());
-                    ofstream scdFile(scdFileName.c_str(), ios::out | ios::binary);
-                    // REVIEW: yucky
-                    scdFile.write((const char *)&results.GetDebugInfo()[0], (std::streamsize)results.GetDebugInfo().size());
-                    scdFile.close();
-                }
-                fRet = true;
-            }
+        if (!results.GetDebugInfo().empty())
+        {
+            // Save debug information.
+            std::string scdFileName = helper.GetScriptDebugFileName(script.GetResourceNumber());
+            ofstream scdFile(scdFileName.c_str(), ios::out | ios::binary);
+            // REVIEW: yucky
+            scdFile.write((const char *)&results.GetDebugInfo()[0], (std::streamsize)results.GetDebugInfo().size());
+            scdFile.close();
         }
-        log.CalculateErrors();
-        buffer.FreeAll();
+        results.Timings.Write += timer.Stop();
+
+        // Remember what went into this, so we can tell later if it needs to be recompiled.
+        appState->GetResourceMap().GetBuildGraph().RecordCompile(appState->GetResourceMap(), script, wNum, headers.GetCurrentHeaders(), results.Inputs);
+        fRet = true;
+    }
+    else
+    {
+        appState->GetResourceMap().GetBuildGraph().Forget(script);
     }
     return fRet;
 }
 
+bool NewCompileScript(CompileResults &results, CompileLog &log, CompileTables &tables, PrecompiledHeaders &headers, ScriptId &script)
+{
+    bool fRet = false;
+	ClassBrowserLock lock(appState->GetClassBrowser());
+    lock.Lock();
+
+    CPrecisionTimer timer;
+    timer.Start();
+    std::unique_ptr<sci::Script> pScript = ParseScriptForCompile(log, script);
+    results.Timings.Parse += timer.Stop();
+    if (pScript)
+    {
+        fRet = GenerateParsedScript(results, log, tables, headers, script, *pScript);
+    }
+    log.CalculateErrors();
+    return fRet;
+}
+
 void DisassembleScript(WORD wScript)
 {
     CompiledScript compiledScript(0);
@@ -372,7 +418,7 @@ void FixDuplicateObjectNames(CompiledScript &compiledScript, const SelectorTable
     }
 }
 
-std::unique_ptr<sci::Script> DecompileScript(const IDecompilerConfig *config, GlobalCompiledScriptLookups &scriptLookups, const GameFolderHelper &helper, WORD wScript, CompiledScript &compiledScript, IDecompilerResults &results, bool debugControlFlow, bool debugInstConsumption, PCSTR pszDebugFilter, bool decompileAsm, bool substituteTextTuples)
+std::unique_ptr<sci::Script> DecompileScript(const IDecompilerConfig *config, GlobalCompiledScriptLookups &scriptLookups, const GameFolderHelper &helper, WORD wScript, CompiledScript &compiledScript, IDecompilerResults &results, bool debugControlFlow, bool debugInstConsumption, PCSTR pszDebugFilter, bool decompileAsm, bool substituteTextTuples, DecompileOutputs *outputs)
 {
     unique_ptr<sci::Script> pScript;
     ObjectFileScriptLookups objectFileLookups(helper, scriptLookups.GetSelectorTable());
@@ -386,13 +432,21 @@ std::unique_ptr<sci::Script> DecompileScript(const IDecompilerConfig *config, Gl
 
     FixDuplicateObjectNames(compiledScript, config->GetSelectorTable());
 
+    // Note which parts of the config are consulted, so a cached result can tell if a change to it matters.
+    unique_ptr<IDecompilerConfig> recordingConfig;
+    if (outputs)
+    {
+        recordingConfig = CreateRecordingDecompilerConfig(*config, outputs->ConfigEntriesUsed);
+        config = recordingConfig.get();
+    }
+
     DecompileLookups decompileLookups(config, helper, wScript, &scriptLookups, &objectFileLookups, &compiledScript, pText, &compiledScript, results);
     decompileLookups.DebugControlFlow = debugControlFlow;
     decompileLookups.DebugInstructionConsumption = debugInstConsumption;
     decompileLookups.pszDebugFilter = pszDebugFilter;
     decompileLookups.DecompileAsm = decompileAsm;
     decompileLookups.SubstituteTextTuples = substituteTextTuples;
-    pScript.reset(Decompile(helper, compiledScript, decompileLookups, appState->GetResourceMap().GetVocab000()));
+    pScript.reset(Decompile(helper, compiledScript, decompileLookups, appState->GetResourceMap().GetVocab000(), outputs));
 
     if (helper.Language == LangSyntaxSCI)
     {
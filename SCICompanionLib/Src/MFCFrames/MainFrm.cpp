@@ -62,6 +62,8 @@
 #include "ResourceBlob.h"
 #include "GenerateDocsDialog.h"
 #include "DependencyTracker.h"
+#include "BuildGraph.h"
+#include "CompileContext.h"
 #include "MessageSource.h"
 #include "ValidateSaid.h"
 #include "OutputScriptStrings.h"
@@ -881,10 +883,15 @@ LRESULT CMainFrame::OnExtMenuPrepare(WPARAM wParam, LPARAM)
                 {
                     text = blob->GetName();
 
-                    auto resource = CreateResourceFromResourceData(*blob);
+                    // Only the first cel is shown, so don't decode the others.
+                    auto resource = CreateDeferredResourceFromResourceData(*blob);
+                    RasterComponent raster = *resource->TryGetComponentHeaders<RasterComponent>();
+                    if ((raster.LoopCount() > 0) && (raster.CelCount(0) > 0))
+                    {
+                        ReadCelImageData(*resource, CelIndex(0, 0), raster.GetCel(CelIndex(0, 0)));
+                    }
 
                     // Incorporate the global palette if necessary
-                    auto &raster = resource->GetComponent<RasterComponent>();
                     PaletteComponent *palette = nullptr;
                     std::unique_ptr<PaletteComponent> temp;
                     if (raster.Traits.PaletteType == PaletteType::VGA_256)
@@ -1922,6 +1929,10 @@ void PurgeUnnecessaryResources()
                 stat.second.TotalSize / 1024,
                 ((float)stat.second.TotalSize / (float)totalSize) * 100.0f
             );
+            if (stat.second.CompressedCount)
+            {
+                result += fmt::format(", {0} compressed ({1}KB saved)", stat.second.CompressedCount, stat.second.CompressionSavings / 1024);
+            }
             statResults.emplace_back(result, CompileResult::CompileResultType::CRT_Message);
         }
         appState->OutputResults(OutputPaneType::Compile, statResults);
@@ -1994,13 +2005,41 @@ void CMainFrame::OnNewScript()
     _OnNewScriptDialog(dialog);
 }
 
+// Recompiling a script can change its .sco, so we may need a few rounds before everything is up to date.
+const int MaxBuildRounds = 10;
+
+// Finds the scripts whose inputs have changed since they were last compiled. Scripts the build graph
+// doesn't know about are recompiled if the dependency tracker says they're dirty.
+void _GetScriptsToBuild(AppState *appState, DependencyTracker *dependencyTracker, std::unordered_set<std::string> &scriptsToRecompile)
+{
+    std::unordered_set<std::string> dirtyScripts;
+    std::unordered_set<std::string> unknownScripts;
+    if (dependencyTracker)
+    {
+        dependencyTracker->GetScriptsToRecompile(dirtyScripts, true);
+    }
+
+    std::vector<ScriptId> scripts;
+    appState->GetResourceMap().GetAllScripts(scripts);
+    CompileTables tables;
+    tables.Load(appState->GetVersion());
+    appState->GetResourceMap().GetBuildGraph().GetOutOfDateScripts(appState->GetResourceMap(), tables, scripts, scriptsToRecompile, unknownScripts);
+    for (const std::string &dirtyScript : dirtyScripts)
+    {
+        if (unknownScripts.find(dirtyScript) != unknownScripts.end())
+        {
+            scriptsToRecompile.insert(dirtyScript);
+        }
+    }
+}
+
 // If dependencyTracker is null, all are compiled.
 bool CompileABunchOfScripts(AppState *appState, DependencyTracker *dependencyTracker)
 {
     std::unordered_set<std::string> scriptsToRecompile;
     if (dependencyTracker)
     {
-        dependencyTracker->GetScriptsToRecompile(scriptsToRecompile, true);
+        _GetScriptsToBuild(appState, dependencyTracker, scriptsToRecompile);
     }
     if (dependencyTracker && scriptsToRecompile.empty())
     {
@@ -2015,13 +2054,28 @@ bool CompileABunchOfScripts(AppState *appState, DependencyTracker *dependencyTra
     // Clear out results
     appState->ShowOutputPane(OutputPaneType::Compile);
     appState->OutputClearResults(OutputPaneType::Compile);
+    int round = 0;
+    do
     {
-        DeferResourceAppend defer(appState->GetResourceMap());
-        CNewCompileDialog dialog(scriptsToRecompile);
-        dialog.DoModal();
-        result = !dialog.HasErrors();
-        defer.Commit();
-    }
+        bool aborted = false;
+        {
+            DeferResourceAppend defer(appState->GetResourceMap());
+            CNewCompileDialog dialog(scriptsToRecompile);
+            dialog.DoModal();
+            result = !dialog.HasErrors();
+            aborted = dialog.GetAborted();
+            defer.Commit();
+        }
+
+        // Scripts that use one whose .sco just changed are now out of date. If the .sco files
+        // came out the same, this finds nothing.
+        scriptsToRecompile.clear();
+        round++;
+        if (dependencyTracker && result && !aborted && (round < MaxBuildRounds))
+        {
+            _GetScriptsToBuild(appState, nullptr, scriptsToRecompile);
+        }
+    } while (!scriptsToRecompile.empty());
 
     timer.Stop();
 
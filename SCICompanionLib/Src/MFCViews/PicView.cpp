@@ -1515,6 +1515,45 @@ void CPicView::InvalidateOurselvesImmediately()
     RedrawWindow();
 }
 
+//
+// Like InvalidateOurselvesImmediately, but only repaints the part of the window that covers the
+// pixels that changed in the pic. If we're showing things on top of the pic that might have changed
+// too, then everything is repainted.
+//
+void CPicView::_InvalidatePicChangesImmediately()
+{
+    CRect rectChanged = _shownScreen.GetChangedRect(_GetDrawManager(), _mainViewScreen, PicPosition::PostPlugin, _GetPicSize());
+    const ViewPort *viewPort = _GetDrawManager().GetViewPort(PicPosition::PostPlugin);
+    bool overlaysChanged = (_fGridLines && (_currentTool == Command)) ||
+        (_fDrawingLine && !IsFlagSet(viewPort->dwDrawEnable, PicScreenToFlags(_mainViewScreen))) ||
+        !_pastedCommands.empty() ||
+        _transformingCoords ||
+        _fShowingEgo ||
+        _fShowPriorityLines ||
+        (_currentTool == Polygons);
+    if (overlaysChanged)
+    {
+        InvalidateOurselvesImmediately();
+    }
+    else if (!rectChanged.IsRectEmpty())
+    {
+        _isDrawUpToDate = PicScreenFlags::None;
+
+        // Map it to the window the same way OnDraw does.
+        CSize sizePic(_GetPicSize().cx, _GetPicSize().cy);
+        int cyPicScreen = GetPicScreenHeight();
+        CPoint gutter = _GetGutterOffset();
+        CPoint ptDest(-_xOrigin + gutter.x, -_yOrigin + gutter.y);
+        CRect rectClient(
+            ptDest.x + rectChanged.left * _cxPic / sizePic.cx,
+            ptDest.y + rectChanged.top * cyPicScreen / sizePic.cy,
+            ptDest.x + (rectChanged.right * _cxPic + sizePic.cx - 1) / sizePic.cx,
+            ptDest.y + (rectChanged.bottom * cyPicScreen + sizePic.cy - 1) / sizePic.cy);
+        rectClient.InflateRect(1, 1);
+        RedrawWindow(&rectClient);
+    }
+}
+
 LRESULT CPicView::OnMouseLeave(WPARAM wParam, LPARAM lParam)
 {
     _fMouseWithin = FALSE;
@@ -2020,7 +2059,7 @@ void CPicView::OnMouseMove(UINT nFlags, CPoint point)
 
     if (needsImmediateUpdate)
     {
-        InvalidateOurselvesImmediately();
+        _InvalidatePicChangesImmediately();
     }
 
     if (fUpdateCursor)
@@ -2715,7 +2754,29 @@ void CPicView::OnDraw(CDC *pDC)
 
         // Now blt back to the real DC.
         // Now we want to copy it back to the real dc.
-        pDC->StretchBlt(-_xOrigin + gutter.x, -_yOrigin + gutter.y, _cxPic, GetPicScreenHeight(), &dcMem, 0, 0, _GetPicSize().cx, _GetPicSize().cy, SRCCOPY);
+        CSize sizePic(_GetPicSize().cx, _GetPicSize().cy);
+        int cyPicScreen = GetPicScreenHeight();
+        CPoint ptDest(-_xOrigin + gutter.x, -_yOrigin + gutter.y);
+        CRect rectClip;
+        if (((_cxPic % sizePic.cx) == 0) && ((cyPicScreen % sizePic.cy) == 0) && (pDC->GetClipBox(&rectClip) != ERROR))
+        {
+            // Only copy the part that needs painting. When zoomed in, that can be much less than the whole pic.
+            int zoomX = _cxPic / sizePic.cx;
+            int zoomY = cyPicScreen / sizePic.cy;
+            rectClip.OffsetRect(-ptDest);
+            CRect rectSource(rectClip.left / zoomX, rectClip.top / zoomY, (rectClip.right + zoomX - 1) / zoomX, (rectClip.bottom + zoomY - 1) / zoomY);
+            CRect rectPic(CPoint(0, 0), sizePic);
+            rectSource.IntersectRect(&rectSource, &rectPic);
+            if (!rectSource.IsRectEmpty())
+            {
+                pDC->StretchBlt(ptDest.x + rectSource.left * zoomX, ptDest.y + rectSource.top * zoomY, rectSource.Width() * zoomX, rectSource.Height() * zoomY,
+                    &dcMem, rectSource.left, rectSource.top, rectSource.Width(), rectSource.Height(), SRCCOPY);
+            }
+        }
+        else
+        {
+            pDC->StretchBlt(ptDest.x, ptDest.y, _cxPic, cyPicScreen, &dcMem, 0, 0, sizePic.cx, sizePic.cy, SRCCOPY);
+        }
 
         dcMem.SelectObject(hgdiObj);
     }
@@ -3157,6 +3218,7 @@ void CPicView::_OnDraw(CDC* pDC, PicScreen screen)
     {
         StretchDIBits((HDC)*pDC, 0, 0, _GetPicSize().cx, _GetPicSize().cy, 0, 0, _GetPicSize().cx, _GetPicSize().cy, displayBits, pbmi, DIB_RGB_COLORS, SRCCOPY);
         delete pbmi;
+        _shownScreen.MarkShown(_GetDrawManager(), screen, PicPosition::PostPlugin, _GetPicSize());
 
         // Draw a special line for when line-drawing is "invisible".  We can't do this directly
         // on the bits, because the line drawing functions don't support dotted lines.
@@ -3262,11 +3324,16 @@ void CPicView::OnUpdate(CView *pSender, LPARAM lHint, CObject *pHint)
         _cxPic = iZoom * _GetPicSize().cx;
     }
 
-    if (IsFlagSet(hint, PicChangeHint::NewPic | PicChangeHint::EditPicPos | PicChangeHint::Palette | PicChangeHint::EditPicInvalid | PicChangeHint::PreviewPalette))
+    if (IsFlagSet(hint, PicChangeHint::NewPic | PicChangeHint::Palette | PicChangeHint::PreviewPalette))
     {
         // Need to redraw the pic, yup
         InvalidateOurselvesImmediately();
     }
+    else if (IsFlagSet(hint, PicChangeHint::EditPicPos | PicChangeHint::EditPicInvalid))
+    {
+        // Just the pic contents changed, so only repaint those parts.
+        _InvalidatePicChangesImmediately();
+    }
 
     if (IsFlagSet(hint, PicChangeHint::PolygonChoice | PicChangeHint::PolygonsChanged))
     {
@@ -3310,7 +3377,7 @@ BOOL CPicView::OnEraseBkgnd(CDC *pDC)
 
 void CPicView::_OnHistoryLClick(CPoint point)
 {
-    size_t iPos = _GetDrawManager().PosFromPoint(point.x, point.y, -1);
+    size_t iPos = _GetDrawManager().PosFromPoint(point.x, point.y, _mainViewScreen);
 
     // We'll set the pos!
     GetDocument()->SeekToPos(iPos);
@@ -3318,7 +3385,7 @@ void CPicView::_OnHistoryLClick(CPoint point)
 
 void CPicView::_OnHistoryRClick(CPoint point)
 {
-    size_t iPos = _GetDrawManager().PosFromPoint(point.x, point.y, -1);
+    size_t iPos = _GetDrawManager().PosFromPoint(point.x, point.y, _mainViewScreen);
     iPos++;
 
     // We'll set the pos!
@@ -118,6 +118,7 @@ public:
 
 protected:
     CPoint _GetGutterOffset();
+    void _InvalidatePicChangesImmediately();
     const PicComponent *_GetEditPic() const;
     void _ClampPoint(point16 &point);
     void _ClampPoint(CPoint &point);
@@ -342,6 +343,7 @@ private:
 
     // Which screen are we drawing?
     PicScreen _mainViewScreen;
+    PicShownScreen _shownScreen;    // What we last painted, so we can repaint just what changed
 
     BYTE _bRandomNR;
 
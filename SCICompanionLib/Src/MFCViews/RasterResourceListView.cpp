@@ -45,6 +45,7 @@ IMPLEMENT_DYNCREATE(CRasterResourceListCtrl, CResourceListCtrl)
 BEGIN_MESSAGE_MAP(CRasterResourceListCtrl, CResourceListCtrl)
     ON_NOTIFY_REFLECT(LVN_GETDISPINFO, OnGetDispInfo)
     ON_NOTIFY_REFLECT(LVN_ITEMCHANGED, OnItemChanged)
+    ON_NOTIFY_REFLECT(LVN_ENDSCROLL, OnEndScroll)
     ON_NOTIFY_REFLECT(NM_DBLCLK, OnItemDoubleClick)
     ON_MESSAGE(UWM_IMAGEREADY, OnImageReady)
 END_MESSAGE_MAP()
@@ -56,16 +57,12 @@ CRasterResourceListCtrl::CRasterResourceListCtrl()
     _himlPics = nullptr;
     _iCorruptBitmapIndex = 0;
     _iTokenImageIndex = 0;
-    _pQueue = nullptr;
     _iLastImageReadyHint = -1;
+    _thumbnailContext = 0;
 }
 
 CRasterResourceListCtrl::~CRasterResourceListCtrl()
 {
-    if (_pQueue)
-    {
-        _pQueue->Abort();
-    }
 }
 
 void _StretchForAspectRatio(CWnd *pwnd, CBitmap &bitmap)
@@ -94,11 +91,44 @@ void _StretchForAspectRatio(CWnd *pwnd, CBitmap &bitmap)
     }
 }
 
+int CRasterResourceListCtrl::_AddThumbnailImage(HBITMAP hbmp)
+{
+    if (!hbmp)
+    {
+        return -1;
+    }
+
+    CBitmap bitmap;
+    bitmap.Attach(hbmp);
+
+    // Stretch the image if we're using the original aspect ratio.
+    if (appState->_fUseOriginalAspectRatioCached)
+    {
+        bitmap.SetBitmapDimension(VIEW_IMAGE_SIZE, VIEW_IMAGE_SIZE);
+        _StretchForAspectRatio(this, bitmap);
+    }
+    return ImageList_Add(_himlPics, bitmap, nullptr);
+}
+
+ThumbnailKey CRasterResourceListCtrl::_GetThumbnailKey(const ResourceBlob &blob)
+{
+    ThumbnailKey key;
+    key.Type = blob.GetType();
+    key.Number = blob.GetNumber();
+    key.Base36Number = blob.GetBase36();
+    key.ContentHash = ThumbnailCache::HashResource(blob);
+    key.Context = _thumbnailContext;
+    key.Width = VIEW_IMAGE_SIZE;
+    key.Height = VIEW_IMAGE_SIZE;
+    return key;
+}
+
 LRESULT CRasterResourceListCtrl::OnImageReady(WPARAM wParam, LPARAM lParam)
 {
-    VIEWWORKRESULT *pWorkResult;
-    while (_pQueue->TakeWorkResult(&pWorkResult))
+    std::unique_ptr<VIEWWORKRESULT> workResult;
+    while (_scheduler && (workResult = _scheduler->RetrieveNextResponse()))
     {
+        VIEWWORKRESULT *pWorkResult = workResult.get();
         LVFINDINFO findInfo = {};
         findInfo.flags |= LVFI_PARAM | LVFI_WRAP;
         findInfo.lParam = pWorkResult->lParam;
@@ -111,19 +141,9 @@ LRESULT CRasterResourceListCtrl::OnImageReady(WPARAM wParam, LPARAM lParam)
                 (pData->GetNumber() == pWorkResult->iResourceNumber) &&
                 (pData->GetPackageHint() == pWorkResult->iPackageNumber))
             {
-                CBitmap bitmap;
-                bitmap.Attach(pWorkResult->hbmp);
-                pWorkResult->hbmp = nullptr;    // Owned by CBitmap now
-
-                // Stretch the image if we're using the original aspect ratio.
-                if (appState->_fUseOriginalAspectRatioCached)
-                {
-                    bitmap.SetBitmapDimension(VIEW_IMAGE_SIZE, VIEW_IMAGE_SIZE);
-                    _StretchForAspectRatio(this, bitmap);
-                }
-
                 // this is a match
-                int iIndex = ImageList_Add(_himlPics, bitmap, nullptr);
+                int iIndex = _AddThumbnailImage(pWorkResult->hbmp);
+                pWorkResult->hbmp = nullptr;    // Owned by the image list now
                 if (iIndex != -1)
                 {
                     SetItemImage(i, iIndex);
@@ -132,7 +152,6 @@ LRESULT CRasterResourceListCtrl::OnImageReady(WPARAM wParam, LPARAM lParam)
             }
         }
         _iLastImageReadyHint = i;
-        delete pWorkResult;
     }
     return 0;
 }
@@ -147,16 +166,16 @@ BOOL CRasterResourceListCtrl::SetItemImage(int nItem, int nImageIndex)
 }
 
 // Finds the smallest cel that is at least as big in each dimension as "dimensions".
-CelIndex _FindBestPreviewCel(int dimensions, RasterComponent &raster)
+CelIndex _FindBestPreviewCel(int dimensions, const RasterComponent &raster)
 {
     CelIndex bestCelIndex;
     int minGap = dimensions;
     for (int nLoop = 0; nLoop < raster.LoopCount(); nLoop++)
     {
-        Loop &loop = raster.Loops[nLoop];
+        const Loop &loop = raster.Loops[nLoop];
         for (int nCel = 0; nCel < (int)loop.Cels.size(); nCel++)
         {
-            Cel &cel = loop.Cels[nCel];
+            const Cel &cel = loop.Cels[nCel];
             int minDimension = min(cel.size.cx, cel.size.cy);
             if ((dimensions - minDimension) < minGap)
             {
@@ -173,15 +192,15 @@ CelIndex _FindBestPreviewCel(int dimensions, RasterComponent &raster)
     return bestCelIndex;
 }
 
-VIEWWORKRESULT *VIEWWORKRESULT::CreateFromWorkItem(VIEWWORKITEM *pWorkItem)
+HBITMAP _CreateViewThumbnail(const ResourceBlob &blob)
 {
     HBITMAP hbmp = nullptr;
 
-    std::unique_ptr<ResourceEntity> pEntity = CreateResourceFromResourceData(pWorkItem->blob);
+    // Only one cel is shown, so just read the headers and then decode that cel.
+    std::unique_ptr<ResourceEntity> pEntity = CreateDeferredResourceFromResourceData(blob);
     if (pEntity)
     {
-        RasterComponent &raster = pEntity->GetComponent<RasterComponent>();
-        CBitmap bitmap;
+        RasterComponent raster = *pEntity->TryGetComponentHeaders<RasterComponent>();
         std::unique_ptr<PaletteComponent> palette;
         if (raster.Traits.PaletteType == PaletteType::VGA_256)
         {
@@ -193,7 +212,30 @@ VIEWWORKRESULT *VIEWWORKRESULT::CreateFromWorkItem(VIEWWORKITEM *pWorkItem)
             // Take 0 as an indication that we should use any cel
             previewCel = _FindBestPreviewCel(VIEW_IMAGE_SIZE, raster);
         }
-        hbmp = GetBitmap(raster, palette.get(), previewCel, VIEW_IMAGE_SIZE, VIEW_IMAGE_SIZE, BitmapScaleOptions::AllowMag | BitmapScaleOptions::AllowMin);
+        if ((previewCel.loop < raster.LoopCount()) && (previewCel.cel < raster.CelCount(previewCel.loop)))
+        {
+            try
+            {
+                ReadCelImageData(*pEntity, previewCel, raster.GetCel(previewCel));
+                hbmp = GetBitmap(raster, palette.get(), previewCel, VIEW_IMAGE_SIZE, VIEW_IMAGE_SIZE, BitmapScaleOptions::AllowMag | BitmapScaleOptions::AllowMin);
+            }
+            catch (std::exception)
+            {
+                // Corrupt cel data. No thumbnail.
+            }
+        }
+    }
+    return hbmp;
+}
+
+VIEWWORKRESULT *VIEWWORKRESULT::CreateFromWorkItem(VIEWWORKITEM *pWorkItem)
+{
+    HBITMAP hbmp = nullptr;
+    const ResourceBlob &blob = pWorkItem->blob;
+    std::shared_ptr<const Thumbnail> thumbnail = appState->GetThumbnailCache().GetOrCreate(pWorkItem->key, [&blob]() { return _CreateViewThumbnail(blob); });
+    if (thumbnail)
+    {
+        hbmp = thumbnail->CreateBitmap();
     }
 
     VIEWWORKRESULT *pResult = new VIEWWORKRESULT;
@@ -243,14 +285,29 @@ void CRasterResourceListCtrl::OnGetDispInfo(NMHDR* pNMHDR, LRESULT* pResult)
     { 
         if (_iView == LVS_ICON)
         {
-            if (_pQueue)
+            if (_scheduler)
             {
                 ResourceBlob *pData = _GetResourceForItemRealized(pItem->lParam);
-                std::unique_ptr<VIEWWORKITEM> pWorkItem = std::make_unique<VIEWWORKITEM>();
-                pWorkItem->blob = *pData;
-                pWorkItem->lParam = pItem->lParam;
-                _pQueue->GiveWorkItem(move(pWorkItem));
-                pItem->iImage = _iTokenImageIndex; // Done!
+                ThumbnailKey key = _GetThumbnailKey(*pData);
+                std::shared_ptr<const Thumbnail> thumbnail = appState->GetThumbnailCache().LookupInMemory(key);
+                int iImage = -1;
+                if (thumbnail)
+                {
+                    // We've drawn this before, no need to go to the background thread.
+                    iImage = _AddThumbnailImage(thumbnail->CreateBitmap());
+                }
+                if (iImage == -1)
+                {
+                    std::unique_ptr<VIEWWORKITEM> pWorkItem = std::make_unique<VIEWWORKITEM>();
+                    pWorkItem->blob = *pData;
+                    pWorkItem->lParam = pItem->lParam;
+                    pWorkItem->key = key;
+                    _scheduler->SubmitTask(move(pWorkItem),
+                        [](ITaskStatus &status, VIEWWORKITEM &workItem) { return std::unique_ptr<VIEWWORKRESULT>(VIEWWORKRESULT::CreateFromWorkItem(&workItem)); },
+                        ThumbnailPriorityVisible);
+                    iImage = _iTokenImageIndex;
+                }
+                pItem->iImage = iImage; // Done!
                 pItem->mask |= LVIF_DI_SETITEM; // So we don't ask for it again.
             }
         }
@@ -260,7 +317,19 @@ void CRasterResourceListCtrl::OnGetDispInfo(NMHDR* pNMHDR, LRESULT* pResult)
     *pResult = 0; 
 }
 
-
+void CRasterResourceListCtrl::OnEndScroll(NMHDR* pNMHDR, LRESULT* pResult)
+{
+    // Generate thumbnails for what the user is looking at now, before the ones that were scrolled past.
+    if (_scheduler)
+    {
+        std::unordered_set<LPARAM> visible = _GetVisibleItemParams();
+        _scheduler->Reprioritize([&visible](const VIEWWORKITEM &workItem)
+        {
+            return (visible.find(workItem.lParam) != visible.end()) ? ThumbnailPriorityVisible : ThumbnailPriorityOffscreen;
+        });
+    }
+    *pResult = 0;
+}
 
 void CRasterResourceListCtrl::_OnInitListView(int cItems)
 {
@@ -312,20 +381,18 @@ void CRasterResourceListCtrl::_OnInitListView(int cItems)
         }
     }
 
-    // Prepare our worker thread.
-    if (_pQueue)
+    // The thumbnails of VGA views depend on the global palette too.
+    _thumbnailContext = 0;
+    std::unique_ptr<ResourceBlob> globalPalette = appState->GetResourceMap().MostRecentResource(ResourceType::Palette, 999, false);
+    if (globalPalette)
     {
-        _pQueue->Abort();
-    }
-    _pQueue = std::make_shared<QueueItems<VIEWWORKITEM, VIEWWORKRESULT>>(GetSafeHwnd(), UWM_IMAGEREADY);
-    if (_pQueue)
-    {
-        if (!_pQueue->Init())
-        {
-            _pQueue = nullptr;
-        }
+        _thumbnailContext = ThumbnailCache::HashResource(*globalPalette);
     }
 
+    // Prepare our worker thread.
+    _scheduler.reset();
+    _scheduler = std::make_unique<BackgroundScheduler<VIEWWORKITEM, VIEWWORKRESULT>>(GetSafeHwnd(), UWM_IMAGEREADY);
+
     // Adjust the icon spacing so things don't look too spread out.
     CSize sizeSpacing(sizeImages.cx + 20, sizeImages.cy + 30);
     SetIconSpacing(sizeSpacing);
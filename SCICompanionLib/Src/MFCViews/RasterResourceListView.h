@@ -18,8 +18,9 @@
 #pragma once
 
 #include "ResourceListView.h"
-#include "QueueItems.h"
+#include "Task.h"
 #include "ResourceBlob.h"
+#include "ThumbnailCache.h"
 
 // This is created by the UI thread, and deleted by the worker thread.
 class VIEWWORKITEM
@@ -27,6 +28,7 @@ class VIEWWORKITEM
 public:
     ResourceBlob blob;
     LPARAM lParam;
+    ThumbnailKey key;
 };
 
 
@@ -69,11 +71,14 @@ public:
 #endif
     void OnGetDispInfo(NMHDR* pNMHDR, LRESULT* pResult);
     void OnItemChanged(NMHDR* pNMHDR, LRESULT* pResult);
+    void OnEndScroll(NMHDR* pNMHDR, LRESULT* pResult);
 
 private:
     virtual void _PrepareLVITEM(LVITEM *pItem);
     virtual void _OnInitListView(int cItems);
     void _RegenerateImages() override;
+    ThumbnailKey _GetThumbnailKey(const ResourceBlob &blob);
+    int _AddThumbnailImage(HBITMAP hbmp);
 
 // Generated message map functions
     afx_msg int OnCreate(LPCREATESTRUCT lpCreateStruct);
@@ -84,7 +89,8 @@ private:
     HIMAGELIST _himlPics;
     int _iCorruptBitmapIndex;
     int _iTokenImageIndex;
-    std::shared_ptr<QueueItems<VIEWWORKITEM, VIEWWORKRESULT>> _pQueue;
+    std::unique_ptr<BackgroundScheduler<VIEWWORKITEM, VIEWWORKRESULT>> _scheduler;
     int _iLastImageReadyHint;
+    uint32_t _thumbnailContext;     // Identifies the global palette the thumbnails are drawn with
 };
 
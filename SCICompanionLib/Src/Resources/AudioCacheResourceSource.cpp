@@ -673,7 +673,7 @@ std::ostream *_ChooseBakOutputStream(SCIVersion version, const std::string &game
     return toUse;
 }
 
-void AudioCacheResourceSource::RebuildResources(bool force, ResourceSource &source, std::map<ResourceType, RebuildStats> &stats)
+void AudioCacheResourceSource::RebuildResources(bool force, ResourceSource &source, std::map<ResourceType, RebuildStats> &stats, const ResourceCompressionPolicies &compression)
 {
     UpToDateResources upToDate(_cacheFolder);
 
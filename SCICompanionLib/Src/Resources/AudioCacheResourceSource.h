@@ -57,7 +57,7 @@ public:
 
     void RemoveEntry(const ResourceMapEntryAgnostic &mapEntry) override;
     AppendBehavior AppendResources(const std::vector<const ResourceBlob*> &blobs) override;
-    void RebuildResources(bool force, ResourceSource &source, std::map<ResourceType, RebuildStats> &stats) override;
+    void RebuildResources(bool force, ResourceSource &source, std::map<ResourceType, RebuildStats> &stats, const ResourceCompressionPolicies &compression) override;
 
     // A way to call RemoveEntry directly, for more efficiency.
     void RemoveEntries(int number, const std::vector<uint32_t> tuples);
@@ -227,6 +227,29 @@ std::string GameFolderHelper::GetPolyFolder(const std::string *prefix) const
     return _GetSubfolder("poly", prefix);
 }
 
+std::string GameFolderHelper::GetThumbnailFolder() const
+{
+    return _GetSubfolder("thumbnails");
+}
+
+std::string GameFolderHelper::GetHeaderCacheFileName() const
+{
+    std::string folder = _GetSubfolder("cache");
+    return folder.empty() ? folder : (folder + "\\headers.bin");
+}
+
+std::string GameFolderHelper::GetBuildGraphFileName() const
+{
+    std::string folder = _GetSubfolder("cache");
+    return folder.empty() ? folder : (folder + "\\build.bin");
+}
+
+std::string GameFolderHelper::GetDecompileCacheFileName() const
+{
+    std::string folder = _GetSubfolder("cache");
+    return folder.empty() ? folder : (folder + "\\decompile.bin");
+}
+
 //
 // Returns the script identifier for something "main", or "rm001".
 //
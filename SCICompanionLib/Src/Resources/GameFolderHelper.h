@@ -55,6 +55,10 @@ public:
     std::string GameFolderHelper::GetSubFolder(const std::string &subFolder) const;
     std::string GameFolderHelper::GetLipSyncFolder() const;
     std::string GameFolderHelper::GetPolyFolder(const std::string *prefix = nullptr) const;
+    std::string GameFolderHelper::GetThumbnailFolder() const;
+    std::string GetHeaderCacheFileName() const;
+    std::string GetBuildGraphFileName() const;
+    std::string GetDecompileCacheFileName() const;
     std::string GetGameIniFileName() const;
     std::string GetIniString(const std::string &sectionName, const std::string &keyName, PCSTR pszDefault = "") const;
     bool GetIniBool(const std::string &sectionName, const std::string &keyName, bool value = false) const;
@@ -730,6 +730,15 @@ const uint16_t DefaultViewAngle = 70;
 const uint16_t DefaultXVanish = 160;
 const uint16_t DefaultYVanish = 55536;
 
+// SCI 1.1 pics can be 200 pixels high, so the size is based on the background cel.
+void _SetSizeFromVGA11Cel(PicComponent &pic, const Cel &cel)
+{
+    pic.Size.cy = max(DEFAULT_PIC_HEIGHT, cel.size.cy);
+    pic.Size.cy = min(sPIC_HEIGHT_MAX, pic.Size.cy);
+    pic.Size.cx = max(DEFAULT_PIC_WIDTH, cel.size.cx);
+    pic.Size.cx = min(sPIC_WIDTH_MAX, pic.Size.cx);
+}
+
 void PicReadFromVGA11(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
 {
     PicComponent &pic = resource.GetComponent<PicComponent>();
@@ -769,11 +778,7 @@ void PicReadFromVGA11(ResourceEntity &resource, sci::istream &byteStream, const
         byteStream.seekg(header.celHeaderOffset);
         ReadCelFromVGA11(byteStream, celTemp, true);
         // "plug it in" to our system by making a drawing command for it, just like SCI 1.0 VGA would do
-        // SCI 1.1 pics can be 200 pixels high:
-        pic.Size.cy = max(DEFAULT_PIC_HEIGHT, celTemp.size.cy);
-        pic.Size.cy = min(sPIC_HEIGHT_MAX, pic.Size.cy);
-        pic.Size.cx = max(DEFAULT_PIC_WIDTH, celTemp.size.cx);
-        pic.Size.cx = min(sPIC_WIDTH_MAX, pic.Size.cx);
+        _SetSizeFromVGA11Cel(pic, celTemp);
         pic.commands.push_back(PicCommand());
         pic.commands.back().CreateDrawVisualBitmap(celTemp, true);
     }
@@ -782,6 +787,30 @@ void PicReadFromVGA11(ResourceEntity &resource, sci::istream &byteStream, const
     PicReadFromSCI0_SCI1(resource, byteStream, true);
 }
 
+// Header-only readers: these fill in the pic size and palette, but don't decode the cels or the
+// drawing commands. SCI0 and SCI1 pics keep their palette in the command stream, so they don't have one.
+void PicReadHeadersFromVGA11(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
+{
+    PicComponent &pic = resource.GetComponent<PicComponent>();
+    PicHeader_VGA11 header;
+    byteStream >> header;
+
+    if (header.paletteOffset)
+    {
+        resource.AddComponent(move(make_unique<PaletteComponent>()));
+        byteStream.seekg(header.paletteOffset);
+        ReadPalette(resource.GetComponent<PaletteComponent>(), byteStream);
+    }
+
+    if (header.celCount)
+    {
+        Cel celTemp;
+        byteStream.seekg(header.celHeaderOffset);
+        ReadCelFromVGA11(byteStream, celTemp, true, true);
+        _SetSizeFromVGA11Cel(pic, celTemp);
+    }
+}
+
 void PicWriteToVGA11(const ResourceEntity &resource, sci::ostream &byteStream, std::map<BlobKey, uint32_t> &propertyBag)
 {
     const PicComponent &pic = resource.GetComponent<PicComponent>();
@@ -989,6 +1018,34 @@ void PicReadFromVGA2(ResourceEntity &resource, sci::istream &byteStream, const s
     }
 }
 
+void PicReadHeadersFromVGA2(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
+{
+    PicComponent &pic = resource.GetComponent<PicComponent>();
+    PicHeader_VGA2 header;
+    byteStream >> header;
+
+    pic.Size = size16(header.width, header.height);
+    pic.Size.cx = max(pic.Size.cx, 320);
+    pic.Size.cy = max(pic.Size.cy, 200);
+
+    uint32_t base = byteStream.tellg();
+    for (uint8_t cel = 0; cel < header.celCount; cel++)
+    {
+        byteStream.seekg(base + cel * header.celHeaderSize);
+        PicCelHeader_VGA2 celHeader;
+        byteStream >> celHeader;
+        pic.Size.cx = max(pic.Size.cx, celHeader.size.cx);
+        pic.Size.cy = max(pic.Size.cy, celHeader.size.cy);
+    }
+
+    if (header.paletteOffset)
+    {
+        resource.AddComponent(move(make_unique<PaletteComponent>()));
+        byteStream.seekg(header.paletteOffset);
+        ReadPalette(resource.GetComponent<PaletteComponent>(), byteStream);
+    }
+}
+
 // SCI2 pics looks like:
 // [PicHeader]
 // [n * celHeaders]
@@ -1061,7 +1118,7 @@ void PicWriteToVGA2(const ResourceEntity &resource, sci::ostream &byteStream, st
         {
             PicCelHeader_VGA2 celHeader = {};
             celHeader.compressed = compressed ? CompressionTag : 0;
-            Cel *pCel = command.drawVisualBitmap.pCel;
+            const Cel *pCel = command.drawVisualBitmap.pCel;
             celHeader.size = pCel->size;
             celHeader.relativePlacement = pCel->placement;
 
@@ -1271,6 +1328,7 @@ ResourceTraits picResourceTraitsVGA11 =
     PicWriteToVGA11,
     PicValidateVGA,
     PicWritePolygons,
+    PicReadHeadersFromVGA11,
 };
 
 ResourceTraits picResourceTraitsVGA2 =
@@ -1280,6 +1338,7 @@ ResourceTraits picResourceTraitsVGA2 =
     PicWriteToVGA2,
     NoValidationFunc,
     PicWritePolygons,
+    PicReadHeadersFromVGA2,
 };
 
 int g_PicIds = 0;
@@ -626,19 +626,66 @@ void ViewPort::Reset(uint8_t bPaletteToUse)
     std::copy(g_defaultPriBands, g_defaultPriBands + ARRAYSIZE(g_defaultPriBands), bPriorityLines);
 }
 
+PicOwnership::PicOwnership(size16 size) : Command(NoCommand)
+{
+    for (auto &owners : Owners)
+    {
+        owners.assign(size.cx * size.cy, NoCommand);
+    }
+}
+
+void PicOwnership::SetChanged(PicScreen screen, const uint8_t *before, const uint8_t *after, size_t count)
+{
+    uint16_t *owners = &Owners[(int)screen][0];
+    for (size_t i = 0; i < count; i++)
+    {
+        if (before[i] != after[i])
+        {
+            owners[i] = Command;
+        }
+    }
+}
+
+//
+// Writes a pixel to one of the screens, noting which command changed it if we're keeping track of that.
+//
+inline void _SetScreenPixel(PicData *pData, PicScreen screen, uint8_t *screenData, int p, uint8_t value)
+{
+    if (pData->pOwnership && (screenData[p] != value))
+    {
+        pData->pOwnership->Owners[(int)screen][p] = pData->pOwnership->Command;
+    }
+    screenData[p] = value;
+}
+
+inline void _SetScreenSpan(PicData *pData, PicScreen screen, uint8_t *screenData, int p, int count, uint8_t value)
+{
+    if (pData->pOwnership)
+    {
+        for (int i = p; i < (p + count); i++)
+        {
+            _SetScreenPixel(pData, screen, screenData, i, value);
+        }
+    }
+    else
+    {
+        memset(screenData + p, value, count);
+    }
+}
+
 inline void _PlotPixI(int p, PicData *pData, int16_t x, int16_t y, PicScreenFlags dwDrawEnable, EGACOLOR color, uint8_t bPriorityValue, uint8_t bControlValue)
 {
     if (IsFlagSet(pData->dwMapsToRedraw, PicScreenFlags::Visual) && IsFlagSet(dwDrawEnable, PicScreenFlags::Visual))
     {
-        pData->pdataVisual[p] = ((x^y) & 1)? color.color1 : color.color2;
+        _SetScreenPixel(pData, PicScreen::Visual, pData->pdataVisual, p, ((x^y) & 1)? color.color1 : color.color2);
     }
     if (IsFlagSet(pData->dwMapsToRedraw, PicScreenFlags::Priority) && IsFlagSet(dwDrawEnable, PicScreenFlags::Priority))
     {
-        pData->pdataPriority[p] = bPriorityValue;
+        _SetScreenPixel(pData, PicScreen::Priority, pData->pdataPriority, p, bPriorityValue);
     }
     if (IsFlagSet(pData->dwMapsToRedraw, PicScreenFlags::Control) && IsFlagSet(dwDrawEnable, PicScreenFlags::Control))
     {
-        pData->pdataControl[p] = bControlValue;
+        _SetScreenPixel(pData, PicScreen::Control, pData->pdataControl, p, bControlValue);
     }
 }
 
@@ -727,15 +774,15 @@ inline void _PlotPix(PicData *pData, int16_t x, int16_t y, PicScreenFlags dwDraw
     // Duplicate the code from _PlotPixI here for speed (perf increase of ~5%?)
     if (IsFlagSet(pData->dwMapsToRedraw, PicScreenFlags::Visual) && IsFlagSet(dwDrawEnable, PicScreenFlags::Visual))
     {
-        pData->pdataVisual[p] = _TFormat::Plot(x, y, color);
+        _SetScreenPixel(pData, PicScreen::Visual, pData->pdataVisual, p, _TFormat::Plot(x, y, color));
     }
     if (IsFlagSet(pData->dwMapsToRedraw, PicScreenFlags::Priority) && IsFlagSet(dwDrawEnable, PicScreenFlags::Priority))
     {
-        pData->pdataPriority[p] = bPriorityValue;
+        _SetScreenPixel(pData, PicScreen::Priority, pData->pdataPriority, p, bPriorityValue);
     }
     if (IsFlagSet(pData->dwMapsToRedraw, PicScreenFlags::Control) && IsFlagSet(dwDrawEnable, PicScreenFlags::Control))
     {
-        pData->pdataControl[p] = bControlValue;
+        _SetScreenPixel(pData, PicScreen::Control, pData->pdataControl, p, bControlValue);
     }
 
     pData->pdataAux[p] |= (uint8_t)auxSet;
@@ -1521,8 +1568,13 @@ int g_commands = 0;
 
 std::mutex g_mutexDither;
 
+//
+// The original fill. It visits one pixel at a time, so each pixel is tested up to five times
+// and every write goes through _PlotPix. It's kept around as the reference that the span fill
+// is verified against.
+//
 template<typename _TFormat>
-void _DitherFill(PicData *pdata, int16_t x, int16_t y, typename  _TFormat::PixelType color, uint8_t bPriorityValue, uint8_t bControlValue, PicScreenFlags dwDrawEnable)
+void _DitherFillPerPixel(PicData *pdata, int16_t x, int16_t y, typename  _TFormat::PixelType color, uint8_t bPriorityValue, uint8_t bControlValue, PicScreenFlags dwDrawEnable)
 {
     PicScreenFlags auxSet = _GetAuxSet<_TFormat>(color, bPriorityValue, bControlValue, dwDrawEnable);
     dwDrawEnable = auxSet;
@@ -1615,6 +1667,206 @@ void _DitherFill(PicData *pdata, int16_t x, int16_t y, typename  _TFormat::Pixel
     }
 }
 
+//
+// Writes a horizontal run of pixels. This is the equivalent of calling _PlotPix for each pixel
+// from xLeft to xRight (inclusive), but the priority and control screens are written in one go.
+//
+template<typename _TFormat>
+inline void _PlotSpan(PicData *pData, int16_t xLeft, int16_t xRight, int16_t y, PicScreenFlags dwDrawEnable, PicScreenFlags auxSet, typename _TFormat::PixelType color, uint8_t bPriorityValue, uint8_t bControlValue)
+{
+    int p = BUFFEROFFSET_NONSTD(pData->size.cx, pData->size.cy, xLeft, y);
+    int count = xRight - xLeft + 1;
+    if (IsFlagSet(pData->dwMapsToRedraw, PicScreenFlags::Visual) && IsFlagSet(dwDrawEnable, PicScreenFlags::Visual))
+    {
+        if (pData->pOwnership)
+        {
+            for (int16_t x = xLeft; x <= xRight; x++)
+            {
+                _SetScreenPixel(pData, PicScreen::Visual, pData->pdataVisual, p + (x - xLeft), _TFormat::Plot(x, y, color));
+            }
+        }
+        else
+        {
+            uint8_t *visual = pData->pdataVisual + p;
+            for (int16_t x = xLeft; x <= xRight; x++)
+            {
+                *visual++ = _TFormat::Plot(x, y, color);
+            }
+        }
+    }
+    if (IsFlagSet(pData->dwMapsToRedraw, PicScreenFlags::Priority) && IsFlagSet(dwDrawEnable, PicScreenFlags::Priority))
+    {
+        _SetScreenSpan(pData, PicScreen::Priority, pData->pdataPriority, p, count, bPriorityValue);
+    }
+    if (IsFlagSet(pData->dwMapsToRedraw, PicScreenFlags::Control) && IsFlagSet(dwDrawEnable, PicScreenFlags::Control))
+    {
+        _SetScreenSpan(pData, PicScreen::Control, pData->pdataControl, p, count, bControlValue);
+    }
+
+    uint8_t *aux = pData->pdataAux + p;
+    uint8_t auxBits = (uint8_t)auxSet;
+    for (int i = 0; i < count; i++)
+    {
+        aux[i] |= auxBits;
+    }
+}
+
+//
+// The span fill relies on a pixel no longer being fillable once it's plotted. That isn't true
+// when filling with a half-white colour (see the BUG comment above): the white pixels we plot
+// still look empty. The per-pixel fill keeps revisiting them and eventually runs out of queue
+// space on large areas, leaving them partially filled. We need to reproduce that exactly, so
+// those fills are left to the per-pixel fill.
+//
+template<typename _TFormat>
+bool _FillLeavesEmptyPixels(const PicData *pdata, typename _TFormat::PixelType color, PicScreenFlags dwDrawEnable)
+{
+    if (!IsFlagSet(dwDrawEnable, PicScreenFlags::Visual))
+    {
+        return false;
+    }
+    if (!IsFlagSet(pdata->dwMapsToRedraw, PicScreenFlags::Visual))
+    {
+        // The visual screen won't be written, so white stays white.
+        return true;
+    }
+    // Dithering only depends on the parity of x + y
+    return _TFormat::IsPixelWhite(_TFormat::Plot(0, 0, color), 0, 0) || _TFormat::IsPixelWhite(_TFormat::Plot(1, 0, color), 1, 0);
+}
+
+//
+// Scanline fill. Rather than pushing every neighbour of every pixel, we grow each seed into the
+// longest run on its row, plot that run, and then push one seed for each run of fillable pixels
+// directly above and below it.
+// This fills exactly the same connected region as _DitherFillPerPixel, since a pixel's
+// fillability only changes when that pixel itself is plotted.
+//
+template<typename _TFormat>
+void _DitherFillSpan(PicData *pdata, int16_t x, int16_t y, typename  _TFormat::PixelType color, uint8_t bPriorityValue, uint8_t bControlValue, PicScreenFlags dwDrawEnable)
+{
+    PicScreenFlags auxSet = _GetAuxSet<_TFormat>(color, bPriorityValue, bControlValue, dwDrawEnable);
+    dwDrawEnable = auxSet;
+
+    // See _DitherFillPerPixel
+    if (_TFormat::EarlyBail(dwDrawEnable, color, bPriorityValue, bControlValue))
+    {
+        return;
+    }
+    if (dwDrawEnable == PicScreenFlags::None)
+    {
+        return;
+    }
+
+    int cx = pdata->size.cx;
+    int cy = pdata->size.cy;
+    if ((x < 0) || (y < 0) || !CHECK_RECT(cx, cy, x, y))
+    {
+        return;
+    }
+    if (FILL_BOUNDS(cx, cy, x, y, _TFormat))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(g_mutexDither);
+
+    int16_t xMax = (int16_t)(cx - 1);
+    int16_t yMax = (int16_t)(cy - 1);
+    int displayByteSize = cx * cy;
+
+    const uint8_t *pdataAux = pdata->pdataAux;
+    const uint8_t *pdataVisual = pdata->pdataVisual;
+    uint8_t drawMask = (uint8_t)dwDrawEnable;
+    bool checkWhite = IsFlagSet(dwDrawEnable, PicScreenFlags::Visual);
+
+    // Same as OK_TO_FILL, minus the bounds check. rowOffset is the buffer offset of (0, fy).
+    auto canFill = [&](int rowOffset, int16_t fx, int16_t fy)
+    {
+        int p = rowOffset + fx;
+        if (!(drawMask & pdataAux[p]))
+        {
+            return true;
+        }
+        return checkWhite && _TFormat::IsPixelWhite(pdataVisual[p], fx, fy);
+    };
+
+    __int32 rpos = 0;
+    qstore(displayByteSize, x, y, &rpos);
+    bool overflow = false;
+    while (rpos && !overflow)
+    {
+        sPOINT seed = qretrieve(&rpos);
+        int16_t row = seed.y;
+        int rowOffset = BUFFEROFFSET_NONSTD(cx, cy, 0, row);
+        if (!canFill(rowOffset, seed.x, row))
+        {
+            continue;
+        }
+
+        int16_t xLeft = seed.x;
+        while ((xLeft > 0) && canFill(rowOffset, xLeft - 1, row))
+        {
+            xLeft--;
+        }
+        int16_t xRight = seed.x;
+        while ((xRight < xMax) && canFill(rowOffset, xRight + 1, row))
+        {
+            xRight++;
+        }
+
+        _PlotSpan<_TFormat>(pdata, xLeft, xRight, row, dwDrawEnable, auxSet, color, bPriorityValue, bControlValue);
+
+        // Seed the runs on the rows above and below.
+        for (int16_t adjacentRow = row - 1; adjacentRow <= row + 1; adjacentRow += 2)
+        {
+            if ((adjacentRow < 0) || (adjacentRow > yMax))
+            {
+                continue;
+            }
+            int adjacentOffset = BUFFEROFFSET_NONSTD(cx, cy, 0, adjacentRow);
+            bool inRun = false;
+            for (int16_t fx = xLeft; fx <= xRight; fx++)
+            {
+                if (canFill(adjacentOffset, fx, adjacentRow))
+                {
+                    if (!inRun)
+                    {
+                        if (!qstore(displayByteSize, fx, adjacentRow, &rpos))
+                        {
+                            // We only push one seed per run, so this shouldn't happen in practice. But do
+                            // the same as the per-pixel fill if it does.
+                            overflow = true;
+                            break;
+                        }
+                        inRun = true;
+                    }
+                }
+                else
+                {
+                    inRun = false;
+                }
+            }
+            if (overflow)
+            {
+                break;
+            }
+        }
+    }
+}
+
+template<typename _TFormat>
+void _DitherFill(PicData *pdata, int16_t x, int16_t y, typename  _TFormat::PixelType color, uint8_t bPriorityValue, uint8_t bControlValue, PicScreenFlags dwDrawEnable)
+{
+    if ((pdata->fillAlgorithm == FillAlgorithm::PerPixel) || _FillLeavesEmptyPixels<_TFormat>(pdata, color, _GetAuxSet<_TFormat>(color, bPriorityValue, bControlValue, dwDrawEnable)))
+    {
+        _DitherFillPerPixel<_TFormat>(pdata, x, y, color, bPriorityValue, bControlValue, dwDrawEnable);
+    }
+    else
+    {
+        _DitherFillSpan<_TFormat>(pdata, x, y, color, bPriorityValue, bControlValue, dwDrawEnable);
+    }
+}
+
 
 
 
@@ -1640,23 +1892,28 @@ void LineCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pSta
 // This doesn't update the picstate.
 //
 void LineCommand_DrawOnly(const PicCommand *pCommand, PicData *pData, const ViewPort *pState)
+{
+    LineCommand_DrawOnly(pData, pState, pCommand->drawLine.xFrom, pCommand->drawLine.yFrom, pCommand->drawLine.xTo, pCommand->drawLine.yTo);
+}
+
+void LineCommand_DrawOnly(PicData *pData, const ViewPort *pState, int16_t xFrom, int16_t yFrom, int16_t xTo, int16_t yTo)
 {
     if (pData->isVGA)
     {
         _DitherLine<PlotVGA>(pData,
-            pCommand->drawLine.xFrom, pCommand->drawLine.yFrom, pCommand->drawLine.xTo, pCommand->drawLine.yTo,
+            xFrom, yFrom, xTo, yTo,
             pState->bPaletteOffset, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable);
     }
 	else if (pData->isUndithered)
 	{
 		_DitherLine<PlotEGAUndithered>(pData,
-			pCommand->drawLine.xFrom, pCommand->drawLine.yFrom, pCommand->drawLine.xTo, pCommand->drawLine.yTo,
+			xFrom, yFrom, xTo, yTo,
 			pState->egaColor, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable);
 	}
 	else
     {
         _DitherLine<PlotEGA>(pData,
-            pCommand->drawLine.xFrom, pCommand->drawLine.yFrom, pCommand->drawLine.xTo, pCommand->drawLine.yTo,
+            xFrom, yFrom, xTo, yTo,
             pState->egaColor, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable);
     }
 }
@@ -1766,36 +2023,42 @@ void PicCommand::_CreatePattern(int16_t x, int16_t y, uint8_t bPatternSize, uint
 
 // This version doesn't update the pState.  It is used for previewing the pen tool.
 void PatternCommand_Draw_DrawOnly(const PicCommand *pCommand, PicData *pData, const ViewPort *pState)
+{
+    PatternCommand_Draw_DrawOnly(pData, pState, pCommand->drawPattern.x, pCommand->drawPattern.y,
+        pCommand->drawPattern.bPatternSize, pCommand->drawPattern.bPatternNR, pCommand->drawPattern.wFlags);
+}
+
+void PatternCommand_Draw_DrawOnly(PicData *pData, const ViewPort *pState, int16_t x, int16_t y, uint8_t bPatternSize, uint8_t bPatternNR, uint8_t wFlags)
 {
     if (pData->isVGA)
     {
         _DrawPattern<PlotVGA>(pData,
-            pCommand->drawPattern.x, pCommand->drawPattern.y,
+            x, y,
             pState->bPaletteOffset, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable,
-            (pCommand->drawPattern.wFlags & PATTERN_FLAG_USE_PATTERN) != 0,
-            pCommand->drawPattern.bPatternSize,
-            pCommand->drawPattern.bPatternNR,
-            (pCommand->drawPattern.wFlags & PATTERN_FLAG_RECTANGLE) != 0);
+            (wFlags & PATTERN_FLAG_USE_PATTERN) != 0,
+            bPatternSize,
+            bPatternNR,
+            (wFlags & PATTERN_FLAG_RECTANGLE) != 0);
     }
 	else if (pData->isUndithered)
 	{
 		_DrawPattern<PlotEGAUndithered>(pData,
-			pCommand->drawPattern.x, pCommand->drawPattern.y,
+			x, y,
 			pState->egaColor, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable,
-			(pCommand->drawPattern.wFlags & PATTERN_FLAG_USE_PATTERN) != 0,
-			pCommand->drawPattern.bPatternSize,
-			pCommand->drawPattern.bPatternNR,
-			(pCommand->drawPattern.wFlags & PATTERN_FLAG_RECTANGLE) != 0);
+			(wFlags & PATTERN_FLAG_USE_PATTERN) != 0,
+			bPatternSize,
+			bPatternNR,
+			(wFlags & PATTERN_FLAG_RECTANGLE) != 0);
 	}
     else
     {
         _DrawPattern<PlotEGA>(pData,
-            pCommand->drawPattern.x, pCommand->drawPattern.y,
+            x, y,
             pState->egaColor, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable,
-            (pCommand->drawPattern.wFlags & PATTERN_FLAG_USE_PATTERN) != 0,
-            pCommand->drawPattern.bPatternSize,
-            pCommand->drawPattern.bPatternNR,
-            (pCommand->drawPattern.wFlags & PATTERN_FLAG_RECTANGLE) != 0);
+            (wFlags & PATTERN_FLAG_USE_PATTERN) != 0,
+            bPatternSize,
+            bPatternNR,
+            (wFlags & PATTERN_FLAG_RECTANGLE) != 0);
     }
 }
 
@@ -1926,18 +2189,23 @@ void PicCommand::_CreateFill(int16_t x, int16_t y)
 }
 
 void FillCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState)
+{
+    FillCommand_Draw(pData, pState, pCommand->fill.x, pCommand->fill.y);
+}
+
+void FillCommand_Draw(PicData *pData, const ViewPort *pState, int16_t x, int16_t y)
 {
     if (pData->isVGA)
     {
-        _DitherFill<PlotVGA>(pData, pCommand->fill.x, pCommand->fill.y, pState->bPaletteOffset, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable);
+        _DitherFill<PlotVGA>(pData, x, y, pState->bPaletteOffset, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable);
     }
 	else if (pData->isUndithered)
 	{
-		_DitherFill<PlotEGAUndithered>(pData, pCommand->fill.x, pCommand->fill.y, pState->egaColor, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable);
+		_DitherFill<PlotEGAUndithered>(pData, x, y, pState->egaColor, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable);
 	}
     else
     {
-        _DitherFill<PlotEGA>(pData, pCommand->fill.x, pCommand->fill.y, pState->egaColor, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable);
+        _DitherFill<PlotEGA>(pData, x, y, pState->egaColor, pState->bPriorityValue, pState->bControlValue, pState->dwDrawEnable);
     }
 }
 
@@ -1980,14 +2248,19 @@ void PicCommand::_CreateSetVisualVGA(uint8_t bColor)
 
 void SetVisualCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState)
 {
-    if (pCommand->setVisual.isVGA)
+    SetVisualCommand_Draw(pState, pCommand->setVisual.bColor, pCommand->setVisual.isVGA);
+}
+
+void SetVisualCommand_Draw(ViewPort *pState, uint8_t bColor, bool isVGA)
+{
+    if (isVGA)
     {
-        pState->bPaletteOffset = pCommand->setVisual.bColor;
+        pState->bPaletteOffset = bColor;
     }
     else
     {
         // Obey SCI game behaviour of ignoring bPalette if not zero
-        uint8_t bPaletteToUse = pCommand->setVisual.GetPaletteNumber();
+        uint8_t bPaletteToUse = GET_PALDEX(bColor);
         if (bPaletteToUse == 0)
         {
             bPaletteToUse = pState->bPaletteToDraw;
@@ -1995,20 +2268,20 @@ void SetVisualCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort
         EGACOLOR *pPalette = GET_PALETTE(pState->pPalettes, bPaletteToUse);
 
         // Update the ViewPort
-        pState->bPaletteNumber = pCommand->setVisual.GetPaletteNumber(); // This matters for UI state -> note, it is not necessarily bPaletteToUse.
+        pState->bPaletteNumber = GET_PALDEX(bColor); // This matters for UI state -> note, it is not necessarily bPaletteToUse.
         // bPaletteToUse represents the palette to use when drawing stuff right now, but the palette number
         // encoded in the command, might be different.
-        pState->bPaletteOffset = pCommand->setVisual.GetPaletteIndex();  // This matters for UI state
+        pState->bPaletteOffset = GET_PALCOL(bColor);  // This matters for UI state
         // Set the color we are actually going to draw, given current picstate:
         if (pState->rgLocked[pState->bPaletteOffset])
         {
             // Palette 0 has this index "locked".  So use palette 0 for drawing for this colour.
-            pState->egaColor = pState->pPalettes[pCommand->setVisual.GetPaletteIndex()];
+            pState->egaColor = pState->pPalettes[GET_PALCOL(bColor)];
         }
         else
         {
             // The "normal" case
-            pState->egaColor = pPalette[pCommand->setVisual.GetPaletteIndex()];
+            pState->egaColor = pPalette[GET_PALCOL(bColor)];
         }
     }
     pState->dwDrawEnable |= PicScreenFlags::Visual;
@@ -2089,7 +2362,12 @@ uint8_t PriorityValueToColorIndex(bool continuousPriority, int16_t priorityValue
 
 void SetPriorityCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState)
 {
-    pState->bPriorityValue = PriorityValueToColorIndex(pData->isContinuousPriority, pCommand->setPriority.bPriorityValue);
+    SetPriorityCommand_Draw(pData, pState, pCommand->setPriority.bPriorityValue);
+}
+
+void SetPriorityCommand_Draw(PicData *pData, ViewPort *pState, int16_t bPriorityValue)
+{
+    pState->bPriorityValue = PriorityValueToColorIndex(pData->isContinuousPriority, bPriorityValue);
     pState->dwDrawEnable |= PicScreenFlags::Priority;
 }
 
@@ -2117,7 +2395,12 @@ void PicCommand::_CreateSetControl(uint8_t bControlValue)
 
 void SetControlCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState)
 {
-    pState->bControlValue = pCommand->setControl.bControlValue;
+    SetControlCommand_Draw(pState, pCommand->setControl.bControlValue);
+}
+
+void SetControlCommand_Draw(ViewPort *pState, uint8_t bControlValue)
+{
+    pState->bControlValue = bControlValue;
     pState->dwDrawEnable |= PicScreenFlags::Control;
 }
 
@@ -2366,7 +2649,7 @@ void DrawVisualBitmap_Draw(const PicCommand *pCommand, PicData *pData, ViewPort
     if (pCommand->drawVisualBitmap.pCel)
     {
         size16 displaySize = pData->size;
-        Cel &cel = *pCommand->drawVisualBitmap.pCel;
+        const Cel &cel = *pCommand->drawVisualBitmap.pCel;
         // Optimization
 #if CANT_DO_BECAUSE_OF_TRANS_COLOR
         if ((cel.size.cx == pData->size.cx) && (cel.size.cy == pData->size.cy))
@@ -2387,6 +2670,18 @@ void DrawVisualBitmap_Draw(const PicCommand *pCommand, PicData *pData, ViewPort
                 writeToPriorityScreen = true;
             }
 
+            // The bitmap is drawn in one go, so compare before and after to see what it changed.
+            size_t byteSize = displaySize.cx * displaySize.cy;
+            std::vector<uint8_t> visualBefore, priorityBefore;
+            if (pData->pOwnership)
+            {
+                visualBefore.assign(pData->pdataVisual, pData->pdataVisual + byteSize);
+                if (writeToPriorityScreen && pData->pdataPriority)
+                {
+                    priorityBefore.assign(pData->pdataPriority, pData->pdataPriority + byteSize);
+                }
+            }
+
             // Copy line by line.
             DrawImageWithPriority(
                 displaySize,
@@ -2403,6 +2698,15 @@ void DrawVisualBitmap_Draw(const PicCommand *pCommand, PicData *pData, ViewPort
                 cel.TransparentColor,
                 false,
 				false);
+
+            if (pData->pOwnership)
+            {
+                pData->pOwnership->SetChanged(PicScreen::Visual, &visualBefore[0], pData->pdataVisual, byteSize);
+                if (!priorityBefore.empty())
+                {
+                    pData->pOwnership->SetChanged(PicScreen::Priority, &priorityBefore[0], pData->pdataPriority, byteSize);
+                }
+            }
         }
 
         // Fill in the aux thing (otherwise stuff like LSL6, pic 320 is wrong).
@@ -92,7 +92,34 @@ public:
     uint16_t bPriorityLines[NumPriorityBars];
 };
 
+//
+// Optionally filled in as a side effect of drawing: for each pixel of the visual, priority
+// and control screens, the index of the last command that changed it. This lets us find the
+// command responsible for a pixel without redrawing the pic.
+//
+struct PicOwnership
+{
+    static const uint16_t NoCommand = 0xffff;   // Also the limit on the number of commands
+
+    PicOwnership(size16 size);
+
+    // Compares a screen before and after drawing, and marks the pixels that changed.
+    void SetChanged(PicScreen screen, const uint8_t *before, const uint8_t *after, size_t count);
+
+    uint16_t Command;                       // The command being drawn
+    std::vector<uint16_t> Owners[3];        // Indexed by PicScreen
+};
+
 
+//
+// Fill commands use a scanline fill by default. The original per-pixel fill can still be selected
+// (through PicData) so that the two can be compared.
+//
+enum class FillAlgorithm
+{
+    Span,
+    PerPixel,
+};
 
 struct PicData
 {
@@ -105,6 +132,8 @@ struct PicData
 	bool isUndithered;
     size16 size;
     bool isContinuousPriority;
+    PicOwnership *pOwnership;   // Optional
+    FillAlgorithm fillAlgorithm; // Left out by most callers, which get the span fill.
 
     void EnsureInBounds(int &x, int &y);
 };
@@ -414,13 +443,19 @@ enum DRAWSIZE
 //
 void LineCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState);
 void LineCommand_DrawOnly(const PicCommand *pCommand, PicData *pData, const ViewPort *pState);
+void LineCommand_DrawOnly(PicData *pData, const ViewPort *pState, int16_t xFrom, int16_t yFrom, int16_t xTo, int16_t yTo);
 void PatternCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState);
 void PatternCommand_Draw_DrawOnly(const PicCommand *pCommand, PicData *pData, const ViewPort *pState);
+void PatternCommand_Draw_DrawOnly(PicData *pData, const ViewPort *pState, int16_t x, int16_t y, uint8_t bPatternSize, uint8_t bPatternNR, uint8_t wFlags);
 void PatternCommand_Draw_StateOnly(const PicCommand *pCommand, PicData *pData, ViewPort *pState);
 void FillCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState);
+void FillCommand_Draw(PicData *pData, const ViewPort *pState, int16_t x, int16_t y);
 void SetVisualCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState);
+void SetVisualCommand_Draw(ViewPort *pState, uint8_t bColor, bool isVGA);
 void SetPriorityCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState);
+void SetPriorityCommand_Draw(PicData *pData, ViewPort *pState, int16_t bPriorityValue);
 void SetControlCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState);
+void SetControlCommand_Draw(ViewPort *pState, uint8_t bControlValue);
 void DisableVisualCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState);
 void DisablePriorityCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState);
 void DisableControlCommand_Draw(const PicCommand *pCommand, PicData *pData, ViewPort *pState);
@@ -19,7 +19,9 @@
 #include "PaletteOperations.h"
 #include "format.h"
 #include "PicCommands.h"
+#include "PicRenderProgram.h"
 #include "View.h"
+#include <chrono>
 
 using namespace Gdiplus;
 
@@ -33,13 +35,24 @@ PicPositionFlags PicPositionToFlags(PicPosition pos)
     return (PicPositionFlags)(0x1 << (int)pos);
 }
 
-PicDrawManager::PicDrawManager(const PicComponent *pPic, const PaletteComponent *pPalette, bool isEGAUndithered)
+// We take a checkpoint every this many commands, or sooner if drawing since the last one took
+// longer than CheckpointDrawMilliseconds.
+const ptrdiff_t CheckpointCommandInterval = 100;
+const long long CheckpointDrawMilliseconds = 10;
+// How many commands we draw between looking at the time.
+const ptrdiff_t CheckpointTimeCheckInterval = 10;
+// Upper limit on the memory used by checkpoints.
+const size_t CheckpointMemoryBudget = 16 * 1024 * 1024;
+
+PicDrawManager::PicDrawManager(const PicComponent *pPic, const PaletteComponent *pPalette, bool isEGAUndithered, bool useCheckpoints)
     : _pPicWeak(pPic),
     _paletteVGA{},
     _isVGA(pPalette != nullptr),
     _isContinuousPri(pPic && pPic->Traits->ContinuousPriority),
 	_isUndithered(isEGAUndithered),
-    _screenBuffers{}
+    _screenBuffers{},
+    _useCheckpoints(useCheckpoints),
+    _maxCheckpoints(0)
 {
     _viewPorts = std::make_unique<ViewPort[]>(3);
     _Reset();
@@ -54,12 +67,20 @@ PicDrawManager::PicDrawManager(const PicComponent *pPic, const PaletteComponent
     }
 }
 
+PicDrawManager::~PicDrawManager() {}
+
 void PicDrawManager::_EnsureBufferPool(size16 size)
 {
     size_t byteSize = size.cx * size.cy;
     if (!_bufferPool || (_bufferPool->GetSize() != byteSize))
     {
+        _ClearCheckpoints();
         _bufferPool = std::make_unique<BufferPool<12>>(byteSize);
+        if (_useCheckpoints)
+        {
+            _checkpointPool = std::make_unique<BufferPool<MaxCheckpointBuffers>>(byteSize);
+            _maxCheckpoints = min((size_t)(MaxCheckpointBuffers / 4), max((size_t)2, CheckpointMemoryBudget / (byteSize * 4)));
+        }
         Invalidate();
     }
 }
@@ -87,13 +108,23 @@ void PicDrawManager::_Reset()
     _bPaletteNumber = 0;
     //_currentState.Reset(_bPaletteNumber);
     _iInsertPos = -1;
+    _ClearCheckpoints();
+    _ownership.reset();
+    _program.reset();
 }
 
 void PicDrawManager::SetPic(const PicComponent *pPic, const PaletteComponent *pPalette, bool isEGAUndithered)
 {
+    bool isContinuousPri = pPic && pPic->Traits->ContinuousPriority;
+    if ((_isUndithered != isEGAUndithered) || (_isVGA != (pPalette != nullptr)) || (_isContinuousPri != isContinuousPri))
+    {
+        // These affect what gets drawn.
+        _ClearCheckpoints();
+        _ownership.reset();
+    }
 	_isUndithered = isEGAUndithered;
     _isVGA = (pPalette != nullptr);
-    _isContinuousPri = pPic && pPic->Traits->ContinuousPriority;
+    _isContinuousPri = isContinuousPri;
     if (!IsSame(pPic, _pPicWeak))
     {
         _Reset();
@@ -204,6 +235,7 @@ void PicDrawManager::SetPalette(uint8_t bPaletteNumber)
         _fValidPalette = false; // Since the palette changed.
         _fValidScreens = PicScreenFlags::None;
         _fValidState = false;
+        _ClearCheckpoints();
     }
 }
 
@@ -353,7 +385,7 @@ void PicDrawManager::_RedrawBuffers(ViewPort *pState, PicScreenFlags screenFlags
         };
 
         // Now draw!
-        Draw(*_pPicWeak, data, _viewPorts[0], 0, _iDrawPos);
+        _DrawFromCheckpoint(data, _viewPorts[0], _iDrawPos);
     }
 
     // Perf optimization: if no one is drawing on the pic, then we can "skip" this step
@@ -430,7 +462,7 @@ void PicDrawManager::_RedrawBuffers(ViewPort *pState, PicScreenFlags screenFlags
             };
 
             // Now draw!
-            Draw(*_pPicWeak, data, _viewPorts[2], _iDrawPos, -1);
+            _GetProgram().Execute(data, _viewPorts[2], _iDrawPos, -1);
         }
     }
 
@@ -671,15 +703,27 @@ const ViewPort *PicDrawManager::GetViewPort(PicPosition pos)
 }
 
 //
-// Given a point, determines the position in the pic, before iState (-1 = end)
-// where that position changed.
+// Given a point, determines the position in the pic of the last command that
+// changed it on the given screen.
 // Returns -1 if that point was never changed.
-// Currently only works for visual screen.
 //
-ptrdiff_t PicDrawManager::PosFromPoint(int x, int y, ptrdiff_t iStart)
+ptrdiff_t PicDrawManager::PosFromPoint(int x, int y, PicScreen screen)
 {
-    ViewPort state(0);
     size16 size = _GetPicSize();
+    if ((x < 0) || (y < 0) || (x >= size.cx) || (y >= size.cy))
+    {
+        return -1;
+    }
+
+    if (_pPicWeak->commands.size() < PicOwnership::NoCommand)
+    {
+        _EnsureOwnership();
+        uint16_t command = _ownership->Owners[(int)screen][BUFFEROFFSET_NONSTD(size.cx, size.cy, x, y)];
+        return (command == PicOwnership::NoCommand) ? -1 : command;
+    }
+
+    // Too many commands to keep track of, so redraw the pic and watch the pixel (only works for the visual screen).
+    ViewPort state(0);
     size_t byteSize = size.cx * size.cy;
     // Clear out our cached bitmaps.
     PicScreenFlags dwMapsToRedraw = PicScreenFlags::None;
@@ -702,6 +746,51 @@ ptrdiff_t PicDrawManager::PosFromPoint(int x, int y, ptrdiff_t iStart)
     return GetLastChangedSpot(*_pPicWeak, data, state, x, y);
 }
 
+//
+// Draws the whole pic, noting which command last changed each pixel. This is kept until the pic changes.
+//
+void PicDrawManager::_EnsureOwnership()
+{
+    if (!_ownership)
+    {
+        size16 size = _GetPicSize();
+        size_t byteSize = size.cx * size.cy;
+        std::vector<uint8_t> pdataVisual(byteSize, (_isVGA || _isUndithered) ? 0xff : 0x0f);
+        std::vector<uint8_t> pdataPriority(byteSize, 0x00);
+        std::vector<uint8_t> pdataControl(byteSize, 0x00);
+        std::vector<uint8_t> pdataAux(byteSize, 0x00);
+        _ownership = std::make_unique<PicOwnership>(size);
+        PicData data =
+        {
+            PicScreenFlags::Visual | PicScreenFlags::Priority | PicScreenFlags::Control,
+            &pdataVisual[0],
+            &pdataPriority[0],
+            &pdataControl[0],
+            &pdataAux[0],
+            _isVGA,
+            _isUndithered,
+            size,
+            _isContinuousPri,
+            _ownership.get()
+        };
+        ViewPort state(0);
+        _GetProgram().Execute(data, state, 0, -1);
+    }
+}
+
+//
+// The compiled form of the pic's commands, which is what we redraw from. It's rebuilt the first
+// time it's needed after the pic changes.
+//
+const PicRenderProgram &PicDrawManager::_GetProgram()
+{
+    if (!_program || !_program->IsFor(_pPicWeak->commands))
+    {
+        _program = std::make_unique<PicRenderProgram>(_pPicWeak->commands);
+    }
+    return *_program;
+}
+
 //
 // Seek to a particular position.
 // The picture is drawn up to and including that position.
@@ -724,7 +813,75 @@ void PicDrawManager::AddPicPlugin(IPicDrawPlugin *plugin)
     _plugins.push_back(plugin);
 }
 
-void PicDrawManager::Invalidate()
+//
+// Call this when the pic has changed. Commands before iFirstChanged are assumed to be the same as
+// before, so we can keep the checkpoints that only include those. Otherwise everything is redrawn
+// from scratch.
+//
+void PicDrawManager::Invalidate(ptrdiff_t iFirstChanged)
+{
+    _InvalidateScreens();
+    _ClearCheckpoints(iFirstChanged);
+    _ownership.reset();
+    _program.reset();
+}
+
+//
+// The bounding rectangle (in pic coordinates) of the pixels that differ between two screens.
+//
+CRect _GetDifferenceBounds(const uint8_t *one, const uint8_t *two, size16 size)
+{
+    CRect rect(0, 0, 0, 0);
+    for (int y = 0; y < size.cy; y++)
+    {
+        size_t offset = BUFFEROFFSET_NONSTD(size.cx, size.cy, 0, y);
+        const uint8_t *lineOne = one + offset;
+        const uint8_t *lineTwo = two + offset;
+        if (memcmp(lineOne, lineTwo, size.cx) != 0)
+        {
+            int left = 0;
+            while (lineOne[left] == lineTwo[left])
+            {
+                left++;
+            }
+            int right = size.cx;
+            while (lineOne[right - 1] == lineTwo[right - 1])
+            {
+                right--;
+            }
+            if (rect.IsRectEmpty())
+            {
+                rect.SetRect(left, y, right, y + 1);
+            }
+            else
+            {
+                rect.left = min(rect.left, left);
+                rect.right = max(rect.right, right);
+                rect.bottom = y + 1;
+            }
+        }
+    }
+    return rect;
+}
+
+CRect PicShownScreen::GetChangedRect(PicDrawManager &pdm, PicScreen screen, PicPosition position, size16 size) const
+{
+    if ((screen != _screen) || (position != _position) || (_bits.size() != (size_t)(size.cx * size.cy)))
+    {
+        return CRect(0, 0, size.cx, size.cy);
+    }
+    return _GetDifferenceBounds(&_bits[0], pdm.GetPicBits(screen, position, size), size);
+}
+
+void PicShownScreen::MarkShown(PicDrawManager &pdm, PicScreen screen, PicPosition position, size16 size)
+{
+    const uint8_t *bits = pdm.GetPicBits(screen, position, size);
+    _screen = screen;
+    _position = position;
+    _bits.assign(bits, bits + size.cx * size.cy);
+}
+
+void PicDrawManager::_InvalidateScreens()
 {
     _fValidScreens = PicScreenFlags::None;
     _fValidState = false;
@@ -732,7 +889,166 @@ void PicDrawManager::Invalidate()
 
 void PicDrawManager::_OnPosChanged(bool fNotify)
 {
-    Invalidate();
+    // The pic itself hasn't changed, so our checkpoints are still good.
+    _InvalidateScreens();
+}
+
+//
+// Draws commands up to iEnd (-1 for all of them) into the PrePlugin buffers in data. If we have a
+// checkpoint before iEnd, we start from there. Otherwise data and state need to hold the initial pic state.
+// New checkpoints are taken as we go, if we use them.
+//
+void PicDrawManager::_DrawFromCheckpoint(PicData &data, ViewPort &state, ptrdiff_t iEnd)
+{
+    const PicComponent &pic = *_pPicWeak;
+    ptrdiff_t commandCount = (ptrdiff_t)pic.commands.size();
+    if ((iEnd == -1) || (iEnd > commandCount))
+    {
+        iEnd = commandCount;
+    }
+
+    ptrdiff_t iStart = 0;
+    uint8_t *screens[4] = { data.pdataVisual, data.pdataPriority, data.pdataControl, data.pdataAux };
+    for (auto it = _checkpoints.rbegin(); it != _checkpoints.rend(); ++it)
+    {
+        if ((it->Position <= iEnd) && AreAllFlagsSet(it->Screens, data.dwMapsToRedraw))
+        {
+            size_t byteSize = _bufferPool->GetSize();
+            for (int i = 0; i < 4; i++)
+            {
+                if (IsFlagSet(data.dwMapsToRedraw, PicScreenToFlags((PicScreen)i)))
+                {
+                    memcpy(screens[i], it->Buffers[i], byteSize);
+                }
+            }
+            state = it->State;
+            iStart = it->Position;
+            break;
+        }
+    }
+
+    const PicRenderProgram &program = _GetProgram();
+    if (!_useCheckpoints)
+    {
+        program.Execute(data, state, iStart, iEnd);
+        return;
+    }
+
+    auto lastCheckpointTime = std::chrono::steady_clock::now();
+    ptrdiff_t drawn = iStart;
+    while (drawn < iEnd)
+    {
+        ptrdiff_t nextCheckpoint = (drawn / CheckpointCommandInterval + 1) * CheckpointCommandInterval;
+        ptrdiff_t next = min(iEnd, min(nextCheckpoint, drawn + CheckpointTimeCheckInterval));
+        program.Execute(data, state, drawn, next);
+        drawn = next;
+
+        auto now = std::chrono::steady_clock::now();
+        if (((drawn % CheckpointCommandInterval) == 0) ||
+            (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastCheckpointTime).count() >= CheckpointDrawMilliseconds))
+        {
+            _AddCheckpoint(drawn, data, state);
+            lastCheckpointTime = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+void PicDrawManager::_AddCheckpoint(ptrdiff_t iPos, const PicData &data, const ViewPort &state)
+{
+    auto it = std::lower_bound(_checkpoints.begin(), _checkpoints.end(), iPos,
+        [](const Checkpoint &checkpoint, ptrdiff_t pos) { return checkpoint.Position < pos; });
+    if ((it != _checkpoints.end()) && (it->Position == iPos))
+    {
+        if (AreAllFlagsSet(it->Screens, data.dwMapsToRedraw))
+        {
+            // Already have this one.
+            return;
+        }
+        // Replace it with one that has more screens.
+        for (uint8_t *buffer : it->Buffers)
+        {
+            _checkpointPool->FreeBuffer(buffer);
+        }
+        _checkpoints.erase(it);
+    }
+
+    if (_checkpoints.size() >= _maxCheckpoints)
+    {
+        _EvictCheckpoint();
+    }
+
+    Checkpoint checkpoint = {};
+    checkpoint.Position = iPos;
+    checkpoint.Screens = data.dwMapsToRedraw;
+    checkpoint.State = state;
+    const uint8_t *screens[4] = { data.pdataVisual, data.pdataPriority, data.pdataControl, data.pdataAux };
+    for (int i = 0; i < 4; i++)
+    {
+        if (IsFlagSet(checkpoint.Screens, PicScreenToFlags((PicScreen)i)))
+        {
+            checkpoint.Buffers[i] = _checkpointPool->TryAllocateBuffer();
+            if (!checkpoint.Buffers[i])
+            {
+                for (uint8_t *buffer : checkpoint.Buffers)
+                {
+                    _checkpointPool->FreeBuffer(buffer);
+                }
+                return;
+            }
+            memcpy(checkpoint.Buffers[i], screens[i], _checkpointPool->GetSize());
+        }
+    }
+
+    it = std::lower_bound(_checkpoints.begin(), _checkpoints.end(), iPos,
+        [](const Checkpoint &checkpoint, ptrdiff_t pos) { return checkpoint.Position < pos; });
+    _checkpoints.insert(it, checkpoint);
+}
+
+//
+// Makes room for a new checkpoint. We remove the one closest to its predecessor, so that
+// the remaining ones stay spread out over the pic.
+//
+void PicDrawManager::_EvictCheckpoint()
+{
+    if (!_checkpoints.empty())
+    {
+        size_t evict = 0;
+        ptrdiff_t smallestGap = _checkpoints[0].Position;
+        for (size_t i = 1; i < _checkpoints.size(); i++)
+        {
+            ptrdiff_t gap = _checkpoints[i].Position - _checkpoints[i - 1].Position;
+            if (gap <= smallestGap)
+            {
+                smallestGap = gap;
+                evict = i;
+            }
+        }
+        for (uint8_t *buffer : _checkpoints[evict].Buffers)
+        {
+            _checkpointPool->FreeBuffer(buffer);
+        }
+        _checkpoints.erase(_checkpoints.begin() + evict);
+    }
+}
+
+//
+// Removes the checkpoints that include commands from iFirstChanged onwards.
+//
+void PicDrawManager::_ClearCheckpoints(ptrdiff_t iFirstChanged)
+{
+    auto itFirst = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), iFirstChanged,
+        [](ptrdiff_t pos, const Checkpoint &checkpoint) { return pos < checkpoint.Position; });
+    if (_checkpointPool)
+    {
+        for (auto it = itFirst; it != _checkpoints.end(); ++it)
+        {
+            for (uint8_t *buffer : it->Buffers)
+            {
+                _checkpointPool->FreeBuffer(buffer);
+            }
+        }
+    }
+    _checkpoints.erase(itFirst, _checkpoints.end());
 }
 
 void PicDrawManager::InvalidatePlugins()
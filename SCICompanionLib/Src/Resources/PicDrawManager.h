@@ -20,6 +20,7 @@ struct PicData;
 struct PicComponent;
 struct PaletteComponent;
 struct Cel;
+class PicRenderProgram;
 
 enum class PicPosition
 {
@@ -53,7 +54,10 @@ public:
 class PicDrawManager
 {
 public:
-    PicDrawManager(const PicComponent *pPic = nullptr, const PaletteComponent *pPalette = nullptr, bool isEGAUndithered = false);
+    // Checkpoints make seeking around in the pic quick, but hold onto a lot of memory. So only
+    // use them for a pic that's being edited.
+    PicDrawManager(const PicComponent *pPic = nullptr, const PaletteComponent *pPalette = nullptr, bool isEGAUndithered = false, bool useCheckpoints = false);
+    ~PicDrawManager();
     void SetPic(const PicComponent *pPic, const PaletteComponent *pPalette, bool isEGAUndithered);
     const PicComponent *GetPic() const { return _pPicWeak; }
 
@@ -68,10 +72,10 @@ public:
     uint8_t GetPalette() { return _bPaletteNumber; }
     const ViewPort *GetViewPort(PicPosition pos);
     bool SeekToPos(ptrdiff_t iPos); // true if changed
-    ptrdiff_t PosFromPoint(int x, int y, ptrdiff_t iStart);
+    ptrdiff_t PosFromPoint(int x, int y, PicScreen screen = PicScreen::Visual);
     ptrdiff_t GetPos() const { return _iInsertPos; }
     void SetPreview(bool fPreview);
-    void Invalidate();
+    void Invalidate(ptrdiff_t iFirstChanged = 0);
 
     void AddPicPlugin(IPicDrawPlugin *plugin);
 
@@ -102,6 +106,13 @@ private:
     void _ApplyVGAPalette(const PaletteComponent *pPalette);
     RGBQUAD *PicDrawManager::_GetPalette();
     void _EnsureBufferPool(size16 size);
+    void _DrawFromCheckpoint(PicData &data, ViewPort &state, ptrdiff_t iEnd);
+    void _AddCheckpoint(ptrdiff_t iPos, const PicData &data, const ViewPort &state);
+    void _EvictCheckpoint();
+    void _ClearCheckpoints(ptrdiff_t iFirstChanged = 0);
+    void _InvalidateScreens();
+    void _EnsureOwnership();
+    const PicRenderProgram &_GetProgram();
 
     const PicComponent *_pPicWeak;
     RGBQUAD _paletteVGA[256];
@@ -114,6 +125,27 @@ private:
     // Cached view port state for each of the 3 position buffers.
     std::unique_ptr<ViewPort[]> _viewPorts;
 
+    // Snapshots of the PrePlugin screens and state part way through the pic. Redrawing after a seek
+    // starts from the nearest one before the draw position, instead of from the first command.
+    struct Checkpoint
+    {
+        ptrdiff_t Position;         // Number of commands drawn
+        PicScreenFlags Screens;     // Which of Buffers are valid
+        ViewPort State;
+        uint8_t *Buffers[4];        // Indexed by PicScreen
+    };
+    static const int MaxCheckpointBuffers = 128;
+    bool _useCheckpoints;
+    std::unique_ptr<BufferPool<MaxCheckpointBuffers>> _checkpointPool;  // Only if _useCheckpoints
+    std::vector<Checkpoint> _checkpoints;   // Sorted by Position
+    size_t _maxCheckpoints;
+
+    // Which command last changed each pixel of the whole pic, for PosFromPoint. Created on demand.
+    std::unique_ptr<PicOwnership> _ownership;
+
+    // The pic's commands in the form we draw them from. Created on demand.
+    std::unique_ptr<PicRenderProgram> _program;
+
     // Are the bitmaps valid? (note, if any of these are valid, then the aux is valid too)
     PicScreenFlags _fValidScreens;
     PicPositionFlags _validPositions;
@@ -131,4 +163,24 @@ private:
     bool _isVGA;
 	bool _isUndithered;
     bool _isContinuousPri;
+};
+
+//
+// For redrawing only what changed: a copy of the screen a view last showed. Several views can show
+// the same PicDrawManager, so each keeps its own.
+//
+class PicShownScreen
+{
+public:
+    PicShownScreen() : _screen(PicScreen::Visual), _position(PicPosition::PostPlugin) {}
+
+    // The area of a screen (in pic coordinates) that differs from what it was when MarkShown was last
+    // called for it. This is the whole pic if it wasn't.
+    CRect GetChangedRect(PicDrawManager &pdm, PicScreen screen, PicPosition position, size16 size) const;
+    void MarkShown(PicDrawManager &pdm, PicScreen screen, PicPosition position, size16 size);
+
+private:
+    PicScreen _screen;
+    PicPosition _position;
+    std::vector<uint8_t> _bits;
 };
\ No newline at end of file
@@ -397,6 +397,10 @@ void Draw(const PicComponent &pic, PicData &data, ViewPort &state, ptrdiff_t iSt
     for (ptrdiff_t i = iStart; i < iEnd; i++)
     {
         const PicCommand &command = pic.commands[i];
+        if (data.pOwnership)
+        {
+            data.pOwnership->Command = (uint16_t)i;
+        }
         command.Draw(&data, state);
     }
 }
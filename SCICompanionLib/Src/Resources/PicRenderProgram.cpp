@@ -0,0 +1,208 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "PicRenderProgram.h"
+
+// How many of each kind of operand a command uses, indexed by PicCommand::CommandType.
+struct OperandCounts
+{
+    uint8_t Coords;
+    uint8_t Values;
+    uint8_t Others;
+};
+
+const OperandCounts c_operandCounts[] =
+{
+    { 4, 0, 0 },    // Line
+    { 2, 3, 0 },    // Pattern
+    { 2, 0, 0 },    // Fill
+    { 0, 2, 0 },    // SetVisual
+    { 1, 0, 0 },    // SetPriority
+    { 0, 1, 0 },    // SetControl
+    { 0, 0, 0 },    // DisableVisual
+    { 0, 0, 0 },    // DisablePriority
+    { 0, 0, 0 },    // DisableControl
+    { 0, 0, 1 },    // SetPalette
+    { 0, 0, 1 },    // SetPaletteEntry
+    { 0, 0, 1 },    // SetPriorityBars
+    { 0, 0, 1 },    // DrawBitmap
+    { 0, 0, 1 },    // Circle
+};
+
+PicRenderProgram::PicRenderProgram(const std::vector<PicCommand> &commands) : _source(&commands)
+{
+    _opcodes.reserve(commands.size());
+    _coords.reserve(commands.size() * 2);
+    _values.reserve(commands.size());
+    _index.reserve(commands.size() / IndexInterval + 1);
+    for (const PicCommand &command : commands)
+    {
+        if ((_opcodes.size() % IndexInterval) == 0)
+        {
+            Cursor cursor = { (uint32_t)_coords.size(), (uint32_t)_values.size(), (uint32_t)_others.size() };
+            _index.push_back(cursor);
+        }
+
+        assert(command.type < ARRAYSIZE(c_operandCounts));
+        _opcodes.push_back(command.type);
+        switch (command.type)
+        {
+            case PicCommand::Line:
+                _coords.push_back(command.drawLine.xFrom);
+                _coords.push_back(command.drawLine.yFrom);
+                _coords.push_back(command.drawLine.xTo);
+                _coords.push_back(command.drawLine.yTo);
+                break;
+
+            case PicCommand::Pattern:
+                _coords.push_back(command.drawPattern.x);
+                _coords.push_back(command.drawPattern.y);
+                _values.push_back(command.drawPattern.bPatternSize);
+                _values.push_back(command.drawPattern.bPatternNR);
+                _values.push_back(command.drawPattern.wFlags);
+                break;
+
+            case PicCommand::Fill:
+                _coords.push_back(command.fill.x);
+                _coords.push_back(command.fill.y);
+                break;
+
+            case PicCommand::SetVisual:
+                _values.push_back(command.setVisual.bColor);
+                _values.push_back(command.setVisual.isVGA ? 1 : 0);
+                break;
+
+            case PicCommand::SetPriority:
+                _coords.push_back(command.setPriority.bPriorityValue);
+                break;
+
+            case PicCommand::SetControl:
+                _values.push_back(command.setControl.bControlValue);
+                break;
+
+            case PicCommand::DisableVisual:
+            case PicCommand::DisablePriority:
+            case PicCommand::DisableControl:
+                break;
+
+            default:
+                _others.push_back(&command);
+                break;
+        }
+    }
+}
+
+bool PicRenderProgram::IsFor(const std::vector<PicCommand> &commands) const
+{
+    return (_source == &commands) && (_opcodes.size() == commands.size());
+}
+
+//
+// Finds where the operands for a command start.
+//
+PicRenderProgram::Cursor PicRenderProgram::_Seek(ptrdiff_t iPos) const
+{
+    Cursor cursor = { 0, 0, 0 };
+    if (!_index.empty())
+    {
+        size_t indexEntry = min((size_t)iPos / IndexInterval, _index.size() - 1);
+        cursor = _index[indexEntry];
+        for (ptrdiff_t i = (ptrdiff_t)(indexEntry * IndexInterval); i < iPos; i++)
+        {
+            const OperandCounts &counts = c_operandCounts[_opcodes[i]];
+            cursor.Coord += counts.Coords;
+            cursor.Value += counts.Values;
+            cursor.Other += counts.Others;
+        }
+    }
+    return cursor;
+}
+
+void PicRenderProgram::Execute(PicData &data, ViewPort &state, ptrdiff_t iStart, ptrdiff_t iEnd) const
+{
+    ptrdiff_t commandCount = (ptrdiff_t)_opcodes.size();
+    if ((iEnd == -1) || (iEnd > commandCount))
+    {
+        iEnd = commandCount;
+    }
+    if (iStart >= iEnd)
+    {
+        return;
+    }
+
+    Cursor cursor = _Seek(iStart);
+    const PicCommand::CommandType *opcodes = &_opcodes[0];
+    const int16_t *coords = _coords.empty() ? nullptr : &_coords[cursor.Coord];
+    const uint8_t *values = _values.empty() ? nullptr : &_values[cursor.Value];
+    const PicCommand * const *others = _others.empty() ? nullptr : &_others[cursor.Other];
+    for (ptrdiff_t i = iStart; i < iEnd; i++)
+    {
+        if (data.pOwnership)
+        {
+            data.pOwnership->Command = (uint16_t)i;
+        }
+
+        switch (opcodes[i])
+        {
+            case PicCommand::Line:
+                LineCommand_DrawOnly(&data, &state, coords[0], coords[1], coords[2], coords[3]);
+                coords += 4;
+                break;
+
+            case PicCommand::Pattern:
+                PatternCommand_Draw_DrawOnly(&data, &state, coords[0], coords[1], values[0], values[1], values[2]);
+                state.bPatternSize = values[0]; // As in PatternCommand_Draw_StateOnly
+                coords += 2;
+                values += 3;
+                break;
+
+            case PicCommand::Fill:
+                FillCommand_Draw(&data, &state, coords[0], coords[1]);
+                coords += 2;
+                break;
+
+            case PicCommand::SetVisual:
+                SetVisualCommand_Draw(&state, values[0], values[1] != 0);
+                values += 2;
+                break;
+
+            case PicCommand::SetPriority:
+                SetPriorityCommand_Draw(&data, &state, coords[0]);
+                coords += 1;
+                break;
+
+            case PicCommand::SetControl:
+                SetControlCommand_Draw(&state, values[0]);
+                values += 1;
+                break;
+
+            case PicCommand::DisableVisual:
+                state.dwDrawEnable &= ~PicScreenFlags::Visual;
+                break;
+
+            case PicCommand::DisablePriority:
+                state.dwDrawEnable &= ~PicScreenFlags::Priority;
+                break;
+
+            case PicCommand::DisableControl:
+                state.dwDrawEnable &= ~PicScreenFlags::Control;
+                break;
+
+            default:
+                (*others)->Draw(&data, state);
+                others += 1;
+                break;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+#include "PicCommands.h"
+
+//
+// A compact form of a pic's commands, for redrawing it quickly. The PicCommand vector is still what
+// gets edited; this is built from it after each change (it keeps pointers into it).
+//
+// The opcodes and their operands are kept in separate packed arrays, and each command consumes
+// its operands in order. Commands that are rare or carry a lot of data (palettes, bitmaps,
+// priority bars, circles) just refer back to the original PicCommand.
+//
+class PicRenderProgram
+{
+public:
+    PicRenderProgram(const std::vector<PicCommand> &commands);
+
+    size_t GetCommandCount() const { return _opcodes.size(); }
+    bool IsFor(const std::vector<PicCommand> &commands) const;
+
+    // Same as Draw(pic, data, state, iStart, iEnd)
+    void Execute(PicData &data, ViewPort &state, ptrdiff_t iStart, ptrdiff_t iEnd) const;
+
+private:
+    struct Cursor
+    {
+        uint32_t Coord;
+        uint32_t Value;
+        uint32_t Other;
+    };
+    Cursor _Seek(ptrdiff_t iPos) const;
+
+    static const int IndexInterval = 64;
+
+    const std::vector<PicCommand> *_source;
+    std::vector<PicCommand::CommandType> _opcodes;
+    std::vector<int16_t> _coords;               // Coordinates, and priority values
+    std::vector<uint8_t> _values;               // Colors, control values and pen styles
+    std::vector<const PicCommand*> _others;     // Commands that are drawn as is
+    std::vector<Cursor> _index;                 // Where the operands start for every IndexInterval commands
+};
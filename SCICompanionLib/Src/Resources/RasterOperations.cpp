@@ -63,7 +63,7 @@ void ReallocBits(
     if ((newSize != cel.size) || fForce)
     {
         size_t cItems = PaddedSize(newSize);
-        sci::array<uint8_t> newBits(cItems);
+        sci::cow_array<uint8_t> newBits(cItems);
         if (fCopy || fFill)
         {
             if (fFill)
@@ -74,7 +74,7 @@ void ReallocBits(
             if (fCopy)
             {
                 uint8_t *pBitsNew = &newBits[0];   // Access to raw data
-                uint8_t *pBits = &cel.Data[0];      // Access to old raw data
+                const uint8_t *pBits = &static_cast<const Cel&>(cel).Data[0];      // Access to old raw data (without copying it)
 
                 // Copy from the old bitmap (y = 0 is at the bottom)
                 int yEnd = min(newSize.cy, cel.size.cy);
@@ -403,6 +403,32 @@ void CreateDegenerate(Cel &cel, uint8_t bColor)
     cel.Data.fill(bColor);
 }
 
+// Is celMirror's image already the horizontal flip of celOrig's? This only reads the bits,
+// so it doesn't cause either cel to take its own copy of them.
+bool _IsMirroredCopy(const Cel &celMirror, const Cel &celOrig)
+{
+    if ((celMirror.size != celOrig.size) || (celMirror.Data.size() < PaddedSize(celOrig.size)))
+    {
+        return false;
+    }
+    int cxActual = CX_ACTUAL(celOrig.size.cx);
+    for (int y = 0; y < celOrig.size.cy; y++)
+    {
+        const uint8_t *pLineOrig = &celOrig.Data[y * cxActual];
+        const uint8_t *pLineMirror = &celMirror.Data[y * cxActual] + (celOrig.size.cx - 1);
+        for (int x = 0; x < celOrig.size.cx; x++)
+        {
+            if (*pLineOrig != *pLineMirror)
+            {
+                return false;
+            }
+            ++pLineOrig;
+            --pLineMirror;
+        }
+    }
+    return true;
+}
+
 void SyncCelMirrorState(Cel &celMirror, const Cel &celOrig)
 {
     // Not valid anymore, with VGA
@@ -412,26 +438,35 @@ void SyncCelMirrorState(Cel &celMirror, const Cel &celOrig)
     celMirror.placement.x = -celOrig.placement.x; // Note that we invert x here!  It's a mirror!
     celMirror.placement.y = celOrig.placement.y;
 
-    ReallocBits(celMirror, celOrig.size, false, false, false, 0, RasterResizeFlags::Normal);
-    CopyMirrored(celMirror, celOrig);
+    if (_IsMirroredCopy(celOrig, celOrig))
+    {
+        // The original is symmetric, so the mirror can just share its bits.
+        celMirror.size = celOrig.size;
+        celMirror.Data = celOrig.Data;
+    }
+    else if (!_IsMirroredCopy(celMirror, celOrig))
+    {
+        // Only re-flip when something changed, so that an unchanged mirror keeps sharing its
+        // bits with earlier copies of the resource (e.g. on the undo stack).
+        ReallocBits(celMirror, celOrig.size, false, false, false, 0, RasterResizeFlags::Normal);
+        CopyMirrored(celMirror, celOrig);
+    }
 }
 
 const uint8_t UpdateFromMirror = 0xff;
 
 RasterChange MirrorLoopFrom(Loop &loop, uint8_t nOriginal, const Loop &orig)
 {
-    // Reallocate all cels.
-    loop.Cels.clear();
     if (nOriginal != UpdateFromMirror)
     {
         loop.MirrorOf = nOriginal;
         loop.IsMirror = true;
     }
+    // Keep the cels we already have, so the ones whose original didn't change are left alone.
+    // Any extra ones start out empty.
+    loop.Cels.resize(orig.Cels.size());
     for (size_t i = 0; i < orig.Cels.size(); i++)
     {
-        // Make new empty cels, and for each one, do a "sync mirror state" if the original.
-        loop.Cels.push_back(Cel());
-        assert(loop.Cels.size() == (i + 1));
         SyncCelMirrorState(loop.Cels[i], orig.Cels[i]);
     }
     return RasterChange(RasterChangeHint::NewView);
@@ -1082,16 +1117,28 @@ RasterChange RemoveCel(RasterComponent &raster, CelIndex celIndex)
 }
 
 
+// Each field is written on its own (Cel isn't plain data, since its bits are shared), followed by the bits.
 void SerializeCelRuntime(sci::ostream &out, const Cel &cel)
 {
-    out << cel;
+    out << cel.size.cx;
+    out << cel.size.cy;
+    out << cel.placement.x;
+    out << cel.placement.y;
+    out << cel.TransparentColor;
+    out << (uint8_t)(cel.Stride32 ? 1 : 0);
     out.WriteBytes(&cel.Data[0], PaddedSize(cel.size));
 }
 void DeserializeCelRuntime(sci::istream &in, Cel &cel)
 {
     assert(cel.Data.empty());
-    in >> cel;
-    memset(&cel.Data, 0, sizeof(cel.Data)); // A bit of a hack
+    uint8_t stride32;
+    in >> cel.size.cx;
+    in >> cel.size.cy;
+    in >> cel.placement.x;
+    in >> cel.placement.y;
+    in >> cel.TransparentColor;
+    in >> stride32;
+    cel.Stride32 = (stride32 != 0);
     cel.Data.allocate(PaddedSize(cel.size));
     in.read_data(&cel.Data[0], cel.Data.size());
 }
@@ -362,6 +362,8 @@ public:
     int GetEncoding() const { return header.CompressionMethod; }
     std::string GetEncodingString() const;
     const uint8_t *GetData() const;
+    // The uncompressed data as a shared block, for holding onto it without a copy.
+    const sci::cow_array<uint8_t> &GetSharedData() const { return _pData; }
     const uint8_t *GetDataCompressed() const; // WARNING: this can be nullptr!
     int GetLength() const { return header.cbDecompressed; }
     std::string GetName() const { return _strName; }
@@ -402,8 +404,8 @@ private:
 
     // PERF: Don't use vector since resizing does a memset, or using std::copy
     // is much too slow in debug builds.
-    // Uncompressed data.
-    sci::array<uint8_t> _pData;
+    // Uncompressed data. Copies of the blob (and deferred resources created from it) share this.
+    sci::cow_array<uint8_t> _pData;
     // Compressed data (optional, can be NULL)
     sci::array<uint8_t> _pDataCompressed;
 
@@ -0,0 +1,112 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "ResourceCompression.h"
+#include "ResourceBlob.h"
+#include "ResourceUtil.h"
+#include "GameFolderHelper.h"
+#include "Codec.h"
+
+const std::string CompressionSection = "Compression";
+const std::string CompressionDefaultKey = "default";
+
+// Method numbers as they appear in resource headers
+const uint16_t CompressionMethodLZW = 1;    // SCI0
+const uint16_t CompressionMethodDCL = 18;   // SCI1.1
+
+ResourceCompressionPolicies::ResourceCompressionPolicies()
+{
+    std::fill(std::begin(Policies), std::end(Policies), ResourceCompressionPolicy::Store);
+}
+
+ResourceCompressionPolicy _PolicyFromString(std::string value, ResourceCompressionPolicy defaultPolicy)
+{
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    if (value == "store")
+    {
+        return ResourceCompressionPolicy::Store;
+    }
+    else if (value == "compress")
+    {
+        return ResourceCompressionPolicy::Compress;
+    }
+    else if (value == "auto")
+    {
+        return ResourceCompressionPolicy::AutoIfSmaller;
+    }
+    return defaultPolicy;
+}
+
+ResourceCompressionPolicies ResourceCompressionPolicies::FromGameIni(const GameFolderHelper &helper)
+{
+    ResourceCompressionPolicies policies;
+    ResourceCompressionPolicy defaultPolicy = _PolicyFromString(helper.GetIniString(CompressionSection, CompressionDefaultKey), ResourceCompressionPolicy::Store);
+    for (int i = 0; i < NumResourceTypes; i++)
+    {
+        policies.Policies[i] = _PolicyFromString(helper.GetIniString(CompressionSection, g_resourceInfo[i].pszSampleFolderName), defaultPolicy);
+    }
+    return policies;
+}
+
+ResourceCompressionPolicy ResourceCompressionPolicies::ForType(ResourceType type) const
+{
+    return ((int)type < NumResourceTypes) ? Policies[(int)type] : ResourceCompressionPolicy::Store;
+}
+
+bool ResourceCompressionPolicies::IsStoreOnly() const
+{
+    return std::all_of(std::begin(Policies), std::end(Policies), [](ResourceCompressionPolicy policy) { return policy == ResourceCompressionPolicy::Store; });
+}
+
+uint16_t GetResourceCompressionMethod(const SCIVersion &version)
+{
+    if ((version.PackageFormat == ResourcePackageFormat::SCI0) && (version.CompressionFormat == CompressionFormat::SCI0))
+    {
+        return CompressionMethodLZW;
+    }
+    if (version.PackageFormat == ResourcePackageFormat::SCI11)
+    {
+        return CompressionMethodDCL;
+    }
+    // SCI1 uses different LZW and huffman variants, and SCI2 uses STACpack. We can't write those.
+    return 0;
+}
+
+bool CompressResourceData(const SCIVersion &version, ResourceType type, ResourceCompressionPolicy policy, const uint8_t *data, uint32_t size, std::vector<uint8_t> &compressed, uint16_t &compressionMethod)
+{
+    compressionMethod = GetResourceCompressionMethod(version);
+    if ((policy == ResourceCompressionPolicy::Store) || (compressionMethod == 0) || (size == 0))
+    {
+        return false;
+    }
+
+    bool lzw = (compressionMethod == CompressionMethodLZW);
+    bool encoded = lzw ? compressLZW(data, size, compressed) : compressDCL(data, size, compressed);
+    if (!encoded || !IsValidResourceSize(version, compressed.size(), type))
+    {
+        return false;
+    }
+    if ((policy == ResourceCompressionPolicy::AutoIfSmaller) && (compressed.size() >= size))
+    {
+        return false;
+    }
+
+    // Make sure this decompresses back to what we started with, or the game won't be able to load it.
+    std::vector<uint8_t> packed = compressed;
+    std::vector<uint8_t> roundTrip(size);
+    bool decoded = lzw ?
+        (decompressLZW(&roundTrip[0], &packed[0], size, packed.size()) == 0) :
+        decompressDCL(&roundTrip[0], &packed[0], size, packed.size());
+    return decoded && (memcmp(&roundTrip[0], data, size) == 0);
+}
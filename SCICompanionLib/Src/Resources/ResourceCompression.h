@@ -0,0 +1,52 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+//
+// Controls how RebuildResources stores resources that are currently uncompressed. Resources that
+// are already compressed are always copied over as they are.
+//
+// The policies come from the [Compression] section of game.ini, keyed by resource type (the same
+// names as the sample folders, e.g. "view=auto"). A "default" key applies to any type not listed.
+//
+
+class GameFolderHelper;
+
+enum class ResourceCompressionPolicy : uint8_t
+{
+    Store,          // Write the data uncompressed
+    Compress,       // Compress, as long as the result is a valid resource size
+    AutoIfSmaller,  // Compress only if it makes the resource smaller
+};
+
+struct ResourceCompressionPolicies
+{
+    ResourceCompressionPolicies();
+
+    static ResourceCompressionPolicies FromGameIni(const GameFolderHelper &helper);
+
+    ResourceCompressionPolicy ForType(ResourceType type) const;
+    bool IsStoreOnly() const;
+
+    ResourceCompressionPolicy Policies[NumResourceTypes];
+};
+
+// Returns the compression method number that goes in the resource header for resources we compress
+// for this version, or 0 if we don't have an encoder for it.
+uint16_t GetResourceCompressionMethod(const SCIVersion &version);
+
+// Compresses data according to the policy. Returns false if the data should be stored uncompressed.
+// Otherwise, compressed contains data that has been verified to decompress back to the original with
+// our decompressors, and compressionMethod is the method number for the header.
+bool CompressResourceData(const SCIVersion &version, ResourceType type, ResourceCompressionPolicy policy, const uint8_t *data, uint32_t size, std::vector<uint8_t> &compressed, uint16_t &compressionMethod);
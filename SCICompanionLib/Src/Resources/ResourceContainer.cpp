@@ -15,6 +15,7 @@
 #include "ResourceContainer.h"
 #include "ResourceMap.h"
 #include "ResourceBlob.h"
+#include <deque>
 
 using namespace std;
 
@@ -59,6 +60,142 @@ bool ResourceContainer::_PassesFilter(ResourceType type, int resourceNumber, uin
 ResourceContainer::iterator ResourceContainer::begin() { return ResourceIterator(this, false); }
 ResourceContainer::iterator ResourceContainer::end() { return ResourceIterator(this, true); }
 
+struct PendingDecompression
+{
+    PendingDecompression(std::unique_ptr<ResourceBlob> blob) : blob(std::move(blob)), done(false) {}
+
+    std::unique_ptr<ResourceBlob> blob;
+    bool done;
+};
+
+void ResourceContainer::ForEachDecompressed(ResourceTypeFlags types, ResourceEnumOrder order, std::function<bool(std::unique_ptr<ResourceBlob>)> callback)
+{
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    // exit, toDecompress and PendingDecompression::done are protected by the mutex.
+    bool exit = false;
+    std::deque<std::shared_ptr<PendingDecompression>> toDecompress;
+    // Only touched on this thread. In enumeration order.
+    std::deque<std::shared_ptr<PendingDecompression>> inFlight;
+
+    size_t workerCount = max(1u, std::thread::hardware_concurrency());
+    // Don't get too far ahead of the callback, or we'll end up with the whole game in memory.
+    size_t maxInFlight = workerCount * 4;
+
+    auto worker = [&]()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            workAvailable.wait(lock, [&]() { return exit || !toDecompress.empty(); });
+            if (exit)
+            {
+                break;
+            }
+            std::shared_ptr<PendingDecompression> pending = toDecompress.front();
+            toDecompress.pop_front();
+            lock.unlock();
+
+            try
+            {
+                pending->blob->EnsureRealized();
+            }
+            catch (std::exception)
+            {
+                // The decompressors can throw on corrupt data.
+                pending->blob->AddStatusFlags(ResourceLoadStatusFlags::DecompressionFailed);
+            }
+
+            lock.lock();
+            pending->done = true;
+            workDone.notify_one();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(worker);
+    }
+
+    auto stopWorkers = [&]()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            exit = true;
+            toDecompress.clear();
+        }
+        workAvailable.notify_all();
+        for (std::thread &thread : workers)
+        {
+            thread.join();
+        }
+    };
+
+    try
+    {
+        iterator it = begin();
+        iterator itEnd = end();
+        bool keepGoing = true;
+        while (keepGoing)
+        {
+            // Read resources from the volumes until we have enough work queued up.
+            while ((it != itEnd) && (inFlight.size() < maxInFlight))
+            {
+                if (IsFlagSet(types, ResourceTypeToFlag(it.GetResourceType())))
+                {
+                    std::shared_ptr<PendingDecompression> pending = std::make_shared<PendingDecompression>(it.CreateButDelayDecompression());
+                    std::lock_guard<std::mutex> lock(mutex);
+                    inFlight.push_back(pending);
+                    if (IsFlagSet(pending->blob->GetStatusFlags(), ResourceLoadStatusFlags::Delayed))
+                    {
+                        toDecompress.push_back(pending);
+                        workAvailable.notify_one();
+                    }
+                    else
+                    {
+                        // Not compressed, nothing to do.
+                        pending->done = true;
+                    }
+                }
+                ++it;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (inFlight.empty())
+            {
+                break;  // We've handed back everything.
+            }
+
+            auto itReady = inFlight.end();
+            workDone.wait(lock, [&]()
+            {
+                if (order == ResourceEnumOrder::MapOrder)
+                {
+                    itReady = inFlight.front()->done ? inFlight.begin() : inFlight.end();
+                }
+                else
+                {
+                    itReady = std::find_if(inFlight.begin(), inFlight.end(), [](std::shared_ptr<PendingDecompression> &pending) { return pending->done; });
+                }
+                return itReady != inFlight.end();
+            });
+            std::unique_ptr<ResourceBlob> blob = std::move((*itReady)->blob);
+            inFlight.erase(itReady);
+            lock.unlock();
+
+            keepGoing = callback(std::move(blob));
+        }
+    }
+    catch (...)
+    {
+        stopWorkers();
+        throw;
+    }
+    stopWorkers();
+}
+
 // Iterator
 ResourceContainer::ResourceIterator::ResourceIterator(ResourceContainer *container, bool atEnd) : _container(container), _atEnd(atEnd)
 {
@@ -138,7 +275,16 @@ sci::istream ResourceContainer::ResourceIterator::_GetResourceHeaderAndPackage(R
 ResourceHeaderAgnostic ResourceContainer::ResourceIterator::GetResourceHeader() const
 {
     ResourceHeaderAgnostic rh;
-    sci::istream packageByteStream = _GetResourceHeaderAndPackage(rh);
+    if (!_atEnd && (*_container->_mapAndVolumes)[_state.mapIndex]->GetCachedHeader(_currentEntry, rh))
+    {
+        // No need to go to the volume.
+        rh.Number = _currentEntry.Number;
+        rh.PackageHint = _currentEntry.PackageNumber;
+    }
+    else
+    {
+        sci::istream packageByteStream = _GetResourceHeaderAndPackage(rh);
+    }
     return rh;
 }
 
@@ -208,6 +354,11 @@ int ResourceContainer::ResourceIterator::GetResourceNumber()
     return _currentEntry.Number;
 }
 
+ResourceType ResourceContainer::ResourceIterator::GetResourceType()
+{
+    return _currentEntry.Type;
+}
+
 void ResourceContainer::ResourceIterator::_GetNextEntry()
 {
     assert(!_atEnd);
@@ -37,6 +37,13 @@ std::string GetGameIniFileName(const std::string &gameFolder);
 
 DEFINE_ENUM_FLAGS(ResourceEnumFlags, uint16_t)
 
+// For ResourceContainer::ForEachDecompressed
+enum class ResourceEnumOrder
+{
+    MapOrder,       // Resources are handed back in the order they are enumerated
+    Unordered,      // Resources are handed back as soon as they are decompressed
+};
+
 // This is used for iterating through various resources in the game (views, pics, etc...)
 class ResourceContainer
 {
@@ -84,6 +91,7 @@ public:
         ResourceIterator operator++(int);
 
         int GetResourceNumber();
+        ResourceType GetResourceType();
 
     private:
         sci::istream _GetResourceHeaderAndPackage(ResourceHeaderAgnostic &rh) const;
@@ -103,6 +111,11 @@ public:
     iterator begin();
     iterator end();
 
+    // Enumerates the resources of the given types, decompressing them on a pool of worker threads. Resources
+    // are still read from the volumes on the calling thread, and the callback is always called on the calling thread.
+    // Return false from the callback to stop enumerating.
+    void ForEachDecompressed(ResourceTypeFlags types, ResourceEnumOrder order, std::function<bool(std::unique_ptr<ResourceBlob>)> callback);
+
 private:
     bool _PassesFilter(ResourceType type, int resourceNumber, uint32_t base36Number);
 
@@ -15,6 +15,7 @@
 #include "ResourceEntity.h"
 #include "RasterOperations.h"
 #include "ResourceBlob.h"
+#include "AppState.h"
 
 bool NoValidationFunc(const ResourceEntity &resource)
 {
@@ -27,6 +28,7 @@ ResourceTraits emptyTraits =
     nullptr,
     nullptr,
     nullptr,
+    nullptr,
     nullptr
 };
 
@@ -61,6 +63,7 @@ void ResourceEntity::WriteTo(sci::ostream &byteStream, bool fullWrite, int resou
 
 void ResourceEntity::ReadFrom(sci::istream byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
 {
+    _deferred.reset();
     (*Traits.ReadFromFunc)(*this, byteStream, propertyBag);
 }
 
@@ -79,8 +82,86 @@ HRESULT ResourceEntity::InitFromResource(const ResourceBlob *prd)
     return S_OK;
 }
 
+void ResourceEntity::InitFromResourceDeferred(const ResourceBlob *prd, CreateResourceFuncPtr fallbackFunc)
+{
+    PackageNumber = prd->GetPackageHint();
+    ResourceNumber = prd->HasNumber() ? prd->GetNumber() : -1;
+    Base36Number = prd->GetHeader().Base36Number;
+    SourceFlags = prd->GetSourceFlags();
+
+    _deferred = std::make_unique<DeferredRead>();
+    _deferred->Data = prd->GetSharedData();
+    _deferred->Length = (uint32_t)prd->GetLength();
+    _deferred->PropertyBag = prd->GetPropertyBag();
+    _deferred->FallbackFunc = fallbackFunc;
+    _deferred->Version = prd->GetVersion();
+    _deferred->HeadersRead = false;
+}
+
+bool ResourceEntity::TryGetDeferredStream(sci::istream &byteStream) const
+{
+    if (_deferred)
+    {
+        const sci::cow_array<uint8_t> &data = _deferred->Data;
+        byteStream = sci::istream((_deferred->Length > 0) ? &data[0] : nullptr, _deferred->Length);
+        return true;
+    }
+    return false;
+}
+
+void ResourceEntity::_EnsureHeaders() const
+{
+    if (_deferred && !_deferred->HeadersRead)
+    {
+        _ReadDeferred(Traits.ReadHeadersFromFunc != nullptr);
+    }
+}
+
+void ResourceEntity::_ReadDeferred(bool headersOnly) const
+{
+    // Detach the pending state first, so that component access from within the read functions
+    // doesn't recurse back here.
+    std::unique_ptr<DeferredRead> deferred = std::move(_deferred);
+    ResourceEntity &resource = const_cast<ResourceEntity&>(*this);
+    try
+    {
+        const sci::cow_array<uint8_t> &data = deferred->Data;
+        sci::istream byteStream((deferred->Length > 0) ? &data[0] : nullptr, deferred->Length);
+        byteStream.setThrowExceptions(true);
+        if (headersOnly)
+        {
+            (*Traits.ReadHeadersFromFunc)(resource, byteStream, deferred->PropertyBag);
+        }
+        else
+        {
+            (*Traits.ReadFromFunc)(resource, byteStream, deferred->PropertyBag);
+        }
+    }
+    catch (std::exception)
+    {
+        if (!deferred->FallbackFunc)
+        {
+            // Leave things as they were, so the next access fails in the same way.
+            _deferred = std::move(deferred);
+            throw;
+        }
+        appState->LogInfo("Failed to read resource: (%d,%d).", ResourceNumber, PackageNumber);
+        std::unique_ptr<ResourceEntity> fallback((*deferred->FallbackFunc)(deferred->Version));
+        components = std::move(fallback->components);
+        return;
+    }
+
+    if (headersOnly)
+    {
+        // The full read still needs to happen when someone asks for the complete component.
+        deferred->HeadersRead = true;
+        _deferred = std::move(deferred);
+    }
+}
+
 std::unique_ptr<ResourceEntity> ResourceEntity::Clone() const
 {
+    _EnsureComponents();
     std::unique_ptr<ResourceEntity> pClone = std::make_unique<ResourceEntity>(Traits);
     pClone->ResourceNumber = ResourceNumber;
     pClone->PackageNumber = PackageNumber;
@@ -27,6 +27,7 @@ typedef void(*DeserializeFuncPtr)(ResourceEntity &resource, sci::istream &byteSt
 typedef void(*SerializeFuncPtr)(const ResourceEntity &resource, sci::ostream &byteStream, std::map<BlobKey, uint32_t> &propertyBag);
 typedef void(*SidecarSerializeFuncPtr)(const ResourceEntity &resource, int resourceNumber);
 typedef bool(*ValidationFuncPtr)(const ResourceEntity &resource);
+typedef ResourceEntity*(*CreateResourceFuncPtr)(SCIVersion version);
 
 struct ResourceTraits
 {
@@ -42,6 +43,7 @@ struct ResourceTraits
     SerializeFuncPtr WriteToFunc;               // This is null if saving isn't supported for this resource.
     ValidationFuncPtr ValidationFunc;
     SidecarSerializeFuncPtr SidecarWriteToFunc; // Null for most resources. For resources with associated sidecar files.
+    DeserializeFuncPtr ReadHeadersFromFunc;     // Null for most resources. Reads only metadata (e.g. cel sizes), no image data.
 };
 
 extern ResourceTraits emptyTraits;
@@ -61,6 +63,17 @@ public:
     // We could trap exceptions and then create the default resource instead?
     // Or is the caller responsible?
     HRESULT InitFromResource(const ResourceBlob *prd);
+
+    // Like InitFromResource, but only keeps a reference to the resource bytes. The components are
+    // deserialized the first time anyone asks for one. If that fails and fallbackFunc is provided,
+    // the components of the fallback resource are used instead of throwing.
+    // Note that deferred resources are not thread-safe, even for const access.
+    void InitFromResourceDeferred(const ResourceBlob *prd, CreateResourceFuncPtr fallbackFunc = nullptr);
+    bool IsDeferred() const { return _deferred != nullptr; }
+    // While a deferred resource hasn't been fully read, provides a stream over its bytes, so that
+    // the parts that are needed can be decoded on their own.
+    bool TryGetDeferredStream(sci::istream &byteStream) const;
+
     std::unique_ptr<ResourceEntity> Clone() const;
     
     int ResourceNumber;
@@ -72,6 +85,7 @@ public:
     template<typename _T>
     const _T &GetComponent() const
     {
+        _EnsureComponents();
         const std::type_info& r2 = typeid(_T);
         auto result = components.find(std::type_index(r2));
         if (result != components.end())
@@ -84,6 +98,7 @@ public:
     template<typename _T>
     _T &GetComponent()
     {
+        _EnsureComponents();
         const std::type_info& r2 = typeid(_T);
         auto result = components.find(std::type_index(r2));
         if (result != components.end())
@@ -96,6 +111,7 @@ public:
     template<typename _T>
     _T *TryGetComponent()
     {
+        _EnsureComponents();
         const std::type_info& r2 = typeid(_T);
         auto result = components.find(std::type_index(r2));
         if (result != components.end())
@@ -108,6 +124,24 @@ public:
     template<typename _T>
     const _T *TryGetComponent() const
     {
+        _EnsureComponents();
+        const std::type_info& r2 = typeid(_T);
+        auto result = components.find(std::type_index(r2));
+        if (result != components.end())
+        {
+            return static_cast<_T*>(result->second.get());
+        }
+        return nullptr;
+    }
+
+    // Returns a component that may only have its header-level information filled in (e.g. for a
+    // view, the loops and cel sizes, but no bits). Resources that don't support this, or
+    // that are already fully read, return the complete component. Components that are replaced
+    // when the resource is fully read (e.g. the palette) are only valid until then.
+    template<typename _T>
+    const _T *TryGetComponentHeaders() const
+    {
+        _EnsureHeaders();
         const std::type_info& r2 = typeid(_T);
         auto result = components.find(std::type_index(r2));
         if (result != components.end())
@@ -120,6 +154,7 @@ public:
     template<typename _T>
     void AddComponent(std::unique_ptr<_T> pComponent)
     {
+        _EnsureComponents();
         std::unique_ptr<ResourceComponent> pTemp(pComponent.release());
         const std::type_info& r2 = typeid(_T);
         components[std::type_index(r2)] = std::move(pTemp);
@@ -128,6 +163,7 @@ public:
     template<typename _T>
     void RemoveComponent()
     {
+        _EnsureComponents();
         const std::type_info& r2 = typeid(_T);
         auto it = components.find(std::type_index(r2));
         if (it != components.end())
@@ -153,5 +189,27 @@ public:
     ResourceType GetType() const { return Traits.Type; }
 
 private:
-    std::unordered_map<std::type_index, std::unique_ptr<ResourceComponent>> components;
+    struct DeferredRead
+    {
+        sci::cow_array<uint8_t> Data;   // Shared with the blob, so only ever read through a const reference.
+        uint32_t Length;
+        std::map<BlobKey, uint32_t> PropertyBag;
+        CreateResourceFuncPtr FallbackFunc;
+        SCIVersion Version;
+        bool HeadersRead;
+    };
+
+    void _EnsureComponents() const
+    {
+        if (_deferred)
+        {
+            _ReadDeferred(false);
+        }
+    }
+    void _EnsureHeaders() const;
+    void _ReadDeferred(bool headersOnly) const;
+
+    // These are mutable so that deferred resources can be materialized from const accessors.
+    mutable std::unordered_map<std::type_index, std::unique_ptr<ResourceComponent>> components;
+    mutable std::unique_ptr<DeferredRead> _deferred;
 };
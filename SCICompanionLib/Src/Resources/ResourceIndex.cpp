@@ -0,0 +1,306 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "ResourceIndex.h"
+#include "ResourceSources.h"
+#include "crc.h"
+#include "AppState.h"
+
+using namespace std;
+
+const uint32_t ResourceIndexSignature = (('S' << 24) + ('C' << 16) + ('I' << 8) + 'X');
+const uint32_t ResourceIndexVersion = 3;
+
+// Volume number used for the stamp of the map itself.
+const int MapStampId = -1;
+
+#include <pshpack1.h>
+
+struct RESOURCEINDEX_HEADER
+{
+    uint32_t signature;
+    uint32_t version;
+    uint32_t formatKey;
+    uint32_t types;
+    uint32_t stampCount;
+    uint32_t entryCount;
+};
+
+struct RESOURCEINDEX_STAMP
+{
+    int32_t volume;             // MapStampId for the map
+    uint32_t sizeLow;
+    uint32_t sizeHigh;
+    FILETIME lastWriteTime;
+};
+
+struct RESOURCEINDEX_ENTRY
+{
+    uint8_t type;
+    uint8_t packageNumber;
+    uint8_t hasHeader;
+    uint16_t number;
+    uint32_t base36Number;
+    uint32_t offset;
+    uint16_t compressionMethod;
+    uint32_t cbCompressed;
+    uint32_t cbDecompressed;
+    uint32_t checksum;
+};
+
+#include <poppack.h>
+
+uint32_t _GetFormatKey(const SCIVersion &version)
+{
+    return (uint32_t)version.MapFormat |
+        ((uint32_t)version.PackageFormat << 8) |
+        ((uint32_t)version.CompressionFormat << 16);
+}
+
+uint64_t _GetLookupKey(const ResourceMapEntryAgnostic &mapEntry)
+{
+    return (uint64_t)mapEntry.Offset |
+        ((uint64_t)mapEntry.PackageNumber << 32) |
+        ((uint64_t)mapEntry.Number << 40) |
+        ((uint64_t)mapEntry.Type << 56);
+}
+
+bool _GetStamp(const std::string &filename, int volume, RESOURCEINDEX_STAMP &stamp)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (GetFileAttributesEx(filename.c_str(), GetFileExInfoStandard, &data))
+    {
+        stamp.volume = volume;
+        stamp.sizeLow = data.nFileSizeLow;
+        stamp.sizeHigh = data.nFileSizeHigh;
+        stamp.lastWriteTime = data.ftLastWriteTime;
+        return true;
+    }
+    return false;
+}
+
+bool _GetStamp(const FileDescriptorBase &fileDescriptor, int volume, RESOURCEINDEX_STAMP &stamp)
+{
+    std::string filename = (volume == MapStampId) ? fileDescriptor._GetMapFilename() : fileDescriptor._GetVolumeFilename(volume);
+    return _GetStamp(filename, volume, stamp);
+}
+
+// Have the map and volumes changed since the stamps were taken?
+bool _AreStampsCurrent(const FileDescriptorBase &fileDescriptor, const std::vector<RESOURCEINDEX_STAMP> &stamps)
+{
+    for (const RESOURCEINDEX_STAMP &stampSaved : stamps)
+    {
+        RESOURCEINDEX_STAMP stampCurrent;
+        if (!_GetStamp(fileDescriptor, stampSaved.volume, stampCurrent) ||
+            (stampSaved.sizeLow != stampCurrent.sizeLow) ||
+            (stampSaved.sizeHigh != stampCurrent.sizeHigh) ||
+            (0 != CompareFileTime(&stampSaved.lastWriteTime, &stampCurrent.lastWriteTime)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Indices that couldn't be saved, by index filename.
+struct InMemoryIndex
+{
+    uint32_t FormatKey;
+    std::vector<RESOURCEINDEX_STAMP> Stamps;
+    std::shared_ptr<const ResourceIndex> Index;
+};
+std::mutex g_mutexInMemoryIndices;
+std::unordered_map<std::string, InMemoryIndex> g_inMemoryIndices;
+
+void ResourceIndex::Add(const ResourceIndexEntry &entry)
+{
+    _lookup[_GetLookupKey(entry.MapEntry)] = _entries.size();
+    _entries.push_back(entry);
+}
+
+const ResourceIndexEntry *ResourceIndex::Find(const ResourceMapEntryAgnostic &mapEntry) const
+{
+    auto it = _lookup.find(_GetLookupKey(mapEntry));
+    if (it != _lookup.end())
+    {
+        const ResourceIndexEntry &entry = _entries[it->second];
+        if (entry.MapEntry == mapEntry)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t ResourceIndex::CalculateChecksum(sci::istream &stream, uint32_t size)
+{
+    uint32_t checksum = 0;
+    if ((size > 0) && (size <= stream.getBytesRemaining()) && stream.GetInternalPointer())
+    {
+        checksum = crcFast(stream.GetInternalPointer() + stream.tellg(), (int)min(size, ChecksumLength));
+    }
+    return checksum;
+}
+
+std::shared_ptr<const ResourceIndex> ResourceIndex::Load(const FileDescriptorBase &fileDescriptor, const SCIVersion &version)
+{
+    std::shared_ptr<ResourceIndex> index;
+    std::string indexFilename = fileDescriptor._GetIndexFilename();
+    if (PathFileExists(indexFilename.c_str()))
+    {
+        try
+        {
+            ScopedFile scoped(indexFilename, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING);
+            sci::streamOwner owner(scoped.hFile);
+            sci::istream reader = owner.getReader();
+
+            RESOURCEINDEX_HEADER header;
+            reader >> header;
+            bool valid = reader.good() && (header.signature == ResourceIndexSignature) && (header.version == ResourceIndexVersion) && (header.formatKey == _GetFormatKey(version));
+
+            // Check that the map and volumes haven't changed since we wrote the index.
+            std::vector<RESOURCEINDEX_STAMP> stamps;
+            for (uint32_t i = 0; valid && (i < header.stampCount); i++)
+            {
+                RESOURCEINDEX_STAMP stampSaved;
+                reader >> stampSaved;
+                valid = reader.good();
+                stamps.push_back(stampSaved);
+            }
+            valid = valid && _AreStampsCurrent(fileDescriptor, stamps);
+
+            if (valid)
+            {
+                index = std::make_shared<ResourceIndex>((ResourceTypeFlags)header.types);
+                index->_entries.reserve(header.entryCount);
+                for (uint32_t i = 0; valid && (i < header.entryCount); i++)
+                {
+                    RESOURCEINDEX_ENTRY entrySaved;
+                    reader >> entrySaved;
+                    valid = reader.good();
+
+                    ResourceIndexEntry entry;
+                    entry.MapEntry.Type = (ResourceType)entrySaved.type;
+                    entry.MapEntry.Number = entrySaved.number;
+                    entry.MapEntry.Base36Number = entrySaved.base36Number;
+                    entry.MapEntry.PackageNumber = entrySaved.packageNumber;
+                    entry.MapEntry.Offset = entrySaved.offset;
+                    entry.HasHeader = (entrySaved.hasHeader != 0);
+                    entry.CompressionMethod = entrySaved.compressionMethod;
+                    entry.cbCompressed = entrySaved.cbCompressed;
+                    entry.cbDecompressed = entrySaved.cbDecompressed;
+                    entry.Checksum = entrySaved.checksum;
+                    index->Add(entry);
+                }
+
+                if (!valid)
+                {
+                    // Truncated index file.
+                    index.reset();
+                }
+            }
+        }
+        catch (std::exception)
+        {
+            // Just treat it as though there's no index.
+            index.reset();
+        }
+    }
+
+    if (!index)
+    {
+        std::lock_guard<std::mutex> lock(g_mutexInMemoryIndices);
+        auto it = g_inMemoryIndices.find(indexFilename);
+        if ((it != g_inMemoryIndices.end()) && (it->second.FormatKey == _GetFormatKey(version)) && _AreStampsCurrent(fileDescriptor, it->second.Stamps))
+        {
+            return it->second.Index;
+        }
+    }
+    return index;
+}
+
+bool ResourceIndex::Save(const FileDescriptorBase &fileDescriptor, const SCIVersion &version) const
+{
+    std::vector<RESOURCEINDEX_STAMP> stamps;
+    RESOURCEINDEX_STAMP stamp;
+    if (!_GetStamp(fileDescriptor, MapStampId, stamp))
+    {
+        return false;
+    }
+    stamps.push_back(stamp);
+
+    std::set<int> volumes;
+    for (const ResourceIndexEntry &entry : _entries)
+    {
+        volumes.insert(entry.MapEntry.PackageNumber);
+    }
+    for (int volume : volumes)
+    {
+        // The map might reference volumes that don't exist (e.g. demos), and that's fine.
+        if (_GetStamp(fileDescriptor, volume, stamp))
+        {
+            stamps.push_back(stamp);
+        }
+    }
+
+    sci::ostream indexStream;
+    RESOURCEINDEX_HEADER header = { ResourceIndexSignature, ResourceIndexVersion, _GetFormatKey(version), (uint32_t)_types, (uint32_t)stamps.size(), (uint32_t)_entries.size() };
+    indexStream << header;
+    for (const RESOURCEINDEX_STAMP &stamp : stamps)
+    {
+        indexStream << stamp;
+    }
+    for (const ResourceIndexEntry &entry : _entries)
+    {
+        RESOURCEINDEX_ENTRY entrySaved;
+        entrySaved.type = (uint8_t)entry.MapEntry.Type;
+        entrySaved.number = entry.MapEntry.Number;
+        entrySaved.base36Number = entry.MapEntry.Base36Number;
+        entrySaved.packageNumber = entry.MapEntry.PackageNumber;
+        entrySaved.offset = entry.MapEntry.Offset;
+        entrySaved.hasHeader = entry.HasHeader ? 1 : 0;
+        entrySaved.compressionMethod = entry.CompressionMethod;
+        entrySaved.cbCompressed = entry.cbCompressed;
+        entrySaved.cbDecompressed = entry.cbDecompressed;
+        entrySaved.checksum = entry.Checksum;
+        indexStream << entrySaved;
+    }
+
+    std::string indexFilename = fileDescriptor._GetIndexFilename();
+    try
+    {
+        ScopedFile scoped(indexFilename, GENERIC_WRITE, 0, CREATE_ALWAYS);
+        scoped.Write(indexStream.GetInternalPointer(), indexStream.GetDataSize());
+    }
+    catch (std::exception &e)
+    {
+        // The index is just an optimization. If the game folder is read-only, or someone else is
+        // writing the index at the same time, carry on with it in memory.
+        std::lock_guard<std::mutex> lock(g_mutexInMemoryIndices);
+        auto it = g_inMemoryIndices.find(indexFilename);
+        if (it == g_inMemoryIndices.end())
+        {
+            appState->LogInfo("Unable to save the resource index: %s", e.what());
+        }
+        InMemoryIndex &inMemory = g_inMemoryIndices[indexFilename];
+        inMemory.FormatKey = header.formatKey;
+        inMemory.Stamps = stamps;
+        inMemory.Index = std::make_shared<ResourceIndex>(*this);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_mutexInMemoryIndices);
+    g_inMemoryIndices.erase(indexFilename);
+    return true;
+}
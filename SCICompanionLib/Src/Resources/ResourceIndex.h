@@ -0,0 +1,72 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+#include "ResourceBlob.h"
+
+//
+// A persisted index of a resource.map and the headers of the resources it points to. This
+// lets us enumerate resources (and get their headers) without walking the map and reading
+// the header of each resource out of the volumes.
+// It's stored next to the map (e.g. resource.map.idx), and is only valid as long as the size
+// and last write time of the map and all the volumes it references are unchanged.
+// Only the resource types that have been asked for are indexed, since getting the headers means
+// reading from all over the volumes.
+//
+
+struct FileDescriptorBase;
+
+struct ResourceIndexEntry
+{
+    ResourceMapEntryAgnostic MapEntry;
+    bool HasHeader;             // False if the resource header couldn't be read (corrupt resource)
+    uint16_t CompressionMethod;
+    uint32_t cbCompressed;
+    uint32_t cbDecompressed;
+    uint32_t Checksum;          // crc of the start of the resource bits as they are in the volume
+};
+
+class ResourceIndex
+{
+public:
+    ResourceIndex(ResourceTypeFlags types = ResourceTypeFlags::All) : _types(types) {}
+
+    // Returns nullptr if there is no index, or if it's out of date.
+    // The header sizes depend on the version we're interpreting the game as, so the version is part of the key.
+    static std::shared_ptr<const ResourceIndex> Load(const FileDescriptorBase &fileDescriptor, const SCIVersion &version);
+    // Returns false if the index couldn't be written (e.g. the game folder is read-only). It's then kept in
+    // memory for Load to return, so it doesn't need to be built again for each resource source.
+    bool Save(const FileDescriptorBase &fileDescriptor, const SCIVersion &version) const;
+
+    // The resource types in the index. Resources of other types are left out.
+    ResourceTypeFlags GetTypes() const { return _types; }
+
+    void Add(const ResourceIndexEntry &entry);
+    const std::vector<ResourceIndexEntry> &GetEntries() const { return _entries; }
+    const ResourceIndexEntry *Find(const ResourceMapEntryAgnostic &mapEntry) const;
+
+    // Checksum of the start (at most ChecksumLength bytes) of the next size bytes in the stream (doesn't
+    // advance the stream). Only the start is used, so that building the index doesn't have to read
+    // all of every volume.
+    static uint32_t CalculateChecksum(sci::istream &stream, uint32_t size);
+    static const uint32_t ChecksumLength = 256;
+
+    // How many entries are checked against the volumes when a saved index is loaded.
+    static const size_t EntriesToVerify = 16;
+
+private:
+    ResourceTypeFlags _types;
+    std::vector<ResourceIndexEntry> _entries;
+    std::unordered_map<uint64_t, size_t> _lookup;
+};
@@ -46,6 +46,9 @@
 #include "ResourceBlob.h"
 #include "DependencyTracker.h"
 #include "VersionDetectionHelper.h"
+#include "HeaderCache.h"
+#include "BuildGraph.h"
+#include "DecompileCache.h"
 
 using namespace std;
 
@@ -171,9 +174,11 @@ HRESULT RebuildResources(const GameFolderHelper &helper, SCIVersion version, BOO
         if (version.AudioVolumeName != AudioVolumeName::None)
         {
             std::unique_ptr<ResourceSource> resourceSource = CreateResourceSource(ResourceTypeFlags::All, helper, ResourceSourceFlags::AudioCache);
-            resourceSource->RebuildResources(true, *resourceSource, stats);
+            resourceSource->RebuildResources(true, *resourceSource, stats, ResourceCompressionPolicies());
         }
 
+        ResourceCompressionPolicies compression = ResourceCompressionPolicies::FromGameIni(helper);
+
         // Enumerate resources and write the ones we have not already encountered.
         std::unique_ptr<ResourceSource> resourceSource = CreateResourceSource(ResourceTypeFlags::All, helper, ResourceSourceFlags::ResourceMap);
         ResourceSource *theActualSource = resourceSource.get();
@@ -184,13 +189,13 @@ HRESULT RebuildResources(const GameFolderHelper &helper, SCIVersion version, BOO
             patchFileSource = CreateResourceSource(ResourceTypeFlags::All, helper, ResourceSourceFlags::PatchFile);
             theActualSource = patchFileSource.get();
         }
-        resourceSource->RebuildResources(true, *theActualSource, stats);
+        resourceSource->RebuildResources(true, *theActualSource, stats, compression);
 
         if (version.MessageMapSource != MessageMapSource::Included)
         {
             ResourceSourceFlags sourceFlags = (version.MessageMapSource == MessageMapSource::MessageMap) ? ResourceSourceFlags::MessageMap : ResourceSourceFlags::AltMap;
             std::unique_ptr<ResourceSource> messageSource = CreateResourceSource(ResourceTypeFlags::All, helper, ResourceSourceFlags::MessageMap);
-            messageSource->RebuildResources(true, *messageSource, stats);
+            messageSource->RebuildResources(true, *messageSource, stats, compression);
         }
     }
     catch (std::exception &e)
@@ -207,6 +212,9 @@ HRESULT RebuildResources(const GameFolderHelper &helper, SCIVersion version, BOO
 CResourceMap::CResourceMap(ISCIAppServices *appServices, ResourceRecency *resourceRecency) : _appServices(appServices), _resourceRecency(resourceRecency)
 {
     _runLogic = std::make_unique<RunLogic>();
+    _headerCache = std::make_unique<HeaderCache>();
+    _buildGraph = std::make_unique<BuildGraph>();
+    _decompileCache = std::make_unique<DecompileCache>();
     _paletteListNeedsUpdate = true;
     _skipVersionSniffOnce = false;
     _pVocab000 = nullptr;
@@ -405,7 +413,7 @@ void CResourceMap::RepackageAudio(bool force)
     {
         std::map<ResourceType, RebuildStats> stats;
         std::unique_ptr<ResourceSource> resourceSource = CreateResourceSource(ResourceTypeFlags::All, Helper(), ResourceSourceFlags::AudioCache);
-        resourceSource->RebuildResources(force, *resourceSource, stats);
+        resourceSource->RebuildResources(force, *resourceSource, stats, ResourceCompressionPolicies());
     }
 }
 
@@ -1026,7 +1034,8 @@ std::unique_ptr<PaletteComponent> CResourceMap::GetMergedPalette(const ResourceE
 {
     assert((_gameFolderHelper.Version.ViewFormat != ViewFormat::EGA) || (_gameFolderHelper.Version.PicFormat != PicFormat::EGA));
     std::unique_ptr<PaletteComponent> paletteReturn;
-    const PaletteComponent *paletteEmbedded = resource.TryGetComponent<PaletteComponent>();
+    // The palette is header-level information, so this doesn't force deferred resources to be fully read.
+    const PaletteComponent *paletteEmbedded = resource.TryGetComponentHeaders<PaletteComponent>();
     if (!paletteEmbedded)
     {
         paletteEmbedded = _emptyPalette.get();
@@ -1254,6 +1263,42 @@ RunLogic &CResourceMap::GetRunLogic()
     return *_runLogic;
 }
 
+HeaderCache &CResourceMap::GetHeaderCache()
+{
+    return *_headerCache;
+}
+
+BuildGraph &CResourceMap::GetBuildGraph()
+{
+    return *_buildGraph;
+}
+
+DecompileCache &CResourceMap::GetDecompileCache()
+{
+    return *_decompileCache;
+}
+
+//
+// Replaced resource volumes are moved aside to scv*.tmp files, which can't be deleted while they're
+// still mapped by a resource source. Clean up any left behind by earlier sessions. Those still in use
+// by this one just fail to delete, and are picked up next time.
+//
+void _DeleteStaleVolumeCopies(const std::string &gameFolder)
+{
+    std::string pattern = gameFolder + "\\scv*.tmp";
+    WIN32_FIND_DATA findData;
+    HANDLE hFind = FindFirstFile(pattern.c_str(), &findData);
+    if (hFind != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            std::string stale = gameFolder + "\\" + findData.cFileName;
+            DeleteFile(stale.c_str());
+        } while (FindNextFile(hFind, &findData));
+        FindClose(hFind);
+    }
+}
+
 //
 // Called when we open a new game.
 //
@@ -1261,6 +1306,9 @@ void CResourceMap::SetGameFolder(const string &gameFolder)
 {
     _runLogic->SetGameFolder(gameFolder);
     _gameFolderHelper.GameFolder = gameFolder;
+    _headerCache->SetFilename(Helper().GetHeaderCacheFileName());
+    _buildGraph->SetFilename(Helper().GetBuildGraphFileName());
+    _decompileCache->SetFilename(Helper().GetDecompileCacheFileName());
     _talkerToView = TalkerToViewMap(Helper().GetLipSyncFolder());
     ClearVocab000();
     _pPalette999.reset(nullptr);                    // REVIEW: also do this if global palette is edited.
@@ -1270,6 +1318,7 @@ void CResourceMap::SetGameFolder(const string &gameFolder)
     _verbsHeaderFile.reset(nullptr);
     if (!gameFolder.empty())
     {
+        _DeleteStaleVolumeCopies(gameFolder);
         try
         {
             _SniffGameLanguage();
@@ -1341,51 +1390,105 @@ std::unique_ptr<ResourceEntity> CreateResourceHelper(const ResourceBlob &data, T
 
 void DoNothing(ResourceEntity &resource) {}
 
-//
-// Given a ResourceBlob, this creates the SCI resource represented by the data, and hands back
-// a ResourceEntity.
-// If there is an exception creating the resource, a default one is handed back.
-//
-std::unique_ptr<ResourceEntity> CreateResourceFromResourceData(const ResourceBlob &data, bool fallbackOnException)
+// Picks the functions that create an empty resource of the right kind, and a default one to use
+// when the data can't be read.
+bool _GetResourceCreateFunctions(const ResourceBlob &data, CreateResourceFuncPtr &createFunction, CreateResourceFuncPtr &fallbackFunc)
 {
     switch (data.GetType())
     {
         case ResourceType::View:
-            return CreateResourceHelper(data, CreateViewResource, CreateDefaultViewResource, fallbackOnException);
+            createFunction = CreateViewResource;
+            fallbackFunc = CreateDefaultViewResource;
+            return true;
         case ResourceType::Font:
-            return CreateResourceHelper(data, CreateFontResource, CreateDefaultFontResource, fallbackOnException);
+            createFunction = CreateFontResource;
+            fallbackFunc = CreateDefaultFontResource;
+            return true;
         case ResourceType::Cursor:
-            return CreateResourceHelper(data, CreateCursorResource, CreateDefaultCursorResource, fallbackOnException);
+            createFunction = CreateCursorResource;
+            fallbackFunc = CreateDefaultCursorResource;
+            return true;
         case ResourceType::Text:
-            return CreateResourceHelper(data, CreateTextResource, CreateDefaultTextResource, fallbackOnException);
+            createFunction = CreateTextResource;
+            fallbackFunc = CreateDefaultTextResource;
+            return true;
         case ResourceType::Sound:
-            return CreateResourceHelper(data, CreateSoundResource, CreateDefaultSoundResource, fallbackOnException);
+            createFunction = CreateSoundResource;
+            fallbackFunc = CreateDefaultSoundResource;
+            return true;
         case ResourceType::Vocab:
-            return CreateResourceHelper(data, CreateVocabResource, CreateVocabResource, fallbackOnException);
+            createFunction = CreateVocabResource;
+            fallbackFunc = CreateVocabResource;
+            return true;
         case ResourceType::Pic:
-            return CreateResourceHelper(data, CreatePicResource, CreateDefaultPicResource, fallbackOnException);
+            createFunction = CreatePicResource;
+            fallbackFunc = CreateDefaultPicResource;
+            return true;
         case ResourceType::Palette:
-            return CreateResourceHelper(data, CreatePaletteResource, CreatePaletteResource, fallbackOnException);
+            createFunction = CreatePaletteResource;
+            fallbackFunc = CreatePaletteResource;
+            return true;
         case ResourceType::Message:
-            return CreateResourceHelper(data, CreateMessageResource, CreateDefaultMessageResource, fallbackOnException);
+            createFunction = CreateMessageResource;
+            fallbackFunc = CreateDefaultMessageResource;
+            return true;
         case ResourceType::Audio:
             if (data.GetVersion().AudioIsWav && (data.GetBase36() == NoBase36))
             {
-                return CreateResourceHelper(data, CreateWaveAudioResource, CreateDefaultAudioResource, fallbackOnException);
+                createFunction = CreateWaveAudioResource;
             }
             else
             {
-                return CreateResourceHelper(data, CreateAudioResource, CreateDefaultAudioResource, fallbackOnException);
+                createFunction = CreateAudioResource;
             }
+            fallbackFunc = CreateDefaultAudioResource;
+            return true;
         case ResourceType::AudioMap:
-            return CreateResourceHelper(data, CreateMapResource, CreateMapResource, fallbackOnException);
+            createFunction = CreateMapResource;
+            fallbackFunc = CreateMapResource;
+            return true;
         default:
         assert(false);
         break;
     }
+    return false;
+}
+
+//
+// Given a ResourceBlob, this creates the SCI resource represented by the data, and hands back
+// a ResourceEntity.
+// If there is an exception creating the resource, a default one is handed back.
+//
+std::unique_ptr<ResourceEntity> CreateResourceFromResourceData(const ResourceBlob &data, bool fallbackOnException)
+{
+    CreateResourceFuncPtr createFunction;
+    CreateResourceFuncPtr fallbackFunc;
+    if (_GetResourceCreateFunctions(data, createFunction, fallbackFunc))
+    {
+        return CreateResourceHelper(data, createFunction, fallbackFunc, fallbackOnException);
+    }
     return nullptr;
 }
 
+//
+// Like CreateResourceFromResourceData, but the components aren't deserialized until they are first
+// accessed. Use this when you may only need a few bits of information from the resource.
+// Since reading happens later, the ResourceLoadStatusFlags::ResourceCreationFailed flag is never set
+// on the blob.
+//
+std::unique_ptr<ResourceEntity> CreateDeferredResourceFromResourceData(const ResourceBlob &data, bool fallbackOnException)
+{
+    CreateResourceFuncPtr createFunction;
+    CreateResourceFuncPtr fallbackFunc;
+    std::unique_ptr<ResourceEntity> pResourceReturn;
+    if (_GetResourceCreateFunctions(data, createFunction, fallbackFunc))
+    {
+        pResourceReturn.reset(createFunction(data.GetVersion()));
+        pResourceReturn->InitFromResourceDeferred(&data, fallbackOnException ? fallbackFunc : nullptr);
+    }
+    return pResourceReturn;
+}
+
 void CResourceMap::SetGameLanguage(LangSyntax lang)
 {
     Helper().SetIniString(GameSection, LanguageKey, (lang == LangSyntaxSCI) ? LanguageValueSCI : LanguageValueStudio);
@@ -34,6 +34,9 @@ class ResourceRecency;
 class ResourceEntity;
 class GlobalCompiledScriptLookups;
 class IResourceMapEvents;
+class HeaderCache;
+class BuildGraph;
+class DecompileCache;
 enum class ResourceSaveLocation : uint16_t;
 
 //
@@ -109,6 +112,9 @@ public:
     const PaletteComponent *GetPalette999();
     void SaveAudioMap65535(const AudioMapComponent &newAudioMap, int mapContext);
     GlobalCompiledScriptLookups *GetCompiledScriptLookups();
+    HeaderCache &GetHeaderCache();
+    BuildGraph &GetBuildGraph();
+    DecompileCache &GetDecompileCache();
     std::vector<int> GetPaletteList();
     std::unique_ptr<PaletteComponent> GetPalette(int fallbackPalette);
     std::unique_ptr<PaletteComponent> GetMergedPalette(const ResourceEntity &resource, int fallbackPalette);
@@ -155,6 +161,9 @@ private:
     ISCIAppServices *_appServices;
 
     // Useful resources to cache
+    std::unique_ptr<HeaderCache> _headerCache;
+    std::unique_ptr<BuildGraph> _buildGraph;
+    std::unique_ptr<DecompileCache> _decompileCache;
     std::unique_ptr<ResourceEntity> _pVocab000;
     std::unique_ptr<ResourceEntity> _pPalette999;
     std::unique_ptr<PaletteComponent> _emptyPalette;
@@ -25,34 +25,34 @@
 #include "AppState.h"
 
 template<typename _TFileDescriptor>
-std::unique_ptr<ResourceSource> _CreateResourceSource(const std::string &gameFolder, SCIVersion version, ResourceSourceFlags source)
+std::unique_ptr<ResourceSource> _CreateResourceSource(const std::string &gameFolder, SCIVersion version, ResourceSourceFlags source, ResourceSourceAccessFlags access)
 {
     if (version.MapFormat == ResourceMapFormat::SCI0)
     {
-        return std::make_unique<MapAndPackageSource<SCI0MapNavigator<RESOURCEMAPENTRY_SCI0>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI0>(), gameFolder);
+        return std::make_unique<MapAndPackageSource<SCI0MapNavigator<RESOURCEMAPENTRY_SCI0>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI0>(), gameFolder, access);
     }
     else if (version.MapFormat == ResourceMapFormat::SCI0_LayoutSCI1)
     {
-        return std::make_unique<MapAndPackageSource<SCI0MapNavigator<RESOURCEMAPENTRY_SCI0_SCI1LAYOUT>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI0>(), gameFolder);
+        return std::make_unique<MapAndPackageSource<SCI0MapNavigator<RESOURCEMAPENTRY_SCI0_SCI1LAYOUT>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI0>(), gameFolder, access);
     }
     else if (version.MapFormat == ResourceMapFormat::SCI1)
     {
         if (version.PackageFormat == ResourcePackageFormat::SCI2)
         {
-            return std::make_unique<MapAndPackageSource<SCI1MapNavigator<RESOURCEMAPENTRY_SCI1>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI2>(), gameFolder);
+            return std::make_unique<MapAndPackageSource<SCI1MapNavigator<RESOURCEMAPENTRY_SCI1>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI2>(), gameFolder, access);
         }
         else
         {
-            return std::make_unique<MapAndPackageSource<SCI1MapNavigator<RESOURCEMAPENTRY_SCI1>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI1>(), gameFolder);
+            return std::make_unique<MapAndPackageSource<SCI1MapNavigator<RESOURCEMAPENTRY_SCI1>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI1>(), gameFolder, access);
         }
     }
     else if (version.MapFormat == ResourceMapFormat::SCI11)
     {
-        return std::make_unique<MapAndPackageSource<SCI1MapNavigator<RESOURCEMAPENTRY_SCI1_1>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI1>(), gameFolder);
+        return std::make_unique<MapAndPackageSource<SCI1MapNavigator<RESOURCEMAPENTRY_SCI1_1>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI1>(), gameFolder, access);
     }
     else if (version.MapFormat == ResourceMapFormat::SCI2)
     {
-        return std::make_unique<MapAndPackageSource<SCI1MapNavigator<RESOURCEMAPENTRY_SCI1>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI2_1>(), gameFolder);
+        return std::make_unique<MapAndPackageSource<SCI1MapNavigator<RESOURCEMAPENTRY_SCI1>, _TFileDescriptor>>(version, MakeResourceHeaderReadWriter<RESOURCEHEADER_SCI2_1>(), gameFolder, access);
     }
     return std::unique_ptr<ResourceSource>(nullptr);
 }
@@ -61,15 +61,15 @@ std::unique_ptr<ResourceSource> CreateResourceSource(ResourceTypeFlags flagsHint
 {
     if (source == ResourceSourceFlags::ResourceMap)
     {
-        return _CreateResourceSource<FileDescriptorResourceMap>(helper.GameFolder, helper.Version, source);
+        return _CreateResourceSource<FileDescriptorResourceMap>(helper.GameFolder, helper.Version, source, access);
     }
     else if (source == ResourceSourceFlags::MessageMap)
     {
-        return _CreateResourceSource<FileDescriptorMessageMap>(helper.GameFolder, helper.Version, source);
+        return _CreateResourceSource<FileDescriptorMessageMap>(helper.GameFolder, helper.Version, source, access);
     }
     else if (source == ResourceSourceFlags::AltMap)
     {
-        return _CreateResourceSource<FileDescriptorAltMap>(helper.GameFolder, helper.Version, source);
+        return _CreateResourceSource<FileDescriptorAltMap>(helper.GameFolder, helper.Version, source, access);
     }
     else if (source == ResourceSourceFlags::PatchFile)
     {
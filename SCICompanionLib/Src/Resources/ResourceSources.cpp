@@ -39,6 +39,7 @@ SourceTraits altMapSourceTraits =
 
 const char *folderFileFormat = "{0}\\{1}";
 const char *folderFileFormatBak = "{0}\\{1}.bak";
+const char *folderFileFormatIndex = "{0}\\{1}.idx";
 std::string FileDescriptorBase::_GetMapFilename() const
 {
     return fmt::format(folderFileFormat, _gameFolder, _traits.MapFormat);
@@ -56,6 +57,10 @@ std::string FileDescriptorBase::_GetVolumeFilenameBak(int volume) const
 {
     return fmt::format(folderFileFormatBak, _gameFolder, fmt::format(_traits.VolumeFormat, volume));
 }
+std::string FileDescriptorBase::_GetIndexFilename() const
+{
+    return fmt::format(folderFileFormatIndex, _gameFolder, _traits.MapFormat);
+}
 
 bool IsResourceCompatible(const SCIVersion &usVersion, const SCIVersion &resourceVersion, ResourceType type)
 {
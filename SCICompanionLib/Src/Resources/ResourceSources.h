@@ -14,6 +14,8 @@
 #pragma once
 
 #include "ResourceBlob.h"
+#include "ResourceIndex.h"
+#include "ResourceCompression.h"
 
 // This file describes various resource sources and the base classes needed for:
 // (1) resource.map/resource.xxx
@@ -39,6 +41,8 @@ struct RebuildStats
 {
     size_t ItemCount;
     size_t TotalSize;
+    size_t CompressedCount;     // Resources that we compressed during the rebuild
+    size_t CompressionSavings;  // Bytes saved by compressing them
 };
 
 typedef ResourceHeaderAgnostic(*ReadResourceHeaderFunc)(sci::istream &byteStream, SCIVersion version, ResourceSourceFlags sourceFlags, uint16_t packageHint);
@@ -115,9 +119,13 @@ public:
     virtual bool ReadNextEntry(ResourceTypeFlags typeFlags, IteratorState &state, ResourceMapEntryAgnostic &entry, std::vector<uint8_t> *optionalRawData = nullptr) = 0;
     virtual sci::istream GetHeaderAndPositionedStream(const ResourceMapEntryAgnostic &mapEntry, ResourceHeaderAgnostic &headerEntry) = 0;
     virtual sci::istream GetPositionedStreamAndResourceSizeIncludingHeader(const ResourceMapEntryAgnostic &mapEntry, uint32_t &size, bool &includesHeader) = 0;
+    // Sources that have the header information cached can return it without going to the volume.
+    virtual bool GetCachedHeader(const ResourceMapEntryAgnostic &mapEntry, ResourceHeaderAgnostic &headerEntry) { return false; }
 
     virtual void RemoveEntry(const ResourceMapEntryAgnostic &mapEntry) = 0;
-    virtual void RebuildResources(bool force, ResourceSource &source, std::map<ResourceType, RebuildStats> &stats) = 0;
+    // Rewrites the resources without any stale or duplicate entries. Since AppendResources leaves old versions
+    // of resources in the volumes, this is also what compacts them.
+    virtual void RebuildResources(bool force, ResourceSource &source, std::map<ResourceType, RebuildStats> &stats, const ResourceCompressionPolicies &compression) = 0;
     virtual AppendBehavior AppendResources(const std::vector<const ResourceBlob*> &blobs) = 0;
 };
 
@@ -133,6 +141,15 @@ extern SourceTraits resourceMapSourceTraits;
 extern SourceTraits messageMapSourceTraits;
 extern SourceTraits altMapSourceTraits;
 
+// Data to be added to the end of a volume file.
+struct VolumeAppend
+{
+    VolumeAppend() : Offset(0) {}
+
+    uint32_t Offset;        // The size of the volume before appending, which is where Data goes.
+    sci::ostream Data;
+};
+
 struct FileDescriptorBase
 {
     FileDescriptorBase(const std::string &gameFolder, SourceTraits &traits, ResourceSourceFlags sourceFlags) : _gameFolder(gameFolder), _traits(traits), SourceFlags(sourceFlags) {}
@@ -145,6 +162,7 @@ struct FileDescriptorBase
     std::string _GetVolumeFilename(int volume) const;
     std::string _GetMapFilenameBak() const;
     std::string _GetVolumeFilenameBak(int volume) const;
+    std::string _GetIndexFilename() const;
 
     std::unique_ptr<sci::streamOwner> OpenMap() const
     {
@@ -163,11 +181,97 @@ struct FileDescriptorBase
         return std::make_unique<sci::streamOwner>(scoped.hFile);
     }
 
+    // Maps the volume read-only instead of reading it into memory. Streams obtained from it are views
+    // directly onto the file, so the volume file can't be deleted or truncated while the streamOwner
+    // is alive (see _ReplaceVolume).
+    std::unique_ptr<sci::streamOwner> OpenVolumeMapped(int volumeNumber) const
+    {
+        std::string filename = _GetVolumeFilename(volumeNumber);
+        if (!PathFileExists(filename.c_str()))
+        {
+            std::string details = "Opening ";
+            details += filename;
+            throw std::exception(GetMessageFromLastError(details).c_str());
+        }
+        return std::make_unique<sci::streamOwner>(filename);
+    }
+
     bool DoesVolumeExist(int volumeNumber) const
     {
         return !!PathFileExists(_GetVolumeFilename(volumeNumber).c_str());
     }
 
+    uint32_t GetVolumeSize(int volumeNumber) const
+    {
+        std::string filename = _GetVolumeFilename(volumeNumber);
+        if (!PathFileExists(filename.c_str()))
+        {
+            return 0;
+        }
+        ScopedFile volume(filename, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING);
+        return volume.GetLength();
+    }
+
+    // Appends to the end of the volumes, and then replaces the map. Existing volume data is never touched,
+    // and the new map is swapped in with a single move. So if we're interrupted at any point, the map on disk is
+    // either the old one or the new one, and both point to valid data.
+    void AppendToVolumesAndReplaceMap(const sci::ostream &mapStream, const std::unordered_map<int, VolumeAppend> &volumeAppends) const
+    {
+        for (const auto &volumeAppend : volumeAppends)
+        {
+            // Other sources may have the volume mapped, so let them keep reading it. We only write past the end.
+            ScopedFile volume(_GetVolumeFilename(volumeAppend.first), GENERIC_WRITE, FILE_SHARE_READ, OPEN_ALWAYS);
+            if (volume.SeekToEnd() != volumeAppend.second.Offset)
+            {
+                throw std::exception("The resource volume was modified while saving.");
+            }
+            volume.Write(volumeAppend.second.Data.GetInternalPointer(), volumeAppend.second.Data.GetDataSize());
+            FlushFileBuffers(volume.hFile);
+        }
+
+        {
+            ScopedFile holderMap(_GetMapFilenameBak(), GENERIC_WRITE, 0, CREATE_ALWAYS);
+            holderMap.Write(mapStream.GetInternalPointer(), mapStream.GetDataSize());
+            FlushFileBuffers(holderMap.hFile);
+        }
+
+        std::string resmap_name = _GetMapFilename();
+        if (!MoveFileEx(_GetMapFilenameBak().c_str(), resmap_name.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        {
+            std::string details = "Replacing ";
+            details += resmap_name;
+            throw std::exception(GetMessageFromLastError(details).c_str());
+        }
+    }
+
+    // Another resource source may still have the volume mapped. A mapped file can't be replaced
+    // or deleted, but it can be renamed. So move the old volume aside to a scv*.tmp file first, and
+    // delete that if nothing has it mapped. Otherwise it's deleted on reboot if we're allowed to ask
+    // for that, and in any case the next time the game folder is opened (see CResourceMap::SetGameFolder).
+    void _ReplaceVolume(const std::string &newFilename, const std::string &filename) const
+    {
+        if (PathFileExists(filename.c_str()))
+        {
+            char szOld[MAX_PATH];
+            if (!GetTempFileName(_gameFolder.c_str(), "scv", 0, szOld))
+            {
+                throw std::exception(GetMessageFromLastError("Creating temporary file").c_str());
+            }
+            if (!MoveFileEx(filename.c_str(), szOld, MOVEFILE_REPLACE_EXISTING))
+            {
+                DeleteFile(szOld);
+                std::string details = "Replacing ";
+                details += filename;
+                throw std::exception(GetMessageFromLastError(details).c_str());
+            }
+            if (!DeleteFile(szOld))
+            {
+                MoveFileEx(szOld, nullptr, MOVEFILE_DELAY_UNTIL_REBOOT);
+            }
+        }
+        movefile(newFilename, filename);
+    }
+
     void WriteAndReplaceMapAndVolumes(const sci::ostream &mapStream, const std::unordered_map<int, sci::ostream> &volumeWriteStreams) const
     {
         // TODO: Verify we can write to the orignal files. Or do we need to bother? We'll produce nice error messages anyway.
@@ -189,9 +293,7 @@ struct FileDescriptorBase
         // Move the volumes over
         for (const auto &volumeStream : volumeWriteStreams)
         {
-            std::string package_name = _GetVolumeFilename( volumeStream.first);
-            deletefile(package_name);
-            movefile(_GetVolumeFilenameBak( volumeStream.first), package_name);
+            _ReplaceVolume(_GetVolumeFilenameBak(volumeStream.first), _GetVolumeFilename(volumeStream.first));
         }
 
         // Nothing to do at this point if it fails.
@@ -221,17 +323,54 @@ template<typename _TNavigator, typename _FileDescriptor>
 class MapAndPackageSource : public ResourceSource, public _TNavigator, public _FileDescriptor
 {
 public:
-    MapAndPackageSource(SCIVersion version, ResourceHeaderReadWrite headerReadWrite, const std::string &gameFolder) :
+    MapAndPackageSource(SCIVersion version, ResourceHeaderReadWrite headerReadWrite, const std::string &gameFolder, ResourceSourceAccessFlags access = ResourceSourceAccessFlags::Read) :
         _headerReadWrite(headerReadWrite),
         _version(version),
+        _access(access),
+        _indexChecked(false),
+        _useIndex(false),
         _FileDescriptor(gameFolder)
         {}
 
     bool ReadNextEntry(ResourceTypeFlags typeFlags, IteratorState &state, ResourceMapEntryAgnostic &entry, std::vector<uint8_t> *optionalRawData) override
     {
+        if (!optionalRawData && _EnsureIndex(typeFlags))
+        {
+            // When enumerating from the index, mapStreamOffset is just the index of the next entry.
+            const std::vector<ResourceIndexEntry> &entries = _index->GetEntries();
+            while (state.mapStreamOffset < entries.size())
+            {
+                const ResourceIndexEntry &indexEntry = entries[state.mapStreamOffset++];
+                if (IsFlagSet(typeFlags, ResourceTypeToFlag(indexEntry.MapEntry.Type)))
+                {
+                    entry = indexEntry.MapEntry;
+                    return true;
+                }
+            }
+            return false;
+        }
         return NavAndReadNextEntry(typeFlags, GetMapStream(), state, entry, optionalRawData);
     }
 
+    bool GetCachedHeader(const ResourceMapEntryAgnostic &mapEntry, ResourceHeaderAgnostic &headerEntry) override
+    {
+        const ResourceIndexEntry *indexEntry = _EnsureIndex(ResourceTypeToFlag(mapEntry.Type)) ? _index->Find(mapEntry) : nullptr;
+        if (indexEntry && indexEntry->HasHeader)
+        {
+            headerEntry.Type = mapEntry.Type;
+            headerEntry.Number = mapEntry.Number;
+            headerEntry.Base36Number = mapEntry.Base36Number;
+            headerEntry.PackageHint = mapEntry.PackageNumber;
+            headerEntry.CompressionMethod = indexEntry->CompressionMethod;
+            headerEntry.cbCompressed = indexEntry->cbCompressed;
+            headerEntry.cbDecompressed = indexEntry->cbDecompressed;
+            headerEntry.Version = _version;
+            headerEntry.SourceFlags = this->SourceFlags;
+            return true;
+        }
+        return false;
+    }
+
     sci::istream GetHeaderAndPositionedStream(const ResourceMapEntryAgnostic &mapEntry, ResourceHeaderAgnostic &headerEntry) override
     {
         sci::istream packageByteStream = _GetVolumeStream(mapEntry.PackageNumber);
@@ -270,9 +409,7 @@ public:
     {
         // The stream might be in a failbit state (because someone enumerated and read off the end), so reset them before continuing.
         // Otherwise, the enumeration will fail, and the resource map will get cleaned out.
-        _map = nullptr;
-        _mapStream = nullptr;
-        _volumeStreams.clear();
+        _ReleaseStreams();
 
         std::unordered_map<int, sci::ostream> volumeStreamWrites;
 
@@ -339,11 +476,12 @@ public:
 
             // Now we have mapStreamWrite1 and volumeStreamWrite that have the needed data.
             // Let's ask the _FileDescriptor to replace things.
+            _ReleaseStreams();
             this->WriteAndReplaceMapAndVolumes(mapStreamWrite1, volumeStreamWrites);
         }
     }
 
-    void RebuildResources(bool force, ResourceSource &source, std::map<ResourceType, RebuildStats> &stats) override
+    void RebuildResources(bool force, ResourceSource &source, std::map<ResourceType, RebuildStats> &stats, const ResourceCompressionPolicies &compression) override
     {
         IteratorState iteratorState;
 
@@ -384,31 +522,41 @@ public:
                         bool includesHeader;
                         sci::istream volumneReadStream = source.GetPositionedStreamAndResourceSizeIncludingHeader(entryExisting, totalResourceSize, includesHeader);
 
-                        if (!includesHeader)
+                        auto &statsForType = stats[entryExisting.Type];
+                        ResourceCompressionPolicy policy = compression.ForType(entryExisting.Type);
+                        uint32_t compressedResourceSize;
+                        if ((policy != ResourceCompressionPolicy::Store) &&
+                            _WriteCompressed(source, entryExisting, volumneReadStream, totalResourceSize, includesHeader, policy, volumeWriteStreams[rebuildPackageNumber], compressedResourceSize, statsForType))
                         {
-                            // This is the case for when we put patch files into the resource map.
-                            ResourceHeaderAgnostic header;
-                            header.cbCompressed = totalResourceSize;
-                            header.cbDecompressed = totalResourceSize;
-                            header.Base36Number = entryExisting.Base36Number;
-                            header.Number = entryExisting.Number;
-                            header.PackageHint = entryExisting.PackageNumber;
-                            header.Type = entryExisting.Type;
-                            header.Version = this->_version;
-                            header.CompressionMethod = 0;
-                            (*_headerReadWrite.writer)(volumeWriteStreams[rebuildPackageNumber], header);
+                            totalResourceSize = compressedResourceSize;
+                        }
+                        else
+                        {
+                            if (!includesHeader)
+                            {
+                                // This is the case for when we put patch files into the resource map.
+                                ResourceHeaderAgnostic header;
+                                header.cbCompressed = totalResourceSize;
+                                header.cbDecompressed = totalResourceSize;
+                                header.Base36Number = entryExisting.Base36Number;
+                                header.Number = entryExisting.Number;
+                                header.PackageHint = entryExisting.PackageNumber;
+                                header.Type = entryExisting.Type;
+                                header.Version = this->_version;
+                                header.CompressionMethod = 0;
+                                (*_headerReadWrite.writer)(volumeWriteStreams[rebuildPackageNumber], header);
+                            }
+                            // else the data we're copying already includes the header.
+
+                            // Now transfer this to the write stream
+                            transfer(volumneReadStream, volumeWriteStreams[rebuildPackageNumber], totalResourceSize);
                         }
-                        // else the data we're copying already includes the header.
-
-                        // Now transfer this to the write stream
-                        transfer(volumneReadStream, volumeWriteStreams[rebuildPackageNumber], totalResourceSize);
 
                         // Then write this entry to the map, after modifying our map header's offset accordingly 
                         entryExisting.Offset = newResourceOffset;
                         entryExisting.PackageNumber = rebuildPackageNumber;
                         WriteEntry(entryExisting, mapStreamWrite1, mapStreamWrite2, false);
 
-                        auto &statsForType = stats[entryExisting.Type];
                         statsForType.ItemCount++;
                         statsForType.TotalSize += totalResourceSize;
                     }
@@ -425,14 +573,17 @@ public:
 
         // Now we have mapStreamWrite1 and volumeStreamWrite that have the needed data.
         // Let's ask the _FileDescriptor to replace things.
+        // (source may be us, so release any volumes we have mapped before they get replaced)
+        _ReleaseStreams();
         this->WriteAndReplaceMapAndVolumes(mapStreamWrite1, volumeWriteStreams);
     }
 
     virtual ::AppendBehavior AppendResources(const std::vector<const ResourceBlob*> &blobs)
     {
-        // For this, we append the resource data to the end of the volume file.
-        // We could have any number of volumes being saved to, so we'll use a map.
-        std::unordered_map<int, sci::ostream> volumeWriteStreams;
+        // For this, we append the resource data to the end of the volume file. Only the new data is written
+        // to the volumes; any previous version of the resource stays where it is (unreferenced) until the
+        // resources are rebuilt. We could have any number of volumes being saved to, so we'll use a map.
+        std::unordered_map<int, VolumeAppend> volumeAppends;
 
         sci::ostream mapStreamWriteMain;
         sci::ostream mapStreamWriteSecondary;
@@ -444,17 +595,21 @@ public:
             assert(IsResourceCompatible(_version, *blob));
             ResourceHeaderAgnostic header = blob->GetHeader();
 
-            // Possibly copy over a new volume, if we haven't written to it yet
-            if (volumeWriteStreams.find(header.PackageHint) == volumeWriteStreams.end())
+            // Find out where the volume currently ends, if we haven't written to it yet
+            if (volumeAppends.find(header.PackageHint) == volumeAppends.end())
             {
-                sci::istream volumeReadStream = _GetVolumeStream(blob->GetPackageHint());
-                volumeReadStream.seekg(0);
-                transfer(volumeReadStream, volumeWriteStreams[header.PackageHint], volumeReadStream.getBytesRemaining());
+                volumeAppends[header.PackageHint].Offset = this->GetVolumeSize(header.PackageHint);
             }
+            VolumeAppend &volumeAppend = volumeAppends[header.PackageHint];
 
             // Take note of the offset so we can create a map entry
-            _TNavigator::EnsureResourceAlignment(volumeWriteStreams[header.PackageHint]);
-            uint32_t resourceOffset = volumeWriteStreams[header.PackageHint].tellp();
+            uint32_t endOffset = volumeAppend.Offset + volumeAppend.Data.tellp();
+            uint32_t resourceOffset = endOffset;
+            _TNavigator::EnsureResourceAlignment(resourceOffset);
+            if (resourceOffset > endOffset)
+            {
+                volumeAppend.Data.FillByte(0, resourceOffset - endOffset);
+            }
 
             // Write the map entry
             ResourceMapEntryAgnostic newMapEntry;
@@ -465,11 +620,13 @@ public:
             WriteEntry(newMapEntry, mapStreamWriteMain, mapStreamWriteSecondary, true);
 
             // Write the header to the volume
-            header.CompressionMethod = 0; // We never write with compression, currently
-            (*_headerReadWrite.writer)(volumeWriteStreams[header.PackageHint], blob->GetHeader());
+            // We never write with compression, currently (the blob might have been loaded from compressed data)
+            header.CompressionMethod = 0;
+            header.cbCompressed = header.cbDecompressed;
+            (*_headerReadWrite.writer)(volumeAppend.Data, header);
             
             // Follow the volume header with the actual resource data
-            transfer(blob->GetReadStream(), volumeWriteStreams[header.PackageHint], blob->GetDecompressedLength());
+            transfer(blob->GetReadStream(), volumeAppend.Data, blob->GetDecompressedLength());
         }
 
         // Now we need to follow up with the rest of the map entries. For SCI0, we could just copy over the original resource map.
@@ -484,14 +641,73 @@ public:
         // Combine the two write streams. Or rather, append stream 2 to the end of stream 1.
         FinalizeMapStreams(mapStreamWriteMain, mapStreamWriteSecondary);
 
-        // Now we have mapStreamWrite1 and volumeStreamWrite that have the needed data.
-        // Let's ask the _FileDescriptor to replace things.
-        this->WriteAndReplaceMapAndVolumes(mapStreamWriteMain, volumeWriteStreams);
+        // Let the _FileDescriptor write out the new data and the map.
+        _ReleaseStreams();
+        this->AppendToVolumesAndReplaceMap(mapStreamWriteMain, volumeAppends);
 
         return _TNavigator::AppendBehavior;
     }
 
 protected:
+    // Writes an uncompressed resource to the volume in compressed form, if the policy says so. Returns false
+    // if nothing was written, in which case the resource should be copied over as is.
+    bool _WriteCompressed(ResourceSource &source, const ResourceMapEntryAgnostic &mapEntry, sci::istream readStream, uint32_t totalResourceSize, bool includesHeader, ResourceCompressionPolicy policy, sci::ostream &volumeWriteStream, uint32_t &sizeWritten, RebuildStats &statsForType)
+    {
+        ResourceHeaderAgnostic header;
+        std::vector<uint8_t> data;
+        try
+        {
+            if (includesHeader)
+            {
+                readStream = source.GetHeaderAndPositionedStream(mapEntry, header);
+                if (header.CompressionMethod != 0)
+                {
+                    return false;   // Already compressed
+                }
+            }
+            else
+            {
+                header.cbDecompressed = totalResourceSize;
+                header.Base36Number = mapEntry.Base36Number;
+                header.Number = mapEntry.Number;
+                header.Type = mapEntry.Type;
+            }
+            data.resize(header.cbDecompressed);
+            if (!data.empty())
+            {
+                readStream.read_data(&data[0], header.cbDecompressed);
+            }
+        }
+        catch (std::exception)
+        {
+            return false;
+        }
+        if (!readStream.good() || data.empty())
+        {
+            return false;
+        }
+
+        std::vector<uint8_t> compressed;
+        uint16_t compressionMethod;
+        if (!CompressResourceData(_version, mapEntry.Type, policy, &data[0], (uint32_t)data.size(), compressed, compressionMethod))
+        {
+            return false;
+        }
+
+        header.PackageHint = mapEntry.PackageNumber;
+        header.Version = this->_version;
+        header.CompressionMethod = compressionMethod;
+        header.cbCompressed = compressed.size();
+        uint32_t startPosition = volumeWriteStream.tellp();
+        (*_headerReadWrite.writer)(volumeWriteStream, header);
+        volumeWriteStream.WriteBytes(&compressed[0], (int)compressed.size());
+        sizeWritten = volumeWriteStream.tellp() - startPosition;
+
+        statsForType.CompressedCount++;
+        statsForType.CompressionSavings += (data.size() > compressed.size()) ? (data.size() - compressed.size()) : 0;
+        return true;
+    }
+
     sci::istream _GetVolumeStream(int volumeNumber)
     {
         auto result = _volumeStreams.find(volumeNumber);
@@ -500,10 +716,135 @@ protected:
             return result->second->getReader();
         }
 
-        _volumeStreams[volumeNumber] = _FileDescriptor::OpenVolume(volumeNumber);
+        // Sources that are only used for reading can just map the volumes, instead of pulling the
+        // whole thing into memory (CD-era games have very large volumes).
+        if (IsFlagSet(_access, ResourceSourceAccessFlags::ReadWrite))
+        {
+            _volumeStreams[volumeNumber] = _FileDescriptor::OpenVolume(volumeNumber);
+        }
+        else
+        {
+            _volumeStreams[volumeNumber] = _FileDescriptor::OpenVolumeMapped(volumeNumber);
+        }
         return _volumeStreams.find(volumeNumber)->second->getReader();
     }
 
+    // Only read-only sources use the index. Sources that we write to are short-lived, and
+    // writing changes the map, which invalidates the index anyway.
+    // If the index doesn't cover typeFlags yet, it's extended to. An enumeration only ever asks
+    // for the types it's enumerating, so the index won't change under it.
+    bool _EnsureIndex(ResourceTypeFlags typeFlags)
+    {
+        if (!_indexChecked)
+        {
+            _indexChecked = true;
+            _useIndex = !IsFlagSet(_access, ResourceSourceAccessFlags::ReadWrite) && this->DoesMapExist();
+            if (_useIndex)
+            {
+                _index = ResourceIndex::Load(*this, _version);
+                if (_index && !_IsIndexConsistent(*_index))
+                {
+                    _index.reset();
+                }
+            }
+        }
+        if (_useIndex && (!_index || !AreAllFlagsSet(_index->GetTypes(), typeFlags)))
+        {
+            std::unique_ptr<ResourceIndex> index = _BuildIndex(_index ? (_index->GetTypes() | typeFlags) : typeFlags, _index.get());
+            index->Save(*this, _version);
+            _index = std::move(index);
+        }
+        return _index != nullptr;
+    }
+
+    // The stamps don't catch everything (e.g. a volume copied over another one of the same size with
+    // its timestamp preserved), so spot-check a handful of entries against what's actually in the volumes.
+    bool _IsIndexConsistent(const ResourceIndex &index)
+    {
+        const std::vector<ResourceIndexEntry> &entries = index.GetEntries();
+        size_t step = max((size_t)1, entries.size() / ResourceIndex::EntriesToVerify);
+        for (size_t i = 0; i < entries.size(); i += step)
+        {
+            const ResourceIndexEntry &indexEntry = entries[i];
+            if (indexEntry.HasHeader)
+            {
+                try
+                {
+                    ResourceHeaderAgnostic header;
+                    sci::istream volumeStream = GetHeaderAndPositionedStream(indexEntry.MapEntry, header);
+                    if ((header.CompressionMethod != indexEntry.CompressionMethod) ||
+                        (header.cbCompressed != indexEntry.cbCompressed) ||
+                        (header.cbDecompressed != indexEntry.cbDecompressed) ||
+                        (ResourceIndex::CalculateChecksum(volumeStream, header.cbCompressed) != indexEntry.Checksum))
+                    {
+                        return false;
+                    }
+                }
+                catch (std::exception)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Entries for the types already in previous are copied from it, so only the headers of the new
+    // types need to be read from the volumes.
+    std::unique_ptr<ResourceIndex> _BuildIndex(ResourceTypeFlags types, const ResourceIndex *previous)
+    {
+        std::unique_ptr<ResourceIndex> index = std::make_unique<ResourceIndex>(types);
+        IteratorState state;
+        ResourceIndexEntry indexEntry;
+        while (NavAndReadNextEntry(types, GetMapStream(), state, indexEntry.MapEntry, nullptr))
+        {
+            const ResourceIndexEntry *previousEntry = nullptr;
+            if (previous && IsFlagSet(previous->GetTypes(), ResourceTypeToFlag(indexEntry.MapEntry.Type)))
+            {
+                previousEntry = previous->Find(indexEntry.MapEntry);
+            }
+            if (previousEntry)
+            {
+                index->Add(*previousEntry);
+                continue;
+            }
+
+            indexEntry.HasHeader = false;
+            indexEntry.CompressionMethod = 0;
+            indexEntry.cbCompressed = 0;
+            indexEntry.cbDecompressed = 0;
+            indexEntry.Checksum = 0;
+            try
+            {
+                ResourceHeaderAgnostic header;
+                sci::istream volumeStream = GetHeaderAndPositionedStream(indexEntry.MapEntry, header);
+                indexEntry.HasHeader = true;
+                indexEntry.CompressionMethod = header.CompressionMethod;
+                indexEntry.cbCompressed = header.cbCompressed;
+                indexEntry.cbDecompressed = header.cbDecompressed;
+                indexEntry.Checksum = ResourceIndex::CalculateChecksum(volumeStream, header.cbCompressed);
+            }
+            catch (std::exception)
+            {
+                // Corrupt resource, or the map entry points to nothing. We'll still enumerate it, but we'll
+                // go to the volume for the header (and fail in the same way) like we would without the index.
+            }
+            index->Add(indexEntry);
+        }
+
+        // The map stream was read to the end (and is in a failed state), so start fresh next time.
+        _mapStream = nullptr;
+        _map = nullptr;
+        return index;
+    }
+
+    void _ReleaseStreams()
+    {
+        _mapStream = nullptr;
+        _map = nullptr;
+        _volumeStreams.clear();
+    }
+
     sci::istream &GetMapStream()
     {
         if (!_map)
@@ -517,6 +858,11 @@ protected:
 private:
     ResourceHeaderReadWrite _headerReadWrite;
     SCIVersion _version;
+    ResourceSourceAccessFlags _access;
+
+    bool _indexChecked;
+    bool _useIndex;
+    std::shared_ptr<const ResourceIndex> _index;
 
     std::unique_ptr<sci::streamOwner> _map;
     std::unique_ptr<sci::istream> _mapStream;
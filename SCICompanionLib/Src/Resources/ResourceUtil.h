@@ -30,6 +30,7 @@ public:
 // fwd decl
 class ResourceBlob;
 std::unique_ptr<ResourceEntity> CreateResourceFromResourceData(const ResourceBlob &data, bool fallbackOnException = true);
+std::unique_ptr<ResourceEntity> CreateDeferredResourceFromResourceData(const ResourceBlob &data, bool fallbackOnException = true);
 
 void ExportResourceAsBitmap(const ResourceEntity &resourceEntity);
 
@@ -901,9 +901,10 @@ void SniffSCIVersion(GameFolderHelper &helper)
             {
                 // REVIEW: Could test a few instead of just one. The 2nd one from KQ7 would show 320x200, so if the first one were deleted
                 // we'd get the wrong result
-                std::unique_ptr<ResourceEntity> view = CreateResourceFromResourceData(*viewBlob, false);
-                RasterComponent &raster = view->GetComponent<RasterComponent>();
-                helper.Version.DefaultResolution = raster.Resolution;
+                // We only need the resolution, so don't bother decoding the cels.
+                std::unique_ptr<ResourceEntity> view = CreateDeferredResourceFromResourceData(*viewBlob, false);
+                const RasterComponent *raster = view->TryGetComponentHeaders<RasterComponent>();
+                helper.Version.DefaultResolution = raster->Resolution;
                 break;
             }
         }
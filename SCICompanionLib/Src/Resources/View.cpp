@@ -21,6 +21,12 @@
 #include "format.h"
 #include "ImageUtil.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#include <intrin.h>
+#define VIEW_RLE_SSE2
+#endif
+
 using namespace std;
 
 int g_debugCelRLE;
@@ -35,14 +41,6 @@ bool IsMirror(uint16_t nLoop, uint16_t mask)
     return (0 != (((mask) >> (nLoop)) & 1));
 }
 
-enum class GNPResult
-{
-    Done = 0,   // pColor is not set
-    NewLine = 1,// pColor is set
-    Ok = 2,    // pColor is set
-};
-
-
 void ReadImageData(sci::istream &byteStream, Cel &cel, bool isVGA)
 {
     ReadImageData(byteStream, cel, isVGA, byteStream);
@@ -89,12 +87,12 @@ void ReadImageDataWorker(sci::istream &byteStreamRLE, Cel &cel, bool isVGA, sci:
         {
             // Read more data.
             byteStreamRLE >> b;
+            bool isLiteral = false;
+            uint8_t color = cel.TransparentColor;
             if (!isVGA)
             {
-                uint8_t color = (b & 0x0f);
+                color = (b & 0x0f);
                 cCount = ((b & 0xf0) >> 4);
-                memset(scratchBuffer, color, cCount);
-                scratchPointer = scratchBuffer;
             }
             else
             {
@@ -108,20 +106,58 @@ void ReadImageDataWorker(sci::istream &byteStreamRLE, Cel &cel, bool isVGA, sci:
                         // fall through...
                     case 0x00:
                         // Copy next cCount bytes as is
-                        byteStreamLiteral.read_data(scratchBuffer, cCount);
+                        isLiteral = true;
                         break;
                     case 0x02:
-                        uint8_t color;
-                        byteStreamLiteral >> color;
                         // Set next cCount bytes to color
-                        memset(scratchBuffer, color, cCount);
+                        byteStreamLiteral >> color;
                         break;
                     case 0x03:
                         // Set next cCount bytes to transparent
-                        memset(scratchBuffer, cel.TransparentColor, cCount);
                         break;
                 }
             }
+
+            assert(y >= 0);
+
+            if (cCount <= cxRemainingOnThisLine)
+            {
+                // This is almost always the case: the command fits on this line, so it can go
+                // straight into the cel.
+                uint8_t *dest = &cel.Data[y * cxActual + x];
+                if (isLiteral)
+                {
+                    byteStreamLiteral.read_data(dest, cCount);
+                }
+                else
+                {
+                    memset(dest, color, cCount);
+                }
+                x += cCount;
+                cxRemainingOnThisLine -= cCount;
+                cBufferSizeRemaining -= cCount;
+                if (cxRemainingOnThisLine == 0)
+                {
+                    // Pad, and move to the next line:
+                    cel.Data.fill((y * cxActual + x), cxPadding, cel.TransparentColor);
+                    cBufferSizeRemaining -= cxPadding;
+                    x = 0;
+                    y -= 1;
+                    calcFunc(y, byteStreamRLE, byteStreamLiteral);
+                    cxRemainingOnThisLine = cel.size.cx;
+                }
+                continue;
+            }
+
+            // Otherwise it continues onto the next line. Go through the scratch buffer.
+            if (isLiteral)
+            {
+                byteStreamLiteral.read_data(scratchBuffer, cCount);
+            }
+            else
+            {
+                memset(scratchBuffer, color, cCount);
+            }
             scratchPointer = scratchBuffer;
             cxRemainingForThisCommand = cCount;
         }
@@ -216,7 +252,7 @@ void CalculateSCI2RowOffsets(Cel &cel, sci::istream byteStreamRLE, sci::istream
 const uint16_t ReasonableCelWidth = 320;
 const uint16_t ReasonableCelHeight = 200;
 
-void ReadCelFrom(ResourceEntity &resource, sci::istream byteStream, Cel &cel, bool isVGA)
+void ReadCelFrom(const ResourceEntity &resource, const RasterComponent &raster, sci::istream byteStream, Cel &cel, bool isVGA, bool headersOnly)
 {
     // Width and height
     byteStream >> cel.size.cx;
@@ -224,7 +260,7 @@ void ReadCelFrom(ResourceEntity &resource, sci::istream byteStream, Cel &cel, bo
 
     // Ensure the size is reasonable (unsure if this is a real limit), so we don't go
     // allocating huge amounts of memory.
-    if (ClampSize(resource.GetComponent<RasterComponent>(), cel.size))
+    if (ClampSize(raster, cel.size))
     {
         appState->LogInfo("Corrupt view resource: (%d,%d).", resource.ResourceNumber, resource.PackageNumber);
         throw std::exception("Invalid cel size.");
@@ -246,13 +282,16 @@ void ReadCelFrom(ResourceEntity &resource, sci::istream byteStream, Cel &cel, bo
         byteStream >> unknown;
     }
 
-    g_debugCelRLE = resource.ResourceNumber;
-    ReadImageData(byteStream, cel, isVGA);
+    if (!headersOnly)
+    {
+        g_debugCelRLE = resource.ResourceNumber;
+        ReadImageData(byteStream, cel, isVGA);
+    }
 }
 
 const uint16_t ReasonableCelCount = 128;
 
-void ReadLoopFrom(ResourceEntity &resource, sci::istream byteStream, Loop &loop, bool isVGA)
+void ReadLoopFrom(ResourceEntity &resource, sci::istream byteStream, Loop &loop, bool isVGA, bool headersOnly)
 {
     assert(loop.Cels.empty());
     uint16_t nCels;
@@ -283,128 +322,149 @@ void ReadLoopFrom(ResourceEntity &resource, sci::istream byteStream, Loop &loop,
             byteStream >> nOffset;
             sci::istream byteStreamCel(byteStream);
             byteStreamCel.seekg(nOffset);
-            ReadCelFrom(resource, byteStreamCel, loop.Cels[i], isVGA);
+            ReadCelFrom(resource, resource.GetComponent<RasterComponent>(), byteStreamCel, loop.Cels[i], isVGA, headersOnly);
         }
     }
     assert(loop.Cels.size() == nCels); // Ensure cel count is right.
 }
 
-uint8_t GetPixel(const uint8_t *p, int x, int y, int cxActual)
+const int MaxIdenticalPixelCount = 0x3f;
+
+// Sierra actually handles 127 (63 + 64) here, but SV.exe barfs on it, so limit ourselves to 63.
+const int MaxDifferentPixelCount = 63;
+
+const int MaxEGAPixelCount = 15;
+
+// How many pixels, up to count, are the same as the first one.
+int _GetIdenticalPixelCountScalar(const uint8_t *pixels, int count)
 {
-    return (*((p)+((y)* (cxActual)) + (x)));
+    int length = 1;
+    while ((length < count) && (pixels[length] == pixels[0]))
+    {
+        length++;
+    }
+    return length;
 }
 
-// The sole purpose of this is to ignore the padding at the end of each scanline.
-GNPResult GetNextPixel(const uint8_t *pData, int &x, int &y, int cx, uint8_t *pColor)
+// How many pixels, up to count, should be written as is before we reach a run that is
+// worth encoding on its own. The way this works is:
+//  - sequences of 2 are allowed in these sequences (since it would end up
+//      costing the same just to keep going), unless they are of the transparent color.
+int _GetDifferentPixelCountScalar(const uint8_t *pixels, int count, uint8_t transparent)
 {
-    GNPResult iResult = GNPResult::Ok;
-    if (x >= cx)
+    int identicalColorCount = 1;
+    for (int i = 1; i < count; i++)
     {
-        x = 0;
-        y--;
-        iResult = GNPResult::NewLine;
+        if (pixels[i] == pixels[i - 1])
+        {
+            identicalColorCount++;
+            if ((identicalColorCount >= 3) || (pixels[i] == transparent))
+            {
+                // 3 in a row (or 2 transparent). Time to bail.
+                int length = i + 1 - identicalColorCount;
+                assert(length > 0);
+                return length;
+            }
+        }
+        else
+        {
+            identicalColorCount = 1;
+        }
     }
+    return count;
+}
+
+#ifdef VIEW_RLE_SSE2
 
-    if (y < 0)
+int _GetIdenticalPixelCountSSE2(const uint8_t *pixels, int count)
+{
+    __m128i color = _mm_set1_epi8((char)pixels[0]);
+    int length = 0;
+    while ((length + 16) <= count)
     {
-        iResult = GNPResult::Done;
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + length));
+        unsigned int differentMask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, color)) & 0xffff;
+        if (differentMask)
+        {
+            unsigned long index;
+            _BitScanForward(&index, differentMask);
+            return length + (int)index;
+        }
+        length += 16;
     }
-
-    if (iResult != GNPResult::Done)
+    while ((length < count) && (pixels[length] == pixels[0]))
     {
-        *pColor = GetPixel(pData, x, y, CX_ACTUAL(cx));
+        length++;
     }
-    ++x;
-    return iResult;
+    return length;
 }
 
-const int ValuableIdenticalColorsThreshold = 2;
-
-// Returns the next pixel color, and how many pixels after that are identical
-int GetNextIdenticalPixelCount(const uint8_t *pData, int x, int y, int cx, uint8_t *pColor)
+// Same as _GetDifferentPixelCountScalar. The first pixel i where we'd bail is one that
+// matches the one before it, and either is transparent or also matches the one before that.
+// The run that's worth encoding starts 1 or 2 pixels before that.
+int _GetDifferentPixelCountSSE2(const uint8_t *pixels, int count, uint8_t transparent)
 {
-    int count = 0;
-    if (GetNextPixel(pData, x, y, cx, pColor) == GNPResult::Ok)
+    if (count < 2)
     {
-        count++;
-        uint8_t temp;
-        while ((GetNextPixel(pData, x, y, cx, &temp) == GNPResult::Ok) && (*pColor == temp) && (count < 0x3f))
+        return count;
+    }
+    if ((pixels[1] == pixels[0]) && (pixels[1] == transparent))
+    {
+        return 0;
+    }
+
+    __m128i transparentColor = _mm_set1_epi8((char)transparent);
+    int i = 2;
+    while ((i + 16) <= count)
+    {
+        __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+        __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i - 1));
+        __m128i beforePrevious = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i - 2));
+        __m128i sameAsPrevious = _mm_cmpeq_epi8(current, previous);
+        __m128i previousSameAsBefore = _mm_cmpeq_epi8(previous, beforePrevious);
+        __m128i isTransparent = _mm_cmpeq_epi8(current, transparentColor);
+        unsigned int bailMask = _mm_movemask_epi8(_mm_and_si128(sameAsPrevious, _mm_or_si128(isTransparent, previousSameAsBefore)));
+        if (bailMask)
         {
-            count++;
+            unsigned long index;
+            _BitScanForward(&index, bailMask);
+            int bail = i + (int)index;
+            return (pixels[bail] == transparent) ? (bail - 1) : (bail - 2);
+        }
+        i += 16;
+    }
+    for (; i < count; i++)
+    {
+        if ((pixels[i] == pixels[i - 1]) && ((pixels[i] == transparent) || (pixels[i - 1] == pixels[i - 2])))
+        {
+            return (pixels[i] == transparent) ? (i - 1) : (i - 2);
         }
     }
     return count;
 }
 
-// Sierra actually handles 127 (63 + 64) here, but SV.exe barfs on it, so limit ourselves to 63.
-const int MaxDifferentPixelCount = 63;
+#endif
 
-// The way this works is:
-//  - sequences of 2 are allowed in these sequences (since it would end up
-//      costing the same just to keep going), unless they are immediately
-//      followed by another sequence of 2.
-int GetNextDifferentPixelCount(const uint8_t *pData, int x, int y, int cx, uint8_t transparent)
+int _GetIdenticalPixelCount(const uint8_t *pixels, int count, RLEScan scan)
 {
-    int count = 0;
-    uint8_t previousColor;
-    if (GetNextPixel(pData, x, y, cx, &previousColor) == GNPResult::Ok)
-    {
-        count++;
-        uint8_t nextColor;
-        int identicalColorCount = 1;
-        int previousIdenticalColorCountSequence = 0;
-        while ((count < MaxDifferentPixelCount) && (GetNextPixel(pData, x, y, cx, &nextColor) == GNPResult::Ok))
-        {
-            count++;
-            if (nextColor == previousColor)
-            {
-                identicalColorCount++;
-
-                if ((identicalColorCount >= 3) || (identicalColorCount >= 2 && (previousColor == transparent)))
-                {
-                    // 3 in a row. Time to bail.
-                    count -= identicalColorCount;
-                    assert(count > 0);
-                    break;
-                }
-                // Hmm, this makes it a bit worse. I'm close to the "offical size" with this algorithm
-                // but not quite.
-                // The remaining difference might just be in palette size.
-                /*
-                if ((identicalColorCount >= 2) && (previousIdenticalColorCountSequence >= 2))
-                {
-                // 2 in a row right after 2 in a row. Time to bail.
-                count -= (identicalColorCount + previousIdenticalColorCountSequence);
-                assert(count > 0);
-                break;
-                }*/
-            }
-            else
-            {
-                previousIdenticalColorCountSequence = identicalColorCount;
-                identicalColorCount = 1;
-                previousColor = nextColor;
-            }
-        }
+#ifdef VIEW_RLE_SSE2
+    if (scan == RLEScan::Vectorized)
+    {
+        return _GetIdenticalPixelCountSSE2(pixels, count);
     }
-    return count;
+#endif
+    return _GetIdenticalPixelCountScalar(pixels, count);
 }
 
-// Advances x and y by amount, and returns the color at x and y
-void AdvanceXY(const uint8_t *pData, int amount, int &x, int &y, int cx, uint8_t *pColor)
+int _GetDifferentPixelCount(const uint8_t *pixels, int count, uint8_t transparent, RLEScan scan)
 {
-    assert(y >= 0);
-    *pColor = GetPixel(pData, x, y, CX_ACTUAL(cx));
-    int lines = amount / cx;
-    int columns = amount % cx;
-    y -= (amount / cx);
-    x += columns;
-    if (x >= cx)
-    {
-        x %= cx;
-        y--;
-    }
-    assert((y >= 0) || ((y == -1) && (x == 0)));
+#ifdef VIEW_RLE_SSE2
+    if (scan == RLEScan::Vectorized)
+    {
+        return _GetDifferentPixelCountSSE2(pixels, count, transparent);
+    }
+#endif
+    return _GetDifferentPixelCountScalar(pixels, count, transparent);
 }
 
 void WriteImageData(sci::ostream &byteStream, const Cel &cel, bool isVGA, bool isEmbeddedView)
@@ -412,18 +472,12 @@ void WriteImageData(sci::ostream &byteStream, const Cel &cel, bool isVGA, bool i
     WriteImageData(byteStream, cel, isVGA, byteStream, !isVGA || isEmbeddedView);
 }
 
-void WriteImageData(sci::ostream &rleStream, const Cel &cel, bool isVGA, sci::ostream &literalStream, bool writeZero)
+void WriteImageData(sci::ostream &rleStream, const Cel &cel, bool isVGA, sci::ostream &literalStream, bool writeZero, RLEScan scan)
 {
     // Now the image data
     // cxActual is how wide our bitmap data is (a boundary of 4 pixels - 32 bits)
     int cxActual = CX_ACTUAL(cel.size.cx);
-
-    // Start at the bottom
-    int y = cel.size.cy - 1;
-    int x = 0;
-
-    uint8_t cCount = 0;
-    uint8_t cColorPrev = 0xff; // invalid colour value (hmm, but not for VGA)
+    int cx = cel.size.cx;
 
     // For some reason, image data always starts with a 0x00
     // REVIEW: With VGA1.1 it definitely does not. Still need to check VGA1.0
@@ -434,82 +488,53 @@ void WriteImageData(sci::ostream &rleStream, const Cel &cel, bool isVGA, sci::os
         rleStream.WriteByte(0);
     }
 
+    // Runs never continue onto the next line, so we can encode one line at a time.
+    // Start at the bottom.
     const uint8_t *bits = &cel.Data[0];
-
-    if (isVGA)
+    for (int y = cel.size.cy - 1; y >= 0; y--)
     {
-        int count = 1;  // Anything but zero
-        while (count)
+        const uint8_t *line = bits + y * cxActual;
+        int x = 0;
+        while (x < cx)
         {
-            uint8_t identicalColor;
-            count = GetNextIdenticalPixelCount(bits, x, y, cel.size.cx, &identicalColor);
-            if (count > 1)
+            int remaining = cx - x;
+            if (isVGA)
             {
-                assert(count <= 0x3f);
-                uint8_t byte = (uint8_t)count;
-                if (identicalColor == cel.TransparentColor)
+                int count = _GetIdenticalPixelCount(line + x, min(remaining, MaxIdenticalPixelCount), scan);
+                if (count > 1)
                 {
-                    // Sequence of transparent color
-                    byte |= (0x3 << 6);
-                    rleStream.WriteByte(byte);
+                    uint8_t byte = (uint8_t)count;
+                    if (line[x] == cel.TransparentColor)
+                    {
+                        // Sequence of transparent color
+                        byte |= (0x3 << 6);
+                        rleStream.WriteByte(byte);
+                    }
+                    else
+                    {
+                        // Sequence of identical color
+                        byte |= (0x2 << 6);
+                        rleStream.WriteByte(byte);
+                        literalStream.WriteByte(line[x]);
+                    }
                 }
                 else
                 {
-                    // Sequence of identical color
-                    byte |= (0x2 << 6);
-                    rleStream.WriteByte(byte);
-                    literalStream.WriteByte(identicalColor);
-                }
-                uint8_t dummy;
-                AdvanceXY(bits, count, x, y, cel.size.cx, &dummy);
-            }
-            else
-            {
-                count = GetNextDifferentPixelCount(bits, x, y, cel.size.cx, cel.TransparentColor);
-                if (count > 0x3f)
-                {
-                    uint8_t byte = (uint8_t)(count - 64);
-                    byte |= (0x1 << 6);
-                    rleStream.WriteByte(byte);
-                }
-                else if (count > 0)
-                {
+                    count = _GetDifferentPixelCount(line + x, min(remaining, MaxDifferentPixelCount), cel.TransparentColor, scan);
                     rleStream.WriteByte((uint8_t)count);
+                    // Now copy over that many bits.
+                    literalStream.WriteBytes(line + x, count);
                 }
-                // Now copy over that many bits.
-                for (int i = 0; i < count; i++)
-                {
-                    uint8_t color;
-                    AdvanceXY(bits, 1, x, y, cel.size.cx, &color);
-                    literalStream.WriteByte(color);
-                }
+                x += count;
             }
-        }
-    }
-    else
-    {
-        // EGA
-        GNPResult result = GetNextPixel(bits, x, y, cel.size.cx, &cColorPrev);
-        cCount = 1;
-
-        uint8_t cColor;
-        while (result != GNPResult::Done)
-        {
-            // Look at the next pixel.
-            result = GetNextPixel(bits, x, y, cel.size.cx, &cColor);
-            if ((result == GNPResult::Done) || (result == GNPResult::NewLine) || (cCount == 15) || (cColor != cColorPrev))
+            else
             {
-                // (It is not valid to test cColor if iResult is GNP_DONE)
-                assert((result == GNPResult::Done) || (cColor < 16));
-                assert(cCount < 16);
-
-                // Write out our data
-                uint8_t b = ((cCount << 4) | cColorPrev);
-                rleStream.WriteByte(b);
-                cCount = 0;
+                // EGA
+                int count = _GetIdenticalPixelCount(line + x, min(remaining, MaxEGAPixelCount), scan);
+                assert(line[x] < 16);
+                rleStream.WriteByte((uint8_t)((count << 4) | line[x]));
+                x += count;
             }
-            cColorPrev = cColor;
-            cCount++;
         }
     }
 }
@@ -563,6 +588,41 @@ void WriteLoopTo(const ResourceEntity &resource, sci::ostream &byteStream, const
 
 const uint16_t ReasonableLoopCount = 50;
 
+// When only reading headers there are no bits to mirror, so just carry over the metadata.
+void _SyncCelMirrorState(Cel &celMirror, const Cel &celOrig, bool headersOnly)
+{
+    if (headersOnly)
+    {
+        celMirror.size = celOrig.size;
+        celMirror.TransparentColor = celOrig.TransparentColor;
+        celMirror.placement.x = -celOrig.placement.x;
+        celMirror.placement.y = celOrig.placement.y;
+    }
+    else
+    {
+        SyncCelMirrorState(celMirror, celOrig);
+    }
+}
+
+void _MirrorLoopFrom(Loop &loop, uint8_t nOriginal, const Loop &orig, bool headersOnly)
+{
+    if (headersOnly)
+    {
+        loop.Cels.clear();
+        loop.MirrorOf = nOriginal;
+        loop.IsMirror = true;
+        for (const Cel &celOrig : orig.Cels)
+        {
+            loop.Cels.push_back(Cel());
+            _SyncCelMirrorState(loop.Cels.back(), celOrig, true);
+        }
+    }
+    else
+    {
+        MirrorLoopFrom(loop, nOriginal, orig);
+    }
+}
+
 void ReadPalette(ResourceEntity &resource, sci::istream &stream)
 {
     // TODO: the palette reading code has a limit (bytes remaining) how to enforce
@@ -592,7 +652,7 @@ void PostReadProcessing(ResourceEntity &resource, RasterComponent &raster)
 
 // Helpers for view resources
 // We'll assume resource and package number are already taken care of, because they are common to all.
-void ViewReadFromVersioned(ResourceEntity &resource, sci::istream &byteStream, bool isVGA)
+void ViewReadFromVersioned(ResourceEntity &resource, sci::istream &byteStream, bool isVGA, bool headersOnly)
 {
     RasterComponent &raster = resource.GetComponent<RasterComponent>();
     uint16_t nLoopCountWord;
@@ -633,7 +693,7 @@ void ViewReadFromVersioned(ResourceEntity &resource, sci::istream &byteStream, b
             // Make a copy of the stream so we don't lose our position in this one.
             sci::istream streamLoop(byteStream);
             streamLoop.seekg(rgOffsets[i]);
-            ReadLoopFrom(resource, streamLoop, raster.Loops[i], isVGA);
+            ReadLoopFrom(resource, streamLoop, raster.Loops[i], isVGA, headersOnly);
         }
     }
 
@@ -650,7 +710,7 @@ void ViewReadFromVersioned(ResourceEntity &resource, sci::istream &byteStream, b
                 {
                     if (rgOffsets[iOrig] == rgOffsets[iMirror])
                     {
-                        MirrorLoopFrom(raster.Loops[iMirror], (uint8_t)iOrig, raster.Loops[iOrig]);
+                        _MirrorLoopFrom(raster.Loops[iMirror], (uint8_t)iOrig, raster.Loops[iOrig], headersOnly);
                         break;
                     }
                 }
@@ -695,7 +755,7 @@ struct ViewHeader_VGA11
 };
 #include <poppack.h>
 
-void ReadCelFromVGA11(sci::istream &byteStream, Cel &cel, bool isPic)
+void ReadCelFromVGA11(sci::istream &byteStream, Cel &cel, bool isPic, bool headersOnly)
 {
     CelHeader_VGA11 celHeader;
     byteStream >> celHeader;
@@ -734,6 +794,11 @@ void ReadCelFromVGA11(sci::istream &byteStream, Cel &cel, bool isPic)
     cel.placement = celHeader.placement;
     cel.TransparentColor = celHeader.transparentColor;
 
+    if (headersOnly)
+    {
+        return;
+    }
+
     // RLE are the encoding "instructions", while Literal is the raw data it reads from
     assert(celHeader.offsetRLE != 0);
     byteStream.seekg(celHeader.offsetRLE);
@@ -751,7 +816,7 @@ void ReadCelFromVGA11(sci::istream &byteStream, Cel &cel, bool isPic)
     }
 }
 
-void ReadLoopFromVGA(ResourceEntity &resource, sci::istream &byteStream, Loop &loop, int nLoop, uint8_t celHeaderSize, bool isSCI2)
+void ReadLoopFromVGA(ResourceEntity &resource, sci::istream &byteStream, Loop &loop, int nLoop, uint8_t celHeaderSize, bool isSCI2, bool headersOnly)
 {
     g_debugCelRLE = resource.ResourceNumber;
 
@@ -787,7 +852,7 @@ void ReadLoopFromVGA(ResourceEntity &resource, sci::istream &byteStream, Loop &l
         {
             sci::istream streamCel(byteStream);
             streamCel.seekg(loopHeader.celOffsetAbsolute + celHeaderSize * i);
-            ReadCelFromVGA11(streamCel, loop.Cels[i], false);
+            ReadCelFromVGA11(streamCel, loop.Cels[i], false, headersOnly);
         }
     }
 }
@@ -985,7 +1050,7 @@ void ViewWriteToVGA2(const ResourceEntity &resource, sci::ostream &byteStream, s
     ViewWriteToVGA11_2_Helper(resource, byteStream, propertyBag, true);
 }
 
-void ViewReadFromVGA11Helper(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag, bool isSCI2)
+void ViewReadFromVGA11Helper(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag, bool isSCI2, bool headersOnly)
 {
     RasterComponent &raster = resource.GetComponent<RasterComponent>();
 
@@ -1019,7 +1084,7 @@ void ViewReadFromVGA11Helper(ResourceEntity &resource, sci::istream &byteStream,
     {
         sci::istream streamLoop(byteStream);
         streamLoop.seekg(header.headerSize + (header.loopHeaderSize * i));  // Start of this loop's data
-        ReadLoopFromVGA(resource, streamLoop, raster.Loops[i], i, header.celHeaderSize, isSCI2);
+        ReadLoopFromVGA(resource, streamLoop, raster.Loops[i], i, header.celHeaderSize, isSCI2, headersOnly);
     }
 
     // Now fill in mirrors. They seem setup a little differently than in earlier versions of views,
@@ -1034,7 +1099,7 @@ void ViewReadFromVGA11Helper(ResourceEntity &resource, sci::istream &byteStream,
             {
                 // Make new empty cels, and for each one, do a "sync mirror state" if the original.
                 loop.Cels.push_back(Cel());
-                SyncCelMirrorState(loop.Cels[i], origLoop.Cels[i]);
+                _SyncCelMirrorState(loop.Cels[i], origLoop.Cels[i], headersOnly);
             }
         }
     }
@@ -1044,21 +1109,42 @@ void ViewReadFromVGA11Helper(ResourceEntity &resource, sci::istream &byteStream,
 
 void ViewReadFromVGA11(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
 {
-    ViewReadFromVGA11Helper(resource, byteStream, propertyBag, false);
+    ViewReadFromVGA11Helper(resource, byteStream, propertyBag, false, false);
 }
 void ViewReadFromVGA2(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
 {
-    ViewReadFromVGA11Helper(resource, byteStream, propertyBag, true);
+    ViewReadFromVGA11Helper(resource, byteStream, propertyBag, true, false);
 }
 
 void ViewReadFromEGA(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
 {
-    ViewReadFromVersioned(resource, byteStream, false);
+    ViewReadFromVersioned(resource, byteStream, false, false);
 }
 
 void ViewReadFromVGA(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
 {
-    ViewReadFromVersioned(resource, byteStream, true);
+    ViewReadFromVersioned(resource, byteStream, true, false);
+}
+
+// Header-only readers: these fill in loops, cel sizes/placement/transparency, the palette and
+// the native resolution, but leave the cel bitmaps empty.
+void ViewReadHeadersFromVGA11(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
+{
+    ViewReadFromVGA11Helper(resource, byteStream, propertyBag, false, true);
+}
+void ViewReadHeadersFromVGA2(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
+{
+    ViewReadFromVGA11Helper(resource, byteStream, propertyBag, true, true);
+}
+
+void ViewReadHeadersFromEGA(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
+{
+    ViewReadFromVersioned(resource, byteStream, false, true);
+}
+
+void ViewReadHeadersFromVGA(ResourceEntity &resource, sci::istream &byteStream, const std::map<BlobKey, uint32_t> &propertyBag)
+{
+    ViewReadFromVersioned(resource, byteStream, true, true);
 }
 
 void ViewWriteTo(const ResourceEntity &resource, sci::ostream &byteStream, bool isVGA)
@@ -1216,7 +1302,8 @@ ResourceTraits viewTraitsEGA =
     &ViewReadFromEGA,
     &ViewWriteToEGA,
     &NoValidationFunc,
-    nullptr
+    nullptr,
+    &ViewReadHeadersFromEGA
 };
 
 ResourceTraits viewTraitsVGA =
@@ -1225,7 +1312,8 @@ ResourceTraits viewTraitsVGA =
     &ViewReadFromVGA,
     &ViewWriteToVGA,
     &NoValidationFunc,
-    nullptr
+    nullptr,
+    &ViewReadHeadersFromVGA
 };
 
 ResourceTraits viewTraitsVGA11 =
@@ -1234,7 +1322,8 @@ ResourceTraits viewTraitsVGA11 =
     &ViewReadFromVGA11,
     &ViewWriteToVGA11,
     &NoValidationFunc,
-    nullptr
+    nullptr,
+    &ViewReadHeadersFromVGA11
 };
 
 ResourceTraits viewTraitsVGA2 =
@@ -1243,7 +1332,8 @@ ResourceTraits viewTraitsVGA2 =
     &ViewReadFromVGA2,
     &ViewWriteToVGA2,
     &NoValidationFunc,
-    nullptr
+    nullptr,
+    &ViewReadHeadersFromVGA2
 };
 
 ResourceEntity *CreateViewResource(SCIVersion version)
@@ -1281,6 +1371,64 @@ ResourceEntity *CreateViewResource(SCIVersion version)
     return pResource.release();
 }
 
+void ReadCelImageData(const ResourceEntity &resource, CelIndex celIndex, Cel &cel)
+{
+    const RasterComponent &headers = *resource.TryGetComponentHeaders<RasterComponent>();
+    sci::istream byteStream;
+    if (!resource.TryGetDeferredStream(byteStream))
+    {
+        // Already fully read (or we fell back to a default resource), so the bits are right there.
+        cel = resource.GetComponent<RasterComponent>().GetCel(celIndex);
+        return;
+    }
+
+    const Loop &loop = headers.Loops[celIndex.loop];
+    cel = loop.Cels[celIndex.cel];
+    if (!cel.Data.empty())
+    {
+        // The degenerate cels we make up for empty loops are complete already.
+        return;
+    }
+
+    // Mirrored loops have no data of their own.
+    int nLoopData = loop.IsMirror ? loop.MirrorOf : celIndex.loop;
+    Cel celData = headers.Loops[nLoopData].Cels[celIndex.cel];
+    byteStream.setThrowExceptions(true);
+    if ((&resource.Traits == &viewTraitsVGA11) || (&resource.Traits == &viewTraitsVGA2))
+    {
+        ViewHeader_VGA11 header;
+        byteStream >> header;
+        header.headerSize += 2;
+        byteStream.seekg(header.headerSize + (header.loopHeaderSize * nLoopData));
+        LoopHeader_VGA11 loopHeader;
+        byteStream >> loopHeader;
+        byteStream.seekg(loopHeader.celOffsetAbsolute + header.celHeaderSize * celIndex.cel);
+        ReadCelFromVGA11(byteStream, celData, false);
+    }
+    else
+    {
+        // Loop offsets start after the loop count, mirror mask, version and palette offset words. Then
+        // each loop has its cel count and an unknown word before the cel offsets.
+        uint16_t loopOffset;
+        byteStream.seekg(8 + 2 * nLoopData);
+        byteStream >> loopOffset;
+        uint16_t celOffset;
+        byteStream.seekg(loopOffset + 4 + 2 * celIndex.cel);
+        byteStream >> celOffset;
+        byteStream.seekg(celOffset);
+        ReadCelFrom(resource, headers, byteStream, celData, (&resource.Traits == &viewTraitsVGA), false);
+    }
+
+    if (loop.IsMirror)
+    {
+        SyncCelMirrorState(cel, celData);
+    }
+    else
+    {
+        cel = celData;
+    }
+}
+
 ResourceEntity *CreateDefaultViewResource(SCIVersion version)
 {
     std::unique_ptr<ResourceEntity> pResource(CreateViewResource(version));
@@ -20,9 +20,18 @@ class ResourceEntity;
 // rawDataStream is used if the image bits are stored separately from the RLE encoding opcodes.
 void ReadImageData(sci::istream &byteStream, Cel &cel, bool isVGA);
 void ReadImageData(sci::istream &byteStreamRLE, Cel &cel, bool isVGA, sci::istream &byteStreamLiteral);
+//
+// Encoding looks for runs of pixels 16 at a time with SSE2 where it can. The plain version can
+// still be asked for, so that the two can be compared.
+//
+enum class RLEScan
+{
+    Vectorized,
+    Scalar,
+};
 void WriteImageData(sci::ostream &byteStream, const Cel &cel, bool isVGA, bool isEmbeddedView);
-void WriteImageData(sci::ostream &rleStream, const Cel &cel, bool isVGA, sci::ostream &literalStream, bool writeZero);
-void ReadCelFromVGA11(sci::istream &byteStream, Cel &cel, bool isPic);
+void WriteImageData(sci::ostream &rleStream, const Cel &cel, bool isVGA, sci::ostream &literalStream, bool writeZero, RLEScan scan = RLEScan::Vectorized);
+void ReadCelFromVGA11(sci::istream &byteStream, Cel &cel, bool isPic, bool headersOnly = false);
 
 extern uint8_t g_vgaPaletteMapping[256];
 
@@ -39,6 +48,8 @@ struct Cel
     Cel() : Stride32(true) {}
     Cel(const Cel &cel) = default;
     Cel &operator=(const Cel &cel) = default;
+    Cel(Cel &&cel) = default;
+    Cel &operator=(Cel &&cel) = default;
 
     uint16_t GetStride() const { return Stride32 ? CX_ACTUAL(size.cx) : size.cx; }
     size_t GetDataSize() const
@@ -46,10 +57,10 @@ struct Cel
         return (GetStride() * size.cy);
     }
 
-    // REVIEW: std::vector is 16 bytes. We could change this to 4 bytes if we wish
-    // (thus reducing size of a cel from 24 to 12?) 
-    // But we'd need to write a manual copy/assignment constructor.
-    sci::array<uint8_t> Data;
+    // Copies of a cel (and so of loops, and of whole resources cloned for undo) share
+    // their bits until one of them is modified. Read through a const Cel where possible,
+    // since non-const access to Data makes the bits private to this cel.
+    sci::cow_array<uint8_t> Data;
     size16 size;
     point16 placement;
     uint8_t TransparentColor;
@@ -208,3 +219,7 @@ struct CelHeader_VGA11
 
 ResourceEntity *CreateViewResource(SCIVersion version);
 ResourceEntity *CreateDefaultViewResource(SCIVersion version);
+// Decodes the bits of just one cel of a view, for when only its headers have been read (see
+// ResourceEntity::TryGetComponentHeaders). Much cheaper than reading the whole view when only
+// one cel is shown.
+void ReadCelImageData(const ResourceEntity &resource, CelIndex celIndex, Cel &cel);
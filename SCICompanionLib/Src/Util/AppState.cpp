@@ -57,6 +57,7 @@
 #include "SyntaxParser.h"
 #include "ImageUtil.h"
 #include "DependencyTracker.h"
+#include "ThumbnailCache.h"
 
 // The one and only
 extern AppState *appState;
@@ -77,11 +78,15 @@ void CMultiDocTemplateWithNonViews::InitialUpdateFrame(CFrameWnd *pFrame, CDocum
     __super::InitialUpdateFrame(pFrame, pDoc, bMakeVisible);
 }
 
+// Enough for about a thousand pic thumbnails.
+const size_t ThumbnailCacheMemoryBytes = 64 * 1024 * 1024;
+
 AppState::AppState(CWinApp *pApp) : _resourceMap(this, &_resourceRecency)
 {
     _dependencyTracker = std::make_unique<DependencyTracker>(_fTrackHeaderFiles);
     // This is a pointer because we don't want a dependency on it in the header file.
     _classBrowser = std::make_unique<SCIClassBrowser>(*_dependencyTracker);
+    _thumbnailCache = std::make_unique<ThumbnailCache>(ThumbnailCacheMemoryBytes);
 
     _pApp = pApp;
     _audioProcessing = std::make_unique<AudioProcessingSettings>();
@@ -192,6 +197,10 @@ SCIClassBrowser &AppState::GetClassBrowser()
 {
     return *_classBrowser;
 }
+ThumbnailCache &AppState::GetThumbnailCache()
+{
+    return *_thumbnailCache;
+}
 
 int AppState::AspectRatioY(int value) const
 {
@@ -754,6 +763,7 @@ void AppState::OnGameFolderUpdate()
         _hProcessDebugged.Close();
         _recentViews.clear();
     }
+    _thumbnailCache->SetFolder(_resourceMap.Helper().GetThumbnailFolder());
 }
 
 HRESULT AppState::_GetGameStringProperty(PCTSTR pszProp, PTSTR pszValue, size_t cchValue)
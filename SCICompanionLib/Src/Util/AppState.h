@@ -37,6 +37,7 @@ class CResourceListDoc;
 class AppState;
 class SCIClassBrowser;
 class DependencyTracker;
+class ThumbnailCache;
 struct AudioProcessingSettings;
 
 template<typename _TPayload, typename _TResponse>
@@ -132,6 +133,7 @@ public:
 
     DependencyTracker &GetDependencyTracker();
     SCIClassBrowser &GetClassBrowser();
+    ThumbnailCache &GetThumbnailCache();
 
     // Game properties
     std::string GetGameName();
@@ -254,6 +256,7 @@ public: // TODO for now
 
     std::unique_ptr<DependencyTracker> _dependencyTracker;
     std::unique_ptr<SCIClassBrowser> _classBrowser;
+    std::unique_ptr<ThumbnailCache> _thumbnailCache;
 };
 
 extern AppState *appState;
\ No newline at end of file
@@ -24,6 +24,14 @@ public:
     size_t GetSize() { return _size; }
 
     uint8_t *AllocateBuffer()
+    {
+        uint8_t *buffer = TryAllocateBuffer();
+        assert(buffer && "Requesting more buffers than indicated.");
+        return buffer;
+    }
+
+    // Returns nullptr if all buffers are in use.
+    uint8_t *TryAllocateBuffer()
     {
         for (size_t i = 0; i < ARRAYSIZE(_buffers); i++)
         {
@@ -37,7 +45,6 @@ public:
                 return _buffers[i].get();
             }
         } 
-        assert(false && "Requesting more buffers than indicated.");
         return nullptr;
     }
 
@@ -28,6 +28,8 @@
 #include "CrystalScriptStream.h"
 #include "ResourceBlob.h"
 #include "DependencyTracker.h"
+#include "HeaderCache.h"
+#include "IncrementalParse.h"
 
 using namespace sci;
 using namespace std;
@@ -46,6 +48,9 @@ struct ReloadScriptPayload
     std::string ScriptPath;
 };
 
+// A longer autocomplete list isn't any more useful, and just slows down typing.
+const size_t MaxAutoCompleteChoices = 1000;
+
 
 //
 // helper that looks up a pointer in a map (e.g. like you use the operator[] for, but it doesn't create
@@ -184,6 +189,7 @@ void SCIClassBrowser::ExitSchedulerAndReset()
     _wLKG = 65535; // out of bounds
 
     _scripts.clear();
+    _parseStates.clear();
 
     // Delete all header scripts.
     _headerMap.clear();
@@ -205,6 +211,10 @@ void SCIClassBrowser::ExitSchedulerAndReset()
 
     _customHeaderMap.clear();
 
+    // The autocomplete tokens all came from the game we're leaving. They're regenerated when it's reloaded.
+    _aclist.Clear();
+    _invalidAutoCompleteSources = AutoCompleteSourceType::None;
+
     // Make a new one.
     _scheduler = std::make_unique<BackgroundScheduler<ReloadScriptPayload>>();
 }
@@ -326,7 +336,8 @@ void SCIClassBrowser::_AddToClassTree(Script& script)
         }
     }
 
-    _invalidAutoCompleteSources = AutoCompleteSourceType::ScriptName | AutoCompleteSourceType::ClassName | AutoCompleteSourceType::Procedure;
+    // Main's globals are offered too, so they may have changed.
+    _invalidAutoCompleteSources |= AutoCompleteSourceType::ScriptName | AutoCompleteSourceType::ClassName | AutoCompleteSourceType::Procedure | AutoCompleteSourceType::Variable;
 }
 
 bool SCIClassBrowser::ReLoadFromSources(ITaskStatus &task)
@@ -337,6 +348,7 @@ bool SCIClassBrowser::ReLoadFromSources(ITaskStatus &task)
         // Load the kernel and selector names
         _kernelNamesResource.Load(appState->GetResourceMap().Helper());
         _selectorNames.Load(appState->GetResourceMap().Helper());
+        _invalidAutoCompleteSources |= AutoCompleteSourceType::Kernel | AutoCompleteSourceType::Selector;
 
         // Add headers first, since they have defines that are needed by the other scripts.
         _AddHeaders();
@@ -643,6 +655,7 @@ void SCIClassBrowser::ReloadScript(const std::string &fullPath)
     {
         // It's a header file
         _AddHeader(fullPath.c_str());
+        appState->GetResourceMap().GetHeaderCache().Save();
         // Regenerate the defines cache
         _CacheHeaderDefines();
     }
@@ -753,8 +766,18 @@ bool SCIClassBrowser::_AddFileName(std::string fullPath, bool fReplace)
 
         CScriptStreamLimiter limiter(&buffer);
         CCrystalScriptStream stream(&limiter);
+        std::unique_ptr<IncrementalParseState> &parseState = _parseStates[fullPathLower];
+        bool fIncremental = fReplace && parseState && _ReparseIncrementally(fullPathLower, stream, *parseState);
+        if (!parseState)
+        {
+            parseState = std::make_unique<IncrementalParseState>();
+        }
         std::unique_ptr<Script> pScript = std::make_unique<Script>(fullPath.c_str());
-        if (SyntaxParser_Parse(*pScript, stream, PreProcessorDefinesFromSCIVersion(appState->GetVersion()), this))
+        if (fIncremental)
+        {
+            fRet = true;
+        }
+        else if (SyntaxParser_Parse(*pScript, stream, PreProcessorDefinesFromSCIVersion(appState->GetVersion()), this, false, nullptr, false, parseState.get()))
         {
             Script *pWeakRef = pScript.get();
 
@@ -807,6 +830,34 @@ bool SCIClassBrowser::_AddFileName(std::string fullPath, bool fReplace)
     return fRet;
 }
 
+//
+// Re-parses the script we already have for this file, keeping the parts of it that weren't edited.
+//
+bool SCIClassBrowser::_ReparseIncrementally(const std::string &fullPathLower, CCrystalScriptStream &stream, IncrementalParseState &parseState)
+{
+    auto numberIt = _filenameToScriptNumber.find(fullPathLower);
+    if ((numberIt != _filenameToScriptNumber.end()) && (numberIt->second != InvalidResourceNumber))
+    {
+        for (auto &script : _scripts)
+        {
+            if (GetScriptNumberHelper(script.get()) == numberIt->second)
+            {
+                _RemoveAllRelatedData(script.get());
+                bool success = SyntaxParser_ParseIncremental(*script, parseState, stream, PreProcessorDefinesFromSCIVersion(appState->GetVersion()), this);
+                if (success)
+                {
+                    _filenameToScriptNumber[fullPathLower] = GetScriptNumberHelper(script.get());
+                    _dependencyTracker.ProcessScript(*script);
+                }
+                // If it failed, the script is unchanged. Add it back in case the full parse fails too.
+                _AddToClassTree(*script);
+                return success;
+            }
+        }
+    }
+    return false;
+}
+
 void SCIClassBrowser::_AssertScriptsValid()
 {
     for (auto &script : _scripts)
@@ -817,67 +868,91 @@ void SCIClassBrowser::_AssertScriptsValid()
 
 void SCIClassBrowser::_MaybeGenerateAutoCompleteTree()
 {
-    if (_invalidAutoCompleteSources != AutoCompleteSourceType::None)
+    // Only the kinds of things that changed are updated, and the token database only applies the differences.
+    // Reloading a script generally just affects script, class and procedure names.
+    AutoCompleteSourceType invalid = _invalidAutoCompleteSources;
+    if (invalid != AutoCompleteSourceType::None)
     {
-        CPrecisionTimer timer;
-        timer.Start();
-
-        // Also use this time to update our syntax highlighting things.
-        unordered_set<string> procsSyntaxHighlight;
-        unordered_set<string> classesSyntaxHighlight;
-
-        // REVIEW: If we find this takes too long, we can split things into different _acLists that are updated at different freqs
-        std::vector<ACTreeLeaf> items;
-        items.reserve(4000);
-        for (auto &aDefine : _headerDefines)
+        std::vector<std::string> tokens;
+        if (IsFlagSet(invalid, AutoCompleteSourceType::Define))
         {
             // Standard defines in the system and game header files.
-            items.emplace_back(AutoCompleteSourceType::Define, aDefine.first);
-            //AddToTernaryList(items, aDefine.first, AutoCompleteSourceType::Define);
+            for (auto &aDefine : _headerDefines)
+            {
+                tokens.push_back(aDefine.first);
+            }
+            _aclist.SetTokens(AutoCompleteSourceType::Define, move(tokens));
         }
-        for (auto &aClass : _classMap)
+        if (IsFlagSet(invalid, AutoCompleteSourceType::ClassName))
         {
-            // Updated when new classes created (rare)
-            items.emplace_back(AutoCompleteSourceType::ClassName, aClass.first);
-            classesSyntaxHighlight.insert(aClass.first);
+            tokens.clear();
+            for (auto &aClass : _classMap)
+            {
+                tokens.push_back(aClass.first);
+            }
+            _aclist.SetTokens(AutoCompleteSourceType::ClassName, move(tokens));
         }
-        for (auto &selector : _selectorNames.GetNames())
+        if (IsFlagSet(invalid, AutoCompleteSourceType::Selector))
         {
-            // Updated only when new selectors are created (rare)
-            items.emplace_back(AutoCompleteSourceType::Selector, selector);
+            _aclist.SetTokens(AutoCompleteSourceType::Selector, _selectorNames.GetNames());
         }
-        for (auto &kernelNames : _kernelNamesResource.GetNames())
+        if (IsFlagSet(invalid, AutoCompleteSourceType::Kernel))
         {
-            items.emplace_back(AutoCompleteSourceType::Kernel, kernelNames);
-            procsSyntaxHighlight.insert(kernelNames);
+            _aclist.SetTokens(AutoCompleteSourceType::Kernel, _kernelNamesResource.GetNames());
         }
-        for (auto &publicProc : _GetPublicProcedures())
+        if (IsFlagSet(invalid, AutoCompleteSourceType::Procedure))
         {
-            items.emplace_back(AutoCompleteSourceType::Procedure, publicProc->GetName());
-            procsSyntaxHighlight.insert(publicProc->GetName());
+            tokens.clear();
+            for (auto &publicProc : _GetPublicProcedures())
+            {
+                tokens.push_back(publicProc->GetName());
+            }
+            _aclist.SetTokens(AutoCompleteSourceType::Procedure, move(tokens));
         }
-        for (auto &script : _scripts)
+        if (IsFlagSet(invalid, AutoCompleteSourceType::ScriptName))
         {
-            items.emplace_back(AutoCompleteSourceType::ScriptName, script->GetTitle());
+            tokens.clear();
+            for (auto &script : _scripts)
+            {
+                tokens.push_back(script->GetTitle());
+            }
+            _aclist.SetTokens(AutoCompleteSourceType::ScriptName, move(tokens));
         }
-
-        // Now some global variables
-        const VariableDeclVector *globals = _GetMainGlobals();
-        if (globals)
+        if (IsFlagSet(invalid, AutoCompleteSourceType::Variable))
         {
-            for (const auto &global : *globals)
+            // Main's global variables
+            tokens.clear();
+            const VariableDeclVector *globals = _GetMainGlobals();
+            if (globals)
             {
-                items.emplace_back(AutoCompleteSourceType::Variable, global->GetName());
+                for (const auto &global : *globals)
+                {
+                    tokens.push_back(global->GetName());
+                }
             }
+            _aclist.SetTokens(AutoCompleteSourceType::Variable, move(tokens));
         }
 
-        std::multiset<ACTreeLeaf> itemsSorted;
-        std::copy(items.begin(), items.end(), std::inserter(itemsSorted, itemsSorted.begin()));
-        _aclist.BuildDatabase(itemsSorted);
-
         _invalidAutoCompleteSources = AutoCompleteSourceType::None;
 
+        // Also use this time to update our syntax highlighting things.
+        if (IsFlagSet(invalid, AutoCompleteSourceType::ClassName | AutoCompleteSourceType::Kernel | AutoCompleteSourceType::Procedure))
         {
+            unordered_set<string> procsSyntaxHighlight;
+            unordered_set<string> classesSyntaxHighlight;
+            for (auto &aClass : _classMap)
+            {
+                classesSyntaxHighlight.insert(aClass.first);
+            }
+            for (auto &kernelName : _kernelNamesResource.GetNames())
+            {
+                procsSyntaxHighlight.insert(kernelName);
+            }
+            for (auto &publicProc : _GetPublicProcedures())
+            {
+                procsSyntaxHighlight.insert(publicProc->GetName());
+            }
+
             std::lock_guard<std::mutex> lock(_mutexSyntaxHighlight);
             std::swap(procsSyntaxHighlight, _procsSyntaxHighlight);
             std::swap(classesSyntaxHighlight, _classesSyntaxHighlight);
@@ -902,7 +977,7 @@ void SCIClassBrowser::GetAutoCompleteChoices(const std::string &prefixIn, AutoCo
     std::lock_guard<std::recursive_mutex> lock(_mutexClassBrowser);
     std::string prefixLower = prefixIn;
     std::transform(prefixLower.begin(), prefixLower.end(), prefixLower.begin(), ::tolower);
-    _aclist.GetAutoCompleteChoices(prefixLower, sourceTypes, choices);
+    _aclist.GetAutoCompleteChoices(prefixLower, sourceTypes, choices, MaxAutoCompleteChoices);
 }
 
 SCIClassBrowser::TimeAndHeader::TimeAndHeader() {}
@@ -955,27 +1030,21 @@ void SCIClassBrowser::TriggerCustomIncludeCompile(std::string name)
                 if (needRecompile)
                 {
                     // Time-stamp is different, or we haven't yet compiled this file
-                    // It's a header we have not yet encountered. Parse it.
-                    ScriptId scriptId(path);
-
-                    CCrystalTextBuffer buffer;
-                    if (buffer.LoadFromFile(scriptId.GetFullPath().c_str()))
+                    // It's a header we have not yet encountered. Parse it (or get it from the cache).
+                    unique_ptr<Script> pNewHeader;
+                    HeaderCache &headerCache = appState->GetResourceMap().GetHeaderCache();
+                    if (headerCache.Load(path, appState->GetVersion(), nullptr, pNewHeader) && pNewHeader)
                     {
-                        CScriptStreamLimiter limiter(&buffer);
-                        CCrystalScriptStream stream(&limiter);
-                        unique_ptr<Script> pNewHeader = std::make_unique<Script>(scriptId);
-                        if (SyntaxParser_Parse(*pNewHeader, stream, PreProcessorDefinesFromSCIVersion(appState->GetVersion()), nullptr))
-                        {
-                            // For performance, let's pre-sort the defines.
-                            std::sort(pNewHeader->GetDefines().begin(), pNewHeader->GetDefines().end(), 
-                                [](std::unique_ptr<sci::Define> &one, std::unique_ptr<sci::Define> &two) { return one->GetName() < two->GetName(); }
-                                );
-
-                            std::lock_guard<std::recursive_mutex> lock(_mutexClassBrowser);
-                            TimeAndHeader th { lastWriteTime, move(pNewHeader) };
-                            _customHeaderMap[name] = move(th);
-                        }
-                        buffer.FreeAll();
+                        headerCache.Save();
+
+                        // For performance, let's pre-sort the defines.
+                        std::sort(pNewHeader->GetDefines().begin(), pNewHeader->GetDefines().end(), 
+                            [](std::unique_ptr<sci::Define> &one, std::unique_ptr<sci::Define> &two) { return one->GetName() < two->GetName(); }
+                            );
+
+                        std::lock_guard<std::recursive_mutex> lock(_mutexClassBrowser);
+                        TimeAndHeader th { lastWriteTime, move(pNewHeader) };
+                        _customHeaderMap[name] = move(th);
                     }
                 }
             }
@@ -1056,27 +1125,10 @@ void SCIClassBrowser::_CacheHeaderDefines()
     _invalidAutoCompleteSources |= AutoCompleteSourceType::Define;
 }
 
-std::unique_ptr<sci::Script> SCIClassBrowser::_LoadScript(PCTSTR pszPath)
-{
-    unique_ptr<Script> pScript;
-    CCrystalTextBuffer buffer;
-    if (buffer.LoadFromFile(pszPath))
-    {
-        CScriptStreamLimiter limiter(&buffer);
-        CCrystalScriptStream stream(&limiter);
-        std::unique_ptr<Script> pScriptT = std::make_unique<Script>(pszPath);
-        if (SyntaxParser_Parse(*pScriptT, stream, PreProcessorDefinesFromSCIVersion(appState->GetVersion()), this))
-        {
-            pScript = move(pScriptT);
-        }
-        buffer.FreeAll(); // REVIEW: not exception safe.
-    }
-    return pScript;
-}
-
 void SCIClassBrowser::_AddHeader(PCTSTR pszHeaderPath)
 {
-    unique_ptr<Script> pScript = _LoadScript(pszHeaderPath);
+    unique_ptr<Script> pScript;
+    appState->GetResourceMap().GetHeaderCache().Load(pszHeaderPath, appState->GetVersion(), this, pScript);
     if (pScript)
     {
         _headerMap[pszHeaderPath] = move(pScript);
@@ -1122,6 +1174,8 @@ void SCIClassBrowser::_AddHeaders()
 
     // Make all the header defines accessible in a classMap.
     _CacheHeaderDefines();
+
+    appState->GetResourceMap().GetHeaderCache().Save();
 }
 
 //
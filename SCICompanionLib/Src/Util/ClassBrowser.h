@@ -24,6 +24,8 @@ class ISCIPropertyBag;
 class AutoCompleteChoice;
 
 struct ReloadScriptPayload;
+class IncrementalParseState;
+class CCrystalScriptStream;
 
 class ITaskStatus;
 enum class AutoCompleteSourceType;
@@ -102,7 +104,6 @@ public:
     bool GetPropertyValue(PCTSTR pszName, ISCIPropertyBag *pBag, const sci::ClassDefinition *pClass, WORD *pw);
     void GetAutoCompleteChoices(const std::string &prefix, AutoCompleteSourceType sourceTypes, std::vector<AutoCompleteChoice> &choices);
     const sci::ClassDefinition *LookUpClass(const std::string &className) const;
-    std::unique_ptr<sci::Script> _LoadScript(PCTSTR pszPath);
     
     void TriggerCustomIncludeCompile(std::string name);
     sci::Script *GetCustomHeader(std::string name);
@@ -141,6 +142,7 @@ private:
     bool _CreateClassTree(ITaskStatus &task);
     void _AddToClassTree(sci::Script& script);
     bool _AddFileName(std::string fullPath, bool fReplace = false);
+    bool _ReparseIncrementally(const std::string &fullPathLower, CCrystalScriptStream &stream, IncrementalParseState &parseState);
     void _RemoveAllRelatedData(sci::Script *pScript);
     void _AddHeaders();
     void _AddHeader(PCTSTR pszHeaderPath);
@@ -179,6 +181,9 @@ private:
     // This maps filenames to scriptnumbers.
     word_map _filenameToScriptNumber;
 
+    // What's needed to re-parse each script incrementally when it's saved, keyed by lower-case filename.
+    std::unordered_map<std::string, std::unique_ptr<IncrementalParseState>> _parseStates;
+
     struct TimeAndHeader
     {
         TimeAndHeader();
@@ -51,10 +51,12 @@ void MergeResults(std::vector<AutoCompleteChoice> &existingResults, const std::s
     for (auto &item : items)
     {
         std::string name = nameFunc(item);
-        std::string lower = name;
-        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-        if (0 == lower.compare(0, prefixLower.size(), prefixLower))
+        // Only bother making a lower-case copy of the ones that match.
+        if ((name.size() >= prefixLower.size()) &&
+            std::equal(prefixLower.begin(), prefixLower.end(), name.begin(), [](char prefixChar, char nameChar) { return prefixChar == (char)::tolower(nameChar); }))
         {
+            std::string lower = name;
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
             newResults.emplace_back(name, lower, icon);
         }
     }
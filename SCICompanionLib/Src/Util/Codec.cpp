@@ -302,6 +302,91 @@ int decompressLZW(BYTE *dest, BYTE *src, int length, int complength)
 
 }
 
+//
+// The inverse of decompressLZW. The token bookkeeping here has to mirror what the decompressor does exactly:
+// a new token is registered after every token (except reset), and the bit length grows just before
+// registering a token that doesn't fit.
+//
+bool compressLZW(const byte *src, uint32_t length, std::vector<byte> &dest)
+{
+    // decompressLZW tracks positions with 16 bit counters.
+    if (length > 0xffff)
+    {
+        return false;
+    }
+
+    dest.clear();
+    uint32_t bitBuffer = 0;
+    int bitCount = 0;
+    WORD bitlen = 9;
+    auto writeToken = [&](WORD token)
+    {
+        bitBuffer |= ((uint32_t)token) << bitCount;
+        bitCount += bitlen;
+        while (bitCount >= 8)
+        {
+            dest.push_back((byte)bitBuffer);
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    };
+
+    // Maps (token << 8 | next byte) to the token that represents that string.
+    std::unordered_map<uint32_t, WORD> tokens;
+    WORD maxtoken = 0x200;
+    WORD tokenctr = 0x102;
+    if (length > 0)
+    {
+        WORD current = src[0];
+        for (uint32_t i = 1; i < length; i++)
+        {
+            uint32_t key = (((uint32_t)current) << 8) | src[i];
+            auto it = tokens.find(key);
+            if (it != tokens.end())
+            {
+                current = it->second;
+                continue;
+            }
+
+            writeToken(current);
+            if (tokenctr == maxtoken)
+            {
+                if (bitlen < 12)
+                {
+                    bitlen++;
+                    maxtoken <<= 1;
+                }
+                else
+                {
+                    // The table is full. Rather than continue with a stale table, start over.
+                    writeToken(0x100);
+                    tokens.clear();
+                    bitlen = 9;
+                    maxtoken = 0x200;
+                    tokenctr = 0x102;
+                    current = src[i];
+                    continue;
+                }
+            }
+            tokens[key] = tokenctr++;
+            current = src[i];
+        }
+        writeToken(current);
+        // The decompressor does its bookkeeping for the last token before reading the terminator.
+        if ((tokenctr == maxtoken) && (bitlen < 12))
+        {
+            bitlen++;
+        }
+    }
+    writeToken(0x101);
+    if (bitCount > 0)
+    {
+        dest.push_back((byte)bitBuffer);
+    }
+    // Same for the compressed size (incompressible data can end up larger than it started).
+    return dest.size() < 0xffff;
+}
+
 
 
 
@@ -18,6 +18,15 @@ int decompressHuffman(BYTE* dest, BYTE* src, int length, int complength);
 int decompressLZW_1(BYTE *dest, BYTE *src, int length, int complength);
 int decompressLZW(BYTE *dest, BYTE *src, int length, int complength);
 bool decompressDCL(byte *dest, byte *src, uint32_t unpackedSize, uint32_t packedSize);
+// Bit-at-a-time DCL decoder. decompressDCL is a table-driven equivalent; this is kept as a reference.
+bool decompressDCLBitwise(byte *dest, byte *src, uint32_t unpackedSize, uint32_t packedSize);
+// Decodes up to the end-of-stream code instead of stopping at a known size, which is how Sierra's
+// interpreters read DCL resources. Fails if there's no end code within maxUnpackedSize bytes.
+bool decompressDCLUntilEndMarker(byte *dest, const byte *src, uint32_t maxUnpackedSize, uint32_t packedSize, uint32_t &unpackedSize);
+
+// Encoders. These produce data that decompressLZW and decompressDCL (respectively) can read.
+bool compressLZW(const byte *src, uint32_t length, std::vector<byte> &dest);
+bool compressDCL(const byte *src, uint32_t size, std::vector<byte> &dest);
 bool decompressLZS(byte *dest, byte *src, uint32_t unpackedSize, uint32_t packedSize);
 int decrypt4(byte* dest, byte* src, int length, int complength);
 
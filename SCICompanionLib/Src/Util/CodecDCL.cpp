@@ -312,9 +312,452 @@ bool DecompressorDCL::unpack(ReadStream *src, byte *dest, uint32_t nPacked, uint
     return _dwWrote == _szUnpacked;
 }
 
-bool decompressDCL(byte *dest, byte *src, uint32_t unpackedSize, uint32_t packedSize)
+bool decompressDCLBitwise(byte *dest, byte *src, uint32_t unpackedSize, uint32_t packedSize)
 {
     ReadStream readStream(src);
     DecompressorDCL dcl;
     return dcl.unpack(&readStream, dest, packedSize, unpackedSize);
 }
+
+//
+// Table-driven DCL decoder.
+//
+// The reference decoder above walks the huffman trees one bit at a time. Here we flatten each tree
+// into a lookup table indexed by the next maxBits bits of input (LSB first, like the bitstream), so
+// each code is resolved with a single peek. Bits come from a 64-bit buffer, so refills are rare.
+//
+class DCLHuffmanTable
+{
+public:
+    DCLHuffmanTable(const int *tree) : _maxBits(0)
+    {
+        _MeasureDepth(tree, 0, 0);
+        _values.resize((size_t)1 << _maxBits);
+        _lengths.resize((size_t)1 << _maxBits);
+        _Fill(tree, 0, 0, 0);
+    }
+
+    int GetMaxBits() const { return _maxBits; }
+
+    // Returns the decoded value for the peeked bits, and the number of bits the code actually used.
+    uint16_t Lookup(uint32_t bits, int &codeLength) const
+    {
+        codeLength = _lengths[bits];
+        return _values[bits];
+    }
+
+private:
+    void _MeasureDepth(const int *tree, int pos, int depth)
+    {
+        if (tree[pos] & HUFFMAN_LEAF)
+        {
+            _maxBits = max(_maxBits, depth);
+        }
+        else
+        {
+            _MeasureDepth(tree, tree[pos] >> 12, depth + 1);
+            _MeasureDepth(tree, tree[pos] & 0xFFF, depth + 1);
+        }
+    }
+
+    void _Fill(const int *tree, int pos, int depth, uint32_t code)
+    {
+        if (tree[pos] & HUFFMAN_LEAF)
+        {
+            // Every index whose low "depth" bits match this code resolves to this leaf.
+            for (uint32_t index = code; index < _values.size(); index += (1 << depth))
+            {
+                _values[index] = (uint16_t)(tree[pos] & 0xFFFF);
+                _lengths[index] = (uint8_t)depth;
+            }
+        }
+        else
+        {
+            _Fill(tree, tree[pos] >> 12, depth + 1, code);
+            _Fill(tree, tree[pos] & 0xFFF, depth + 1, code | (1 << depth));
+        }
+    }
+
+    int _maxBits;
+    std::vector<uint16_t> _values;
+    std::vector<uint8_t> _lengths;
+};
+
+class DCLBitReader
+{
+public:
+    DCLBitReader(const byte *src, uint32_t packedSize) : _src(src), _end(src + packedSize), _bits(0), _bitCount(0) {}
+
+    // Makes sure at least 56 bits are buffered. Input past the end of the packed data reads as zeroes.
+    void Refill()
+    {
+        if ((_end - _src) >= 8)
+        {
+            // Load 8 bytes at once, and only advance past the ones that fully fit in the buffer.
+            uint64_t next;
+            memcpy(&next, _src, sizeof(next));
+            _bits |= next << _bitCount;
+            _src += (63 - _bitCount) >> 3;
+            _bitCount |= 56;
+            return;
+        }
+        while (_bitCount <= 56)
+        {
+            uint64_t b = (_src < _end) ? *_src++ : 0;
+            _bits |= b << _bitCount;
+            _bitCount += 8;
+        }
+    }
+
+    uint32_t Peek(int n)
+    {
+        if (_bitCount < n)
+        {
+            Refill();
+        }
+        return (uint32_t)(_bits & ((1ull << n) - 1));
+    }
+
+    void Consume(int n)
+    {
+        _bits >>= n;
+        _bitCount -= n;
+    }
+
+    uint32_t Get(int n)
+    {
+        uint32_t value = Peek(n);
+        Consume(n);
+        return value;
+    }
+
+    int Decode(const DCLHuffmanTable &table)
+    {
+        int codeLength;
+        int value = table.Lookup(Peek(table.GetMaxBits()), codeLength);
+        Consume(codeLength);
+        return value;
+    }
+
+private:
+    const byte *_src;
+    const byte *_end;
+    uint64_t _bits;
+    int _bitCount;
+};
+
+// Length that marks the end of the stream in PKWARE's format.
+const uint32_t DCLEndOfStreamLength = 519;
+
+// If stopAtEndMarker is false this stops after unpackedSize bytes, like ScummVM does. Otherwise it keeps
+// going (up to unpackedSize bytes) until it reads the end-of-stream code, like Sierra's interpreters do.
+bool _DecompressDCL(byte *dest, const byte *src, uint32_t unpackedSize, uint32_t packedSize, bool stopAtEndMarker, uint32_t &written)
+{
+    static const DCLHuffmanTable lengthTable(length_tree);
+    static const DCLHuffmanTable distanceTable(distance_tree);
+    static const DCLHuffmanTable asciiTable(ascii_tree);
+
+    DCLBitReader reader(src, packedSize);
+    int mode = reader.Get(8);
+    int length_param = reader.Get(8);
+
+    if (mode != DCL_BINARY_MODE && mode != DCL_ASCII_MODE) {
+        appState->LogInfo("DCL-INFLATE: Error: Encountered mode %02x, expected 00 or 01", mode);
+        return false;
+    }
+
+    if (length_param < 3 || length_param > 6)
+    {
+        appState->LogInfo("Unexpected length_param value %d (expected in [3,6])", length_param);
+        if (length_param > 32)
+        {
+            // The distance would be wider than the reference decoder can represent.
+            return false;
+        }
+    }
+
+    written = 0;
+    while (stopAtEndMarker || (written < unpackedSize))
+    {
+        if (reader.Get(1))
+        {
+            // (length,distance) pair
+            int value = reader.Decode(lengthTable);
+            uint32_t val_length;
+            if (value < 8)
+            {
+                val_length = value + 2;
+            }
+            else
+            {
+                val_length = 8 + (1 << (value - 7)) + reader.Get(value - 7);
+            }
+
+            if (stopAtEndMarker && (val_length == DCLEndOfStreamLength))
+            {
+                return true;
+            }
+
+            value = reader.Decode(distanceTable);
+            uint32_t val_distance;
+            if (val_length == 2)
+            {
+                val_distance = (value << 2) | reader.Get(2);
+            }
+            else
+            {
+                val_distance = (value << length_param) | reader.Get(length_param);
+            }
+            val_distance++;
+
+            if (val_length + written > unpackedSize) {
+                appState->LogInfo("DCL-INFLATE Error: Write out of bounds while copying %d bytes (declared unpacked size is %d bytes, current is %d + %d bytes)",
+                    val_length, unpackedSize, written, val_length);
+                return false;
+            }
+
+            if (written < val_distance) {
+                appState->LogInfo("DCL-INFLATE Error: Attempt to copy from before beginning of input stream (declared unpacked size is %d bytes, current is %d bytes)",
+                    unpackedSize, written);
+                return false;
+            }
+
+            byte *out = dest + written;
+            const byte *from = out - val_distance;
+            if (val_distance >= val_length)
+            {
+                memcpy(out, from, val_length);
+            }
+            else
+            {
+                // Overlapping copy, which repeats the last val_distance bytes.
+                for (uint32_t i = 0; i < val_length; i++)
+                {
+                    out[i] = from[i];
+                }
+            }
+            written += val_length;
+        }
+        else
+        {
+            if (written >= unpackedSize)
+            {
+                // Only when looking for the end marker.
+                appState->LogInfo("DCL-INFLATE Error: No end of stream marker within %d bytes", unpackedSize);
+                return false;
+            }
+            // Copy byte verbatim
+            dest[written++] = (byte)((mode == DCL_ASCII_MODE) ? reader.Decode(asciiTable) : reader.Get(8));
+        }
+    }
+
+    return written == unpackedSize;
+}
+
+bool decompressDCL(byte *dest, byte *src, uint32_t unpackedSize, uint32_t packedSize)
+{
+    uint32_t written;
+    return _DecompressDCL(dest, src, unpackedSize, packedSize, false, written);
+}
+
+bool decompressDCLUntilEndMarker(byte *dest, const byte *src, uint32_t maxUnpackedSize, uint32_t packedSize, uint32_t &unpackedSize)
+{
+    return _DecompressDCL(dest, src, maxUnpackedSize, packedSize, true, unpackedSize);
+}
+
+class DCLBitWriter
+{
+public:
+    DCLBitWriter(std::vector<byte> &dest) : _dest(dest), _bits(0), _bitCount(0)
+    {
+        _dest.clear();
+    }
+
+    void Write(uint32_t value, int count)
+    {
+        _bits |= ((uint64_t)value) << _bitCount;
+        _bitCount += count;
+        while (_bitCount >= 8)
+        {
+            _dest.push_back((byte)_bits);
+            _bits >>= 8;
+            _bitCount -= 8;
+        }
+    }
+
+    void Flush()
+    {
+        if (_bitCount > 0)
+        {
+            _dest.push_back((byte)_bits);
+        }
+        _bits = 0;
+        _bitCount = 0;
+    }
+
+private:
+    std::vector<byte> &_dest;
+    uint64_t _bits;
+    int _bitCount;
+};
+
+//
+// DCL encoder. This only produces binary mode streams with a 4KB dictionary (length_param 6), which
+// is what Sierra's tools used for SCI1.1 resources.
+//
+class DCLHuffmanCodes
+{
+public:
+    DCLHuffmanCodes(const int *tree)
+    {
+        _Walk(tree, 0, 0, 0);
+    }
+
+    void Write(DCLBitWriter &writer, int value) const
+    {
+        const Code &code = _codes[value];
+        writer.Write(code.bits, code.length);
+    }
+
+private:
+    struct Code
+    {
+        uint32_t bits;
+        int length;
+    };
+
+    void _Walk(const int *tree, int pos, int depth, uint32_t code)
+    {
+        if (tree[pos] & HUFFMAN_LEAF)
+        {
+            int value = tree[pos] & 0xFFFF;
+            if ((size_t)value >= _codes.size())
+            {
+                _codes.resize(value + 1);
+            }
+            _codes[value] = { code, depth };
+        }
+        else
+        {
+            _Walk(tree, tree[pos] >> 12, depth + 1, code);
+            _Walk(tree, tree[pos] & 0xFFF, depth + 1, code | (1 << depth));
+        }
+    }
+
+    std::vector<Code> _codes;
+};
+
+const int DCLLengthParam = 6;
+const uint32_t DCLWindowSize = 64 << DCLLengthParam;
+const uint32_t DCLMinMatch = 3;
+const uint32_t DCLMaxMatch = DCLEndOfStreamLength - 1;
+const int DCLHashBits = 13;
+const int DCLMaxChainLength = 128;
+
+uint32_t _DCLHash(const byte *data)
+{
+    uint32_t value = (data[0] << 16) | (data[1] << 8) | data[2];
+    return (value * 2654435761u) >> (32 - DCLHashBits);
+}
+
+bool compressDCL(const byte *src, uint32_t size, std::vector<byte> &dest)
+{
+    static const DCLHuffmanCodes lengthCodes(length_tree);
+    static const DCLHuffmanCodes distanceCodes(distance_tree);
+
+    DCLBitWriter writer(dest);
+    writer.Write(DCL_BINARY_MODE, 8);
+    writer.Write(DCLLengthParam, 8);
+
+    // Hash chains of the positions at which each 3-byte sequence was seen.
+    std::vector<int32_t> head((size_t)1 << DCLHashBits, -1);
+    std::vector<int32_t> previous(size);
+    auto insert = [&](uint32_t position)
+    {
+        if (position + DCLMinMatch <= size)
+        {
+            uint32_t hash = _DCLHash(src + position);
+            previous[position] = head[hash];
+            head[hash] = (int32_t)position;
+        }
+    };
+
+    uint32_t position = 0;
+    while (position < size)
+    {
+        uint32_t bestLength = 0;
+        uint32_t bestDistance = 0;
+        if (position + DCLMinMatch <= size)
+        {
+            uint32_t maxLength = min(DCLMaxMatch, size - position);
+            int32_t candidate = head[_DCLHash(src + position)];
+            for (int chain = 0; (candidate >= 0) && (chain < DCLMaxChainLength); chain++)
+            {
+                uint32_t distance = position - (uint32_t)candidate;
+                if (distance > DCLWindowSize)
+                {
+                    break;
+                }
+                uint32_t length = 0;
+                while ((length < maxLength) && (src[candidate + length] == src[position + length]))
+                {
+                    length++;
+                }
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestDistance = distance;
+                    if (length == maxLength)
+                    {
+                        break;
+                    }
+                }
+                candidate = previous[candidate];
+            }
+        }
+
+        if (bestLength >= DCLMinMatch)
+        {
+            writer.Write(1, 1);
+            if (bestLength < 10)
+            {
+                lengthCodes.Write(writer, bestLength - 2);
+            }
+            else
+            {
+                // Values 8-15 cover ranges starting at 8 + 2^(value - 7), with (value - 7) extra bits.
+                int value = 8;
+                while (bestLength >= (uint32_t)(8 + (2 << (value - 7))))
+                {
+                    value++;
+                }
+                lengthCodes.Write(writer, value);
+                writer.Write(bestLength - (8 + (1 << (value - 7))), value - 7);
+            }
+            distanceCodes.Write(writer, (bestDistance - 1) >> DCLLengthParam);
+            writer.Write((bestDistance - 1) & ((1 << DCLLengthParam) - 1), DCLLengthParam);
+
+            for (uint32_t i = 0; i < bestLength; i++)
+            {
+                insert(position + i);
+            }
+            position += bestLength;
+        }
+        else
+        {
+            writer.Write(0, 1);
+            writer.Write(src[position], 8);
+            insert(position);
+            position++;
+        }
+    }
+
+    // Sierra's interpreters decode until they see the end-of-stream code (rather than stopping at the
+    // unpacked size), so it's required. It's a copy of length 519 (length code 15 with all its extra
+    // bits set), with no distance.
+    writer.Write(1, 1);
+    lengthCodes.Write(writer, 15);
+    writer.Write(0xff, 8);
+    writer.Flush();
+    return true;
+}
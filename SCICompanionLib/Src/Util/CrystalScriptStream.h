@@ -169,6 +169,7 @@ public:
 
     const_iterator begin() { return const_iterator(_pLimiter); }
     const_iterator get_at(LineCol dwPos) { return const_iterator(_pLimiter, dwPos); }
+    CScriptStreamLimiter *GetLimiter() { return _pLimiter; }
 
 private:
     CScriptStreamLimiter *_pLimiter;
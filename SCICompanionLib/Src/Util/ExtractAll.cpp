@@ -52,29 +52,31 @@ void ExtractAllResources(SCIVersion version, const std::string &destinationFolde
 
     int totalCount = 0;
     auto resourceContainer = appState->GetResourceMap().Resources(ResourceTypeFlags::All, ResourceEnumFlags::MostRecentOnly | ResourceEnumFlags::ExcludePatchFiles);
-    for (auto &blob : *resourceContainer)
+    // We only need the types for this, so don't bother loading the resources.
+    for (auto it = resourceContainer->begin(); it != resourceContainer->end(); ++it)
     {
+        ResourceType type = it.GetResourceType();
         if (extractResources)
         {
             totalCount++;
         }
-        if (extractViewImages && (blob->GetType() == ResourceType::View))
+        if (extractViewImages && (type == ResourceType::View))
         {
             totalCount++;
         }
-        if (extractPicImages && (blob->GetType() == ResourceType::Pic))
+        if (extractPicImages && (type == ResourceType::Pic))
         {
             totalCount++;
         }
-        if (disassembleScripts && (blob->GetType() == ResourceType::Pic))
+        if (disassembleScripts && (type == ResourceType::Pic))
         {
             totalCount++;
         }
-        if (extractMessages && (blob->GetType() == ResourceType::Message))
+        if (extractMessages && (type == ResourceType::Message))
         {
             totalCount++;
         }
-        if (generateWavs && (blob->GetType() == ResourceType::Audio))
+        if (generateWavs && (type == ResourceType::Audio))
         {
             totalCount++;
         }
@@ -101,7 +103,9 @@ void ExtractAllResources(SCIVersion version, const std::string &destinationFolde
     // Get it again, because we don't supprot reset.
     resourceContainer = appState->GetResourceMap().Resources(ResourceTypeFlags::All, ResourceEnumFlags::MostRecentOnly | ResourceEnumFlags::ExcludePatchFiles);
     bool keepGoing = true;
-    for (auto &blob : *resourceContainer)
+    // Decompression happens on worker threads, the rest of the work is done here.
+    resourceContainer->ForEachDecompressed(ResourceTypeFlags::All, ResourceEnumOrder::MapOrder,
+        [&](std::unique_ptr<ResourceBlob> blob)
     {
         std::string filename = GetFileNameFor(*blob);
         std::string fullPath = destinationFolder + filename;
@@ -207,7 +211,8 @@ void ExtractAllResources(SCIVersion version, const std::string &destinationFolde
         {
 
         }
-    }
+        return keepGoing;
+    });
 
     // Finally, the sync36 and audio36 resources and the audio maps
     if (keepGoing)
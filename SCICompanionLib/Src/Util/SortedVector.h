@@ -13,12 +13,168 @@
 ***************************************************************************/
 #pragma once
 
-template <class T, class Compare = std::less<T> >
+#include <type_traits>
+
+// A vector of plain values that stores its first few items inline, and only allocates once it grows past that.
+template <class T, size_t InlineCount>
+class small_vector
+{
+    static_assert(std::is_trivially_copyable<T>::value, "small_vector only supports trivially copyable types");
+
+public:
+    typedef T *iterator;
+    typedef const T *const_iterator;
+    typedef T value_type;
+
+    small_vector() : _data(_inline), _size(0), _capacity(InlineCount) {}
+
+    template <class InputIterator>
+    small_vector(InputIterator first, InputIterator last) : small_vector()
+    {
+        while (first != last)
+        {
+            push_back(*first);
+            ++first;
+        }
+    }
+
+    small_vector(const small_vector &src) : small_vector()
+    {
+        _CopyFrom(src);
+    }
+
+    small_vector(small_vector &&src) : small_vector()
+    {
+        _MoveFrom(src);
+    }
+
+    small_vector &operator=(const small_vector &src)
+    {
+        if (this != &src)
+        {
+            _size = 0;
+            _CopyFrom(src);
+        }
+        return *this;
+    }
+
+    small_vector &operator=(small_vector &&src)
+    {
+        if (this != &src)
+        {
+            _Free();
+            _MoveFrom(src);
+        }
+        return *this;
+    }
+
+    ~small_vector()
+    {
+        _Free();
+    }
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + _size; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + _size; }
+    bool empty() const { return _size == 0; }
+    size_t size() const { return _size; }
+
+    void reserve(size_t capacity)
+    {
+        if (capacity > _capacity)
+        {
+            T *newData = new T[capacity];
+            memcpy(newData, _data, _size * sizeof(T));
+            _Free();
+            _data = newData;
+            _capacity = capacity;
+        }
+    }
+
+    void push_back(const T &t)
+    {
+        insert(end(), t);
+    }
+
+    iterator insert(iterator position, const T &t)
+    {
+        size_t index = position - _data;
+        T value = t;    // t may refer to one of our own items
+        if (_size == _capacity)
+        {
+            reserve(_capacity * 2);
+        }
+        memmove(_data + index + 1, _data + index, (_size - index) * sizeof(T));
+        _data[index] = value;
+        _size++;
+        return _data + index;
+    }
+
+    iterator erase(iterator position)
+    {
+        memmove(position, position + 1, (end() - position - 1) * sizeof(T));
+        _size--;
+        return position;
+    }
+
+    void clear() { _size = 0; }
+
+    bool operator==(const small_vector &other) const
+    {
+        return (_size == other._size) && std::equal(begin(), end(), other.begin());
+    }
+
+private:
+    void _CopyFrom(const small_vector &src)
+    {
+        reserve(src._size);
+        memcpy(_data, src._data, src._size * sizeof(T));
+        _size = src._size;
+    }
+
+    // Expects us to be empty and using our inline storage.
+    void _MoveFrom(small_vector &src)
+    {
+        if (src._data == src._inline)
+        {
+            _data = _inline;
+            _capacity = InlineCount;
+            memcpy(_data, src._data, src._size * sizeof(T));
+        }
+        else
+        {
+            _data = src._data;
+            _capacity = src._capacity;
+            src._data = src._inline;
+            src._capacity = InlineCount;
+        }
+        _size = src._size;
+        src._size = 0;
+    }
+
+    void _Free()
+    {
+        if (_data != _inline)
+        {
+            delete[] _data;
+        }
+        _data = _inline;
+        _capacity = InlineCount;
+    }
+
+    T *_data;
+    size_t _size;
+    size_t _capacity;
+    T _inline[InlineCount];
+};
+
+template <class T, class Compare = std::less<T>, class Storage = std::vector<T> >
 struct sorted_vector {
-    std::vector<T> V;
+    Storage V;
     Compare cmp;
-    typedef typename std::vector<T>::iterator iterator;
-    typedef typename std::vector<T>::const_iterator const_iterator;
+    typedef typename Storage::iterator iterator;
+    typedef typename Storage::const_iterator const_iterator;
     iterator begin() { return V.begin(); }
     iterator end() { return V.end(); }
     const_iterator begin() const { return V.begin(); }
@@ -32,8 +188,6 @@ struct sorted_vector {
     sorted_vector(const Compare& c = Compare())
         : V(), cmp(c)
     {
-        // Provides a slight speed up in our scenario
-        V.reserve(20);
     }
 
     template <class InputIterator>
@@ -75,7 +229,7 @@ struct sorted_vector {
     void erase(const T& t)
     {
         iterator i = std::lower_bound(begin(), end(), t, cmp);
-        if (i != end())
+        if (i != end() && !cmp(t, *i))
         {
             V.erase(i);
         }
@@ -88,12 +242,12 @@ struct sorted_vector {
     }
 
 
-    bool operator==(const sorted_vector<T, Compare> &other) const
+    bool operator==(const sorted_vector<T, Compare, Storage> &other) const
     {
         return V == other.V;
     }
 
-    bool operator!=(const sorted_vector<T, Compare> &other) const
+    bool operator!=(const sorted_vector<T, Compare, Storage> &other) const
     {
         return !(*this == other);
     }
@@ -284,6 +284,118 @@ namespace sci
         _T *_data;
         size_t _size;
     };
+
+    // Like array, but copies share the same block until one of them is written to.
+    // Only the non-const accessors (and fill/assign) make a private copy, so anything
+    // that just reads should go through a const reference.
+    template<typename _T>
+    class cow_array
+    {
+    public:
+        cow_array() : _size(0) {}
+        cow_array(size_t size) : cow_array() { _allocateInternal(size); }
+
+        cow_array(const cow_array &src) = default;
+        cow_array &operator=(const cow_array &src) = default;
+
+        // Moving takes the block without touching its reference count, and leaves the source empty.
+        cow_array(cow_array &&src) noexcept : _data(std::move(src._data)), _size(src._size) { src._size = 0; }
+        cow_array &operator=(cow_array &&src) noexcept
+        {
+            if (this != &src)
+            {
+                _data = std::move(src._data);
+                _size = src._size;
+                src._size = 0;
+            }
+            return *this;
+        }
+
+        void allocate(size_t size)
+        {
+            _allocateInternal(size);
+        }
+
+        void assign(const _T *begin, const _T *end)
+        {
+            assert((end - begin) <= (ptrdiff_t)_size);
+            _T *curThis = _detach();
+            for (const _T *cur = begin; cur != end; ++cur, ++curThis)
+            {
+                *curThis = *cur;
+            }
+        }
+
+        void swap(cow_array &src)
+        {
+            std::swap(_data, src._data);
+            std::swap(_size, src._size);
+        }
+
+        void fill(_T value)
+        {
+            fill(0, _size, value);
+        }
+
+        void fill(size_t position, size_t length, _T value)
+        {
+            assert((position + length) <= _size);
+            _T *data = _detach();
+            for (size_t i = position; i < (position + length); i++)
+            {
+                data[i] = value;
+            }
+        }
+
+        _T *begin() { return _detach(); }
+        _T *end() { return _detach() + _size; }
+        const _T *begin() const { return _data.get(); }
+        const _T *end() const { return _data.get() + _size; }
+
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+        // True if both refer to the same block (so neither has been written to since one was copied from the other).
+        bool shares_data(const cow_array &other) const { return _data && (_data == other._data); }
+
+        _T& operator[](size_t index)
+        {
+            return _detach()[index];
+        }
+
+        const _T& operator[](size_t index) const
+        {
+            return _data.get()[index];
+        }
+
+    private:
+        void _allocateInternal(size_t size)
+        {
+            if (size == 0)
+            {
+                _data.reset();
+            }
+            else
+            {
+                _data.reset(new _T[size], std::default_delete<_T[]>());
+            }
+            _size = size;
+        }
+
+        _T *_detach()
+        {
+            if (_data && (_data.use_count() > 1))
+            {
+                std::shared_ptr<_T> copy(new _T[_size], std::default_delete<_T[]>());
+                memcpy(copy.get(), _data.get(), _size * sizeof(_T));
+                _data.swap(copy);
+            }
+            return _data.get();
+        }
+
+        std::shared_ptr<_T> _data;
+        size_t _size;
+    };
 }
 
 // A remove_if for associative containers.
@@ -14,6 +14,8 @@
 #include "stdafx.h"
 #include "Stream.h"
 #include "PerfTimer.h"
+#include "sci.h"
+#include "format.h"
 
 namespace sci
 {
@@ -394,26 +396,51 @@ namespace sci
 
     streamOwner::streamOwner(const std::string &filename) : _dataMemoryMapped(nullptr), _hMap(nullptr), _cbSizeValid(0), _pData(nullptr)
     {
-        _hFile = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
-        if (_hFile != INVALID_HANDLE_VALUE)
+        // The file stays open (and mapped) for as long as we're alive, so don't lock anyone else out of it.
+        // Whoever writes to it is responsible for not disturbing the part we've mapped (appending is fine,
+        // and replacing the file has to move it out of the way first).
+        // A file we can't read isn't the same as an empty one, so failures throw (and nothing has been
+        // constructed yet, so clean up here).
+        _hFile = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (_hFile == INVALID_HANDLE_VALUE)
         {
-            // If no length specifies, then until the end of the file.
-            DWORD dwSizeHigh;
-            DWORD dwSize = GetFileSize(_hFile, &dwSizeHigh);
-            if (dwSize != INVALID_FILE_SIZE)
+            throw std::exception(GetMessageFromLastError(fmt::format("Opening {0}", filename)).c_str());
+        }
+        DWORD dwSizeHigh;
+        DWORD dwSize = GetFileSize(_hFile, &dwSizeHigh);
+        if (dwSize == INVALID_FILE_SIZE)
+        {
+            _ThrowAndClose(fmt::format("Getting the size of {0}", filename));
+        }
+        assert(dwSizeHigh == 0);
+        if (dwSize > 0) // Empty files can't be mapped, but they're fine to read as empty.
+        {
+            _hMap = CreateFileMapping(_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (_hMap == nullptr)
             {
-                assert(dwSizeHigh == 0);
-                _hMap = CreateFileMapping(_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
-                if (_hMap != nullptr)
-                {
-                    _dataMemoryMapped = reinterpret_cast<uint8_t*>(MapViewOfFile(_hMap, FILE_MAP_READ, 0, 0, 0));
-                    if (_dataMemoryMapped)
-                    {
-                        _cbSizeValid = dwSize;
-                    }
-                }
+                _ThrowAndClose(fmt::format("Mapping {0}", filename));
             }
+            _dataMemoryMapped = reinterpret_cast<uint8_t*>(MapViewOfFile(_hMap, FILE_MAP_READ, 0, 0, 0));
+            if (!_dataMemoryMapped)
+            {
+                _ThrowAndClose(fmt::format("Mapping a view of {0}", filename));
+            }
+            _cbSizeValid = dwSize;
+        }
+    }
+
+    void streamOwner::_ThrowAndClose(const std::string &details)
+    {
+        // Get the message before closing anything changes the last error.
+        std::string message = GetMessageFromLastError(details);
+        if (_hMap)
+        {
+            CloseHandle(_hMap);
+            _hMap = nullptr;
         }
+        CloseHandle(_hFile);
+        _hFile = INVALID_HANDLE_VALUE;
+        throw std::exception(message.c_str());
     }
 
     streamOwner::~streamOwner()
@@ -147,6 +147,8 @@ namespace sci
         uint32_t GetDataSize();
 
     private:
+        void _ThrowAndClose(const std::string &details);
+
         std::unique_ptr<uint8_t[]> _pData;        // Our data
         uint32_t _cbSizeValid;
 
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <deque>
+#include <algorithm>
 
 class ITaskStatus
 {
@@ -37,13 +38,15 @@ public:
         Exit();
     }
 
-    int SubmitTask(std::unique_ptr<_TPayload> task, std::function<std::unique_ptr<_TResponse>(ITaskStatus&, _TPayload&)> func)
+    // Tasks with a higher priority are run first. Tasks of equal priority run in the order they were submitted.
+    int SubmitTask(std::unique_ptr<_TPayload> task, std::function<std::unique_ptr<_TResponse>(ITaskStatus&, _TPayload&)> func, int priority = 0)
     {
         int id;
         {
             std::lock_guard<std::mutex> lock(_mutex);
             id = _nextId++;
-            _queue.emplace_back(id, std::move(task), func);
+            auto it = std::find_if(_queue.begin(), _queue.end(), [priority](const TaskInfo &info) { return info.priority < priority; });
+            _queue.emplace(it, id, std::move(task), func, priority);
         }
 
         _conditionWakeUp.notify_one();
@@ -61,6 +64,21 @@ public:
         return SubmitTask(std::move(task), func);
     }
 
+    // Assigns new priorities to the tasks that haven't started yet, e.g. when what the user
+    // is looking at changes.
+    void Reprioritize(std::function<int(const _TPayload&)> getPriority)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (TaskInfo &info : _queue)
+        {
+            if (info.payload)
+            {
+                info.priority = getPriority(*info.payload);
+            }
+        }
+        std::stable_sort(_queue.begin(), _queue.end(), [](const TaskInfo &a, const TaskInfo &b) { return a.priority > b.priority; });
+    }
+
     std::unique_ptr<_TResponse> RetrieveResponse(int id)
     {
 
@@ -78,6 +96,19 @@ public:
         return response;
     }
 
+    // For when the owner wants every response, not just a particular one. Returns null if there are none.
+    std::unique_ptr<_TResponse> RetrieveNextResponse()
+    {
+        std::lock_guard<std::mutex> lock(_mutexResponse);
+        std::unique_ptr<_TResponse> response;
+        if (!_responseQueue.empty())
+        {
+            response = move(_responseQueue.front().response);
+            _responseQueue.pop_front();
+        }
+        return response;
+    }
+
     void DeactivateHWND(HWND hwndNoMore)
     {
         // Since multiple windows may use the same scheduler, when a window that submits
@@ -180,11 +211,14 @@ private:
 
     struct TaskInfo
     {
-        TaskInfo(int id, std::unique_ptr<_TPayload> payload, std::function<std::unique_ptr<_TResponse>(ITaskStatus&, _TPayload&)> func) : id(id), payload(std::move(payload)), func(func) {}
+        TaskInfo(int id, std::unique_ptr<_TPayload> payload, std::function<std::unique_ptr<_TResponse>(ITaskStatus&, _TPayload&)> func, int priority) : id(id), payload(std::move(payload)), func(func), priority(priority) {}
+        TaskInfo(TaskInfo &&src) = default;
+        TaskInfo &operator=(TaskInfo &&src) = default;
 
         int id;
         std::function<std::unique_ptr<_TResponse>(ITaskStatus&, _TPayload&)> func;
         std::unique_ptr<_TPayload> payload;
+        int priority;
     };
 
     struct TaskResponse
@@ -0,0 +1,324 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "ThumbnailCache.h"
+#include "ResourceBlob.h"
+#include "Codec.h"
+#include "crc.h"
+#include "format.h"
+
+using namespace std;
+
+const uint32_t ThumbnailSignature = (('S' << 24) + ('C' << 16) + ('T' << 8) + 'B');
+const uint16_t ThumbnailVersion = 1;
+
+#include <pshpack1.h>
+struct THUMBNAIL_HEADER
+{
+    uint32_t signature;
+    uint16_t version;
+    uint16_t width;
+    uint16_t height;
+    uint16_t compressed;        // 1 if DCL compressed
+    uint32_t cbDecompressed;
+    uint32_t cbCompressed;
+};
+#include <poppack.h>
+
+bool ThumbnailKey::operator==(const ThumbnailKey &other) const
+{
+    return (Type == other.Type) &&
+        (Number == other.Number) &&
+        (Base36Number == other.Base36Number) &&
+        (ContentHash == other.ContentHash) &&
+        (Context == other.Context) &&
+        (Width == other.Width) &&
+        (Height == other.Height);
+}
+
+size_t ThumbnailKeyHash::operator()(const ThumbnailKey &key) const
+{
+    size_t hash = key.ContentHash;
+    hash = (hash * 31) + (size_t)key.Type;
+    hash = (hash * 31) + (size_t)key.Number;
+    hash = (hash * 31) + (size_t)key.Base36Number;
+    hash = (hash * 31) + (size_t)key.Context;
+    hash = (hash * 31) + (size_t)((key.Width << 16) | key.Height);
+    return hash;
+}
+
+void _InitThumbnailBitmapInfo(BITMAPINFO &bmi, int cx, int cy)
+{
+    bmi = {};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = cx;
+    bmi.bmiHeader.biHeight = -cy;   // top-down
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+}
+
+HBITMAP Thumbnail::CreateBitmap() const
+{
+    BITMAPINFO bmi;
+    _InitThumbnailBitmapInfo(bmi, Width, Height);
+    void *pBits;
+    HBITMAP hbmp = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &pBits, nullptr, 0);
+    if (hbmp)
+    {
+        memcpy(pBits, &Bits[0], Bits.size());
+    }
+    return hbmp;
+}
+
+std::shared_ptr<Thumbnail> Thumbnail::FromBitmap(HBITMAP hbmp)
+{
+    std::shared_ptr<Thumbnail> thumbnail;
+    BITMAP bm;
+    if (hbmp && GetObject(hbmp, sizeof(bm), &bm) && (bm.bmWidth > 0) && (bm.bmHeight > 0))
+    {
+        thumbnail = std::make_shared<Thumbnail>();
+        thumbnail->Width = (uint16_t)bm.bmWidth;
+        thumbnail->Height = (uint16_t)bm.bmHeight;
+        thumbnail->Bits.resize(bm.bmWidth * bm.bmHeight * 4);
+        BITMAPINFO bmi;
+        _InitThumbnailBitmapInfo(bmi, bm.bmWidth, bm.bmHeight);
+        HDC hdc = GetDC(nullptr);
+        int lines = GetDIBits(hdc, hbmp, 0, bm.bmHeight, &thumbnail->Bits[0], &bmi, DIB_RGB_COLORS);
+        ReleaseDC(nullptr, hdc);
+        if (lines != bm.bmHeight)
+        {
+            thumbnail.reset();
+        }
+    }
+    return thumbnail;
+}
+
+ThumbnailCache::ThumbnailCache(size_t maxMemoryBytes) : _maxMemoryBytes(maxMemoryBytes), _memoryBytes(0)
+{
+}
+
+void ThumbnailCache::SetFolder(const std::string &folder)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_folder != folder)
+    {
+        _folder = folder;
+        _mostRecentlyUsed.clear();
+        _lookup.clear();
+        _memoryBytes = 0;
+    }
+}
+
+uint32_t ThumbnailCache::HashResource(const ResourceBlob &blob)
+{
+    const uint8_t *data = blob.GetData();
+    return (data && (blob.GetLength() > 0)) ? (uint32_t)crcFast(data, blob.GetLength()) : 0;
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailCache::LookupInMemory(const ThumbnailKey &key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::shared_ptr<const Thumbnail> thumbnail;
+    auto it = _lookup.find(key);
+    if (it != _lookup.end())
+    {
+        // Move it to the front
+        _mostRecentlyUsed.splice(_mostRecentlyUsed.begin(), _mostRecentlyUsed, it->second);
+        thumbnail = it->second->second;
+    }
+    return thumbnail;
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailCache::GetOrCreate(const ThumbnailKey &key, std::function<HBITMAP()> create)
+{
+    std::shared_ptr<const Thumbnail> thumbnail = LookupInMemory(key);
+    if (!thumbnail)
+    {
+        std::string folder;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            folder = _folder;
+        }
+
+        thumbnail = _LoadFromDisk(key, folder);
+        if (!thumbnail)
+        {
+            HBITMAP hbmp = create();
+            thumbnail = Thumbnail::FromBitmap(hbmp);
+            DeleteObject(hbmp);
+            if (thumbnail)
+            {
+                _SaveToDisk(key, *thumbnail, folder);
+            }
+        }
+
+        if (thumbnail)
+        {
+            _AddToMemory(key, thumbnail);
+        }
+    }
+    return thumbnail;
+}
+
+void ThumbnailCache::_AddToMemory(const ThumbnailKey &key, std::shared_ptr<const Thumbnail> thumbnail)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_lookup.find(key) == _lookup.end())
+    {
+        _mostRecentlyUsed.emplace_front(key, thumbnail);
+        _lookup[key] = _mostRecentlyUsed.begin();
+        _memoryBytes += thumbnail->Bits.size();
+
+        // Evict the least recently used, but always keep the one we just added.
+        while ((_memoryBytes > _maxMemoryBytes) && (_mostRecentlyUsed.size() > 1))
+        {
+            auto &oldest = _mostRecentlyUsed.back();
+            _memoryBytes -= oldest.second->Bits.size();
+            _lookup.erase(oldest.first);
+            _mostRecentlyUsed.pop_back();
+        }
+    }
+}
+
+std::string _GetThumbnailFilePrefix(const ThumbnailKey &key, const std::string &folder)
+{
+    return fmt::format("{0}\\{1}_{2}_{3:08x}_", folder, (int)key.Type, key.Number, key.Base36Number);
+}
+
+// Everything that follows the content hash.
+std::string _GetThumbnailFileSuffix(const ThumbnailKey &key)
+{
+    return fmt::format("_{0:08x}_{1}x{2}.thb", key.Context, key.Width, key.Height);
+}
+
+std::string _GetThumbnailFilename(const ThumbnailKey &key, const std::string &folder)
+{
+    return fmt::format("{0}{1:08x}{2}", _GetThumbnailFilePrefix(key, folder), key.ContentHash, _GetThumbnailFileSuffix(key));
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailCache::_LoadFromDisk(const ThumbnailKey &key, const std::string &folder)
+{
+    std::shared_ptr<Thumbnail> thumbnail;
+    if (!folder.empty())
+    {
+        std::string filename = _GetThumbnailFilename(key, folder);
+        if (PathFileExists(filename.c_str()))
+        {
+            try
+            {
+                ScopedFile scoped(filename, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING);
+                sci::streamOwner owner(scoped.hFile);
+                sci::istream reader = owner.getReader();
+
+                THUMBNAIL_HEADER header;
+                reader >> header;
+                if (reader.good() &&
+                    (header.signature == ThumbnailSignature) &&
+                    (header.version == ThumbnailVersion) &&
+                    (header.width == key.Width) &&
+                    (header.height == key.Height) &&
+                    (header.cbDecompressed == (uint32_t)(header.width * header.height * 4)) &&
+                    (header.cbCompressed <= reader.getBytesRemaining()))
+                {
+                    std::unique_ptr<Thumbnail> temp = std::make_unique<Thumbnail>();
+                    temp->Width = header.width;
+                    temp->Height = header.height;
+                    temp->Bits.resize(header.cbDecompressed);
+                    std::vector<uint8_t> packed(header.cbCompressed);
+                    reader.read_data(&packed[0], header.cbCompressed);
+                    bool ok = reader.good();
+                    if (ok)
+                    {
+                        if (header.compressed)
+                        {
+                            ok = decompressDCL(&temp->Bits[0], &packed[0], header.cbDecompressed, header.cbCompressed);
+                        }
+                        else if (header.cbCompressed == header.cbDecompressed)
+                        {
+                            temp->Bits = std::move(packed);
+                        }
+                        else
+                        {
+                            ok = false;
+                        }
+                    }
+                    if (ok)
+                    {
+                        thumbnail = std::move(temp);
+                    }
+                }
+            }
+            catch (std::exception)
+            {
+                // Just re-generate it.
+            }
+        }
+    }
+    return thumbnail;
+}
+
+void ThumbnailCache::_SaveToDisk(const ThumbnailKey &key, const Thumbnail &thumbnail, const std::string &folder)
+{
+    if (folder.empty() || !EnsureFolderExists(folder, false))
+    {
+        return;
+    }
+
+    THUMBNAIL_HEADER header = { ThumbnailSignature, ThumbnailVersion, thumbnail.Width, thumbnail.Height, 0, (uint32_t)thumbnail.Bits.size(), (uint32_t)thumbnail.Bits.size() };
+    std::vector<uint8_t> packed;
+    const uint8_t *data = &thumbnail.Bits[0];
+    if (compressDCL(&thumbnail.Bits[0], (uint32_t)thumbnail.Bits.size(), packed) && (packed.size() < thumbnail.Bits.size()))
+    {
+        header.compressed = 1;
+        header.cbCompressed = (uint32_t)packed.size();
+        data = &packed[0];
+    }
+
+    // Thumbnails for older versions of this resource are no longer useful. Only those that differ
+    // in content hash are stale though: other sizes or palettes (the context) are still in use.
+    std::string filename = _GetThumbnailFilename(key, folder);
+    std::string prefix = _GetThumbnailFilePrefix(key, folder);
+    std::string suffix = _GetThumbnailFileSuffix(key);
+    std::string pattern = prefix + "????????" + suffix;
+    WIN32_FIND_DATA findData;
+    HANDLE hFind = FindFirstFile(pattern.c_str(), &findData);
+    if (hFind != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            // The wildcards can also match short file names, so check the whole thing.
+            std::string stale = folder + "\\" + findData.cFileName;
+            if ((stale.length() == filename.length()) &&
+                (_strnicmp(stale.c_str(), prefix.c_str(), prefix.length()) == 0) &&
+                (lstrcmpi(stale.c_str() + (stale.length() - suffix.length()), suffix.c_str()) == 0) &&
+                (lstrcmpi(stale.c_str(), filename.c_str()) != 0))
+            {
+                DeleteFile(stale.c_str());
+            }
+        } while (FindNextFile(hFind, &findData));
+        FindClose(hFind);
+    }
+
+    try
+    {
+        ScopedFile scoped(filename, GENERIC_WRITE, 0, CREATE_ALWAYS);
+        scoped.Write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+        scoped.Write(data, header.cbCompressed);
+    }
+    catch (std::exception)
+    {
+        // The disk cache is just an optimization. Another thread (or instance) may be writing the same thumbnail.
+    }
+}
@@ -0,0 +1,88 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#pragma once
+
+class ResourceBlob;
+
+//
+// Caches the thumbnails shown in the game explorer, so they don't need to be re-rendered each
+// time a resource type is shown. Recently used thumbnails are kept in memory, and all of them are
+// written to the thumbnails folder of the game so they survive across sessions.
+// This is accessed from both the UI thread and the background threads generating thumbnails.
+//
+
+// Priorities for the tasks that generate thumbnails.
+const int ThumbnailPriorityOffscreen = 0;
+const int ThumbnailPriorityVisible = 1;
+
+struct ThumbnailKey
+{
+    ResourceType Type;
+    int Number;
+    uint32_t Base36Number;
+    uint32_t ContentHash;       // crc of the resource data. (ResourceBlob::GetChecksum isn't stable across sessions)
+    uint32_t Context;           // Anything else the image depends on (e.g. the global palette)
+    uint16_t Width;
+    uint16_t Height;
+
+    bool operator==(const ThumbnailKey &other) const;
+};
+
+struct ThumbnailKeyHash
+{
+    size_t operator()(const ThumbnailKey &key) const;
+};
+
+// 32bpp top-down bits
+struct Thumbnail
+{
+    uint16_t Width;
+    uint16_t Height;
+    std::vector<uint8_t> Bits;
+
+    HBITMAP CreateBitmap() const;
+    static std::shared_ptr<Thumbnail> FromBitmap(HBITMAP hbmp);
+};
+
+class ThumbnailCache
+{
+public:
+    ThumbnailCache(size_t maxMemoryBytes);
+
+    // Where thumbnails are persisted. Empty means nowhere.
+    void SetFolder(const std::string &folder);
+
+    static uint32_t HashResource(const ResourceBlob &blob);
+
+    // Doesn't touch the disk, so it's cheap enough for the UI thread.
+    std::shared_ptr<const Thumbnail> LookupInMemory(const ThumbnailKey &key);
+
+    // Checks memory, then disk, then calls create (which should return an HBITMAP it no longer wants)
+    // and caches the result. Returns null if create fails.
+    std::shared_ptr<const Thumbnail> GetOrCreate(const ThumbnailKey &key, std::function<HBITMAP()> create);
+
+private:
+    void _AddToMemory(const ThumbnailKey &key, std::shared_ptr<const Thumbnail> thumbnail);
+    std::shared_ptr<const Thumbnail> _LoadFromDisk(const ThumbnailKey &key, const std::string &folder);
+    void _SaveToDisk(const ThumbnailKey &key, const Thumbnail &thumbnail, const std::string &folder);
+
+    typedef std::list<std::pair<ThumbnailKey, std::shared_ptr<const Thumbnail>>> ThumbnailList;
+
+    std::mutex _mutex;
+    std::string _folder;
+    size_t _maxMemoryBytes;
+    size_t _memoryBytes;
+    ThumbnailList _mostRecentlyUsed;    // Front is the most recent
+    std::unordered_map<ThumbnailKey, ThumbnailList::iterator, ThumbnailKeyHash> _lookup;
+};
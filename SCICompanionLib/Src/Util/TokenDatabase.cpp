@@ -14,179 +14,272 @@
 #include "stdafx.h"
 #include "TokenDatabase.h"
 #include "CodeAutoComplete.h"
-#include "format.h"
 
-const size_t MaxWordLength = 255;
+const uint32_t InvalidNode = 0xffffffff;
 
-ACTreeLeaf::ACTreeLeaf(AutoCompleteSourceType sourceType, std::string original) : Original(original), SourceType(sourceType), Lower(original)
+namespace
 {
-    std::transform(Lower.begin(), Lower.end(), Lower.begin(), ::tolower);
-    if (Lower.size() > MaxWordLength)
+    AutoCompleteIconIndex _GetIcon(AutoCompleteSourceType type)
     {
-        Lower = Lower.substr(0, MaxWordLength);
+        switch (type)
+        {
+            case AutoCompleteSourceType::Define:
+                return AutoCompleteIconIndex::Define;
+            case AutoCompleteSourceType::TopLevelKeyword:
+                return AutoCompleteIconIndex::TopLevelKeyword;
+            case AutoCompleteSourceType::ClassName:
+                return AutoCompleteIconIndex::Class;
+            case AutoCompleteSourceType::Selector:
+                return AutoCompleteIconIndex::Selector;
+            case AutoCompleteSourceType::Procedure:
+                return AutoCompleteIconIndex::PublicProcedure;
+            case AutoCompleteSourceType::Kernel:
+                return AutoCompleteIconIndex::Kernel;
+            case AutoCompleteSourceType::ScriptName:
+                return AutoCompleteIconIndex::Script;
+            case AutoCompleteSourceType::Variable:
+                return AutoCompleteIconIndex::Variable;
+        }
+        return AutoCompleteIconIndex::Unknown;
+    }
+
+    // Children are ordered the same way std::string orders characters.
+    bool _CharLess(const std::pair<char, uint32_t> &child, char ch)
+    {
+        return (uint8_t)child.first < (uint8_t)ch;
     }
 }
 
-bool operator<(const ACTreeLeaf &one, const ACTreeLeaf &two)
+TokenDatabase::TokenDatabase()
+{
+    _NewNode(0, 0);
+}
+
+void TokenDatabase::Clear()
+{
+    _nodes.clear();
+    _freeNodes.clear();
+    _tokens.clear();
+    _NewNode(0, 0);
+}
+
+uint32_t TokenDatabase::_NewNode(uint32_t parent, char ch)
 {
-    return one.Lower < two.Lower;
+    uint32_t index;
+    if (_freeNodes.empty())
+    {
+        index = (uint32_t)_nodes.size();
+        _nodes.emplace_back();
+    }
+    else
+    {
+        index = _freeNodes.back();
+        _freeNodes.pop_back();
+    }
+    Node &node = _nodes[index];
+    node.Parent = parent;
+    node.Char = ch;
+    node.SubtreeTypes = AutoCompleteSourceType::None;
+    node.SubtreeCount = 0;
+    node.Children.clear();
+    node.Leaves.clear();
+    return index;
 }
 
+uint32_t TokenDatabase::_FindNode(const std::string &lower) const
+{
+    uint32_t nodeIndex = 0;
+    for (char ch : lower)
+    {
+        const auto &children = _nodes[nodeIndex].Children;
+        auto it = std::lower_bound(children.begin(), children.end(), ch, _CharLess);
+        if ((it == children.end()) || (it->first != ch))
+        {
+            return InvalidNode;
+        }
+        nodeIndex = it->second;
+    }
+    return nodeIndex;
+}
 
-size_t CommonPrefix(const std::string &one, const std::string &two, bool &firstLetterSame)
+void TokenDatabase::_Insert(AutoCompleteSourceType sourceType, const std::string &original)
 {
-    size_t length = min(one.size(), two.size());
-    firstLetterSame = false;
-    for (size_t i = 0; i < length; i++)
+    std::string lower = original;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+    uint32_t nodeIndex = 0;
+    _nodes[nodeIndex].SubtreeCount++;
+    _nodes[nodeIndex].SubtreeTypes |= sourceType;
+    for (char ch : lower)
     {
-        if (one[i] != two[i])
+        auto &children = _nodes[nodeIndex].Children;
+        auto it = std::lower_bound(children.begin(), children.end(), ch, _CharLess);
+        uint32_t childIndex;
+        if ((it != children.end()) && (it->first == ch))
         {
-            return i;
+            childIndex = it->second;
         }
-        firstLetterSame = true;
+        else
+        {
+            size_t position = it - children.begin();
+            childIndex = _NewNode(nodeIndex, ch);   // This may move the nodes, so don't hang on to children.
+            auto &newChildren = _nodes[nodeIndex].Children;
+            newChildren.insert(newChildren.begin() + position, std::make_pair(ch, childIndex));
+        }
+        nodeIndex = childIndex;
+        _nodes[nodeIndex].SubtreeCount++;
+        _nodes[nodeIndex].SubtreeTypes |= sourceType;
     }
-    firstLetterSame = (length > 0);
-    return length;
+    _nodes[nodeIndex].Leaves.push_back({ sourceType, original });
 }
 
-void TokenDatabase::BuildDatabase(std::multiset<ACTreeLeaf> &originalsIn)
+void TokenDatabase::_Remove(AutoCompleteSourceType sourceType, const std::string &original)
 {
-    _data.EnsureCapacity(20000);
-    _data.reset();
-    _originals.clear();
+    std::string lower = original;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    uint32_t nodeIndex = _FindNode(lower);
+    if (nodeIndex == InvalidNode)
+    {
+        return;
+    }
+    auto &leaves = _nodes[nodeIndex].Leaves;
+    auto itLeaf = std::find_if(leaves.begin(), leaves.end(), [&](const Leaf &leaf) { return (leaf.SourceType == sourceType) && (leaf.Original == original); });
+    if (itLeaf == leaves.end())
+    {
+        return;
+    }
+    leaves.erase(itLeaf);
 
-    std::string previous;
-    for (const ACTreeLeaf &leaf : originalsIn)
+    // Walk back up to the root, fixing up the counts and types, and dropping nodes with nothing left below them.
+    while (true)
     {
-        // Count chars in common with previous
-        bool firstLetterSame;
-        size_t commonWithPrev = CommonPrefix(previous, leaf.Lower, firstLetterSame);
-        if (!firstLetterSame)
+        Node &node = _nodes[nodeIndex];
+        node.SubtreeCount--;
+        AutoCompleteSourceType types = AutoCompleteSourceType::None;
+        for (const Leaf &leaf : node.Leaves)
+        {
+            types |= leaf.SourceType;
+        }
+        for (const auto &child : node.Children)
         {
-            // New entry in the letter table.
-            _offsets[leaf.Lower[0]] = _data.GetDataSize();
+            types |= _nodes[child.second].SubtreeTypes;
         }
+        node.SubtreeTypes = types;
 
-        _data.WriteByte((uint8_t)commonWithPrev);
-        size_t currentSize = leaf.Lower.size();
-        _data.WriteByte((uint8_t)(currentSize - commonWithPrev));
-        for (size_t i = commonWithPrev; i < currentSize; i++)
+        if (nodeIndex == 0)
+        {
+            break;
+        }
+        uint32_t parentIndex = node.Parent;
+        if (node.SubtreeCount == 0)
         {
-            _data.WriteByte((uint8_t)leaf.Lower[i]);
+            auto &siblings = _nodes[parentIndex].Children;
+            auto it = std::lower_bound(siblings.begin(), siblings.end(), node.Char, _CharLess);
+            assert((it != siblings.end()) && (it->second == nodeIndex));
+            siblings.erase(it);
+            _freeNodes.push_back(nodeIndex);
         }
-        // Finally, the id.
-        _data.WriteWord((uint16_t)_originals.size());
-        _originals.push_back(leaf);
+        nodeIndex = parentIndex;
+    }
+}
+
+void TokenDatabase::SetTokens(AutoCompleteSourceType sourceType, std::vector<std::string> tokens)
+{
+    tokens.erase(std::remove(tokens.begin(), tokens.end(), std::string()), tokens.end());
+    std::sort(tokens.begin(), tokens.end());
+    std::vector<std::string> &current = _tokens[(int)sourceType];
 
-        previous = leaf.Lower;
+    // Typically only a few of these have changed.
+    std::vector<std::string> removed;
+    std::vector<std::string> added;
+    std::set_difference(current.begin(), current.end(), tokens.begin(), tokens.end(), std::back_inserter(removed));
+    std::set_difference(tokens.begin(), tokens.end(), current.begin(), current.end(), std::back_inserter(added));
+    for (const std::string &token : removed)
+    {
+        _Remove(sourceType, token);
+    }
+    for (const std::string &token : added)
+    {
+        _Insert(sourceType, token);
     }
-    _data.WriteByte(0); // 0 chars in common
-    // Done
+    std::swap(current, tokens);
 }
 
-void TokenDatabase::GetAutoCompleteChoices(const std::string &prefix, AutoCompleteSourceType sourceTypes, std::vector<AutoCompleteChoice> &choices)
+void TokenDatabase::_AddLeaves(uint32_t nodeIndex, AutoCompleteSourceType sourceTypes, std::vector<AutoCompleteChoice> &choices) const
 {
-    if (!prefix.empty())
+    std::string lower;
+    for (const Leaf &leaf : _nodes[nodeIndex].Leaves)
     {
-        sci::istream stream = istream_from_ostream(_data);
-        size_t prefixLength = prefix.size();
-        auto itOffset = _offsets.find(prefix[0]);
-        if (itOffset != _offsets.end())
+        if ((leaf.SourceType & sourceTypes) != AutoCompleteSourceType::None)
         {
-            size_t offset = itOffset->second;
-            stream.seekg(offset);
-            assert(0 == stream.peek()); // 0 chars in common with previous.
-            uint8_t charsInCommon;
-            stream >> charsInCommon;
-            size_t matchingChars = 0; // This can only go up, then go down.
-
-            char buffer[MaxWordLength];
-            do
+            if (lower.empty())
             {
-                uint8_t additionalChars;
-                stream >> additionalChars;
-
-                stream.read_data(reinterpret_cast<uint8_t*>(buffer + charsInCommon), additionalChars);
-
-                if (charsInCommon < matchingChars)
+                for (uint32_t i = nodeIndex; i != 0; i = _nodes[i].Parent)
                 {
-                    // We're done, nothing more could match
-                    break;
+                    lower.push_back(_nodes[i].Char);
                 }
+                std::reverse(lower.begin(), lower.end());
+            }
+            choices.emplace_back(leaf.Original, lower, _GetIcon(leaf.SourceType));
+        }
+    }
+}
+
+void TokenDatabase::GetAutoCompleteChoices(const std::string &prefix, AutoCompleteSourceType sourceTypes, std::vector<AutoCompleteChoice> &choices, size_t maxChoices) const
+{
+    uint32_t startIndex = prefix.empty() ? InvalidNode : _FindNode(prefix);
+    if ((startIndex == InvalidNode) || ((_nodes[startIndex].SubtreeTypes & sourceTypes) == AutoCompleteSourceType::None) || (maxChoices == 0))
+    {
+        return;
+    }
 
-                // Figure out how many characters match the prefix.
-                size_t total = charsInCommon + additionalChars;
-                while (matchingChars < prefixLength && matchingChars < total)
+    if (_nodes[startIndex].SubtreeCount <= maxChoices)
+    {
+        // Everything fits, so just walk the subtree in order. A node's own tokens sort before its children's.
+        std::vector<uint32_t> stack(1, startIndex);
+        while (!stack.empty())
+        {
+            uint32_t nodeIndex = stack.back();
+            stack.pop_back();
+            const Node &node = _nodes[nodeIndex];
+            _AddLeaves(nodeIndex, sourceTypes, choices);
+            for (auto it = node.Children.rbegin(); it != node.Children.rend(); ++it)
+            {
+                if ((_nodes[it->second].SubtreeTypes & sourceTypes) != AutoCompleteSourceType::None)
                 {
-                    if (buffer[matchingChars] == prefix[matchingChars])
-                    {
-                        matchingChars++;
-                    }
-                    else
-                    {
-                        break;
-                    }
+                    stack.push_back(it->second);
                 }
-
-                if (matchingChars == prefixLength)
+            }
+        }
+    }
+    else
+    {
+        // Too many. Go breadth first, so we end up with the shortest ones, one length at a time.
+        size_t firstChoice = choices.size();
+        std::vector<uint32_t> level(1, startIndex);
+        std::vector<uint32_t> nextLevel;
+        while (!level.empty() && ((choices.size() - firstChoice) < maxChoices))
+        {
+            nextLevel.clear();
+            for (uint32_t nodeIndex : level)
+            {
+                _AddLeaves(nodeIndex, sourceTypes, choices);
+                for (const auto &child : _nodes[nodeIndex].Children)
                 {
-                    // This is a match, unless we have less now
-                    if (buffer[matchingChars - 1] != prefix[matchingChars - 1])
-                    {
-                        // We're done. Nothing more will match
-                        break;
-                    }
-                    uint16_t index;
-                    stream >> index;
-
-                    const ACTreeLeaf &leaf = _originals[index];
-                    AutoCompleteSourceType type = leaf.SourceType;
-                    if ((type & sourceTypes) != AutoCompleteSourceType::None)
+                    if ((_nodes[child.second].SubtreeTypes & sourceTypes) != AutoCompleteSourceType::None)
                     {
-                        AutoCompleteIconIndex icon = AutoCompleteIconIndex::Unknown;
-                        switch (type)
-                        {
-                            case AutoCompleteSourceType::Define:
-                                icon = AutoCompleteIconIndex::Define;
-                                break;
-                            case AutoCompleteSourceType::TopLevelKeyword:
-                                icon = AutoCompleteIconIndex::TopLevelKeyword;
-                                break;
-                            case AutoCompleteSourceType::ClassName:
-                                icon = AutoCompleteIconIndex::Class;
-                                break;
-                            case AutoCompleteSourceType::Selector:
-                                icon = AutoCompleteIconIndex::Selector;
-                                break;
-                            case AutoCompleteSourceType::Procedure:
-                                icon = AutoCompleteIconIndex::PublicProcedure;
-                                break;
-                            case AutoCompleteSourceType::Kernel:
-                                icon = AutoCompleteIconIndex::Kernel;
-                                break;
-                            case AutoCompleteSourceType::ScriptName:
-                                icon = AutoCompleteIconIndex::Script;
-                                break;
-                            case AutoCompleteSourceType::Variable:
-                                icon = AutoCompleteIconIndex::Variable;
-                                break;
-                        }
-                        choices.emplace_back(leaf.Original, leaf.Lower, icon);
+                        nextLevel.push_back(child.second);
                     }
-
-                    
-
-                }
-                else
-                {
-                    stream.skip(sizeof(uint16_t));
                 }
-
-                
-                stream >> charsInCommon;
-            } while (charsInCommon);
-
-            // Go through the entries until we have one where prefixLength chars are matching.
+            }
+            std::swap(level, nextLevel);
+        }
+        // Each level is visited in order, so if the last one overflowed, it's the alphabetically last of the
+        // longest ones that get dropped.
+        if ((choices.size() - firstChoice) > maxChoices)
+        {
+            choices.resize(firstChoice + maxChoices);
         }
+        std::sort(choices.begin() + firstChoice, choices.end());
     }
 }
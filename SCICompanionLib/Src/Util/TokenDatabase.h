@@ -12,33 +12,57 @@
     GNU General Public License for more details.
 ***************************************************************************/
 #pragma once
-#include "AutoCompleteSourceTypes.h"
 
-// Implements a compressed database of tokens for autocompletion.
+#include "AutoCompleteSourceTypes.h"
 
 class AutoCompleteChoice;
 
-struct ACTreeLeaf
+//
+// A prefix trie of the tokens offered for autocompletion, keyed by their lower-case text.
+// Each node knows which source types occur beneath it, and how many tokens, so lookups can skip
+// subtrees that don't have what's asked for and stop early when there are too many matches.
+// Tokens are replaced one source type at a time, and only the differences are applied, so a
+// script reloading doesn't mean rebuilding the whole thing.
+//
+class TokenDatabase
 {
-    ACTreeLeaf(AutoCompleteSourceType sourceType, std::string original);
+public:
+    TokenDatabase();
 
-    AutoCompleteSourceType SourceType;
-    std::string Lower;
-    std::string Original;
-};
+    // Replaces all the tokens of one source type.
+    void SetTokens(AutoCompleteSourceType sourceType, std::vector<std::string> tokens);
 
-bool operator<(const ACTreeLeaf &one, const ACTreeLeaf &two);
-bool operator==(const ACTreeLeaf &one, const ACTreeLeaf &two);
+    // Removes all the tokens.
+    void Clear();
 
-class TokenDatabase
-{
-public:
-    void BuildDatabase(std::multiset<ACTreeLeaf> &originals);
-    void GetAutoCompleteChoices(const std::string &prefix, AutoCompleteSourceType sourceTypes, std::vector<AutoCompleteChoice> &choices);
+    // Adds the tokens of any of sourceTypes that start with prefix (which must be lower case) to choices,
+    // sorted by their lower-case text. If there are more than maxChoices, the shortest ones are returned.
+    void GetAutoCompleteChoices(const std::string &prefix, AutoCompleteSourceType sourceTypes, std::vector<AutoCompleteChoice> &choices, size_t maxChoices = SIZE_MAX) const;
 
 private:
-    std::vector<ACTreeLeaf> _originals;
-    sci::ostream _data;
-    // [chars in common with prev][add'l char length][remaining chars][index into _originals (2 bytes)]
-    std::unordered_map<char, size_t> _offsets;  // Into data
-};
\ No newline at end of file
+    struct Leaf
+    {
+        AutoCompleteSourceType SourceType;
+        std::string Original;
+    };
+
+    struct Node
+    {
+        uint32_t Parent;
+        char Char;
+        AutoCompleteSourceType SubtreeTypes;
+        uint32_t SubtreeCount;                              // Number of leaves here and below
+        std::vector<std::pair<char, uint32_t>> Children;    // Sorted by char
+        std::vector<Leaf> Leaves;
+    };
+
+    void _Insert(AutoCompleteSourceType sourceType, const std::string &original);
+    void _Remove(AutoCompleteSourceType sourceType, const std::string &original);
+    uint32_t _FindNode(const std::string &lower) const;
+    uint32_t _NewNode(uint32_t parent, char ch);
+    void _AddLeaves(uint32_t nodeIndex, AutoCompleteSourceType sourceTypes, std::vector<AutoCompleteChoice> &choices) const;
+
+    std::vector<Node> _nodes;                   // The root is _nodes[0]
+    std::vector<uint32_t> _freeNodes;
+    std::unordered_map<int, std::vector<std::string>> _tokens;  // Sorted tokens for each source type
+};
@@ -310,6 +310,10 @@ public:
     {
         return _dwPos <= _Right._dwPos;
     }
+    bool operator==(const LineCol& _Right) const
+    {
+        return _dwPos == _Right._dwPos;
+    }
 private:
     DWORD _dwPos;
 };
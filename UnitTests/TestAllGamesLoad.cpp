@@ -120,7 +120,8 @@ namespace UnitTests
             flags &= ~ResourceTypeFlags::Vocab;     // Vocabs can't just be "created", we need to follow more specific logic. TODO
             auto container = appState->GetResourceMap().Resources(flags, ResourceEnumFlags::None | ResourceEnumFlags::AddInDefaultEnumFlags);
             int count = 0;
-            for (auto &blob : *container)
+            container->ForEachDecompressed(flags, ResourceEnumOrder::Unordered,
+                [&count](std::unique_ptr<ResourceBlob> blob)
             {
                 try
                 {
@@ -139,7 +140,8 @@ namespace UnitTests
                         Assert::IsTrue(false, message.c_str());
                     }
                 }
-            }
+                return true;
+            });
             
             message = fmt::format(L"Loaded {0} resources.", count);
             Logger::WriteMessage(message.c_str());
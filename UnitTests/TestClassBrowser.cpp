@@ -20,6 +20,8 @@
 #include "Helper.h"
 #include "ClassBrowser.h"
 #include "Task.h"
+#include "TokenDatabase.h"
+#include "CodeAutoComplete.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -48,6 +50,39 @@ namespace UnitTests
             _DoIt();
         }
 
+        TEST_METHOD(TestTokenDatabase)
+        {
+            TokenDatabase database;
+            database.SetTokens(AutoCompleteSourceType::Selector, { "doit", "dispose", "Draw", "x" });
+            database.SetTokens(AutoCompleteSourceType::ClassName, { "Door", "DText" });
+
+            // Matches are sorted by lower-case text, and filtered by source type.
+            Assert::IsTrue(_GetChoices(database, "d", AutoCompleteSourceType::Selector | AutoCompleteSourceType::ClassName) == std::vector<std::string>({ "dispose", "doit", "Door", "Draw", "DText" }));
+            Assert::IsTrue(_GetChoices(database, "do", AutoCompleteSourceType::ClassName) == std::vector<std::string>({ "Door" }));
+            Assert::IsTrue(_GetChoices(database, "do", AutoCompleteSourceType::Kernel).empty());
+            Assert::IsTrue(_GetChoices(database, "q", AutoCompleteSourceType::Selector).empty());
+
+            // Replacing one source type leaves the others alone.
+            database.SetTokens(AutoCompleteSourceType::ClassName, { "DText", "Dialog" });
+            Assert::IsTrue(_GetChoices(database, "d", AutoCompleteSourceType::Selector | AutoCompleteSourceType::ClassName) == std::vector<std::string>({ "Dialog", "dispose", "doit", "Draw", "DText" }));
+            Assert::IsTrue(_GetChoices(database, "do", AutoCompleteSourceType::ClassName).empty());
+
+            // When limited, the shortest ones are returned.
+            Assert::IsTrue(_GetChoices(database, "d", AutoCompleteSourceType::Selector | AutoCompleteSourceType::ClassName, 3) == std::vector<std::string>({ "doit", "Draw", "DText" }));
+        }
+
+        std::vector<std::string> _GetChoices(const TokenDatabase &database, const std::string &prefix, AutoCompleteSourceType sourceTypes, size_t maxChoices = SIZE_MAX)
+        {
+            std::vector<AutoCompleteChoice> choices;
+            database.GetAutoCompleteChoices(prefix, sourceTypes, choices, maxChoices);
+            std::vector<std::string> texts;
+            for (const auto &choice : choices)
+            {
+                texts.push_back(choice.GetText());
+            }
+            return texts;
+        }
+
         TEST_METHOD_CLEANUP(TestCompileAll_Clean)
         {
             CleanUpGame(_gameFolder);
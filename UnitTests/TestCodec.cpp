@@ -0,0 +1,333 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "Codec.h"
+#include "AppState.h"
+#include "format.h"
+#include <random>
+#include <chrono>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+// Writes bits LSB first, the way the DCL decoder consumes them.
+class DCLTestBitWriter
+{
+public:
+    DCLTestBitWriter() : _bits(0), _bitCount(0) {}
+
+    void Write(uint32_t value, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            _bits |= ((value >> i) & 1) << _bitCount;
+            if (++_bitCount == 8)
+            {
+                Data.push_back((uint8_t)_bits);
+                _bits = 0;
+                _bitCount = 0;
+            }
+        }
+    }
+
+    // Writes a huffman code given as a string of bits, in the order they are read.
+    void WriteCode(const char *code)
+    {
+        for (; *code; code++)
+        {
+            Write((*code == '1') ? 1 : 0, 1);
+        }
+    }
+
+    void Flush()
+    {
+        if (_bitCount)
+        {
+            Write(0, 8 - _bitCount);
+        }
+    }
+
+    std::vector<uint8_t> Data;
+
+private:
+    uint32_t _bits;
+    int _bitCount;
+};
+
+// Builds a well-formed DCL stream out of a handful of codes we know from the DCL trees, and returns
+// the bytes it should decompress to.
+std::vector<uint8_t> GenerateDCLStream(std::mt19937 &rng, int mode, int lengthParam, uint32_t unpackedSize, std::vector<uint8_t> &packed)
+{
+    // Length codes for values 0-3 (lengths 2-5), and distance codes for values 0-1.
+    const char *lengthCodes[] = { "101", "11", "100", "011" };
+    const char *distanceCodes[] = { "11", "1011" };
+    // Two literals from the ascii tree
+    const char *asciiCodes[] = { "1111", "10011" };
+    const uint8_t asciiValues[] = { ' ', 'u' };
+
+    std::vector<uint8_t> expected;
+    DCLTestBitWriter writer;
+    writer.Write(mode, 8);
+    writer.Write(lengthParam, 8);
+    std::uniform_int_distribution<int> coin(0, 99);
+    while (expected.size() < unpackedSize)
+    {
+        uint32_t remaining = unpackedSize - (uint32_t)expected.size();
+        int lengthValue = coin(rng) % 4;
+        uint32_t length = lengthValue + 2;
+        int distanceValue = coin(rng) % 2;
+        int lowBitCount = (length == 2) ? 2 : lengthParam;
+        uint32_t lowBits = rng() & ((1 << lowBitCount) - 1);
+        uint32_t distance = ((distanceValue << lowBitCount) | lowBits) + 1;
+        if ((coin(rng) < 40) && (length <= remaining) && (distance <= expected.size()))
+        {
+            writer.Write(1, 1);
+            writer.WriteCode(lengthCodes[lengthValue]);
+            writer.WriteCode(distanceCodes[distanceValue]);
+            writer.Write(lowBits, lowBitCount);
+            size_t from = expected.size() - distance;
+            for (uint32_t i = 0; i < length; i++)
+            {
+                expected.push_back(expected[from + i]);
+            }
+        }
+        else
+        {
+            writer.Write(0, 1);
+            if (mode == 1)
+            {
+                int which = coin(rng) % 2;
+                writer.WriteCode(asciiCodes[which]);
+                expected.push_back(asciiValues[which]);
+            }
+            else
+            {
+                uint8_t literal = (uint8_t)rng();
+                writer.Write(literal, 8);
+                expected.push_back(literal);
+            }
+        }
+    }
+    writer.Flush();
+    packed = writer.Data;
+    // The reference decoder reads a few bytes ahead of what it needs.
+    packed.resize(packed.size() + 4, 0);
+    return expected;
+}
+
+// Some data with different characteristics to feed the encoders: noise, runs, and repeated phrases.
+std::vector<uint8_t> GenerateEncoderInput(std::mt19937 &rng, uint32_t size, int kind)
+{
+    const char phrase[] = "You see nothing special about the ";
+    std::vector<uint8_t> data(size);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        switch (kind % 3)
+        {
+            case 0:
+                data[i] = (uint8_t)rng();
+                break;
+            case 1:
+                data[i] = (i && (rng() % 4)) ? data[i - 1] : (uint8_t)(rng() % 8);
+                break;
+            case 2:
+                data[i] = (rng() % 16) ? phrase[(i + (rng() % 2)) % (ARRAYSIZE(phrase) - 1)] : (uint8_t)rng();
+                break;
+        }
+    }
+    return data;
+}
+
+namespace UnitTests
+{
+    TEST_CLASS(TestCodec)
+    {
+    public:
+        TEST_CLASS_INITIALIZE(ClassSetup)
+        {
+            // The decompressors log errors through appState
+            appState = new AppState(nullptr);
+        }
+
+        TEST_CLASS_CLEANUP(ClassCleanup)
+        {
+            delete appState;
+            appState = nullptr;
+        }
+
+        TEST_METHOD(TestDCLValidStreams)
+        {
+            std::mt19937 rng(1234);
+            for (int i = 0; i < 500; i++)
+            {
+                int mode = i % 2;
+                int lengthParam = 4 + (i % 3);
+                uint32_t unpackedSize = 1 + (rng() % 8192);
+                std::vector<uint8_t> packed;
+                std::vector<uint8_t> expected = GenerateDCLStream(rng, mode, lengthParam, unpackedSize, packed);
+
+                std::vector<uint8_t> unpacked(unpackedSize);
+                Assert::IsTrue(decompressDCL(&unpacked[0], &packed[0], unpackedSize, (uint32_t)packed.size()));
+                Assert::IsTrue(expected == unpacked, fmt::format(L"Mismatch for stream {0}", i).c_str());
+            }
+        }
+
+        // Feeds random (and mostly broken) input to both the table-driven and reference DCL decoders,
+        // and makes sure they agree on both the result and the output.
+        TEST_METHOD(TestDCLDifferentialFuzz)
+        {
+            std::mt19937 rng(5678);
+            int succeeded = 0;
+            const int iterations = 20000;
+            for (int i = 0; i < iterations; i++)
+            {
+                uint32_t unpackedSize = 1 + (rng() % 1024);
+                uint32_t packedSize = 2 + (rng() % 1024);
+
+                // The reference decoder reads past the end of the packed data (which we fill with zeroes,
+                // just like the table-driven decoder assumes), so leave plenty of room.
+                std::vector<uint8_t> packed(packedSize + unpackedSize * 4 + 64, 0);
+                // Mostly valid modes, and length params, with the occasional bad one.
+                packed[0] = (rng() % 16) ? (rng() % 2) : (uint8_t)rng();
+                packed[1] = (rng() % 16) ? (3 + (rng() % 4)) : (rng() % 25);
+
+                // Bias the bits towards zero some of the time, so that we get more literals and short
+                // copies, and therefore more streams that make it to the end.
+                int oneBitPercent = 2 + (rng() % 40);
+                for (uint32_t b = 2; b < packedSize; b++)
+                {
+                    uint8_t value = 0;
+                    for (int bit = 0; bit < 8; bit++)
+                    {
+                        if ((int)(rng() % 100) < oneBitPercent)
+                        {
+                            value |= (1 << bit);
+                        }
+                    }
+                    packed[b] = value;
+                }
+
+                std::vector<uint8_t> fast(unpackedSize, 0xcd);
+                std::vector<uint8_t> reference(unpackedSize, 0xcd);
+                bool fastResult = decompressDCL(&fast[0], &packed[0], unpackedSize, packedSize);
+                bool referenceResult = decompressDCLBitwise(&reference[0], &packed[0], unpackedSize, packedSize);
+                Assert::AreEqual(referenceResult, fastResult, fmt::format(L"Result mismatch for iteration {0}", i).c_str());
+                Assert::IsTrue(reference == fast, fmt::format(L"Output mismatch for iteration {0}", i).c_str());
+                if (fastResult)
+                {
+                    succeeded++;
+                }
+            }
+            Logger::WriteMessage(fmt::format("{0} of {1} random DCL streams decompressed successfully.\n", succeeded, iterations).c_str());
+        }
+
+        TEST_METHOD(TestDCLEncoderRoundTrip)
+        {
+            std::mt19937 rng(99);
+            for (int i = 0; i < 300; i++)
+            {
+                uint32_t size = (i < 30) ? (rng() % 200000) : (rng() % 4096);
+                std::vector<uint8_t> data = GenerateEncoderInput(rng, size, i);
+                std::vector<uint8_t> packed;
+                Assert::IsTrue(compressDCL(data.empty() ? nullptr : &data[0], size, packed));
+                std::vector<uint8_t> unpacked(size + 1);
+                Assert::IsTrue(decompressDCL(&unpacked[0], &packed[0], size, (uint32_t)packed.size()), fmt::format(L"Failed to decompress {0}", i).c_str());
+                Assert::IsTrue(std::equal(data.begin(), data.end(), unpacked.begin()), fmt::format(L"Mismatch for {0}", i).c_str());
+            }
+        }
+
+        TEST_METHOD(TestDCLEncoderEndMarker)
+        {
+            // The interpreter doesn't know the unpacked size up front; it decodes until the end-of-stream
+            // code. So decode that way, with plenty of room, and check we stop exactly at the end of the data.
+            std::mt19937 rng(103);
+            for (int i = 0; i < 100; i++)
+            {
+                uint32_t size = rng() % 8192;
+                std::vector<uint8_t> data = GenerateEncoderInput(rng, size, i);
+                std::vector<uint8_t> packed;
+                Assert::IsTrue(compressDCL(data.empty() ? nullptr : &data[0], size, packed));
+                std::vector<uint8_t> unpacked(size + 1024);
+                uint32_t unpackedSize = 0;
+                Assert::IsTrue(decompressDCLUntilEndMarker(&unpacked[0], &packed[0], (uint32_t)unpacked.size(), (uint32_t)packed.size(), unpackedSize), fmt::format(L"No end marker for {0}", i).c_str());
+                Assert::AreEqual(size, unpackedSize);
+                Assert::IsTrue(std::equal(data.begin(), data.end(), unpacked.begin()), fmt::format(L"Mismatch for {0}", i).c_str());
+            }
+
+            // A stream without the end code is rejected.
+            std::vector<uint8_t> noMarker = { 0x00, 0x06, 0x82, 0x00 };  // Binary mode, 4KB dictionary, the literal 'A'
+            std::vector<uint8_t> unpacked(64);
+            uint32_t unpackedSize = 0;
+            Assert::IsFalse(decompressDCLUntilEndMarker(&unpacked[0], &noMarker[0], (uint32_t)unpacked.size(), (uint32_t)noMarker.size(), unpackedSize));
+        }
+
+        TEST_METHOD(TestLZWEncoderRoundTrip)
+        {
+            std::mt19937 rng(101);
+            for (int i = 0; i < 300; i++)
+            {
+                // Big enough to fill the token table, but within the 64KB limit of SCI0 resources.
+                uint32_t size = (i < 30) ? (rng() % 0xfff0) : (rng() % 4096);
+                std::vector<uint8_t> data = GenerateEncoderInput(rng, size, i);
+                std::vector<uint8_t> packed;
+                if (compressLZW(data.empty() ? nullptr : &data[0], size, packed))
+                {
+                    std::vector<uint8_t> unpacked(size + 1);
+                    Assert::AreEqual(0, decompressLZW(&unpacked[0], &packed[0], size, (int)packed.size()));
+                    Assert::IsTrue(std::equal(data.begin(), data.end(), unpacked.begin()), fmt::format(L"Mismatch for {0}", i).c_str());
+                }
+                else
+                {
+                    // Only incompressible data should end up too big.
+                    Assert::AreEqual(0, i % 3);
+                }
+            }
+        }
+
+        TEST_METHOD(TestDCLThroughput)
+        {
+            std::mt19937 rng(42);
+            const uint32_t unpackedSize = 64 * 1024;
+            std::vector<std::vector<uint8_t>> streams;
+            for (int i = 0; i < 16; i++)
+            {
+                std::vector<uint8_t> packed;
+                GenerateDCLStream(rng, i % 2, 6, unpackedSize, packed);
+                streams.push_back(packed);
+            }
+
+            std::vector<uint8_t> unpacked(unpackedSize);
+            const int passes = 20;
+            double seconds[2];
+            for (int decoder = 0; decoder < 2; decoder++)
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                for (int pass = 0; pass < passes; pass++)
+                {
+                    for (auto &packed : streams)
+                    {
+                        bool result = (decoder == 0) ?
+                            decompressDCL(&unpacked[0], &packed[0], unpackedSize, (uint32_t)packed.size()) :
+                            decompressDCLBitwise(&unpacked[0], &packed[0], unpackedSize, (uint32_t)packed.size());
+                        Assert::IsTrue(result);
+                    }
+                }
+                seconds[decoder] = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            }
+
+            double megabytes = (double)unpackedSize * streams.size() * passes / (1024.0 * 1024.0);
+            Logger::WriteMessage(fmt::format("DCL table-driven: {0:.1f} MB/s, bitwise: {1:.1f} MB/s\n", megabytes / seconds[0], megabytes / seconds[1]).c_str());
+        }
+    };
+}
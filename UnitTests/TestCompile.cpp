@@ -19,9 +19,189 @@
 #include "CompileContext.h"
 #include "Helper.h"
 #include "ScriptConvert.h"
+#include "BatchCompile.h"
+#include "ParallelScriptParser.h"
+#include "HeaderCache.h"
+#include "BuildGraph.h"
+#include "DecompileCache.h"
+#include "BatchDecompile.h"
+#include "DecompileScript.h"
+#include "DecompilerCore.h"
+#include "DecompilerConfig.h"
+#include "DecompilerResults.h"
+#include "CompiledScript.h"
+#include "ResourceContainer.h"
+#include "SyntaxParser.h"
+#include "IncrementalParse.h"
+#include "CCrystalTextBuffer.h"
+#include "CrystalScriptStream.h"
+#include "ControlFlowNode.h"
+#include "TarjanAlgorithm.h"
+#include "format.h"
+#include <atomic>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
+class TestDecompilerResults : public IDecompilerResults
+{
+public:
+    void AddResult(DecompilerResultType type, const std::string &message) override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _messages.push_back(message);
+    }
+    size_t CountMessagesContaining(const std::string &text)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return std::count_if(_messages.begin(), _messages.end(), [&text](const std::string &message) { return message.find(text) != std::string::npos; });
+    }
+    bool IsAborted() override { return false; }
+    void InformStats(bool functionSuccessful, int byteCount) override {}
+    void SetGlobalVarsUpdated(const std::vector<std::pair<std::string, std::string>> &mainDirtyRenames) override {}
+
+private:
+    std::mutex _mutex;
+    std::vector<std::string> _messages;
+};
+
+// Checks each dominator calculation the decompiler does against the original algorithm, which
+// iteratively intersected each node's set of dominators with its predecessors' until nothing changed.
+class DominatorCheckingResults : public TestDecompilerResults
+{
+public:
+    DominatorCheckingResults() : Checked(0), Mismatches(0) {}
+
+    void InformDominators(const NodeSet &nodes, ControlFlowNode *entry, const std::function<NodeSet(ControlFlowNode*)> &edgesIn, const DominatorMap &dominators) override
+    {
+        std::map<ControlFlowNode*, NodeSet> expected = _IterateDominators(nodes, entry, edgesIn);
+        bool match = true;
+        for (ControlFlowNode *a : nodes)
+        {
+            for (ControlFlowNode *b : nodes)
+            {
+                match = match && (expected[a].contains(b) == dominators.IsADominatedByB(a, b));
+            }
+        }
+
+        std::map<ControlFlowNode*, ControlFlowNode*> expectedIdoms, idoms;
+        bool expectedThrew = false;
+        bool threw = false;
+        try
+        {
+            expectedIdoms = _ImmediateDominators(expected);
+        }
+        catch (ControlFlowException &)
+        {
+            expectedThrew = true;
+        }
+        try
+        {
+            idoms = CalculateImmediateDominators(dominators);
+        }
+        catch (ControlFlowException &)
+        {
+            threw = true;
+        }
+        match = match && (expectedThrew == threw) && (expectedIdoms == idoms);
+
+        Checked++;
+        if (!match)
+        {
+            Mismatches++;
+        }
+    }
+
+    std::atomic<int> Checked;
+    std::atomic<int> Mismatches;
+
+private:
+    static std::map<ControlFlowNode*, NodeSet> _IterateDominators(const NodeSet &nodes, ControlFlowNode *n0, const std::function<NodeSet(ControlFlowNode*)> &edgesIn)
+    {
+        std::map<ControlFlowNode*, NodeSet> dominators;
+        dominators[n0].insert(n0);
+        NodeSet others = nodes;
+        others.erase(n0);
+        for (ControlFlowNode *n : others)
+        {
+            dominators[n] = nodes;
+        }
+
+        bool changes = true;
+        while (changes)
+        {
+            changes = false;
+            for (ControlFlowNode *n : others)
+            {
+                NodeSet newDominators;
+                newDominators.insert(n);
+                bool first = true;
+                NodeSet result;
+                for (ControlFlowNode *pred : edgesIn(n))
+                {
+                    if (first)
+                    {
+                        result = dominators[pred];
+                        first = false;
+                    }
+                    else
+                    {
+                        NodeSet intersection;
+                        NodeSet &predDominators = dominators[pred];
+                        std::set_intersection(result.begin(), result.end(), predDominators.begin(), predDominators.end(),
+                            std::inserter(intersection, intersection.begin()), std::less<ControlFlowNode*>());
+                        std::swap(intersection, result);
+                    }
+                }
+                for (ControlFlowNode *node : result)
+                {
+                    newDominators.insert(node);
+                }
+                if (newDominators != dominators[n])
+                {
+                    dominators[n] = newDominators;
+                    changes = true;
+                }
+            }
+        }
+        return dominators;
+    }
+
+    static std::map<ControlFlowNode*, ControlFlowNode*> _ImmediateDominators(const std::map<ControlFlowNode*, NodeSet> &dominatorMap)
+    {
+        // The immediate dominator is the one that doesn't dominate any of the node's other dominators.
+        std::map<ControlFlowNode*, ControlFlowNode*> immediateDominators;
+        for (const auto &pair : dominatorMap)
+        {
+            ControlFlowNode *dominatee = pair.first;
+            for (ControlFlowNode *potentialImmDom : pair.second)
+            {
+                if (potentialImmDom != dominatee)
+                {
+                    bool found = true;
+                    for (ControlFlowNode *test : pair.second)
+                    {
+                        if ((test != potentialImmDom) && (test != dominatee) && dominatorMap.at(test).contains(potentialImmDom))
+                        {
+                            found = false;
+                            break;
+                        }
+                    }
+                    if (found)
+                    {
+                        immediateDominators[dominatee] = potentialImmDom;
+                        break;
+                    }
+                }
+            }
+        }
+        if (immediateDominators.size() != (dominatorMap.size() - 1))
+        {
+            throw ControlFlowException(dominatorMap.begin()->first, "Problem with calculating dominators");
+        }
+        return immediateDominators;
+    }
+};
+
 namespace UnitTests
 {
 	TEST_CLASS(TestCompile)
@@ -47,11 +227,439 @@ namespace UnitTests
             _DoIt();
         }
 
+        TEST_METHOD(TestParallelCompileSCI0)
+        {
+            _gameFolder = SetUpGameSCI0();
+            _CompareSerialAndParallel();
+        }
+
+        TEST_METHOD(TestParallelCompileSCI11)
+        {
+            _gameFolder = SetUpGameSCI11();
+            _CompareSerialAndParallel();
+        }
+
+        TEST_METHOD(TestBatchCompileSCI0)
+        {
+            _gameFolder = SetUpGameSCI0();
+            std::vector<ScriptId> scripts;
+            appState->GetResourceMap().GetAllScripts(scripts);
+
+            CompileLog log;
+            BatchCompileReport report;
+            Assert::IsTrue(BatchCompileScripts(appState->GetResourceMap(), std::vector<ScriptId>(), log, report));
+            Assert::IsFalse(log.HasErrors());
+            Assert::AreEqual((int)scripts.size(), report.ScriptCount);
+            Assert::AreEqual(0, report.FailedCount);
+            Assert::IsTrue(report.Timings.Parse > 0);
+            Assert::IsTrue(report.Timings.CodeGen > 0);
+            Assert::IsTrue(report.ScriptsPerSecond() > 0);
+
+            // The phases shouldn't account for more than the total time.
+            double phases = report.Timings.Parse + report.Timings.Prescan + report.Timings.CodeGen + report.Timings.Write;
+            Assert::IsTrue(phases <= report.TotalSeconds);
+        }
+
+        TEST_METHOD(TestHeaderCacheSCI0)
+        {
+            _gameFolder = SetUpGameSCI0();
+            CResourceMap &resourceMap = appState->GetResourceMap();
+            std::string cacheFile = _gameFolder + "\\testheaders.bin";
+            std::vector<std::string> headers = { "game.sh", "sci.sh", "keys.sh" };
+
+            {
+                HeaderCache cache;
+                cache.SetFilename(cacheFile);
+                for (const std::string &header : headers)
+                {
+                    // The first load parses, and the second comes from the cache.
+                    std::string path = resourceMap.GetIncludePath(header);
+                    std::unique_ptr<sci::Script> parsed, cached;
+                    Assert::IsTrue(cache.Load(path, appState->GetVersion(), nullptr, parsed));
+                    Assert::IsTrue(cache.Load(path, appState->GetVersion(), nullptr, cached));
+                    _CompareHeaders(*parsed, *cached);
+                }
+                cache.Save();
+            }
+
+            // Now from the file the cache was saved to.
+            HeaderCache reloaded;
+            reloaded.SetFilename(cacheFile);
+            for (const std::string &header : headers)
+            {
+                std::string path = resourceMap.GetIncludePath(header);
+                std::unique_ptr<sci::Script> parsed, cached;
+                HeaderCache fresh;
+                Assert::IsTrue(fresh.Load(path, appState->GetVersion(), nullptr, parsed));
+                Assert::IsTrue(reloaded.Load(path, appState->GetVersion(), nullptr, cached));
+                _CompareHeaders(*parsed, *cached);
+            }
+
+            // Nothing was added or invalidated, so saving shouldn't write the file again.
+            Assert::IsTrue(!!DeleteFile(cacheFile.c_str()));
+            reloaded.Save();
+            Assert::IsFalse(!!PathFileExists(cacheFile.c_str()));
+
+            // But touching a header should.
+            std::string touched = resourceMap.GetIncludePath(headers[0]);
+            HANDLE hFile = CreateFile(touched.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            Assert::IsTrue(hFile != INVALID_HANDLE_VALUE);
+            FILETIME ft;
+            GetSystemTimeAsFileTime(&ft);
+            SetFileTime(hFile, nullptr, nullptr, &ft);
+            CloseHandle(hFile);
+            std::unique_ptr<sci::Script> refreshed;
+            Assert::IsTrue(reloaded.Load(touched, appState->GetVersion(), nullptr, refreshed));
+            reloaded.Save();
+            Assert::IsTrue(!!PathFileExists(cacheFile.c_str()));
+        }
+
+        TEST_METHOD(TestBuildGraphSCI0)
+        {
+            _gameFolder = SetUpGameSCI0();
+            CResourceMap &resourceMap = appState->GetResourceMap();
+            std::vector<ScriptId> scripts;
+            resourceMap.GetAllScripts(scripts);
+
+            // The first compile may change .sco files that earlier scripts already read, so compile twice.
+            for (int i = 0; i < 2; i++)
+            {
+                CompileLog log;
+                BatchCompileReport report;
+                Assert::IsTrue(BatchCompileScripts(resourceMap, std::vector<ScriptId>(), log, report));
+            }
+            std::unordered_set<std::string> outOfDate, unknown;
+            _GetOutOfDateScripts(scripts, outOfDate, unknown);
+            Assert::IsTrue(outOfDate.empty());
+            Assert::IsTrue(unknown.empty());
+
+            // Editing a script makes it out of date...
+            ScriptId script = scripts.back();
+            {
+                std::ofstream file(script.GetFullPath(), std::ios::out | std::ios::app);
+                file << "\n" << ((script.Language() == LangSyntaxSCI) ? ";" : "//") << " Just a comment\n";
+            }
+            outOfDate.clear();
+            _GetOutOfDateScripts(scripts, outOfDate, unknown);
+            Assert::AreEqual((size_t)1, outOfDate.size());
+            Assert::IsTrue(outOfDate.find(script.GetTitleLower()) != outOfDate.end());
+
+            // ...but its .sco comes out the same, so once it's recompiled nothing else needs to be.
+            {
+                CompileLog log;
+                BatchCompileReport report;
+                Assert::IsTrue(BatchCompileScripts(resourceMap, std::vector<ScriptId>(1, script), log, report));
+            }
+            outOfDate.clear();
+            _GetOutOfDateScripts(scripts, outOfDate, unknown);
+            Assert::IsTrue(outOfDate.empty());
+
+            // Changing a header affects the scripts that include it.
+            {
+                std::ofstream file(resourceMap.GetIncludePath("game.sh"), std::ios::out | std::ios::app);
+                file << "\n(define BUILD_GRAPH_TEST 1)\n";
+            }
+            _GetOutOfDateScripts(scripts, outOfDate, unknown);
+            Assert::IsFalse(outOfDate.empty());
+            Assert::IsTrue(unknown.empty());
+        }
+
+        TEST_METHOD(TestDecompileAllSCI0Parallel)
+        {
+            // Decompiling on several threads should produce the same source and .sco files as on one.
+            std::map<std::string, std::string> serial = _DecompileAll(1);
+            CleanUpGame(_gameFolder);
+            std::map<std::string, std::string> parallel = _DecompileAll(4);
+            Assert::IsFalse(serial.empty());
+            Assert::IsTrue(serial == parallel);
+        }
+
+        TEST_METHOD(TestDominatorsMatchIterativeSCI0)
+        {
+            // Every set of nodes the decompiler calculates (post-)dominators for, over the whole game, should
+            // get the same answers from the dominator tree as from the original iterative calculation.
+            _gameFolder = SetUpGameSCI0();
+            DominatorCheckingResults results;
+            _DecompileGame(4, nullptr, results);
+            Logger::WriteMessage(fmt::format("Checked {0} dominator calculations\n", (int)results.Checked).c_str());
+            Assert::IsTrue(results.Checked > 0);
+            Assert::AreEqual(0, (int)results.Mismatches);
+        }
+
+        TEST_METHOD(TestDecompileCache)
+        {
+            _gameFolder = SetUpGameSCI0();
+            DecompileCache cache;
+            TestDecompilerResults firstResults;
+            std::map<std::string, std::string> previous = _DecompileGame(4, &cache, firstResults);
+            Assert::AreEqual((size_t)0, firstResults.CountMessagesContaining("(unchanged)"));
+
+            // The first decompile rewrites the .sco files, so scripts that read them may be decompiled again
+            // once. After that, nothing has changed, so everything should come from the cache, unchanged.
+            size_t scriptCount = 0;
+            bool allCached = false;
+            for (int pass = 0; !allCached && (pass < 3); pass++)
+            {
+                TestDecompilerResults results;
+                std::map<std::string, std::string> files = _DecompileGame(4, &cache, results);
+                scriptCount = files.size() / 2;
+                allCached = (results.CountMessagesContaining("(unchanged)") == scriptCount);
+                if (allCached)
+                {
+                    Assert::IsTrue(previous == files);
+                }
+                previous = files;
+            }
+            Assert::IsTrue(allCached);
+
+            // Changing a decompile option means everything is decompiled again.
+            TestDecompilerResults results;
+            _DecompileGame(4, &cache, results, true);
+            Assert::AreEqual((size_t)0, results.CountMessagesContaining("(unchanged)"));
+
+            // The config that batch was prepared with is gone now, so the cache shouldn't use it.
+            DecompileCache::Result result;
+            Assert::IsFalse(cache.Lookup(appState->GetResourceMap().Helper(), 0, result));
+        }
+
+        TEST_METHOD(TestRecordingDecompilerConfig)
+        {
+            // Only the real config can be wrapped, and a recording config isn't one.
+            _gameFolder = SetUpGameSCI0();
+            const GameFolderHelper &helper = appState->GetResourceMap().Helper();
+            GlobalCompiledScriptLookups lookups;
+            Assert::IsTrue(lookups.Load(helper));
+            std::unique_ptr<IDecompilerConfig> config = CreateDecompilerConfig(helper, lookups.GetSelectorTable());
+            std::map<std::string, uint32_t> entriesUsed;
+            std::unique_ptr<IDecompilerConfig> recording = CreateRecordingDecompilerConfig(*config, entriesUsed);
+            Assert::ExpectException<std::exception>([&]() { CreateRecordingDecompilerConfig(*recording, entriesUsed); });
+        }
+
+        TEST_METHOD(TestIncrementalParseSCI)
+        {
+            _gameFolder = SetUpGameSCI0();
+            CCrystalTextBuffer buffer;
+            buffer.InitNew();
+            int endLine, endChar;
+            buffer.InsertText(nullptr, 0, 0,
+                "(script# 5)\r\n"
+                "(local\r\n"
+                "    a = 0\r\n"
+                ")\r\n"
+                "; Adds one\r\n"
+                "(procedure (Foo x)\r\n"
+                "    (return (+ x 1))\r\n"
+                ")\r\n"
+                "(class Bar of Obj\r\n"
+                "    (properties\r\n"
+                "        y 0\r\n"
+                "    )\r\n"
+                "    (method (doit)\r\n"
+                "        (Foo y) ; Call it\r\n"
+                "    )\r\n"
+                ")\r\n"
+                "(procedure (Baz)\r\n"
+                "    (= a (Foo a))\r\n"
+                ")\r\n",
+                endLine, endChar);
+
+            // No file by this name exists, so it's treated as SCI syntax.
+            std::string path = _gameFolder + "\\IncrementalTest.sc";
+            std::unique_ptr<sci::Script> script;
+            IncrementalParseState state;
+            _FullParse(buffer, path, script, &state);
+            Assert::AreEqual((int)LangSyntaxSCI, (int)script->Language());
+
+            // Edits in the middle of constructs, with and without changing the number of lines.
+            Assert::IsTrue(_EditAndReparse(buffer, 6, " ", *script, state));
+            Assert::IsTrue(_EditAndReparse(buffer, 13, "\r\n", *script, state));
+            Assert::IsTrue(_EditAndReparse(buffer, 18, "    (Foo 2)\r\n", *script, state));
+
+            // A parse error leaves the script as it was.
+            std::string before = _DumpScript(*script);
+            buffer.InsertText(nullptr, 6, 0, "(", endLine, endChar);
+            Assert::IsFalse(_ReparseIncremental(buffer, *script, state));
+            Assert::AreEqual(before, _DumpScript(*script));
+            buffer.DeleteText(nullptr, 6, 0, 6, 1);
+            Assert::IsTrue(_ReparseIncremental(buffer, *script, state));
+            Assert::AreEqual(before, _DumpScript(*script));
+
+            // Changing the script number can't be done incrementally.
+            Assert::IsFalse(_EditAndReparse(buffer, 0, " ", *script, state));
+        }
+
+        TEST_METHOD(TestIncrementalParseSCI11)
+        {
+            _gameFolder = SetUpGameSCI11();
+            std::vector<ScriptId> scripts;
+            appState->GetResourceMap().GetAllScripts(scripts);
+            int incrementalCount = 0;
+            for (auto &scriptId : scripts)
+            {
+                CCrystalTextBuffer buffer;
+                Assert::IsTrue(!!buffer.LoadFromFile(scriptId.GetFullPath().c_str()));
+                std::unique_ptr<sci::Script> script;
+                IncrementalParseState state;
+                _FullParse(buffer, scriptId.GetFullPath(), script, &state);
+
+                int lineCount = buffer.GetLineCount();
+                for (int line : { lineCount / 2, lineCount * 3 / 4 })
+                {
+                    // A new line moves everything after it, and a space at the start of a line doesn't.
+                    for (const char *text : { "\r\n", " " })
+                    {
+                        if (_EditAndReparse(buffer, line, text, *script, state))
+                        {
+                            incrementalCount++;
+                        }
+                        else
+                        {
+                            // This is what the class browser does.
+                            _FullParse(buffer, scriptId.GetFullPath(), script, &state);
+                        }
+                    }
+                }
+            }
+            Assert::IsTrue(incrementalCount > 0);
+        }
+
         TEST_METHOD_CLEANUP(TestCompileAll_Clean)
         {
             CleanUpGame(_gameFolder);
         }
 
+        // Decompiles all the scripts in a fresh copy of the game, and returns the contents of the files generated.
+        std::map<std::string, std::string> _DecompileAll(unsigned int threadCount)
+        {
+            _gameFolder = SetUpGameSCI0();
+            TestDecompilerResults results;
+            return _DecompileGame(threadCount, nullptr, results);
+        }
+
+        // Decompiles all the scripts in the current game, and returns the contents of the files generated.
+        std::map<std::string, std::string> _DecompileGame(unsigned int threadCount, DecompileCache *cache, TestDecompilerResults &results, bool substituteTextTuples = false)
+        {
+            const GameFolderHelper &helper = appState->GetResourceMap().Helper();
+            GlobalCompiledScriptLookups lookups;
+            Assert::IsTrue(lookups.Load(helper));
+            std::unique_ptr<IDecompilerConfig> config = CreateDecompilerConfig(helper, lookups.GetSelectorTable());
+            appState->GetResourceMap().GetVocab000();
+
+            std::set<uint16_t> scriptNumbers;
+            for (auto &blob : *helper.Resources(ResourceTypeFlags::Script, ResourceEnumFlags::MostRecentOnly))
+            {
+                scriptNumbers.insert((uint16_t)blob->GetNumber());
+            }
+
+            if (cache)
+            {
+                cache->Prepare(helper, lookups, *config, false, substituteTextTuples);
+            }
+            DecompileScripts(helper, lookups.GetSelectorTable(), scriptNumbers, results,
+                [&](uint16_t scriptNumber, CompiledScript &compiledScript, IDecompilerResults &scriptResults, DecompileOutputs &outputs)
+                {
+                    return DecompileScript(config.get(), lookups, helper, scriptNumber, compiledScript, scriptResults, false, false, nullptr, false, substituteTextTuples, &outputs);
+                },
+                threadCount, cache);
+
+            std::map<std::string, std::string> files;
+            for (uint16_t scriptNumber : scriptNumbers)
+            {
+                for (const std::string &filename : { helper.GetScriptFileName(scriptNumber), helper.GetScriptObjectFileName(scriptNumber) })
+                {
+                    std::ifstream file(filename, std::ios::binary);
+                    Assert::IsTrue(file.is_open());
+                    files[filename.substr(_gameFolder.length())].assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                }
+            }
+            return files;
+        }
+
+        // Writes out the source code for the script, and the position of everything in it.
+        std::string _DumpScript(sci::Script &script)
+        {
+            class PositionDump : public sci::IExploreNode
+            {
+            public:
+                PositionDump(std::stringstream &ss) : _ss(ss) {}
+                void ExploreNode(sci::SyntaxNode &node, sci::ExploreNodeState state) override
+                {
+                    if (state == sci::ExploreNodeState::Pre)
+                    {
+                        _ss << (int)node.GetNodeType() << ":" << node.GetLineNumber() << "," << node.GetColumnNumber() << "\n";
+                    }
+                }
+            private:
+                std::stringstream &_ss;
+            };
+
+            std::stringstream ss;
+            sci::SourceCodeWriter out(ss, script.Language(), &script);
+            script.OutputSourceCode(out);
+            PositionDump dump(ss);
+            script.Traverse(dump);
+            for (auto &comment : script.GetComments())
+            {
+                ss << comment->GetLineNumber() << "," << comment->GetColumnNumber() << ":" << comment->GetName() << "\n";
+            }
+            return ss.str();
+        }
+
+        void _FullParse(CCrystalTextBuffer &buffer, const std::string &path, std::unique_ptr<sci::Script> &script, IncrementalParseState *state)
+        {
+            CScriptStreamLimiter limiter(&buffer);
+            CCrystalScriptStream stream(&limiter);
+            script = std::make_unique<sci::Script>(path.c_str());
+            Assert::IsTrue(SyntaxParser_Parse(*script, stream, PreProcessorDefinesFromSCIVersion(appState->GetVersion()), nullptr, true, nullptr, false, state));
+        }
+
+        bool _ReparseIncremental(CCrystalTextBuffer &buffer, sci::Script &script, IncrementalParseState &state)
+        {
+            CScriptStreamLimiter limiter(&buffer);
+            CCrystalScriptStream stream(&limiter);
+            return SyntaxParser_ParseIncremental(script, state, stream, PreProcessorDefinesFromSCIVersion(appState->GetVersion()));
+        }
+
+        // Inserts text at the start of a line and re-parses incrementally. If that worked, the result should be
+        // the same as parsing the whole thing again.
+        bool _EditAndReparse(CCrystalTextBuffer &buffer, int line, const char *text, sci::Script &script, IncrementalParseState &state)
+        {
+            int endLine, endChar;
+            buffer.InsertText(nullptr, line, 0, text, endLine, endChar);
+            bool incremental = _ReparseIncremental(buffer, script, state);
+            if (incremental)
+            {
+                std::unique_ptr<sci::Script> fullScript;
+                _FullParse(buffer, script.GetScriptId().GetFullPath(), fullScript, nullptr);
+                Assert::AreEqual(_DumpScript(*fullScript), _DumpScript(script));
+            }
+            return incremental;
+        }
+
+        void _GetOutOfDateScripts(const std::vector<ScriptId> &scripts, std::unordered_set<std::string> &outOfDate, std::unordered_set<std::string> &unknown)
+        {
+            CompileTables tables;
+            tables.Load(appState->GetVersion());
+            appState->GetResourceMap().GetBuildGraph().GetOutOfDateScripts(appState->GetResourceMap(), tables, scripts, outOfDate, unknown);
+        }
+
+        void _CompareHeaders(const sci::Script &one, const sci::Script &two)
+        {
+            Assert::IsTrue(one.GetIncludes() == two.GetIncludes());
+            Assert::AreEqual(one.GetDefines().size(), two.GetDefines().size());
+            Assert::IsFalse(one.GetDefines().empty());
+            for (size_t i = 0; i < one.GetDefines().size(); i++)
+            {
+                const sci::Define &defineOne = *one.GetDefines()[i];
+                const sci::Define &defineTwo = *two.GetDefines()[i];
+                Assert::AreEqual(defineOne.GetLabel(), defineTwo.GetLabel());
+                Assert::AreEqual(defineOne.GetValue(), defineTwo.GetValue());
+                Assert::IsTrue(defineOne.GetFlags() == defineTwo.GetFlags());
+                Assert::AreEqual(defineOne.GetLineNumber(), defineTwo.GetLineNumber());
+                Assert::AreEqual(defineOne.GetColumnNumber(), defineTwo.GetColumnNumber());
+            }
+        }
+
         void _DoItHelper()
         {
             std::vector<ScriptId> scripts;
@@ -69,6 +677,64 @@ namespace UnitTests
             Assert::IsFalse(log.HasErrors());
         }
 
+        // Compiles every script the way Compile All does, with parsing on worker threads if parallel is set.
+        // The script and heap bytes for each are added to output.
+        void _CompileAll(std::vector<ScriptId> scripts, bool parallel, std::vector<std::vector<uint8_t>> &output)
+        {
+            CompileLog log;
+            CompileTables tables;
+            tables.Load(appState->GetVersion());
+            PrecompiledHeaders headers(appState->GetResourceMap());
+            std::unique_ptr<ParallelScriptParser> parser;
+            if (parallel)
+            {
+                parser = std::make_unique<ParallelScriptParser>(scripts);
+            }
+            for (size_t i = 0; i < scripts.size(); i++)
+            {
+                CompileResults results(log);
+                if (parallel)
+                {
+                    std::unique_ptr<sci::Script> script;
+                    while (!parser->TryTake(i, std::chrono::milliseconds(50), log, script))
+                    {
+                    }
+                    if (script)
+                    {
+                        GenerateParsedScript(results, log, tables, headers, scripts[i], *script);
+                    }
+                }
+                else
+                {
+                    NewCompileScript(results, log, tables, headers, scripts[i]);
+                }
+                output.push_back(results.GetScriptResource());
+                output.push_back(results.GetHeapResource());
+            }
+            log.CalculateErrors();
+            Assert::IsFalse(log.HasErrors());
+        }
+
+        void _CompareSerialAndParallel()
+        {
+            std::vector<ScriptId> scripts;
+            appState->GetResourceMap().GetAllScripts(scripts);
+
+            // Code generation reads the .sco files from earlier compiles, so compile once first. That way
+            // both of the compiles we compare start from the same files.
+            std::vector<std::vector<uint8_t>> first, parallel, serial;
+            _CompileAll(scripts, false, first);
+            _CompileAll(scripts, true, parallel);
+            _CompileAll(scripts, false, serial);
+
+            Assert::AreEqual((int)serial.size(), (int)parallel.size());
+            for (size_t i = 0; i < serial.size(); i++)
+            {
+                std::wstring message = fmt::format(L"{0} differs when parsed in parallel ({1}).", scripts[i / 2].GetTitle(), (i % 2) ? "heap" : "script");
+                Assert::IsTrue(serial[i] == parallel[i], message.c_str());
+            }
+        }
+
         void _DoIt()
         {
             _DoItHelper();
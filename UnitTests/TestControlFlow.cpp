@@ -0,0 +1,290 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "ControlFlowNode.h"
+#include "ControlFlowGraph.h"
+#include "TarjanAlgorithm.h"
+#include "format.h"
+#include <chrono>
+#include <atomic>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+    // NodeSet as it was before small sets were stored inline: a plain vector that reserved room for 20 nodes.
+    struct VectorNodeSet : public sorted_vector<ControlFlowNode*>
+    {
+        VectorNodeSet() { V.reserve(20); }
+    };
+
+    std::atomic<int> g_allocationCount;
+
+#ifdef _DEBUG
+    int __cdecl _CountAllocations(int allocType, void *userData, size_t size, int blockType, long requestNumber, const unsigned char *filename, int lineNumber)
+    {
+        if (allocType == _HOOK_ALLOC)
+        {
+            g_allocationCount++;
+        }
+        return TRUE;
+    }
+#endif
+}
+
+namespace UnitTests
+{
+    TEST_CLASS(TestControlFlow)
+    {
+    public:
+        TEST_METHOD(TestDominatorsDiamondLoop)
+        {
+            // 0 -> 1, 0 -> 2, 1 -> 3, 2 -> 3, 3 -> 4, 4 -> 1
+            _CreateNodes(5);
+            _Edge(0, 1); _Edge(0, 2); _Edge(1, 3); _Edge(2, 3); _Edge(3, 4); _Edge(4, 1);
+
+            DominatorMap dominators = _GetDominators();
+            Assert::IsTrue(dominators.HasSingleEntry());
+            for (auto &node : _nodes)
+            {
+                Assert::IsTrue(dominators.IsADominatedByB(node.get(), node.get()));
+                Assert::IsTrue(dominators.IsADominatedByB(node.get(), _nodes[0].get()));
+            }
+            Assert::IsFalse(dominators.IsADominatedByB(_nodes[3].get(), _nodes[1].get()));
+            Assert::IsFalse(dominators.IsADominatedByB(_nodes[3].get(), _nodes[2].get()));
+            Assert::IsTrue(dominators.IsADominatedByB(_nodes[4].get(), _nodes[3].get()));
+            Assert::IsFalse(dominators.IsADominatedByB(_nodes[1].get(), _nodes[4].get()));
+            Assert::IsFalse(dominators.IsADominatedByB(_nodes[0].get(), _nodes[1].get()));
+
+            std::map<ControlFlowNode*, ControlFlowNode*> idoms = CalculateImmediateDominators(dominators);
+            Assert::AreEqual((size_t)4, idoms.size());
+            Assert::IsTrue(idoms[_nodes[1].get()] == _nodes[0].get());
+            Assert::IsTrue(idoms[_nodes[2].get()] == _nodes[0].get());
+            Assert::IsTrue(idoms[_nodes[3].get()] == _nodes[0].get());
+            Assert::IsTrue(idoms[_nodes[4].get()] == _nodes[3].get());
+        }
+
+        TEST_METHOD(TestDominatorsExtraEntry)
+        {
+            // Node 2 has no predecessors, so it is only dominated by itself, and so is what it leads to.
+            _CreateNodes(4);
+            _Edge(0, 1); _Edge(1, 3); _Edge(2, 3);
+
+            DominatorMap dominators = _GetDominators();
+            Assert::IsFalse(dominators.HasSingleEntry());
+            Assert::IsTrue(dominators.IsADominatedByB(_nodes[1].get(), _nodes[0].get()));
+            Assert::IsFalse(dominators.IsADominatedByB(_nodes[2].get(), _nodes[0].get()));
+            Assert::IsFalse(dominators.IsADominatedByB(_nodes[3].get(), _nodes[0].get()));
+            Assert::IsFalse(dominators.IsADominatedByB(_nodes[3].get(), _nodes[2].get()));
+            Assert::ExpectException<ControlFlowException>([&]() { CalculateImmediateDominators(dominators); });
+        }
+
+        TEST_METHOD(TestDominatorsLargeGraph)
+        {
+            // A long chain of if/else diamonds, with a loop back every few of them, like a big decompiled function.
+            const int diamonds = 1000;
+            _CreateNodes(diamonds * 3 + 1);
+            for (int i = 0; i < diamonds; i++)
+            {
+                int head = i * 3;
+                _Edge(head, head + 1);
+                _Edge(head, head + 2);
+                _Edge(head + 1, head + 3);
+                _Edge(head + 2, head + 3);
+                if ((i % 10) == 9)
+                {
+                    _Edge(head + 3, head - 24);
+                }
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            DominatorMap dominators = _GetDominators();
+            std::map<ControlFlowNode*, ControlFlowNode*> idoms = CalculateImmediateDominators(dominators);
+            int queries = 0;
+            for (int i = 0; i <= diamonds; i++)
+            {
+                ControlFlowNode *head = _nodes[i * 3].get();
+                for (int j = 0; j <= diamonds; j += 7)
+                {
+                    Assert::AreEqual(j <= i, dominators.IsADominatedByB(head, _nodes[j * 3].get()));
+                    queries++;
+                }
+                if (i > 0)
+                {
+                    Assert::IsTrue(idoms[head] == _nodes[(i - 1) * 3].get());
+                    Assert::IsFalse(dominators.IsADominatedByB(head, _nodes[i * 3 - 1].get()));
+                }
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            Logger::WriteMessage(fmt::format("Dominators of {0} nodes, and {1} queries: {2:.1f}ms\n", _nodes.size(), queries, ms).c_str());
+        }
+
+        TEST_METHOD(TestNodeSetAllocations)
+        {
+            // Measures a structuring-like workload over a number of methods, with nodes and sets stored the
+            // way the decompiler stores them now and the way it used to.
+            const int methods = 200;
+            const int nodesPerMethod = 300;
+            int oldAllocations, newAllocations;
+            double oldMs = _MeasureWorkload<VectorNodeSet, false>(methods, nodesPerMethod, oldAllocations);
+            double newMs = _MeasureWorkload<NodeSet, true>(methods, nodesPerMethod, newAllocations);
+            Logger::WriteMessage(fmt::format("Per-node allocation and vector sets: {0} allocations per method, {1:.0f}ms\n", oldAllocations / methods, oldMs).c_str());
+            Logger::WriteMessage(fmt::format("Arena and inline sets: {0} allocations per method, {1:.0f}ms\n", newAllocations / methods, newMs).c_str());
+#ifdef _DEBUG
+            // Allocations are only counted with the debug CRT.
+            Assert::IsTrue(newAllocations < oldAllocations);
+#endif
+        }
+
+        TEST_METHOD(TestNodeSet)
+        {
+            // Enough nodes to spill out of the inline storage, inserted out of order.
+            _CreateNodes(12);
+            NodeSet nodes;
+            for (int i = 11; i >= 0; i -= 2)
+            {
+                nodes.insert(_nodes[i].get());
+            }
+            for (int i = 0; i < 12; i += 2)
+            {
+                nodes.insert(_nodes[i].get());
+            }
+            nodes.insert(_nodes[5].get());
+            Assert::AreEqual((size_t)12, nodes.size());
+            int expected = 0;
+            for (ControlFlowNode *node : nodes)
+            {
+                Assert::IsTrue(node == _nodes[expected++].get());
+            }
+
+            // Erasing something that isn't there leaves the set alone.
+            NodeSet copy = nodes;
+            copy.erase(_nodes[3].get());
+            copy.erase(_nodes[3].get());
+            Assert::AreEqual((size_t)11, copy.size());
+            Assert::IsFalse(copy.contains(_nodes[3].get()));
+            Assert::IsTrue(copy.contains(_nodes[4].get()));
+            Assert::IsTrue(nodes.contains(_nodes[3].get()));
+
+            NodeSet moved = std::move(copy);
+            Assert::AreEqual((size_t)11, moved.size());
+            Assert::IsTrue(copy.empty());
+            Assert::IsTrue(moved != nodes);
+        }
+
+    private:
+        // Builds each method's nodes, gives them predecessors, then does what structuring does a lot of: copy the
+        // working set, collect the nodes between two points, and filter predecessor sets into new sets.
+        template<typename _TSet, bool _UseArena>
+        static double _MeasureWorkload(int methods, int nodesPerMethod, int &allocations)
+        {
+#ifdef _DEBUG
+            _CRT_ALLOC_HOOK oldHook = _CrtSetAllocHook(_CountAllocations);
+#endif
+            g_allocationCount = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int method = 0; method < methods; method++)
+            {
+                ControlFlowNodeArena arena;
+                std::vector<std::unique_ptr<ControlFlowNode>> owner;
+                std::vector<ControlFlowNode*> nodes;
+                for (int i = 0; i < nodesPerMethod; i++)
+                {
+                    if (_UseArena)
+                    {
+                        nodes.push_back(arena.Create<ExitNode>((uint16_t)i));
+                    }
+                    else
+                    {
+                        owner.push_back(std::make_unique<ExitNode>((uint16_t)i));
+                        nodes.push_back(owner.back().get());
+                    }
+                }
+
+                std::vector<_TSet> preds(nodes.size());
+                _TSet all;
+                for (size_t i = 0; i < nodes.size(); i++)
+                {
+                    all.insert(nodes[i]);
+                    if (i > 0)
+                    {
+                        preds[i].insert(nodes[i - 1]);
+                    }
+                    if ((i % 3) == 2)
+                    {
+                        preds[i].insert(nodes[i - 2]);
+                    }
+                    if ((i % 25) == 24)
+                    {
+                        preds[i - 20].insert(nodes[i]);
+                    }
+                }
+
+                for (size_t i = 0; i < nodes.size(); i += 5)
+                {
+                    _TSet working = all;
+                    _TSet collected;
+                    for (size_t j = i; (j > 0) && (j + 30 > i); j--)
+                    {
+                        collected.insert(nodes[j]);
+                        working.erase(nodes[j]);
+                        _TSet filtered;
+                        for (ControlFlowNode *pred : preds[j])
+                        {
+                            if (collected.find(pred) == collected.end())
+                            {
+                                filtered.insert(pred);
+                            }
+                        }
+                        _TSet copy = filtered;
+                        Assert::IsTrue(copy.size() <= preds[j].size());
+                    }
+                }
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            allocations = g_allocationCount;
+#ifdef _DEBUG
+            _CrtSetAllocHook(oldHook);
+#endif
+            return ms;
+        }
+
+        void _CreateNodes(int count)
+        {
+            _nodes.clear();
+            for (int i = 0; i < count; i++)
+            {
+                _nodes.push_back(std::make_unique<ExitNode>((uint16_t)i));
+            }
+        }
+
+        void _Edge(int from, int to)
+        {
+            _nodes[to]->InsertPredecessor(_nodes[from].get());
+        }
+
+        DominatorMap _GetDominators()
+        {
+            NodeSet nodes;
+            for (auto &node : _nodes)
+            {
+                nodes.insert(node.get());
+            }
+            return DominatorMap(nodes, _nodes[0].get(), [](ControlFlowNode *node) { return node->Predecessors(); });
+        }
+
+        std::vector<std::unique_ptr<ControlFlowNode>> _nodes;
+    };
+}
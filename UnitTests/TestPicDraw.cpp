@@ -25,12 +25,15 @@ using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 #include "ResourceMapOperations.h"
 #include "PatchResourceSource.h"
 #include "PicDrawManager.h"
+#include "PicOperations.h"
+#include "PicRenderProgram.h"
 #include "Pic.h"
 #include "ResourceEntity.h"
 #include "ResourceSourceFlags.h"
 #include "format.h"
 #include "Helper.h"
 #include "GameFolderHelper.h"
+#include <chrono>
 
 std::unique_ptr<Cel> CelFromBitmapFile(const std::string &filename)
 {
@@ -101,7 +104,31 @@ void VerifyPic(PicDrawManager &pdm, PicScreen screen, const std::string &fileNam
     }
 }
 
-void VerifyFileWorker(ResourceEntity &resource, const std::string &filenameRaw)
+// Calls picCallback with each pic patch file in folder, and its file name. Returns how many there were.
+size_t ForEachPicInFolder(SCIVersion version, const std::string &folder, std::function<void(const ResourceEntity &, const std::string &)> picCallback)
+{
+    std::unique_ptr<ResourceSourceArray> mapAndVolumes = std::make_unique<ResourceSourceArray>();
+    mapAndVolumes->push_back(std::make_unique<PatchFilesResourceSource>(ResourceTypeFlags::Pic, version, folder, ResourceSourceFlags::PatchFile));
+    std::unique_ptr<ResourceContainer> resourceContainer(
+        new ResourceContainer(
+        folder,
+        move(mapAndVolumes),
+        ResourceTypeFlags::Pic,
+        ResourceEnumFlags::None,
+        nullptr)
+        );
+
+    size_t count = 0;
+    for (auto blob : *resourceContainer)
+    {
+        std::unique_ptr<ResourceEntity> resource = CreateResourceFromResourceData(*blob);
+        picCallback(*resource, GetFileNameFor(*blob));
+        count++;
+    }
+    return count;
+}
+
+void VerifyFileWorker(const ResourceEntity &resource, const std::string &filenameRaw)
 {
     PicDrawManager pdm(resource.TryGetComponent<PicComponent>(), resource.TryGetComponent<PaletteComponent>());
 
@@ -117,43 +144,29 @@ void VerifyFileWorker(ResourceEntity &resource, const std::string &filenameRaw)
 
 void VerifyFilesInFolder(bool saveAndReload, SCIVersion version, const std::string &folder)
 {
-    std::unique_ptr<ResourceSourceArray> mapAndVolumes = std::make_unique<ResourceSourceArray>();
-    mapAndVolumes->push_back(std::make_unique<PatchFilesResourceSource>(ResourceTypeFlags::Pic, version, folder, ResourceSourceFlags::PatchFile));
-    std::unique_ptr<ResourceContainer> resourceContainer(
-        new ResourceContainer(
-        folder,
-        move(mapAndVolumes),
-        ResourceTypeFlags::Pic,
-        ResourceEnumFlags::None,
-        nullptr)
-        );
-
-    bool foundSome = false;
-    for (auto blob : *resourceContainer)
+    bool foundSome = 0 != ForEachPicInFolder(version, folder, [&](const ResourceEntity &resource, const std::string &name)
     {
-        foundSome = true;
-        std::unique_ptr<ResourceEntity> resource = CreateResourceFromResourceData(*blob);
-        std::string filenameRaw = folder + "\\" + GetFileNameFor(*blob);
+        std::string filenameRaw = folder + "\\" + name;
         if (saveAndReload)
         {
             // Save it to a stream
             sci::ostream savedStream;
             std::map<BlobKey, uint32_t> propertyBag;
-            resource->WriteTo(savedStream, true, resource->ResourceNumber, propertyBag);
+            resource.WriteTo(savedStream, true, resource.ResourceNumber, propertyBag);
             // Load it back
             sci::istream loadStream(savedStream.GetInternalPointer(), savedStream.GetDataSize());
             ResourceBlob blob;
             GameFolderHelper dummyHelper;
-            blob.CreateFromBits(dummyHelper, "whatever", resource->GetType(), &loadStream, resource->PackageNumber, resource->ResourceNumber, resource->Base36Number, version, ResourceSourceFlags::PatchFile);
+            blob.CreateFromBits(dummyHelper, "whatever", resource.GetType(), &loadStream, resource.PackageNumber, resource.ResourceNumber, resource.Base36Number, version, ResourceSourceFlags::PatchFile);
             std::unique_ptr<ResourceEntity> resourceReloaded = CreateResourceFromResourceData(blob, false);
             // Veirfy
             VerifyFileWorker(*resourceReloaded, filenameRaw);
         }
         else
         {
-            VerifyFileWorker(*resource, filenameRaw);
+            VerifyFileWorker(resource, filenameRaw);
         }
-    }
+    });
     if (!foundSome)
     {
         std::wstring message = fmt::format(L"Found no test files in {0}", folder);
@@ -173,6 +186,304 @@ void TestPicsHelper(bool saveAndReload)
     VerifyFilesInFolder(saveAndReload, sciVersion2, folder + "\\SCI2");
 }
 
+void CompareFillAlgorithms(const PicComponent &pic, const PaletteComponent *palette, bool isEGAUndithered, const std::string &name)
+{
+    // Draw all the screens once with each fill.
+    size_t byteSize = pic.Size.cx * pic.Size.cy;
+    std::vector<uint8_t> screens[2][4];
+    FillAlgorithm algorithms[2] = { FillAlgorithm::PerPixel, FillAlgorithm::Span };
+    for (int i = 0; i < 2; i++)
+    {
+        screens[i][0].assign(byteSize, ((palette != nullptr) || isEGAUndithered) ? 0xff : 0x0f);
+        for (int s = 1; s < 4; s++)
+        {
+            screens[i][s].assign(byteSize, 0x00);
+        }
+        PicData data = { PicScreenFlags::All, &screens[i][0][0], &screens[i][1][0], &screens[i][2][0], &screens[i][3][0], palette != nullptr, isEGAUndithered, pic.Size, pic.Traits->ContinuousPriority, nullptr, algorithms[i] };
+        ViewPort state(0);
+        Draw(pic, data, state, -1);
+    }
+
+    for (PicScreen screen : { PicScreen::Visual, PicScreen::Priority, PicScreen::Control })
+    {
+        const std::vector<uint8_t> &expected = screens[0][(int)screen];
+        const std::vector<uint8_t> &found = screens[1][(int)screen];
+        auto mismatch = std::mismatch(expected.begin(), expected.end(), found.begin());
+        if (mismatch.first != expected.end())
+        {
+            size_t offset = mismatch.first - expected.begin();
+            std::wstring message = fmt::format(L"Span fill differs in screen {0} at offset {1} ({2},{3}) of {4}{5}.\nExpected {6:02x} and got {7:02x}",
+                (int)screen, offset, offset % pic.Size.cx, offset / pic.Size.cx, name, isEGAUndithered ? " (undithered)" : "", (int)*mismatch.first, (int)*mismatch.second);
+            Logger::WriteMessage(message.c_str());
+        }
+        Assert::IsTrue(mismatch.first == expected.end());
+    }
+}
+
+void CompareFillAlgorithmsInFolder(SCIVersion version, const std::string &folder)
+{
+    size_t count = ForEachPicInFolder(version, folder, [](const ResourceEntity &resource, const std::string &name)
+    {
+        // EGA pics get checked both dithered and undithered.
+        bool isEGA = (resource.TryGetComponent<PaletteComponent>() == nullptr);
+        for (int undithered = 0; undithered < (isEGA ? 2 : 1); undithered++)
+        {
+            CompareFillAlgorithms(resource.GetComponent<PicComponent>(), resource.TryGetComponent<PaletteComponent>(), undithered != 0, name);
+        }
+    });
+    Assert::IsTrue(count > 0);
+}
+
+void TestFillConformanceHelper()
+{
+    std::string folder = GetTestFileDirectory("Pics");
+    CompareFillAlgorithmsInFolder(sciVersion0, folder + "\\SCI0");
+    CompareFillAlgorithmsInFolder(sciVersion1_EarlyEGA, folder + "\\SCI1.0\\EGA");
+    CompareFillAlgorithmsInFolder(sciVersion1_Early, folder + "\\SCI1.0\\Early");
+    CompareFillAlgorithmsInFolder(sciVersion1_Mid, folder + "\\SCI1.0\\Mid");
+    CompareFillAlgorithmsInFolder(sciVersion1_1, folder + "\\SCI1.1");
+    CompareFillAlgorithmsInFolder(sciVersion2, folder + "\\SCI2");
+}
+
+void CompareSeekWithFreshDraw(PicDrawManager &pdm, const PicComponent &pic, const PaletteComponent *palette, ptrdiff_t pos, const std::string &name)
+{
+    PicDrawManager pdmFresh(&pic, palette);
+    pdmFresh.SeekToPos(pos);
+    pdm.SeekToPos(pos);
+    PicScreen screens[] = { PicScreen::Visual, PicScreen::Priority, PicScreen::Control };
+    for (PicScreen screen : screens)
+    {
+        std::unique_ptr<Cel> celFresh = pdmFresh.MakeCelFromPic(screen, PicPosition::PrePlugin);
+        std::unique_ptr<Cel> celSeek = pdm.MakeCelFromPic(screen, PicPosition::PrePlugin);
+        size_t offset;
+        uint8_t expected, found;
+        bool result = CompareCels(*celFresh, *celSeek, offset, expected, found);
+        if (!result)
+        {
+            std::wstring message = fmt::format(L"Seeking to {0} in {1} differs from a fresh draw in screen {2} at offset {3}.\nExpected {4:02x} and got {5:02x}",
+                pos, name, (int)screen, offset, (int)expected, (int)found);
+            Logger::WriteMessage(message.c_str());
+        }
+        Assert::IsTrue(result);
+    }
+}
+
+void TestSeekInFolder(SCIVersion version, const std::string &folder)
+{
+    ForEachPicInFolder(version, folder, [](const ResourceEntity &resource, const std::string &name)
+    {
+        const PicComponent &pic = resource.GetComponent<PicComponent>();
+        const PaletteComponent *palette = resource.TryGetComponent<PaletteComponent>();
+        ptrdiff_t count = (ptrdiff_t)pic.commands.size();
+
+        // Draw it all (which takes checkpoints), then jump around backwards and forwards.
+        PicDrawManager pdm(&pic, palette, false, true);
+        CompareSeekWithFreshDraw(pdm, pic, palette, count, name);
+        ptrdiff_t positions[] = { count / 2, count / 3, count - 1, 1, count * 3 / 4, count / 2 + 1, 0 };
+        for (ptrdiff_t pos : positions)
+        {
+            CompareSeekWithFreshDraw(pdm, pic, palette, max((ptrdiff_t)0, pos), name);
+        }
+    });
+}
+
+void TestSeekHelper()
+{
+    std::string folder = GetTestFileDirectory("Pics");
+    TestSeekInFolder(sciVersion0, folder + "\\SCI0");
+    TestSeekInFolder(sciVersion1_1, folder + "\\SCI1.1");
+}
+
+void TestPartialInvalidateInFolder(SCIVersion version, const std::string &folder)
+{
+    ForEachPicInFolder(version, folder, [](const ResourceEntity &resource, const std::string &name)
+    {
+        PicComponent pic = resource.GetComponent<PicComponent>();
+        const PaletteComponent *palette = resource.TryGetComponent<PaletteComponent>();
+        ptrdiff_t count = (ptrdiff_t)pic.commands.size();
+        if (count < 4)
+        {
+            return;
+        }
+
+        // Two views showing the same pic.
+        PicDrawManager pdm(&pic, palette);
+        PicShownScreen shown, otherShown;
+        pdm.SeekToPos(-1);
+        CRect rectAll = shown.GetChangedRect(pdm, PicScreen::Visual, PicPosition::PrePlugin, pic.Size);
+        Assert::AreEqual((LONG)pic.Size.cx, rectAll.Width());
+        Assert::AreEqual((LONG)pic.Size.cy, rectAll.Height());
+        shown.MarkShown(pdm, PicScreen::Visual, PicPosition::PrePlugin, pic.Size);
+        Assert::IsTrue(shown.GetChangedRect(pdm, PicScreen::Visual, PicPosition::PrePlugin, pic.Size).IsRectEmpty());
+
+        // The other view hasn't shown anything yet, and then shows a different screen. That shouldn't
+        // affect what the first one thinks changed.
+        Assert::IsTrue(otherShown.GetChangedRect(pdm, PicScreen::Visual, PicPosition::PrePlugin, pic.Size) == rectAll);
+        otherShown.MarkShown(pdm, PicScreen::Priority, PicPosition::PrePlugin, pic.Size);
+        Assert::IsTrue(shown.GetChangedRect(pdm, PicScreen::Visual, PicPosition::PrePlugin, pic.Size).IsRectEmpty());
+        Assert::IsTrue(otherShown.GetChangedRect(pdm, PicScreen::Visual, PicPosition::PrePlugin, pic.Size) == rectAll);
+
+        // Remove a command from the middle, and only invalidate from there on. The checkpoints
+        // that are kept should still give the same result as a fresh draw.
+        ptrdiff_t removed = count / 2;
+        RemoveCommand(pic, removed);
+        pdm.Invalidate(removed);
+        CompareSeekWithFreshDraw(pdm, pic, palette, count - 1, name);
+        CompareSeekWithFreshDraw(pdm, pic, palette, removed / 2, name);
+
+        // The changed area should lie within the pic, and be empty once shown.
+        pdm.SeekToPos(-1);
+        CRect rectChanged = shown.GetChangedRect(pdm, PicScreen::Visual, PicPosition::PrePlugin, pic.Size);
+        CRect rectInPic;
+        rectInPic.IntersectRect(&rectChanged, &rectAll);
+        Assert::IsTrue(rectChanged.IsRectEmpty() || (rectInPic == rectChanged));
+        shown.MarkShown(pdm, PicScreen::Visual, PicPosition::PrePlugin, pic.Size);
+        Assert::IsTrue(shown.GetChangedRect(pdm, PicScreen::Visual, PicPosition::PrePlugin, pic.Size).IsRectEmpty());
+    });
+}
+
+void TestPartialInvalidateHelper()
+{
+    std::string folder = GetTestFileDirectory("Pics");
+    TestPartialInvalidateInFolder(sciVersion0, folder + "\\SCI0");
+    TestPartialInvalidateInFolder(sciVersion1_1, folder + "\\SCI1.1");
+}
+
+uint8_t GetPixelAtPos(PicDrawManager &pdm, PicScreen screen, ptrdiff_t pos, int x, int y)
+{
+    pdm.SeekToPos(pos);
+    std::unique_ptr<Cel> cel = pdm.MakeCelFromPic(screen, PicPosition::PrePlugin);
+    return cel->Data[BUFFEROFFSET_NONSTD(cel->GetStride(), cel->size.cy, x, y)];
+}
+
+void TestPosFromPointInFolder(SCIVersion version, const std::string &folder)
+{
+    ForEachPicInFolder(version, folder, [](const ResourceEntity &resource, const std::string &name)
+    {
+        const PicComponent &pic = resource.GetComponent<PicComponent>();
+        const PaletteComponent *palette = resource.TryGetComponent<PaletteComponent>();
+        PicDrawManager pdm(&pic, palette);
+        PicDrawManager pdmSeek(&pic, palette);
+        size16 size = pic.Size;
+        size_t byteSize = size.cx * size.cy;
+        for (int y = size.cy / 10; y < size.cy; y += size.cy / 5)
+        {
+            for (int x = size.cx / 10; x < size.cx; x += size.cx / 5)
+            {
+                // The visual screen should match what we get by redrawing the pic and watching the pixel.
+                std::vector<uint8_t> pdataVisual(byteSize, 0x0f);
+                std::vector<uint8_t> pdataAux(byteSize, 0x00);
+                PicData data = { PicScreenFlags::Visual, &pdataVisual[0], nullptr, nullptr, &pdataAux[0], palette != nullptr, false, size, pic.Traits->ContinuousPriority };
+                ViewPort state(0);
+                if (palette == nullptr)
+                {
+                    Assert::AreEqual((ptrdiff_t)GetLastChangedSpot(pic, data, state, x, y), pdm.PosFromPoint(x, y), fmt::format(L"{0} at {1},{2}", name, x, y).c_str());
+                }
+
+                // The command that owns a pixel is the one after which it has its final value.
+                for (PicScreen screen : { PicScreen::Visual, PicScreen::Priority, PicScreen::Control })
+                {
+                    ptrdiff_t owner = pdm.PosFromPoint(x, y, screen);
+                    uint8_t finalValue = GetPixelAtPos(pdmSeek, screen, -1, x, y);
+                    if (owner == -1)
+                    {
+                        Assert::AreEqual(finalValue, GetPixelAtPos(pdmSeek, screen, 0, x, y));
+                    }
+                    else
+                    {
+                        Assert::AreEqual(finalValue, GetPixelAtPos(pdmSeek, screen, owner + 1, x, y));
+                        Assert::AreNotEqual(finalValue, GetPixelAtPos(pdmSeek, screen, owner, x, y));
+                    }
+                }
+            }
+        }
+    });
+}
+
+void TestPosFromPointHelper()
+{
+    std::string folder = GetTestFileDirectory("Pics");
+    TestPosFromPointInFolder(sciVersion0, folder + "\\SCI0");
+    TestPosFromPointInFolder(sciVersion1_1, folder + "\\SCI1.1");
+}
+
+// Draws all of a pic into the 4 screens, either from its commands or its render program. The
+// render program takes over at iSplit, to check that it can start part way through.
+void DrawAllScreens(const PicComponent &pic, const PaletteComponent *palette, const PicRenderProgram *program, ptrdiff_t iSplit, std::vector<uint8_t> (&screens)[4])
+{
+    size_t byteSize = pic.Size.cx * pic.Size.cy;
+    screens[0].assign(byteSize, (palette != nullptr) ? 0xff : 0x0f);
+    for (int i = 1; i < 4; i++)
+    {
+        screens[i].assign(byteSize, 0x00);
+    }
+    PicData data = { PicScreenFlags::All, &screens[0][0], &screens[1][0], &screens[2][0], &screens[3][0], palette != nullptr, false, pic.Size, pic.Traits->ContinuousPriority };
+    ViewPort state(0);
+    if (program)
+    {
+        Draw(pic, data, state, 0, iSplit);
+        program->Execute(data, state, iSplit, -1);
+    }
+    else
+    {
+        Draw(pic, data, state, -1);
+    }
+}
+
+void TestRenderProgramInFolder(SCIVersion version, const std::string &folder, double &secondsCommands, double &secondsProgram, size_t &picsDrawn)
+{
+    const int passes = 5;
+    ForEachPicInFolder(version, folder, [&](const ResourceEntity &resource, const std::string &name)
+    {
+        const PicComponent &pic = resource.GetComponent<PicComponent>();
+        const PaletteComponent *palette = resource.TryGetComponent<PaletteComponent>();
+        PicRenderProgram program(pic.commands);
+        Assert::IsTrue(program.IsFor(pic.commands));
+        Assert::AreEqual(pic.commands.size(), program.GetCommandCount());
+
+        std::vector<uint8_t> expected[4];
+        std::vector<uint8_t> found[4];
+        DrawAllScreens(pic, palette, nullptr, 0, expected);
+        ptrdiff_t count = (ptrdiff_t)pic.commands.size();
+        for (ptrdiff_t split : { (ptrdiff_t)0, count / 3, count / 2 + 1, count })
+        {
+            DrawAllScreens(pic, palette, &program, split, found);
+            for (int i = 0; i < 4; i++)
+            {
+                Assert::IsTrue(expected[i] == found[i], fmt::format(L"{0}: screen {1} differs when starting the render program at {2}", name, i, split).c_str());
+            }
+        }
+
+        // Compare full redraws.
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int pass = 0; pass < passes; pass++)
+        {
+            DrawAllScreens(pic, palette, nullptr, 0, found);
+        }
+        auto middle = std::chrono::high_resolution_clock::now();
+        for (int pass = 0; pass < passes; pass++)
+        {
+            DrawAllScreens(pic, palette, &program, 0, found);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        secondsCommands += std::chrono::duration<double>(middle - start).count();
+        secondsProgram += std::chrono::duration<double>(end - middle).count();
+        picsDrawn += passes;
+    });
+}
+
+void TestRenderProgramHelper()
+{
+    std::string folder = GetTestFileDirectory("Pics");
+    double secondsCommands = 0.0;
+    double secondsProgram = 0.0;
+    size_t picsDrawn = 0;
+    TestRenderProgramInFolder(sciVersion0, folder + "\\SCI0", secondsCommands, secondsProgram, picsDrawn);
+    TestRenderProgramInFolder(sciVersion1_1, folder + "\\SCI1.1", secondsCommands, secondsProgram, picsDrawn);
+    Logger::WriteMessage(fmt::format("Full pic redraw, from commands: {0:.1f} pics/s, from render program: {1:.1f} pics/s\n",
+        picsDrawn / secondsCommands, picsDrawn / secondsProgram).c_str());
+}
+
 namespace UnitTests
 {
     TEST_CLASS(TextPicDraw)
@@ -201,6 +512,31 @@ namespace UnitTests
             TestPicsHelper(false);
         }
 
+        TEST_METHOD(TestSpanFillConformance)
+        {
+            TestFillConformanceHelper();
+        }
+
+        TEST_METHOD(TestSeekWithCheckpoints)
+        {
+            TestSeekHelper();
+        }
+
+        TEST_METHOD(TestPosFromPoint)
+        {
+            TestPosFromPointHelper();
+        }
+
+        TEST_METHOD(TestPartialInvalidate)
+        {
+            TestPartialInvalidateHelper();
+        }
+
+        TEST_METHOD(TestRenderProgram)
+        {
+            TestRenderProgramHelper();
+        }
+
     private:
         static Gdiplus::GdiplusStartupInput _gdiplusStartupInput;
         static ULONG_PTR _gdiplusToken;
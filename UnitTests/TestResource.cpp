@@ -20,6 +20,8 @@
 #include "ResourceContainer.h"
 #include "RasterOperations.h"
 #include "format.h"
+#include <random>
+#include <chrono>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -28,6 +30,74 @@ std::wstring ToString(const RasterChangeHint& q)
     return fmt::format(L"RasterChangeHint:{0:08x}", (int)q);
 }
 
+// Makes a cel out of runs of random lengths, from a few colors, so that all the kinds of RLE commands
+// get used. The padding at the end of each line is the transparent color, which is what reading gives us.
+Cel MakeRandomCel(std::mt19937 &rng, bool isVGA, int cx, int cy)
+{
+    uint8_t transparent = isVGA ? (uint8_t)(rng() % 256) : 0x0f;
+    Cel cel(size16((uint16_t)cx, (uint16_t)cy), point16(), transparent);
+    int cxActual = CX_ACTUAL(cx);
+    cel.Data.allocate(cxActual * cy);
+    cel.Data.fill(transparent);
+    uint8_t colors[4] = { transparent, (uint8_t)(rng() % 16), (uint8_t)(rng() % 16), (uint8_t)(rng() % 16) };
+    int maxRun = 1 + rng() % 80;
+    uint8_t color = transparent;
+    int run = 0;
+    for (int y = 0; y < cy; y++)
+    {
+        for (int x = 0; x < cx; x++)
+        {
+            if (run == 0)
+            {
+                run = 1 + rng() % maxRun;
+                color = ((rng() % 3) == 0) ? (uint8_t)(rng() % (isVGA ? 256 : 16)) : colors[rng() % 4];
+            }
+            cel.Data[y * cxActual + x] = color;
+            run--;
+        }
+    }
+    return cel;
+}
+
+void EncodeCel(const Cel &cel, bool isVGA, RLEScan scan, std::vector<uint8_t> &rle, std::vector<uint8_t> &literal)
+{
+    sci::ostream rleStream;
+    sci::ostream literalStream;
+    WriteImageData(rleStream, cel, isVGA, literalStream, !isVGA, scan);
+    rle.assign(rleStream.GetInternalPointer(), rleStream.GetInternalPointer() + rleStream.GetDataSize());
+    literal.assign(literalStream.GetInternalPointer(), literalStream.GetInternalPointer() + literalStream.GetDataSize());
+}
+
+Cel DecodeCel(const Cel &celHeader, bool isVGA, const std::vector<uint8_t> &rle, const std::vector<uint8_t> &literal)
+{
+    Cel cel(celHeader.size, celHeader.placement, celHeader.TransparentColor);
+    sci::istream rleStream(rle.empty() ? nullptr : &rle[0], (uint32_t)rle.size());
+    sci::istream literalStream(literal.empty() ? nullptr : &literal[0], (uint32_t)literal.size());
+    ReadImageData(rleStream, cel, isVGA, literalStream);
+    return cel;
+}
+
+void AssertSameCelData(const Cel &one, const Cel &two)
+{
+    Assert::AreEqual(one.Data.size(), two.Data.size());
+    Assert::IsTrue(0 == memcmp(&one.Data[0], &two.Data[0], one.Data.size()));
+}
+
+void AssertEncoding(bool isVGA, int cx, uint8_t transparent, const std::vector<uint8_t> &pixels, const std::vector<uint8_t> &expectedRLE, const std::vector<uint8_t> &expectedLiteral)
+{
+    Cel cel(size16((uint16_t)cx, 1), point16(), transparent);
+    cel.Data.allocate(CX_ACTUAL(cx));
+    cel.Data.fill(transparent);
+    memcpy(&cel.Data[0], &pixels[0], pixels.size());
+    for (RLEScan scan : { RLEScan::Vectorized, RLEScan::Scalar })
+    {
+        std::vector<uint8_t> rle, literal;
+        EncodeCel(cel, isVGA, scan, rle, literal);
+        Assert::IsTrue(expectedRLE == rle);
+        Assert::IsTrue(expectedLiteral == literal);
+    }
+}
+
 namespace UnitTests
 {		
     TEST_CLASS(TestResource)
@@ -73,5 +143,180 @@ namespace UnitTests
             Assert::AreEqual(loopMirror.MirrorOf, (uint8_t)0xff);
         }
 
+        TEST_METHOD(TestCelRLEEncoding)
+        {
+            // Literals stop before a run of 3, and runs are limited to 63.
+            std::vector<uint8_t> pixels = { 1, 2, 2, 3, 3, 3, 4, 5 };
+            AssertEncoding(true, 8, 0xff, pixels, { 0x03, 0x83, 0x02 }, { 1, 2, 2, 3, 4, 5 });
+            // ...or before 2 transparent pixels.
+            AssertEncoding(true, 4, 0, { 1, 0, 0, 2 }, { 0x01, 0xc2, 0x01 }, { 1, 2 });
+            std::vector<uint8_t> longRun(70, 7);
+            AssertEncoding(true, 70, 0xff, longRun, { 0xbf, 0x87 }, { 7, 7 });
+            // EGA runs are limited to 15, and start with a zero.
+            AssertEncoding(false, 4, 0xf, { 1, 1, 1, 2 }, { 0x00, 0x31, 0x12 }, {});
+            std::vector<uint8_t> longRunEGA(20, 5);
+            AssertEncoding(false, 20, 0xf, longRunEGA, { 0x00, 0xf5, 0x55 }, {});
+        }
+
+        TEST_METHOD(TestCelRLERoundTrip)
+        {
+            std::mt19937 rng(1234);
+            for (int i = 0; i < 2000; i++)
+            {
+                bool isVGA = (i % 4) != 0;
+                Cel cel = MakeRandomCel(rng, isVGA, 1 + rng() % 200, 1 + rng() % 60);
+                std::vector<uint8_t> rle, literal, rleScalar, literalScalar;
+                EncodeCel(cel, isVGA, RLEScan::Vectorized, rle, literal);
+                EncodeCel(cel, isVGA, RLEScan::Scalar, rleScalar, literalScalar);
+                Assert::IsTrue(rle == rleScalar);
+                Assert::IsTrue(literal == literalScalar);
+                AssertSameCelData(cel, DecodeCel(cel, isVGA, rle, literal));
+
+                // And with the RLE and literal data in the same stream.
+                sci::ostream stream;
+                WriteImageData(stream, cel, isVGA, false);
+                sci::istream streamRead(stream.GetInternalPointer(), stream.GetDataSize());
+                Cel celRead(cel.size, cel.placement, cel.TransparentColor);
+                ReadImageData(streamRead, celRead, isVGA);
+                AssertSameCelData(cel, celRead);
+            }
+        }
+
+        TEST_METHOD(TestCelRLEThroughput)
+        {
+            // Something like a big SCI1.1 portrait animation.
+            std::mt19937 rng(42);
+            std::vector<Cel> cels;
+            for (int i = 0; i < 200; i++)
+            {
+                cels.push_back(MakeRandomCel(rng, true, 160, 120));
+            }
+
+            const int passes = 5;
+            double secondsWrite[2];
+            double secondsRead = 0.0;
+            std::vector<uint8_t> rle, literal;
+            RLEScan scans[2] = { RLEScan::Vectorized, RLEScan::Scalar };
+            for (int scan = 0; scan < 2; scan++)
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                for (int pass = 0; pass < passes; pass++)
+                {
+                    for (const Cel &cel : cels)
+                    {
+                        EncodeCel(cel, true, scans[scan], rle, literal);
+                    }
+                }
+                secondsWrite[scan] = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            }
+
+            for (const Cel &cel : cels)
+            {
+                EncodeCel(cel, true, RLEScan::Vectorized, rle, literal);
+                auto start = std::chrono::high_resolution_clock::now();
+                for (int pass = 0; pass < passes; pass++)
+                {
+                    DecodeCel(cel, true, rle, literal);
+                }
+                secondsRead += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            }
+
+            double celCount = (double)(cels.size() * passes);
+            Logger::WriteMessage(fmt::format("Cel RLE write, vectorized: {0:.0f} cels/s, scalar: {1:.0f} cels/s. Read: {2:.0f} cels/s\n",
+                celCount / secondsWrite[0], celCount / secondsWrite[1], celCount / secondsRead).c_str());
+        }
+
+        TEST_METHOD(TestCelCopyOnWrite)
+        {
+            std::mt19937 rng(7);
+            Loop loop;
+            loop.Cels.push_back(MakeRandomCel(rng, true, 40, 30));
+            loop.Cels.push_back(MakeRandomCel(rng, true, 40, 30));
+            const Loop &original = loop;
+
+            // Copies share their bits...
+            Loop copy = loop;
+            const Loop &constCopy = copy;
+            Assert::IsTrue(constCopy.Cels[0].Data.shares_data(original.Cels[0].Data));
+            Assert::IsTrue(constCopy.Cels[1].Data.shares_data(original.Cels[1].Data));
+
+            // ...until one is written to, and then only that cel gets its own.
+            uint8_t before = original.Cels[0].Data[5];
+            copy.Cels[0].Data[5] = (uint8_t)(before + 1);
+            Assert::IsFalse(constCopy.Cels[0].Data.shares_data(original.Cels[0].Data));
+            Assert::IsTrue(constCopy.Cels[1].Data.shares_data(original.Cels[1].Data));
+            Assert::AreEqual(before, original.Cels[0].Data[5]);
+            Assert::AreEqual((uint8_t)(before + 1), constCopy.Cels[0].Data[5]);
+
+            // Cloning a resource (which is what undo does) doesn't copy any bits.
+            std::unique_ptr<ResourceEntity> resource(CreateDefaultViewResource(sciVersion0));
+            std::unique_ptr<ResourceEntity> clone = resource->Clone();
+            const RasterComponent *raster = resource->TryGetComponent<RasterComponent>();
+            const RasterComponent *rasterClone = clone->TryGetComponent<RasterComponent>();
+            Assert::IsTrue(rasterClone->Loops[0].Cels[0].Data.shares_data(raster->Loops[0].Cels[0].Data));
+
+            // Moving hands over the bits, and leaves the source empty.
+            Cel moved = std::move(copy.Cels[1]);
+            const Cel &constMoved = moved;
+            Assert::IsTrue(constMoved.Data.shares_data(original.Cels[1].Data));
+            Assert::IsTrue(copy.Cels[1].Data.empty());
+            moved = std::move(copy.Cels[0]);
+            Assert::AreEqual((uint8_t)(before + 1), constMoved.Data[5]);
+            Assert::IsTrue(copy.Cels[0].Data.empty());
+        }
+
+        TEST_METHOD(TestCelRuntimeSerialization)
+        {
+            std::mt19937 rng(3);
+            Cel cel = MakeRandomCel(rng, true, 37, 21);
+            cel.placement = point16(-4, 9);
+            cel.TransparentColor = 0x7a;
+            sci::ostream out;
+            SerializeCelRuntime(out, cel);
+
+            sci::istream in(out.GetInternalPointer(), out.GetDataSize());
+            Cel celRead;
+            DeserializeCelRuntime(in, celRead);
+            Assert::IsTrue(in.good());
+            Assert::AreEqual(in.GetDataSize(), in.tellg());
+            Assert::IsTrue(cel.size == celRead.size);
+            Assert::AreEqual(cel.placement.x, celRead.placement.x);
+            Assert::AreEqual(cel.placement.y, celRead.placement.y);
+            Assert::AreEqual(cel.TransparentColor, celRead.TransparentColor);
+            Assert::AreEqual(cel.Stride32, celRead.Stride32);
+            AssertSameCelData(cel, celRead);
+        }
+
+        TEST_METHOD(TestViewMirrorSharesBits)
+        {
+            std::mt19937 rng(11);
+            Cel celOrig = MakeRandomCel(rng, true, 33, 20);
+            celOrig.placement = point16(5, 7);
+            Cel celMirror;
+            const Cel &orig = celOrig;
+            const Cel &mirror = celMirror;
+            SyncCelMirrorState(celMirror, celOrig);
+            Assert::AreEqual((int16_t)-5, mirror.placement.x);
+            Assert::AreEqual(orig.Data[0], mirror.Data[32]);
+
+            // Syncing again from an unchanged original leaves the mirror's bits alone.
+            Cel mirrorBefore = celMirror;
+            SyncCelMirrorState(celMirror, celOrig);
+            Assert::IsTrue(mirror.Data.shares_data(mirrorBefore.Data));
+
+            // But a change to the original is picked up.
+            celOrig.Data[0] = (uint8_t)(orig.Data[0] + 1);
+            SyncCelMirrorState(celMirror, celOrig);
+            Assert::IsFalse(mirror.Data.shares_data(mirrorBefore.Data));
+            Assert::AreEqual(orig.Data[0], mirror.Data[32]);
+
+            // A symmetric cel is its own mirror image, so its bits are shared outright.
+            Cel celSymmetric(size16(10, 4), point16(), 0);
+            celSymmetric.Data.allocate(PaddedSize(celSymmetric.size));
+            celSymmetric.Data.fill(3);
+            SyncCelMirrorState(celMirror, celSymmetric);
+            Assert::IsTrue(mirror.Data.shares_data(celSymmetric.Data));
+        }
+
 	};
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "ResourceMap.h"
+#include "AppState.h"
+#include "Helper.h"
+#include "ResourceContainer.h"
+#include "ResourceBlob.h"
+#include "ResourceSourceFlags.h"
+#include "ResourceMapOperations.h"
+#include "format.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+std::vector<uint8_t> ReadWholeFile(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+namespace UnitTests
+{
+    TEST_CLASS(TestResourceAppend)
+    {
+    public:
+        TEST_CLASS_INITIALIZE(ClassSetup)
+        {
+        }
+
+        TEST_CLASS_CLEANUP(ClassCleanup)
+        {
+        }
+
+        TEST_METHOD(TestAppendSCI0)
+        {
+            _gameFolder = SetUpGameSCI0();
+            _DoIt();
+        }
+
+        TEST_METHOD(TestAppendSCI11)
+        {
+            _gameFolder = SetUpGameSCI11();
+            _DoIt();
+        }
+
+        TEST_METHOD_CLEANUP(TestAppend_Clean)
+        {
+            CleanUpGame(_gameFolder);
+        }
+
+        void _DoIt()
+        {
+            // Find a view that lives in the resource package. The container is gone by the time
+            // we save, like it is when saving from an editor.
+            std::unique_ptr<ResourceBlob> view;
+            {
+                auto resourceContainer = appState->GetResourceMap().Resources(ResourceTypeFlags::View, ResourceEnumFlags::MostRecentOnly);
+                for (auto &blob : *resourceContainer)
+                {
+                    if (blob->GetSourceFlags() == ResourceSourceFlags::ResourceMap)
+                    {
+                        view = std::make_unique<ResourceBlob>(*blob);
+                        break;
+                    }
+                }
+            }
+            Assert::IsNotNull(view.get());
+
+            std::string volumeFilename = fmt::format("{0}\\resource.{1:03d}", _gameFolder, view->GetPackageHint());
+            std::vector<uint8_t> before = ReadWholeFile(volumeFilename);
+
+            // Save it again
+            Assert::IsTrue(SUCCEEDED(appState->GetResourceMap().AppendResource(*view)));
+
+            // The volume should have only grown by the size of the resource, and existing data should be untouched.
+            std::vector<uint8_t> after = ReadWholeFile(volumeFilename);
+            Assert::IsTrue(after.size() > before.size());
+            Assert::IsTrue((after.size() - before.size()) <= (size_t)(view->GetLength() + 32));
+            Assert::IsTrue(std::equal(before.begin(), before.end(), after.begin()));
+
+            // And we should get back the newly appended copy.
+            std::unique_ptr<ResourceBlob> reloaded = appState->GetResourceMap().MostRecentResource(ResourceType::View, view->GetNumber(), false);
+            Assert::IsNotNull(reloaded.get());
+            Assert::AreEqual(view->GetLength(), reloaded->GetLength());
+            Assert::IsTrue(0 == memcmp(view->GetData(), reloaded->GetData(), view->GetLength()));
+
+            // Saving shouldn't be blocked by something else (e.g. the resource explorer) still having the volume
+            // mapped. That covers both appending, and deleting (which replaces the volume).
+            {
+                std::unique_ptr<ResourceBlob> other;
+                auto reader = appState->GetResourceMap().Resources(ResourceTypeFlags::View, ResourceEnumFlags::MostRecentOnly);
+                for (auto &blob : *reader)
+                {
+                    if ((blob->GetSourceFlags() == ResourceSourceFlags::ResourceMap) && (blob->GetNumber() != view->GetNumber()))
+                    {
+                        other = std::make_unique<ResourceBlob>(*blob);
+                        break;
+                    }
+                }
+                Assert::IsNotNull(other.get());
+
+                Assert::IsTrue(SUCCEEDED(appState->GetResourceMap().AppendResource(*view)));
+                DeleteResource(appState->GetResourceMap(), *other);
+            }
+            reloaded = appState->GetResourceMap().MostRecentResource(ResourceType::View, view->GetNumber(), false);
+            Assert::IsNotNull(reloaded.get());
+            Assert::AreEqual(view->GetLength(), reloaded->GetLength());
+            Assert::IsTrue(0 == memcmp(view->GetData(), reloaded->GetData(), view->GetLength()));
+        }
+
+    private:
+        static std::string _gameFolder;
+    };
+
+    std::string TestResourceAppend::_gameFolder;
+}
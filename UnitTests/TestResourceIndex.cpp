@@ -0,0 +1,217 @@
+/***************************************************************************
+    Copyright (c) 2015 Philip Fortier
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+***************************************************************************/
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "ResourceMap.h"
+#include "AppState.h"
+#include "Helper.h"
+#include "ResourceSources.h"
+#include "ResourceIndex.h"
+#include "ResourceMapOperations.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTests
+{
+    TEST_CLASS(TestResourceIndex)
+    {
+    public:
+        TEST_CLASS_INITIALIZE(ClassSetup)
+        {
+        }
+
+        TEST_CLASS_CLEANUP(ClassCleanup)
+        {
+        }
+
+        TEST_METHOD(TestIndexSCI0)
+        {
+            _gameFolder = SetUpGameSCI0();
+            _TestLoad();
+        }
+
+        TEST_METHOD(TestIndexSCI11)
+        {
+            _gameFolder = SetUpGameSCI11();
+            _TestLoad();
+        }
+
+        TEST_METHOD(TestIndexStaleStamps)
+        {
+            _gameFolder = SetUpGameSCI0();
+            _DeleteIndex();
+            _Enumerate(ResourceTypeFlags::View, ResourceSourceAccessFlags::Read);
+            std::shared_ptr<const ResourceIndex> index = _LoadIndex();
+            Assert::IsNotNull(index.get());
+
+            // Touching a volume the index refers to makes it out of date.
+            FileDescriptorResourceMap fileDescriptor(_gameFolder);
+            HANDLE hFile = CreateFile(fileDescriptor._GetVolumeFilename(index->GetEntries()[0].MapEntry.PackageNumber).c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+            Assert::IsTrue(hFile != INVALID_HANDLE_VALUE);
+            FILETIME now;
+            GetSystemTimeAsFileTime(&now);
+            SetFileTime(hFile, nullptr, nullptr, &now);
+            CloseHandle(hFile);
+
+            Assert::IsNull(_LoadIndex().get());
+        }
+
+        TEST_METHOD(TestIndexInconsistentWithVolume)
+        {
+            _gameFolder = SetUpGameSCI0();
+            _DeleteIndex();
+            _Enumerate(ResourceTypeFlags::View, ResourceSourceAccessFlags::Read);
+            std::shared_ptr<const ResourceIndex> index = _LoadIndex();
+            Assert::IsNotNull(index.get());
+            // The first entry is always one of those spot-checked.
+            ResourceIndexEntry first = index->GetEntries()[0];
+            Assert::IsTrue(first.HasHeader && (first.cbCompressed > 0));
+
+            // Change the resource data in a way the stamps can't tell: same size, same timestamp.
+            uint32_t dataOffset;
+            {
+                std::unique_ptr<ResourceSource> source = CreateResourceSource(ResourceTypeFlags::All, appState->GetResourceMap().Helper(), ResourceSourceFlags::ResourceMap, ResourceSourceAccessFlags::ReadWrite);
+                ResourceHeaderAgnostic header;
+                dataOffset = source->GetHeaderAndPositionedStream(first.MapEntry, header).tellg();
+            }
+            FileDescriptorResourceMap fileDescriptor(_gameFolder);
+            HANDLE hFile = CreateFile(fileDescriptor._GetVolumeFilename(first.MapEntry.PackageNumber).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+            Assert::IsTrue(hFile != INVALID_HANDLE_VALUE);
+            FILETIME lastWriteTime;
+            GetFileTime(hFile, nullptr, nullptr, &lastWriteTime);
+            uint8_t byte;
+            DWORD cb;
+            SetFilePointer(hFile, dataOffset, nullptr, FILE_BEGIN);
+            ReadFile(hFile, &byte, 1, &cb, nullptr);
+            byte = ~byte;
+            SetFilePointer(hFile, dataOffset, nullptr, FILE_BEGIN);
+            WriteFile(hFile, &byte, 1, &cb, nullptr);
+            SetFileTime(hFile, nullptr, nullptr, &lastWriteTime);
+            CloseHandle(hFile);
+
+            // So the saved index still loads...
+            index = _LoadIndex();
+            Assert::IsNotNull(index.get());
+            Assert::AreEqual(first.Checksum, index->GetEntries()[0].Checksum);
+
+            // ...but a resource source rejects it, and indexes the volume again.
+            _Enumerate(ResourceTypeFlags::View, ResourceSourceAccessFlags::Read);
+            index = _LoadIndex();
+            Assert::IsNotNull(index.get());
+            Assert::AreNotEqual(first.Checksum, index->GetEntries()[0].Checksum);
+        }
+
+        TEST_METHOD(TestIndexKeptInMemoryWhenNotSaved)
+        {
+            _gameFolder = SetUpGameSCI0();
+            _DeleteIndex();
+            // A folder where the index should go means it can't be written.
+            FileDescriptorResourceMap fileDescriptor(_gameFolder);
+            Assert::IsTrue(!!CreateDirectory(fileDescriptor._GetIndexFilename().c_str(), nullptr));
+
+            std::vector<ResourceMapEntryAgnostic> views = _Enumerate(ResourceTypeFlags::View, ResourceSourceAccessFlags::Read);
+            std::shared_ptr<const ResourceIndex> index = _LoadIndex();
+            Assert::IsNotNull(index.get());
+            Assert::AreEqual(views.size(), index->GetEntries().size());
+
+            // It goes out of date like a saved one does.
+            HANDLE hFile = CreateFile(fileDescriptor._GetMapFilename().c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+            Assert::IsTrue(hFile != INVALID_HANDLE_VALUE);
+            FILETIME now;
+            GetSystemTimeAsFileTime(&now);
+            SetFileTime(hFile, nullptr, nullptr, &now);
+            CloseHandle(hFile);
+            Assert::IsNull(_LoadIndex().get());
+        }
+
+        TEST_METHOD_CLEANUP(TestIndex_Clean)
+        {
+            CleanUpGame(_gameFolder);
+        }
+
+        void _TestLoad()
+        {
+            _DeleteIndex();
+
+            // Enumerating views indexes just the views.
+            std::vector<ResourceMapEntryAgnostic> views = _Enumerate(ResourceTypeFlags::View, ResourceSourceAccessFlags::Read);
+            std::shared_ptr<const ResourceIndex> index = _LoadIndex();
+            Assert::IsNotNull(index.get());
+            Assert::IsTrue(index->GetTypes() == ResourceTypeFlags::View);
+            _AssertSameEntries(_Enumerate(ResourceTypeFlags::View, ResourceSourceAccessFlags::ReadWrite), index->GetEntries());
+            Assert::AreEqual(views.size(), index->GetEntries().size());
+
+            // Enumerating pics adds them to it.
+            _Enumerate(ResourceTypeFlags::Pic, ResourceSourceAccessFlags::Read);
+            index = _LoadIndex();
+            Assert::IsNotNull(index.get());
+            Assert::IsTrue(index->GetTypes() == (ResourceTypeFlags::View | ResourceTypeFlags::Pic));
+            _AssertSameEntries(_Enumerate(ResourceTypeFlags::View | ResourceTypeFlags::Pic, ResourceSourceAccessFlags::ReadWrite), index->GetEntries());
+
+            // And the headers from the index match those in the volumes.
+            std::unique_ptr<ResourceSource> source = CreateResourceSource(ResourceTypeFlags::All, appState->GetResourceMap().Helper(), ResourceSourceFlags::ResourceMap);
+            for (const ResourceIndexEntry &entry : index->GetEntries())
+            {
+                ResourceHeaderAgnostic cached;
+                Assert::AreEqual(entry.HasHeader, source->GetCachedHeader(entry.MapEntry, cached));
+                if (entry.HasHeader)
+                {
+                    ResourceHeaderAgnostic header;
+                    source->GetHeaderAndPositionedStream(entry.MapEntry, header);
+                    Assert::AreEqual(header.CompressionMethod, cached.CompressionMethod);
+                    Assert::AreEqual(header.cbCompressed, cached.cbCompressed);
+                    Assert::AreEqual(header.cbDecompressed, cached.cbDecompressed);
+                }
+            }
+        }
+
+        // Sources we write to don't use the index, so this reads the map directly for them.
+        std::vector<ResourceMapEntryAgnostic> _Enumerate(ResourceTypeFlags types, ResourceSourceAccessFlags access)
+        {
+            std::vector<ResourceMapEntryAgnostic> entries;
+            std::unique_ptr<ResourceSource> source = CreateResourceSource(types, appState->GetResourceMap().Helper(), ResourceSourceFlags::ResourceMap, access);
+            IteratorState state;
+            ResourceMapEntryAgnostic entry;
+            while (source->ReadNextEntry(types, state, entry, nullptr))
+            {
+                entries.push_back(entry);
+            }
+            return entries;
+        }
+
+        void _AssertSameEntries(const std::vector<ResourceMapEntryAgnostic> &fromMap, const std::vector<ResourceIndexEntry> &fromIndex)
+        {
+            Assert::AreEqual(fromMap.size(), fromIndex.size());
+            for (size_t i = 0; i < fromMap.size(); i++)
+            {
+                Assert::IsTrue(fromMap[i] == fromIndex[i].MapEntry);
+            }
+        }
+
+        std::shared_ptr<const ResourceIndex> _LoadIndex()
+        {
+            return ResourceIndex::Load(FileDescriptorResourceMap(_gameFolder), appState->GetResourceMap().Helper().Version);
+        }
+
+        void _DeleteIndex()
+        {
+            DeleteFile(FileDescriptorResourceMap(_gameFolder)._GetIndexFilename().c_str());
+        }
+
+    private:
+        static std::string _gameFolder;
+    };
+
+    std::string TestResourceIndex::_gameFolder;
+}
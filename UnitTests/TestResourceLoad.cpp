@@ -18,6 +18,9 @@
 #include "ResourceMap.h"
 #include "AppState.h"
 #include "ResourceContainer.h"
+#include "ResourceUtil.h"
+#include "PaletteOperations.h"
+#include "Pic.h"
 #include "Helper.h"
 #include "format.h"
 
@@ -48,6 +51,18 @@ namespace UnitTests
             _DoIt();
         }
 
+        TEST_METHOD(TestDeferredLoadSCI0)
+        {
+            _gameFolder = SetUpGameSCI0();
+            _DoDeferred();
+        }
+
+        TEST_METHOD(TestDeferredLoadSCI11)
+        {
+            _gameFolder = SetUpGameSCI11();
+            _DoDeferred();
+        }
+
         TEST_METHOD_CLEANUP(TestLoadResources_Clean)
         {
             CleanUpGame(_gameFolder);
@@ -70,6 +85,86 @@ namespace UnitTests
             }
         }
 
+        // Deferred views should end up identical to ones read immediately, and their headers
+        // should match without any image data being decoded.
+        void _DoDeferred()
+        {
+            auto container = appState->GetResourceMap().Resources(ResourceTypeFlags::View, ResourceEnumFlags::MostRecentOnly | ResourceEnumFlags::AddInDefaultEnumFlags);
+            for (auto &blob : *container)
+            {
+                std::unique_ptr<ResourceEntity> immediate = CreateResourceFromResourceData(*blob, false);
+                std::unique_ptr<ResourceEntity> deferred = CreateDeferredResourceFromResourceData(*blob, false);
+                Assert::IsTrue(deferred->IsDeferred());
+
+                const RasterComponent &expected = immediate->GetComponent<RasterComponent>();
+                const RasterComponent &headers = *deferred->TryGetComponentHeaders<RasterComponent>();
+                Assert::IsTrue(deferred->IsDeferred());
+                Assert::IsTrue(expected.Loops.size() == headers.Loops.size());
+                for (size_t l = 0; l < expected.Loops.size(); l++)
+                {
+                    Assert::IsTrue(expected.Loops[l].Cels.size() == headers.Loops[l].Cels.size());
+                    Assert::AreEqual(expected.Loops[l].IsMirror, headers.Loops[l].IsMirror);
+                    for (size_t c = 0; c < expected.Loops[l].Cels.size(); c++)
+                    {
+                        const Cel &celExpected = expected.Loops[l].Cels[c];
+                        const Cel &celHeaders = headers.Loops[l].Cels[c];
+                        Assert::IsTrue(celExpected.size == celHeaders.size);
+                        Assert::IsTrue(celExpected.placement == celHeaders.placement);
+                        Assert::AreEqual(celExpected.TransparentColor, celHeaders.TransparentColor);
+                    }
+                }
+                Assert::AreEqual(immediate->TryGetComponent<PaletteComponent>() != nullptr, deferred->TryGetComponentHeaders<PaletteComponent>() != nullptr);
+
+                // Decoding one cel at a time should give the same bits as a full read.
+                for (size_t l = 0; l < expected.Loops.size(); l++)
+                {
+                    for (size_t c = 0; c < expected.Loops[l].Cels.size(); c++)
+                    {
+                        const Cel &celExpected = expected.Loops[l].Cels[c];
+                        Cel celSingle;
+                        ReadCelImageData(*deferred, CelIndex((int)l, (int)c), celSingle);
+                        Assert::IsTrue(celExpected.size == celSingle.size);
+                        Assert::IsTrue(celExpected.placement == celSingle.placement);
+                        Assert::IsTrue(celExpected.Data.size() == celSingle.Data.size());
+                        Assert::IsTrue(celExpected.Data.empty() || (0 == memcmp(&celExpected.Data[0], &celSingle.Data[0], celExpected.Data.size())));
+                    }
+                }
+                Assert::IsTrue(deferred->IsDeferred());
+
+                // Now pull in the bits
+                const RasterComponent &full = deferred->GetComponent<RasterComponent>();
+                Assert::IsFalse(deferred->IsDeferred());
+                for (size_t l = 0; l < expected.Loops.size(); l++)
+                {
+                    for (size_t c = 0; c < expected.Loops[l].Cels.size(); c++)
+                    {
+                        const Cel &celExpected = expected.Loops[l].Cels[c];
+                        const Cel &celFull = full.Loops[l].Cels[c];
+                        Assert::IsTrue(celExpected.Data.size() == celFull.Data.size());
+                        Assert::IsTrue(celExpected.Data.empty() || (0 == memcmp(&celExpected.Data[0], &celFull.Data[0], celExpected.Data.size())));
+                    }
+                }
+            }
+
+            // Pic headers (where there are any) should have the same size and palette as a full read.
+            auto picContainer = appState->GetResourceMap().Resources(ResourceTypeFlags::Pic, ResourceEnumFlags::MostRecentOnly | ResourceEnumFlags::AddInDefaultEnumFlags);
+            for (auto &blob : *picContainer)
+            {
+                std::unique_ptr<ResourceEntity> immediate = CreateResourceFromResourceData(*blob, false);
+                std::unique_ptr<ResourceEntity> deferred = CreateDeferredResourceFromResourceData(*blob, false);
+                const PicComponent &headers = *deferred->TryGetComponentHeaders<PicComponent>();
+                Assert::IsTrue(immediate->GetComponent<PicComponent>().Size == headers.Size);
+                const PaletteComponent *paletteExpected = immediate->TryGetComponent<PaletteComponent>();
+                const PaletteComponent *paletteHeaders = deferred->TryGetComponentHeaders<PaletteComponent>();
+                Assert::AreEqual(paletteExpected != nullptr, paletteHeaders != nullptr);
+                if (paletteExpected)
+                {
+                    PaletteComponent paletteCopy(*paletteHeaders);
+                    Assert::IsTrue(paletteCopy == *paletteExpected);
+                }
+            }
+        }
+
     private:
         static std::string _gameFolder;
 